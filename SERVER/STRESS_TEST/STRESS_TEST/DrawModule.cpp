@@ -148,6 +148,10 @@ int DrawGLScene(GLvoid)									// Here's Where We Do All The Drawing
 	glPrint("Player Delay : %dms", player_delay);
 	glRasterPos2f(0.0f, 0.15f);
 	glPrint("Monster Delay : %dms", monster_delay - 100);
+	if (connect_rate > 0) {
+		glRasterPos2f(0.0f, 0.20f);
+		glPrint("Connect Rate : %d/s (p99 %dus)", (int)connect_rate, (int)connect_p99_us);
+	}
 
 	glColor3f(1, 1, 1);
 
@@ -13,6 +13,7 @@
 #include <queue>
 #include <array>
 #include <memory>
+#include <algorithm>
 
 using namespace std;
 using namespace chrono;
@@ -22,12 +23,17 @@ extern HWND		hWnd;
 const static int MAX_TEST = 1000;
 const static int MAX_CLIENTS = MAX_TEST * 2;
 const static int INVALID_ID = -1;
-const static int MAX_PACKET_SIZE = 512;
 const static int MAX_BUFF_SIZE = 512;
 
+// #define _CONNECT_BENCH		// 부하 테스트 전에 접속 폭주를 걸어 서버의 초당 접속 처리량을 측정한다
+const static int CONNECT_BENCH_THREADS = 8;			// 동시에 접속하는 스레드 수
+const static int CONNECT_BENCH_ROUNDS = 5;			// 라운드마다 MAX_CLIENTS 개를 접속시켰다가 끊는다
+
 #pragma comment (lib, "ws2_32.lib")
 
 #include "protocol.h"
+#include "PacketCodec.h"
+#include "RecvRing.h"
 
 HANDLE g_hiocp;
 
@@ -49,11 +55,10 @@ struct CLIENT {
 
 	SOCKET client_socket;
 	OverlappedEx recv_over;
-	unsigned char packet_buf[MAX_PACKET_SIZE];
-	int prev_packet_data;
-	int curr_packet_size;
+	RECV_RING recv_ring;		// 받았지만 아직 처리하지 않은 데이터 - recv 는 링의 빈 공간에 바로 받는다
 	high_resolution_clock::time_point last_move_time;
 	high_resolution_clock::time_point last_recved_time;
+	STATE_DECODER decoder;		// 압축 인코딩된 상태 패킷의 기준 상태
 };
 
 struct MONSTER {
@@ -69,6 +74,8 @@ atomic_int num_connections;
 atomic_int client_to_close;
 atomic_int active_clients;
 atomic_int active_monsters;
+atomic_int connect_rate;			// 접속 폭주 측정 결과 (초당 접속 수)
+atomic_int connect_p99_us;			// 접속 폭주 측정 결과 (connect 지연 99 백분위)
 
 int			player_delay;
 int			monster_delay;				
@@ -79,7 +86,7 @@ thread test_thread;
 float point_cloud[MAX_TEST * 2];
 float point_cloud_2[MAX_TEST * 2];
 
-// ߿ NPC ߰ Ȯ 
+// 나중에 NPC까지 추가 확장 용
 struct ALIEN {
 	int id;
 	int x, y;
@@ -111,8 +118,8 @@ void DisconnectClient(int ci)
 
 void SendPacket(int cl, void* packet)
 {
-	int psize = reinterpret_cast<unsigned char*>(packet)[0];
-	int ptype = reinterpret_cast<unsigned char*>(packet)[1];
+	int psize = Get_Packet_Size(packet);
+	int ptype = Get_Packet_Type(packet);
 	OverlappedEx* over = new OverlappedEx;
 	over->event_type = OP_SEND;
 	memcpy(over->IOCP_buf, packet, psize);
@@ -129,9 +136,27 @@ void SendPacket(int cl, void* packet)
 	// std::cout << "Send Packet [" << ptype << "] To Client : " << cl << std::endl;
 }
 
+// 몬스터 하나의 상태를 반영한다. (SC_MOVE_MONSTERS, SC_MOVE_MONSTERS_Q 공용)
+void UpdateMonster(int room_num, const MONSTER_SNAPSHOT& m)
+{
+	int mi = room_num * 10 + m.id;
+	if (m.is_alive == false) {
+		g_monsters[mi].connected = false;
+		active_monsters--;
+		return;
+	}
+	g_monsters[mi].pos = m.Pos;
+
+	auto now = high_resolution_clock::now();
+	auto d_ms = duration_cast<milliseconds>(now - g_monsters[mi].last_recved_time).count();
+	if (monster_delay < d_ms) monster_delay++;
+	else if (monster_delay > d_ms) monster_delay--;
+	g_monsters[mi].last_recved_time = now;
+}
+
 void ProcessPacket(int ci, unsigned char packet[])
 {
-	switch (packet[1]) {
+	switch (Get_Packet_Type(packet)) {
 	case SC_MOVE_PLAYER: {
 		SC_MOVE_PLAYER_PACKET* move_packet = reinterpret_cast<SC_MOVE_PLAYER_PACKET*>(packet);
 		if (move_packet->id < MAX_CLIENTS) {
@@ -172,7 +197,7 @@ void ProcessPacket(int ci, unsigned char packet[])
 	{
 		if (ci % MAX_USER_PER_ROOM == 1) {
 			SC_SUMMON_MONSTER_PACKET* p = reinterpret_cast<SC_SUMMON_MONSTER_PACKET*>(packet);
-			//cout << p->room_num << " ȯ\n";
+			//cout << p->room_num << "몬스터 소환\n";
 			g_monsters[p->room_num * 10 + p->id].connected = true;
 			active_monsters++;
 			g_monsters[p->room_num * 10 + p->id].pos = p->Pos;
@@ -199,6 +224,44 @@ void ProcessPacket(int ci, unsigned char packet[])
 
 		break;
 	}
+	case SC_MOVE_MONSTERS:
+	{
+		if (ci % MAX_USER_PER_ROOM == 1) {
+			SC_MOVE_MONSTERS_PACKET* p = reinterpret_cast<SC_MOVE_MONSTERS_PACKET*>(packet);
+			for (int i = 0; i < p->count; ++i)
+				UpdateMonster(p->room_num, p->monsters[i]);
+		}
+		break;
+	}
+	case SC_MOVE_MONSTERS_Q:
+	{
+		if (ci % MAX_USER_PER_ROOM == 1) {
+			SC_MOVE_MONSTERS_Q_HEADER* p = reinterpret_cast<SC_MOVE_MONSTERS_Q_HEADER*>(packet);
+			int room_num = p->room_num;
+			Decode_Monster_Updates(packet, g_clients[ci].decoder, [room_num](const MONSTER_SNAPSHOT& m) {
+				UpdateMonster(room_num, m);
+				});
+		}
+		break;
+	}
+	case SC_UPDATE_PLAYER_Q:
+	{
+		// 복원한 상태로 SC_MOVE_PLAYER 를 처리한다.
+		short id;
+		PLAYER_STATE state;
+		if (false == Decode_Player_Update(packet, g_clients[ci].decoder, id, state)) break;
+		SC_MOVE_PLAYER_PACKET p;
+		p.size = sizeof(SC_MOVE_PLAYER_PACKET);
+		p.type = SC_MOVE_PLAYER;
+		p.id = id;
+		p.HP = state.HP;
+		p.Pos = state.Pos;
+		p.direction = state.direction;
+		p.vel = state.vel;
+		p.move_time = state.move_time;
+		ProcessPacket(ci, reinterpret_cast<unsigned char*>(&p));
+		break;
+	}
 	case CS_ATTACK: {
 		break;
 	}
@@ -217,6 +280,14 @@ void ProcessPacket(int ci, unsigned char packet[])
 	}
 }
 
+// 다음 recv 가 링의 빈 공간에 바로 받도록 wsabuf 를 맞춘다.
+void Set_Recv_Buffer(CLIENT& cl)
+{
+	unsigned len = 0;
+	cl.recv_over.wsabuf.buf = cl.recv_ring.Write_Space(len);
+	cl.recv_over.wsabuf.len = len;
+}
+
 void Worker_Thread()
 {
 	while (true) {
@@ -241,29 +312,15 @@ void Worker_Thread()
 			continue;
 		}
 		if (OP_RECV == over->event_type) {
-			char* buf = g_clients[ci].recv_over.IOCP_buf;
-			unsigned psize = g_clients[ci].curr_packet_size;
-			unsigned pr_size = g_clients[ci].prev_packet_data;
-			while (io_size > 0) {
-				if (0 == psize) psize = buf[0];
-				if (io_size + pr_size >= psize) {
-					//  Ŷ ϼ 
-					unsigned char packet[MAX_PACKET_SIZE];
-					memcpy(packet, g_clients[ci].packet_buf, pr_size);
-					memcpy(packet + pr_size, buf, psize - pr_size);
-					ProcessPacket(static_cast<int>(ci), packet);
-					io_size -= psize - pr_size;
-					buf += psize - pr_size;
-					psize = 0; pr_size = 0;
-				}
-				else {
-					memcpy(g_clients[ci].packet_buf + pr_size, buf, io_size);
-					pr_size += io_size;
-					io_size = 0;
-				}
+			g_clients[ci].recv_ring.Commit(io_size);
+			bool valid = Dispatch_Packets(g_clients[ci].recv_ring, [ci](char* packet, int) {
+				ProcessPacket(static_cast<int>(ci), reinterpret_cast<unsigned char*>(packet));
+				});
+			if (false == valid) {
+				DisconnectClient(client_id);
+				continue;
 			}
-			g_clients[ci].curr_packet_size = psize;
-			g_clients[ci].prev_packet_data = pr_size;
+			Set_Recv_Buffer(g_clients[ci]);
 			DWORD recv_flag = 0;
 			int ret = WSARecv(g_clients[ci].client_socket,
 				&g_clients[ci].recv_over.wsabuf, 1,
@@ -350,13 +407,10 @@ void Adjust_Number_Of_Client()
 		error_display("WSAConnect : ", GetLastError());
 	}
 
-	g_clients[num_connections].curr_packet_size = 0;
-	g_clients[num_connections].prev_packet_data = 0;
+	g_clients[num_connections].recv_ring.Clear();
 	ZeroMemory(&g_clients[num_connections].recv_over, sizeof(g_clients[num_connections].recv_over));
 	g_clients[num_connections].recv_over.event_type = OP_RECV;
-	g_clients[num_connections].recv_over.wsabuf.buf =
-		reinterpret_cast<CHAR*>(g_clients[num_connections].recv_over.IOCP_buf);
-	g_clients[num_connections].recv_over.wsabuf.len = sizeof(g_clients[num_connections].recv_over.IOCP_buf);
+	Set_Recv_Buffer(g_clients[num_connections]);
 
 	DWORD recv_flag = 0;
 	CreateIoCompletionPort(reinterpret_cast<HANDLE>(g_clients[num_connections].client_socket), g_hiocp, num_connections, 0);
@@ -386,8 +440,75 @@ fail_to_connect:
 	return;
 }
 
+/**
+ * @brief 접속 폭주 측정
+ *
+ * CONNECT_BENCH_THREADS 개의 스레드가 MAX_CLIENTS 개의 연결을 쉬지 않고 맺은 뒤 모두 끊는 것을
+ * CONNECT_BENCH_ROUNDS 번 반복합니다. 서버가 accept 를 늦게 처리하면 listen 대기열이 차서 connect 가 밀리므로
+ * 초당 접속 수와 connect 지연이 서버의 accept 처리량을 보여줍니다.
+ * (서버의 _PRINT_STATS 출력에서 accept/s 를 같이 확인한다)
+ */
+void Connect_Bench()
+{
+	SOCKADDR_IN ServerAddr;
+	ZeroMemory(&ServerAddr, sizeof(SOCKADDR_IN));
+	ServerAddr.sin_family = AF_INET;
+	ServerAddr.sin_port = htons(PORT_NUM);
+	ServerAddr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+	double best_rate = 0;
+	vector<long long> latencies;
+	for (int round = 0; round < CONNECT_BENCH_ROUNDS; ++round) {
+		vector<SOCKET> sockets(MAX_CLIENTS, INVALID_SOCKET);
+		vector<long long> round_latencies(MAX_CLIENTS, 0);
+		atomic_int failed = 0;
+		auto start_time = high_resolution_clock::now();
+		vector<thread> threads;
+		for (int t = 0; t < CONNECT_BENCH_THREADS; ++t) {
+			threads.emplace_back([&, t]() {
+				for (int i = t; i < MAX_CLIENTS; i += CONNECT_BENCH_THREADS) {
+					SOCKET s = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, NULL, 0, 0);
+					auto begin = high_resolution_clock::now();
+					if (0 != WSAConnect(s, (sockaddr*)&ServerAddr, sizeof(ServerAddr), NULL, NULL, NULL, NULL)) {
+						closesocket(s);
+						failed++;
+						continue;
+					}
+					round_latencies[i] = duration_cast<microseconds>(high_resolution_clock::now() - begin).count();
+					sockets[i] = s;
+				}
+				});
+		}
+		for (auto& th : threads) th.join();
+		double seconds = duration_cast<microseconds>(high_resolution_clock::now() - start_time).count() / 1e6;
+		int connected = MAX_CLIENTS - failed;
+		double rate = connected / seconds;
+		best_rate = max(best_rate, rate);
+		for (int i = 0; i < MAX_CLIENTS; ++i)
+			if (sockets[i] != INVALID_SOCKET) latencies.push_back(round_latencies[i]);
+		std::cout << "[CONNECT] round " << round << " : " << connected << " connects in " << seconds * 1000 << "ms ("
+			<< static_cast<int>(rate) << "/s), " << failed << " failed\n";
+
+		for (auto s : sockets)
+			if (s != INVALID_SOCKET) closesocket(s);
+		// 서버가 끊긴 세션을 정리하고 자리를 돌려줄 시간을 준다.
+		this_thread::sleep_for(500ms);
+	}
+
+	if (false == latencies.empty()) {
+		sort(latencies.begin(), latencies.end());
+		connect_p99_us = static_cast<int>(latencies[latencies.size() * 99 / 100]);
+	}
+	connect_rate = static_cast<int>(best_rate);
+	std::cout << "[CONNECT] best " << connect_rate << " connects/s, p99 connect " << connect_p99_us << "us\n";
+}
+
 void Test_Thread()
 {
+#ifdef _CONNECT_BENCH
+	Connect_Bench();
+	last_connect_time = high_resolution_clock::now();
+#endif
 	while (true) {
 		//Sleep(max(20, global_delay));
 		Adjust_Number_Of_Client();
@@ -441,6 +562,8 @@ void InitializeNetwork()
 
 	for (auto& cl : client_map) cl = -1;
 	num_connections = 0;
+	connect_rate = 0;
+	connect_p99_us = 0;
 	last_connect_time = high_resolution_clock::now();
 
 	WSADATA	wsadata;
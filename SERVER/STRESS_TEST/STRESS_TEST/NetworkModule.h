@@ -6,4 +6,6 @@ void GetPointCloud(int* size, int* size_2, float** points, float** points_2);
 extern int player_delay;
 extern int monster_delay;
 extern std::atomic_int active_clients;
-extern std::atomic_int active_monsters;
\ No newline at end of file
+extern std::atomic_int active_monsters;
+extern std::atomic_int connect_rate;
+extern std::atomic_int connect_p99_us;
\ No newline at end of file
@@ -0,0 +1,445 @@
+#pragma once
+// PacketCodec.h
+// 플레이어/몬스터 상태를 작게 인코딩하는 인코더와 디코더 (서버, 클라이언트, STRESS_TEST 가 같은 파일을 사용한다)
+//  - 위치는 스테이지 범위(MAP_X_SIZE / MAP_Y_SIZE / MAP_Z_SIZE) 기준 16비트 고정소수점으로 양자화하고,
+//    범위를 벗어난 값(숨긴 투사체의 5000 등)은 float 그대로 보낸다.
+//  - 지난 상태에서 바뀐 필드만 비트마스크로 표시해서 보내고, 위치와 속도는 지난 상태와의 차이를 zigzag varint 로 보낸다.
+//  - 기준 상태는 송신 측이 마지막으로 보낸 상태(= 수신 측이 복원한 상태)이다.
+//    TCP 가 도착과 순서를 보장하므로 따로 ack 를 받지 않고, 보낸 상태를 곧 확인된 상태로 본다.
+//  - 기준 상태가 없거나 CODEC_KEYFRAME_INTERVAL 번마다 모든 필드를 절대값으로 보낸다. (키프레임)
+//    키프레임을 받기 전의 델타는 수신 측이 버린다.
+// protocol.h (XMFLOAT3, DWORD, SC_*_Q_HEADER) 를 먼저 include 해야 한다.
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <unordered_map>
+
+constexpr int CODEC_KEYFRAME_INTERVAL = 30;
+constexpr int CODEC_QUANT_BITS = 16;
+constexpr float CODEC_QUANT_MAX = static_cast<float>((1 << CODEC_QUANT_BITS) - 1);
+
+// 양자화 범위 - 서버 stdafx.h 의 MAP_X_SIZE / MAP_Y_SIZE / MAP_Z_SIZE 와 같아야 한다.
+constexpr float CODEC_MAP_X_SIZE = 700.f;
+constexpr float CODEC_MAP_Y_SIZE = 480.f;
+constexpr float CODEC_MAP_Z_SIZE = 4600.f;
+constexpr float CODEC_MAX_SPEED = 512.f;		// 속도 양자화 범위 (-512 ~ 512)
+
+struct QUANT_RANGE {
+	float min[3];
+	float max[3];
+};
+constexpr QUANT_RANGE POS_RANGE{ { 0.f, -CODEC_MAP_Y_SIZE, 0.f }, { CODEC_MAP_X_SIZE, CODEC_MAP_Y_SIZE, CODEC_MAP_Z_SIZE } };
+constexpr QUANT_RANGE VEL_RANGE{ { -CODEC_MAX_SPEED, -CODEC_MAX_SPEED, -CODEC_MAX_SPEED }, { CODEC_MAX_SPEED, CODEC_MAX_SPEED, CODEC_MAX_SPEED } };
+
+// 벡터 필드의 인코딩 방식 (마스크에 2비트씩)
+enum FIELD_MODE { FIELD_SAME = 0, FIELD_DELTA = 1, FIELD_QUANT = 2, FIELD_RAW = 3 };
+
+// 양자화된 벡터 - 송신 측과 수신 측이 같은 값을 기준 상태로 들고 있는다.
+struct QUANT_VEC3 {
+	bool raw = true;		// 범위를 벗어나 float 로 보냈는지
+	uint16_t q[3]{};		// 양자화 값 (raw == false 일 때)
+	XMFLOAT3 f{};			// 복원한 값
+};
+
+inline float Quant_Step(const QUANT_RANGE& r, int i) { return (r.max[i] - r.min[i]) / CODEC_QUANT_MAX; }
+
+inline QUANT_VEC3 Quantize(const QUANT_RANGE& r, const XMFLOAT3& v)
+{
+	QUANT_VEC3 out;
+	float in[3] = { v.x, v.y, v.z };
+	float deq[3];
+	out.raw = false;
+	for (int i = 0; i < 3; ++i) {
+		if (!(in[i] >= r.min[i] && in[i] <= r.max[i])) {
+			out.raw = true;
+			break;
+		}
+		out.q[i] = static_cast<uint16_t>(lroundf((in[i] - r.min[i]) / Quant_Step(r, i)));
+		deq[i] = r.min[i] + out.q[i] * Quant_Step(r, i);
+	}
+	if (out.raw) {
+		out.q[0] = out.q[1] = out.q[2] = 0;
+		out.f = v;
+	}
+	else out.f = XMFLOAT3(deq[0], deq[1], deq[2]);
+	return out;
+}
+
+inline QUANT_VEC3 Dequantize(const QUANT_RANGE& r, const uint16_t q[3])
+{
+	QUANT_VEC3 out;
+	out.raw = false;
+	for (int i = 0; i < 3; ++i) out.q[i] = q[i];
+	out.f = XMFLOAT3(r.min[0] + q[0] * Quant_Step(r, 0), r.min[1] + q[1] * Quant_Step(r, 1), r.min[2] + q[2] * Quant_Step(r, 2));
+	return out;
+}
+
+inline bool operator==(const QUANT_VEC3& a, const QUANT_VEC3& b)
+{
+	if (a.raw != b.raw) return false;
+	if (a.raw) return 0 == memcmp(&a.f, &b.f, sizeof(XMFLOAT3));
+	return a.q[0] == b.q[0] && a.q[1] == b.q[1] && a.q[2] == b.q[2];
+}
+
+// 버퍼에 이어 쓰는 도우미. 공간이 모자라면 ok 가 false 가 된다.
+struct CODEC_WRITER {
+	unsigned char* buf;
+	int cap;
+	int len = 0;
+	bool ok = true;
+
+	CODEC_WRITER(unsigned char* _buf, int _cap) : buf(_buf), cap(_cap) {}
+	void Put(const void* data, int size)
+	{
+		if (!ok || len + size > cap) {
+			ok = false;
+			return;
+		}
+		memcpy(buf + len, data, size);
+		len += size;
+	}
+	void PutU8(uint8_t v) { Put(&v, 1); }
+	void PutU16(uint16_t v) { Put(&v, 2); }
+	void PutFloat(float v) { Put(&v, 4); }
+	void PutVarint(uint32_t v)
+	{
+		while (v >= 0x80) {
+			PutU8(static_cast<uint8_t>(v | 0x80));
+			v >>= 7;
+		}
+		PutU8(static_cast<uint8_t>(v));
+	}
+	void PutZigzag(int32_t v) { PutVarint((static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31)); }
+};
+
+struct CODEC_READER {
+	const unsigned char* buf;
+	int cap;
+	int len = 0;
+	bool ok = true;
+
+	CODEC_READER(const unsigned char* _buf, int _cap) : buf(_buf), cap(_cap) {}
+	void Get(void* data, int size)
+	{
+		if (!ok || len + size > cap) {
+			ok = false;
+			memset(data, 0, size);
+			return;
+		}
+		memcpy(data, buf + len, size);
+		len += size;
+	}
+	uint8_t GetU8() { uint8_t v; Get(&v, 1); return v; }
+	uint16_t GetU16() { uint16_t v; Get(&v, 2); return v; }
+	float GetFloat() { float v; Get(&v, 4); return v; }
+	uint32_t GetVarint()
+	{
+		uint32_t v = 0;
+		for (int shift = 0; shift < 35 && ok; shift += 7) {
+			uint8_t b = GetU8();
+			v |= static_cast<uint32_t>(b & 0x7f) << shift;
+			if ((b & 0x80) == 0) return v;
+		}
+		ok = false;
+		return 0;
+	}
+	int32_t GetZigzag() { uint32_t v = GetVarint(); return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1); }
+};
+
+// 벡터 하나를 기준 상태 base 에 대해 인코딩하고 사용한 방식을 돌려준다. base 는 새 상태로 바뀐다.
+inline FIELD_MODE Write_Vec3(CODEC_WRITER& w, QUANT_VEC3& base, const QUANT_RANGE& r, const XMFLOAT3& v, bool key)
+{
+	QUANT_VEC3 cur = Quantize(r, v);
+	if (!key && cur == base) return FIELD_SAME;
+	FIELD_MODE mode;
+	if (cur.raw) {
+		mode = FIELD_RAW;
+		w.PutFloat(cur.f.x);
+		w.PutFloat(cur.f.y);
+		w.PutFloat(cur.f.z);
+	}
+	else if (key || base.raw) {
+		mode = FIELD_QUANT;
+		for (int i = 0; i < 3; ++i) w.PutU16(cur.q[i]);
+	}
+	else {
+		mode = FIELD_DELTA;
+		for (int i = 0; i < 3; ++i) w.PutZigzag(static_cast<int32_t>(cur.q[i]) - static_cast<int32_t>(base.q[i]));
+	}
+	base = cur;
+	return mode;
+}
+
+inline void Read_Vec3(CODEC_READER& rd, QUANT_VEC3& base, const QUANT_RANGE& r, int mode)
+{
+	switch (mode) {
+	case FIELD_RAW: {
+		base.raw = true;
+		base.q[0] = base.q[1] = base.q[2] = 0;
+		base.f.x = rd.GetFloat();
+		base.f.y = rd.GetFloat();
+		base.f.z = rd.GetFloat();
+		break;
+	}
+	case FIELD_QUANT: {
+		uint16_t q[3];
+		for (int i = 0; i < 3; ++i) q[i] = rd.GetU16();
+		base = Dequantize(r, q);
+		break;
+	}
+	case FIELD_DELTA: {
+		uint16_t q[3];
+		for (int i = 0; i < 3; ++i) q[i] = static_cast<uint16_t>(base.q[i] + rd.GetZigzag());
+		base = Dequantize(r, q);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 플레이어 상태 (SC_UPDATE_PLAYER_PACKET 의 내용)
+//-----------------------------------------------------------------------------
+struct PLAYER_STATE {
+	float HP;
+	XMFLOAT3 Pos;
+	DWORD direction;
+	XMFLOAT3 vel;
+	unsigned move_time;		// STRESS_TEST 지연 측정용
+};
+
+struct PLAYER_BASELINE {
+	bool valid = false;		// 키프레임을 보냈는지(받았는지)
+	int since_key = 0;
+	int HP = 0;				// 정수로 양자화한 HP
+	QUANT_VEC3 Pos;
+	DWORD direction = 0;
+	QUANT_VEC3 vel;
+	unsigned move_time = 0;
+};
+
+// 마스크 비트
+constexpr uint16_t PM_KEY = 1 << 0;
+constexpr int PM_POS_SHIFT = 1;		// 2비트
+constexpr int PM_VEL_SHIFT = 3;		// 2비트
+constexpr uint16_t PM_HP = 1 << 5;
+constexpr uint16_t PM_DIRECTION = 1 << 6;
+constexpr uint16_t PM_MOVE_TIME = 1 << 7;
+
+/**
+ * @brief 플레이어 상태를 [마스크][필드...] 로 인코딩합니다.
+ * @return 쓴 바이트 수. 바뀐 필드가 없으면 0, 버퍼가 모자라면 -1 (이때 base 는 바뀌지 않습니다)
+ */
+inline int Encode_Player_State(unsigned char* buf, int cap, PLAYER_BASELINE& base, const PLAYER_STATE& cur)
+{
+	PLAYER_BASELINE next = base;
+	bool key = (false == base.valid || base.since_key >= CODEC_KEYFRAME_INTERVAL);
+	unsigned char body[64];
+	CODEC_WRITER w{ body, sizeof(body) };
+	uint16_t mask = key ? PM_KEY : 0;
+
+	mask |= static_cast<uint16_t>(Write_Vec3(w, next.Pos, POS_RANGE, cur.Pos, key) << PM_POS_SHIFT);
+	mask |= static_cast<uint16_t>(Write_Vec3(w, next.vel, VEL_RANGE, cur.vel, key) << PM_VEL_SHIFT);
+	int hp = static_cast<int>(lroundf(cur.HP));
+	if (key || hp != base.HP) {
+		mask |= PM_HP;
+		w.PutZigzag(hp);
+		next.HP = hp;
+	}
+	if (key || cur.direction != base.direction) {
+		mask |= PM_DIRECTION;
+		w.PutVarint(cur.direction);
+		next.direction = cur.direction;
+	}
+	if (key || cur.move_time != base.move_time) {
+		mask |= PM_MOVE_TIME;
+		w.PutVarint(cur.move_time - (key ? 0 : base.move_time));	// 키프레임은 절대값
+		next.move_time = cur.move_time;
+	}
+	if (mask == 0) return 0;
+	if (false == w.ok || w.len + 2 > cap) return -1;
+
+	memcpy(buf, &mask, 2);
+	memcpy(buf + 2, body, w.len);
+	next.valid = true;
+	next.since_key = key ? 0 : base.since_key + 1;
+	base = next;
+	return w.len + 2;
+}
+
+/**
+ * @brief Encode_Player_State 로 만든 바이트를 풀어 base 를 새 상태로 바꿉니다.
+ * @return 읽은 바이트 수. 잘못된 데이터면 -1
+ */
+inline int Decode_Player_State(const unsigned char* buf, int len, PLAYER_BASELINE& base)
+{
+	CODEC_READER rd{ buf, len };
+	uint16_t mask = rd.GetU16();
+	if (mask & PM_KEY) base = PLAYER_BASELINE{};
+	Read_Vec3(rd, base.Pos, POS_RANGE, (mask >> PM_POS_SHIFT) & 3);
+	Read_Vec3(rd, base.vel, VEL_RANGE, (mask >> PM_VEL_SHIFT) & 3);
+	if (mask & PM_HP) base.HP = rd.GetZigzag();
+	if (mask & PM_DIRECTION) base.direction = rd.GetVarint();
+	if (mask & PM_MOVE_TIME) base.move_time += rd.GetVarint();
+	if (false == rd.ok) return -1;
+	if (mask & PM_KEY) base.valid = true;
+	return rd.len;
+}
+
+inline PLAYER_STATE To_Player_State(const PLAYER_BASELINE& base)
+{
+	return PLAYER_STATE{ static_cast<float>(base.HP), base.Pos.f, base.direction, base.vel.f, base.move_time };
+}
+
+//-----------------------------------------------------------------------------
+// 몬스터 상태 (MONSTER_SNAPSHOT 의 내용)
+//-----------------------------------------------------------------------------
+struct MONSTER_BASELINE {
+	bool valid = false;
+	int since_key = 0;
+	short target_id = -1;
+	QUANT_VEC3 Pos;
+	short HP = 0;
+	bool is_alive = false;
+	QUANT_VEC3 BulletPos;
+	short animation_track = 0;
+};
+
+constexpr uint16_t MM_KEY = 1 << 0;
+constexpr int MM_POS_SHIFT = 1;		// 2비트
+constexpr int MM_BULLET_SHIFT = 3;	// 2비트
+constexpr uint16_t MM_HP = 1 << 5;
+constexpr uint16_t MM_TARGET = 1 << 6;
+constexpr uint16_t MM_ANIMATION = 1 << 7;
+constexpr uint16_t MM_ALIVE = 1 << 8;		// 값 (살아있으면 1)
+constexpr uint16_t MM_ALIVE_CHANGED = 1 << 9;
+
+/**
+ * @brief 몬스터 상태를 [마스크][필드...] 로 인코딩합니다.
+ * @return 쓴 바이트 수. 바뀐 필드가 없으면 0, 버퍼가 모자라면 -1 (이때 base 는 바뀌지 않습니다)
+ */
+inline int Encode_Monster_State(unsigned char* buf, int cap, MONSTER_BASELINE& base, const MONSTER_SNAPSHOT& cur)
+{
+	MONSTER_BASELINE next = base;
+	bool key = (false == base.valid || base.since_key >= CODEC_KEYFRAME_INTERVAL);
+	unsigned char body[64];
+	CODEC_WRITER w{ body, sizeof(body) };
+	uint16_t mask = key ? MM_KEY : 0;
+
+	mask |= static_cast<uint16_t>(Write_Vec3(w, next.Pos, POS_RANGE, cur.Pos, key) << MM_POS_SHIFT);
+	mask |= static_cast<uint16_t>(Write_Vec3(w, next.BulletPos, POS_RANGE, cur.BulletPos, key) << MM_BULLET_SHIFT);
+	if (key || cur.HP != base.HP) {
+		mask |= MM_HP;
+		w.PutZigzag(cur.HP);
+		next.HP = cur.HP;
+	}
+	if (key || cur.target_id != base.target_id) {
+		mask |= MM_TARGET;
+		w.PutZigzag(cur.target_id);
+		next.target_id = cur.target_id;
+	}
+	if (key || cur.animation_track != base.animation_track) {
+		mask |= MM_ANIMATION;
+		w.PutZigzag(cur.animation_track);
+		next.animation_track = cur.animation_track;
+	}
+	if (key || cur.is_alive != base.is_alive) {
+		mask |= MM_ALIVE_CHANGED;
+		next.is_alive = cur.is_alive;
+	}
+	if (mask == 0) return 0;
+	if (next.is_alive) mask |= MM_ALIVE;
+	if (false == w.ok || w.len + 2 > cap) return -1;
+
+	memcpy(buf, &mask, 2);
+	memcpy(buf + 2, body, w.len);
+	next.valid = true;
+	next.since_key = key ? 0 : base.since_key + 1;
+	base = next;
+	return w.len + 2;
+}
+
+inline int Decode_Monster_State(const unsigned char* buf, int len, MONSTER_BASELINE& base)
+{
+	CODEC_READER rd{ buf, len };
+	uint16_t mask = rd.GetU16();
+	if (mask & MM_KEY) base = MONSTER_BASELINE{};
+	Read_Vec3(rd, base.Pos, POS_RANGE, (mask >> MM_POS_SHIFT) & 3);
+	Read_Vec3(rd, base.BulletPos, POS_RANGE, (mask >> MM_BULLET_SHIFT) & 3);
+	if (mask & MM_HP) base.HP = static_cast<short>(rd.GetZigzag());
+	if (mask & MM_TARGET) base.target_id = static_cast<short>(rd.GetZigzag());
+	if (mask & MM_ANIMATION) base.animation_track = static_cast<short>(rd.GetZigzag());
+	base.is_alive = (mask & MM_ALIVE) != 0;
+	if (false == rd.ok) return -1;
+	if (mask & MM_KEY) base.valid = true;
+	return rd.len;
+}
+
+inline MONSTER_SNAPSHOT To_Monster_Snapshot(short id, const MONSTER_BASELINE& base)
+{
+	MONSTER_SNAPSHOT s;
+	s.id = id;
+	s.target_id = base.target_id;
+	s.Pos = base.Pos.f;
+	s.HP = base.HP;
+	s.is_alive = base.is_alive;
+	s.BulletPos = base.BulletPos.f;
+	s.animation_track = base.animation_track;
+	return s;
+}
+
+//-----------------------------------------------------------------------------
+// 패킷 단위 디코더 (수신 측)
+//-----------------------------------------------------------------------------
+// 연결 하나가 받은 상태들의 기준 상태
+struct STATE_DECODER {
+	std::unordered_map<short, PLAYER_BASELINE> players;
+	std::unordered_map<short, MONSTER_BASELINE> monsters;
+
+	void Clear()
+	{
+		players.clear();
+		monsters.clear();
+	}
+};
+
+/**
+ * @brief SC_UPDATE_PLAYER_Q 를 풀어 플레이어 상태를 돌려줍니다.
+ * @return 상태를 복원했으면 true. 키프레임을 아직 받지 못했거나 잘못된 패킷이면 false
+ */
+inline bool Decode_Player_Update(const unsigned char* packet, STATE_DECODER& dec, short& id, PLAYER_STATE& out)
+{
+	SC_UPDATE_PLAYER_Q_HEADER header;
+	memcpy(&header, packet, sizeof(header));
+	id = header.id;
+	PLAYER_BASELINE& base = dec.players[id];
+	int used = Decode_Player_State(packet + sizeof(header), header.size - static_cast<int>(sizeof(header)), base);
+	if (used < 0 || false == base.valid) return false;
+	out = To_Player_State(base);
+	return true;
+}
+
+/**
+ * @brief SC_MOVE_MONSTERS_Q 를 풀어 복원한 몬스터마다 func(const MONSTER_SNAPSHOT&) 를 호출합니다.
+ */
+template<class FUNC>
+bool Decode_Monster_Updates(const unsigned char* packet, STATE_DECODER& dec, FUNC func)
+{
+	SC_MOVE_MONSTERS_Q_HEADER header;
+	memcpy(&header, packet, sizeof(header));
+	int offset = sizeof(header);
+	for (int i = 0; i < header.count; ++i) {
+		short id;
+		if (offset + 2 > header.size) return false;
+		memcpy(&id, packet + offset, 2);
+		offset += 2;
+		MONSTER_BASELINE& base = dec.monsters[id];
+		int used = Decode_Monster_State(packet + offset, header.size - offset, base);
+		if (used < 0) return false;
+		offset += used;
+		if (base.valid) func(To_Monster_Snapshot(id, base));
+	}
+	return true;
+}
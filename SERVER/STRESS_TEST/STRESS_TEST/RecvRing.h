@@ -0,0 +1,98 @@
+#pragma once
+// RecvRing.h
+// 수신 데이터를 모으는 링 버퍼와 패킷 분리 (서버, 클라이언트, STRESS_TEST 가 같은 파일을 사용한다)
+//  - recv 는 링의 빈 공간에 바로 받는다. 덜 온 패킷을 버퍼 앞으로 옮기는 복사가 없다.
+//  - 링 안에서 이어져 있는 패킷은 복사하지 않고 링 버퍼를 가리키는 포인터 그대로 처리 함수에 넘긴다.
+//    링 끝을 넘어 둘로 나뉜 패킷만 임시 버퍼에 이어 붙여서 넘긴다.
+//  - 처리 함수가 길이보다 큰 구조체로 읽어도 버퍼를 넘지 않도록 링 뒤에 MAX_PACKET_SIZE 만큼 여유를 둔다.
+// protocol.h (PACKET_SIZE, BUF_SIZE, MAX_PACKET_SIZE) 를 먼저 include 해야 한다.
+
+#include <cstring>
+
+constexpr unsigned RECV_RING_SIZE = 2 * BUF_SIZE;	// 덜 온 패킷 하나(MAX_PACKET_SIZE 미만)를 남겨도 recv 할 공간이 남는 크기
+constexpr unsigned RECV_RING_MASK = RECV_RING_SIZE - 1;
+static_assert((RECV_RING_SIZE & RECV_RING_MASK) == 0, "RECV_RING_SIZE must be a power of two");
+static_assert(RECV_RING_SIZE >= 2 * MAX_PACKET_SIZE, "RECV_RING_SIZE must hold a partial packet and a full recv");
+
+// 링 안의 연속된 바이트 - 링 끝을 넘으면 first 와 second 두 조각으로 나뉜다.
+struct RING_VIEW {
+	char* first;
+	unsigned first_len;
+	char* second;
+	unsigned second_len;
+
+	bool Contiguous() const { return second_len == 0; }
+	void CopyTo(void* dst) const
+	{
+		memcpy(dst, first, first_len);
+		memcpy(static_cast<char*>(dst) + first_len, second, second_len);
+	}
+};
+
+/**
+ * @brief 수신 데이터를 모으는 링 버퍼
+ *
+ * 읽기/쓰기 위치는 계속 증가시키고 링 위치는 RECV_RING_MASK 로 구합니다.
+ * 한 스레드(세션당 recv 는 하나씩만 건다)만 접근한다고 가정합니다.
+ */
+class RECV_RING {
+	char _buf[RECV_RING_SIZE + MAX_PACKET_SIZE]{};	// 뒤의 MAX_PACKET_SIZE 는 쓰지 않는 여유 공간
+	unsigned _head = 0;		// 다음에 꺼낼 위치
+	unsigned _tail = 0;		// 다음에 받을 위치
+public:
+	void Clear() { _head = _tail = 0; }
+	unsigned Size() const { return _tail - _head; }
+
+	// recv 가 바로 쓸 수 있는 연속된 빈 공간
+	char* Write_Space(unsigned& len)
+	{
+		unsigned pos = _tail & RECV_RING_MASK;
+		unsigned free_len = RECV_RING_SIZE - Size();
+		len = (free_len < RECV_RING_SIZE - pos) ? free_len : RECV_RING_SIZE - pos;
+		return _buf + pos;
+	}
+	void Commit(unsigned len) { _tail += len; }
+
+	// 앞에서부터 len 바이트 (len <= Size())
+	RING_VIEW View(unsigned len)
+	{
+		unsigned pos = _head & RECV_RING_MASK;
+		unsigned first_len = (len < RECV_RING_SIZE - pos) ? len : RECV_RING_SIZE - pos;
+		return RING_VIEW{ _buf + pos, first_len, _buf, len - first_len };
+	}
+	void Consume(unsigned len)
+	{
+		_head += len;
+		// 비었으면 처음으로 돌려서 다음 recv 가 링 끝에서 잘리지 않게 한다.
+		if (_head == _tail) Clear();
+	}
+};
+
+/**
+ * @brief 링에 모인 완성된 패킷을 순서대로 handler(packet, size) 로 넘긴다.
+ * @return 길이 필드가 잘못된 패킷을 만나면 false (연결을 끊어야 한다)
+ *
+ * 이어져 있는 패킷은 링 버퍼 안을 가리키는 포인터를 그대로 넘기고, 링 끝에 걸친 패킷만 복사합니다.
+ * 넘긴 포인터는 다음 recv 를 걸기 전까지만 쓸 수 있습니다.
+ */
+template <class HANDLER>
+bool Dispatch_Packets(RECV_RING& ring, HANDLER&& handler)
+{
+	char packet[MAX_PACKET_SIZE];
+	while (ring.Size() >= sizeof(PACKET_SIZE)) {
+		PACKET_SIZE size;
+		ring.View(sizeof(size)).CopyTo(&size);
+		if (size < PACKET_HEADER_SIZE || size > MAX_PACKET_SIZE) return false;
+		if (ring.Size() < size) break;
+		RING_VIEW view = ring.View(size);
+		char* data = view.first;
+		if (false == view.Contiguous()) {
+			view.CopyTo(packet);
+			data = packet;
+		}
+		// 다음 recv 를 걸기 전까지는 링의 내용이 바뀌지 않으므로 먼저 꺼낸 것으로 표시해도 data 는 그대로다.
+		ring.Consume(size);
+		handler(data, static_cast<int>(size));
+	}
+	return true;
+}
@@ -1,7 +1,6 @@
 // protocol.h
 
 constexpr short PORT_NUM = 3500;
-constexpr short BUF_SIZE = 512;
 constexpr short ID_SIZE = 10;
 constexpr short PASSWORD_SIZE = 20;
 constexpr short MAX_USER = 9000;
@@ -16,6 +15,22 @@ constexpr short STAGE_SIZE = 1200;
 constexpr short AREA_SIZE = 200;
 constexpr short OBJECT_ARRAY_SIZE = 24;
 
+// 패킷 프레이밍 버전 - 서버와 클라이언트가 같은 값으로 빌드해야 한다.
+//  1 : 패킷 앞 1바이트(unsigned char)가 길이 - 최대 255바이트
+//  2 : 패킷 앞 2바이트(unsigned short, 리틀 엔디언)가 길이 - 묶음 패킷이 255바이트를 넘을 수 있다
+#define FRAME_VERSION 2
+
+#if FRAME_VERSION >= 2
+using PACKET_SIZE = unsigned short;
+constexpr short BUF_SIZE = 1024;
+#else
+using PACKET_SIZE = unsigned char;
+constexpr short BUF_SIZE = 512;
+#endif
+constexpr int PACKET_HEADER_SIZE = sizeof(PACKET_SIZE) + 1;		// 길이 + 타입
+// 패킷 하나의 최대 길이 - 송신 버퍼 하나에 들어가야 하고 길이 필드로 나타낼 수 있어야 한다.
+constexpr int MAX_PACKET_SIZE = (BUF_SIZE < (1 << (8 * sizeof(PACKET_SIZE)))) ? BUF_SIZE : (1 << (8 * sizeof(PACKET_SIZE))) - 1;
+
 // Packet ID
 constexpr char CS_LOGIN = 0;
 constexpr char CS_SIGNUP = 1;
@@ -37,21 +52,37 @@ constexpr char SC_OPEN_DOOR = 15;
 constexpr char SC_LOGIN_COMPLETE = 16;
 constexpr char SC_GAME_CLEAR = 17;
 constexpr char SC_INTERACTION = 18;
+constexpr char SC_MOVE_MONSTERS = 23;
+constexpr char SC_UPDATE_PLAYER_Q = 24;
+constexpr char SC_MOVE_MONSTERS_Q = 25;
 
 #include "stdafx.h"
 
+// 패킷 앞의 길이 필드를 읽는다. (수신 버퍼 안에서 정렬되지 않은 위치일 수 있으므로 memcpy)
+inline int Get_Packet_Size(const void* packet)
+{
+	PACKET_SIZE size;
+	memcpy(&size, packet, sizeof(size));
+	return size;
+}
+
+inline char Get_Packet_Type(const void* packet)
+{
+	return static_cast<const char*>(packet)[sizeof(PACKET_SIZE)];
+}
+
 #define _STRESS_TEST
 
 #pragma pack (push, 1)
 struct CS_LOGIN_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	//char	name[NAME_SIZE];
 };
 constexpr short CS_LOGIN_PACKET_SIZE = sizeof(CS_LOGIN_PACKET);
 
 struct CS_SIGN_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	wchar_t id[ID_SIZE];
 	wchar_t password[PASSWORD_SIZE];
@@ -59,7 +90,7 @@ struct CS_SIGN_PACKET {
 constexpr short CS_SIGN_PACKET_SIZE = sizeof(CS_SIGN_PACKET);
 
 //struct CS_SIGNIN_PACKET {
-//	unsigned char size;
+//	PACKET_SIZE size;
 //	char	type;
 //	char id[NAME_SIZE];
 //	char password[NAME_SIZE];
@@ -67,7 +98,7 @@ constexpr short CS_SIGN_PACKET_SIZE = sizeof(CS_SIGN_PACKET);
 //constexpr short CS_SIGNIN_PACKET_SIZE = sizeof(CS_SIGNIN_PACKET);
 
 struct CS_MOVE_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	DWORD	direction = 0;
 	short	id;
@@ -81,7 +112,7 @@ struct CS_MOVE_PACKET {
 constexpr short CS_MOVE_PACKET_SIZE = sizeof(CS_MOVE_PACKET);
 
 struct CS_ROTATE_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	float cxDelta = 0.f;
@@ -91,7 +122,7 @@ struct CS_ROTATE_PACKET {
 constexpr short CS_ROTATE_PACKET_SIZE = sizeof(CS_ROTATE_PACKET);
 
 struct CS_ATTACK_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	XMFLOAT3 pos;
@@ -99,7 +130,7 @@ struct CS_ATTACK_PACKET {
 constexpr short CS_ATTACK_PACKET_SIZE = sizeof(CS_ATTACK_PACKET);
 
 struct CS_INTERACTION_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	XMFLOAT3 pos;
@@ -107,7 +138,7 @@ struct CS_INTERACTION_PACKET {
 constexpr short CS_INTERACTION_PACKET_SIZE = sizeof(CS_INTERACTION_PACKET);
 
 struct CS_CHANGEWEAPON_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	short cur_weaponType;
@@ -115,7 +146,7 @@ struct CS_CHANGEWEAPON_PACKET {
 constexpr short CS_CHANGEWEAPON_PACKET_SIZE = sizeof(CS_CHANGEWEAPON_PACKET);
 
 struct SC_LOGIN_INFO_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	XMFLOAT3 pos;
@@ -123,7 +154,7 @@ struct SC_LOGIN_INFO_PACKET {
 constexpr short SC_LOGIN_INFO_PACKET_SIZE = sizeof(SC_LOGIN_INFO_PACKET);
 
 struct SC_ADD_PLAYER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	short cur_weaponType;
@@ -132,14 +163,14 @@ struct SC_ADD_PLAYER_PACKET {
 constexpr short SC_ADD_PLAYER_PACKET_SIZE = sizeof(SC_ADD_PLAYER_PACKET);
 
 struct SC_REMOVE_PLAYER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 };
 constexpr short SC_REMOVE_PLAYER_PACKET_SIZE = sizeof(SC_REMOVE_PLAYER_PACKET);
 
 struct SC_MOVE_PLAYER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	float	HP;
@@ -153,7 +184,7 @@ struct SC_MOVE_PLAYER_PACKET {
 constexpr short SC_MOVE_PLAYER_PACKET_SIZE = sizeof(SC_MOVE_PLAYER_PACKET);
 
 struct SC_ROTATE_PLAYER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	XMFLOAT3 Look, Right;
@@ -161,11 +192,11 @@ struct SC_ROTATE_PLAYER_PACKET {
 constexpr short SC_ROTATE_PLAYER_PACKET_SIZE = sizeof(SC_ROTATE_PLAYER_PACKET);
 
 struct SC_SUMMON_MONSTER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 #ifdef _STRESS_TEST
-	short room_num; // stress test  ϴ ӽ (  )
+	short room_num; // stress test를 위해 사용하는 임시 변수(추후 삭제 예정)
 #endif
 	short monster_type;
 	XMFLOAT3 Pos;
@@ -173,23 +204,66 @@ struct SC_SUMMON_MONSTER_PACKET {
 constexpr short SC_SUMMON_MONSTER_PACKET_SIZE = sizeof(SC_SUMMON_MONSTER_PACKET);
 
 struct SC_MOVE_MONSTER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	short	target_id;
 #ifdef _STRESS_TEST
-	short room_num; // stress test  ϴ ӽ (  )
+	short room_num; // stress test를 위해 사용하는 임시 변수(추후 삭제 예정)
 #endif
 	XMFLOAT3 Pos;
 	short HP;
 	bool is_alive;
 	XMFLOAT3 BulletPos;
-	unsigned short animation_track; // ִϸ̼ Ÿ
+	unsigned short animation_track; // 애니메이션 타입
 };
 constexpr short SC_MOVE_MONSTER_PACKET_SIZE = sizeof(SC_MOVE_MONSTER_PACKET);
 
+// SC_MOVE_MONSTERS 에 담기는 몬스터 하나의 상태
+struct MONSTER_SNAPSHOT {
+	short	id;
+	short	target_id;
+	XMFLOAT3 Pos;
+	short HP;
+	bool is_alive;
+	XMFLOAT3 BulletPos;
+	short animation_track; // 애니메이션 타입
+};
+// 패킷 하나에 담을 수 있는 몬스터 수 (길이 + 타입 + room_num + count 를 뺀 나머지, FRAME_VERSION 1 이면 7)
+constexpr int MAX_MONSTER_SNAPSHOT = (MAX_PACKET_SIZE - PACKET_HEADER_SIZE - 3) / sizeof(MONSTER_SNAPSHOT);
+
+// 방의 몬스터 중 지난 스냅샷 이후 상태가 바뀐 몬스터만 모아서 보내는 패킷
+// 실제 크기는 count 개의 monsters 까지만이다.
+struct SC_MOVE_MONSTERS_PACKET {
+	PACKET_SIZE size;
+	char	type;
+#ifdef _STRESS_TEST
+	short room_num; // stress test를 위해 사용하는 임시 변수(추후 삭제 예정)
+#endif
+	unsigned char count;
+	MONSTER_SNAPSHOT monsters[MAX_MONSTER_SNAPSHOT];
+};
+constexpr short SC_MOVE_MONSTERS_HEADER_SIZE = sizeof(SC_MOVE_MONSTERS_PACKET) - sizeof(MONSTER_SNAPSHOT) * MAX_MONSTER_SNAPSHOT;
+
+// 압축 인코딩(PacketCodec.h) 상태 패킷 - 헤더 뒤에 인코딩된 상태가 이어진다.
+struct SC_UPDATE_PLAYER_Q_HEADER {
+	PACKET_SIZE size;
+	char	type;
+	short	id;
+};
+
+// 헤더 뒤에 count 개의 [short id][인코딩된 몬스터 상태] 가 이어진다.
+struct SC_MOVE_MONSTERS_Q_HEADER {
+	PACKET_SIZE size;
+	char	type;
+#ifdef _STRESS_TEST
+	short room_num; // stress test를 위해 사용하는 임시 변수(추후 삭제 예정)
+#endif
+	unsigned char count;
+};
+
 struct SC_OPEN_DOOR_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	door_num;
 
@@ -197,21 +271,21 @@ struct SC_OPEN_DOOR_PACKET {
 constexpr short SC_OPEN_DOOR_PACKET_SIZE = sizeof(SC_OPEN_DOOR_PACKET);
 
 struct SC_LOGIN_COMPLETE_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	bool	success;
 };
 constexpr short SC_LOGIN_COMPLETE_PACKET_SIZE = sizeof(SC_LOGIN_COMPLETE_PACKET);
 
 struct SC_GAME_CLEAR_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 };
 constexpr short SC_GAME_CLEAR_PACKET_SIZE = sizeof(SC_GAME_CLEAR_PACKET);
 
 struct SC_INTERACTION_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	stage_id;
 	short	obj_id;
@@ -0,0 +1,1865 @@
+#pragma once
+// Benchmark.h
+// 서버 성능 측정 모음
+// Stats.h 의 _BENCHMARK 를 정의하고 빌드하면 main 이 서버를 띄운 뒤 Benchmark_Thread 를 실행하고,
+// 결과를 출력한 다음 종료한다.
+
+#include "MyThread.h"
+
+constexpr int BENCH_CLIENTS = 300;			// 접속할 클라이언트 수 (3의 배수 - 3인 1방)
+constexpr int BENCH_CLIENT_THREADS = 4;		// 클라이언트를 나눠 돌릴 스레드 수
+constexpr int BENCH_BURST = 4;				// 클라이언트가 한 번에 보내는 패킷 수
+constexpr int BENCH_RATE = 50;				// 클라이언트마다 초당 보내는 패킷 수
+constexpr auto BENCH_BURST_INTERVAL = milliseconds(1000 * BENCH_BURST / BENCH_RATE);
+constexpr auto BENCH_WARMUP = 1s;
+constexpr auto BENCH_DURATION = 5s;
+constexpr int POOL_BENCH_THREADS = 4;
+constexpr int POOL_BENCH_BATCH = 32;		// 한 번에 할당했다가 반환하는 객체 수 (송신 큐에 쌓이는 OVER_EXP)
+constexpr int POOL_BENCH_ROUNDS = 200000;
+constexpr int TIMER_BENCH_EVENTS = 180000;	// 3000 방 * 60 몬스터
+constexpr auto TIMER_BENCH_PERIOD = 100ms;	// 몬스터 업데이트 주기
+constexpr auto TIMER_BENCH_DURATION = 3s;
+constexpr int CODEC_BENCH_ROOMS = 100;		// 기록 파일이 없을 때 흉내 낼 방 수
+constexpr int CODEC_BENCH_SECONDS = 60;
+constexpr int CODEC_BENCH_PLAYER_RATE = 20;	// 플레이어 상태 방송 횟수 (초당)
+constexpr int FRAME_FUZZ_STREAMS = 2000;	// 퍼즈 테스트에 넣을 스트림 수 (종류별)
+constexpr int FRAME_FUZZ_PACKETS = 64;		// 스트림 하나에 담는 패킷 수
+constexpr size_t FRAME_BENCH_BYTES = 256ull << 20;	// 처리량 측정에 넣을 바이트 수
+constexpr int SLOT_BENCH_THREADS = 4;		// 동시에 accept 를 처리하는 워커 수
+constexpr int SLOT_BENCH_ROUNDS = 5;
+constexpr int ACTOR_BENCH_THREADS = 4;		// 패킷을 처리하는 워커 수 (작업 스레드 수도 같게 한다)
+constexpr int ACTOR_BENCH_ROOMS = 16;		// 부하가 몰리는 방 수
+constexpr int ACTOR_BENCH_OPS = 100000;		// 워커마다 처리하는 작업 수 (8개 중 1개는 방 틱)
+constexpr int ACCEPT_BENCH_THREADS = 8;		// 동시에 접속하는 클라이언트 스레드 수
+constexpr int ACCEPT_BENCH_WAVE = 3000;		// 한 번에 몰아서 맺는 연결 수 (MAX_USER 이하)
+constexpr int ACCEPT_BENCH_WAVES = 5;
+constexpr auto ACCEPT_BENCH_TIMEOUT = 10s;
+constexpr int PATH_BENCH_ROUNDS = 5;		// 스테이지 시작/목표 쌍 묶음을 반복하는 횟수
+constexpr int FLOW_BENCH_TICKS = 300;		// 흐름장 측정에서 돌리는 방 틱 수
+constexpr int GRID_BENCH_QUERIES = 2000000;	// 칸/선분 검사 측정에서 종류마다 던지는 질의 수
+constexpr float GRID_BENCH_SIGHT = 400.f;		// 긴 선분 길이 (몬스터 시야)
+constexpr int COLLIDE_BENCH_ROUNDS = 20000;	// 몬스터 충돌 측정에서 방의 몬스터가 모두 한 걸음씩 움직이는 횟수
+constexpr int MONSTER_BENCH_TICKS = 600;	// 몬스터 업데이트 측정에서 돌리는 방 틱 수 (100ms 틱으로 1분)
+constexpr float MONSTER_BENCH_RADIUS = 120.f;	// 측정용 플레이어가 도는 원의 반지름
+constexpr int TARGET_BENCH_ROUNDS = 100000;	// 목표 고르기만 따로 재는 횟수 (한 번에 방 전체)
+constexpr int DORMANT_BENCH_ROOMS[] = { 0, 100, 1000, 2900 };	// 플레이어가 모두 끊긴 채 몬스터가 남은 방 수
+constexpr auto DORMANT_BENCH_DURATION = 2s;
+constexpr int ROOM_BENCH_ROOMS[] = { 10, 100, MAX_ROOM };	// 차례로 늘려가며 만들어 둘 방 수
+constexpr const char* HPA_BENCH_FILE = "hpa_bench.bin";	// 계층 경로 그래프 저장/읽기를 재는 임시 파일
+
+/**
+ * @brief 측정을 끝내고 프로세스를 종료한다.
+ * I/O 워커와 작업 스레드가 아직 돌고 있으므로 전역 소멸자를 부르지 않는다.
+ * (exit 는 JOB_SCHEDULER 소멸자에서 작업 스레드를 join 하다가 멈춘다)
+ */
+inline void bench_exit(int code)
+{
+	cout.flush();
+	fflush(stdout);
+	quick_exit(code);
+}
+
+inline void bench_close(SOCKET s)
+{
+#ifdef _WIN32
+	closesocket(s);
+#else
+	close(s);
+#endif
+}
+
+inline void bench_set_nonblock(SOCKET s)
+{
+#ifdef _WIN32
+	u_long mode = 1;
+	ioctlsocket(s, FIONBIO, &mode);
+#else
+	fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+/**
+ * @brief 네트워크 백엔드(IOCP / epoll / io_uring) 처리량 측정
+ *
+ * 루프백으로 BENCH_CLIENTS 개의 클라이언트를 접속시켜 3인씩 게임을 시작시킨 뒤,
+ * 각 클라이언트가 초당 BENCH_RATE 개의 CS_ROTATE 를 보내면 방 인원 모두에게 SC_ROTATE_PLAYER 가 전송됩니다.
+ * 서버가 처리하는 것보다 빨리 보내면 방의 작업 큐와 송신 큐가 끝없이 늘어나므로 보내는 양을 고정하고,
+ * 같은 부하에서의 패킷 처리량, 시스템 콜 수, 코어당 처리량을 출력합니다.
+ * epoll 빌드와 _USE_IO_URING 빌드를 각각 실행하여 결과를 비교합니다.
+ */
+inline void Benchmark_Network()
+{
+	vector<SOCKET> sockets;
+	for (int i = 0; i < BENCH_CLIENTS; ++i) {
+		SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(PORT_NUM);
+		inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+		if (connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+			cout << "[BENCH] connect failed\n";
+			bench_close(s);
+			return;
+		}
+		sockets.push_back(s);
+		// 접속 순서대로 방이 배정되도록 accept 처리를 기다린다.
+		this_thread::sleep_for(1ms);
+	}
+	for (auto s : sockets) {
+		CS_LOGIN_PACKET p;
+		p.size = sizeof(p);
+		p.type = CS_LOGIN;
+		send(s, reinterpret_cast<char*>(&p), sizeof(p), 0);
+		bench_set_nonblock(s);
+	}
+
+	atomic_bool measuring = false;
+	atomic_bool running = true;
+	atomic<unsigned long long> sent_packets = 0;
+	atomic<unsigned long long> recv_bytes = 0;
+
+	vector<thread> client_threads;
+	for (int t = 0; t < BENCH_CLIENT_THREADS; ++t) {
+		client_threads.emplace_back([&, t]() {
+			CS_ROTATE_PACKET burst[BENCH_BURST];
+			for (auto& p : burst) {
+				p.size = sizeof(CS_ROTATE_PACKET);
+				p.type = CS_ROTATE;
+				p.cyDelta = 1.f;
+			}
+			char buf[4096];
+			unsigned long long local_sent = 0, local_recv = 0;
+			auto next_burst = high_resolution_clock::now();
+			while (running) {
+				auto now = high_resolution_clock::now();
+				bool send_burst = now >= next_burst;
+				if (send_burst) next_burst = max(next_burst + BENCH_BURST_INTERVAL, now);
+				for (int i = t; i < BENCH_CLIENTS; i += BENCH_CLIENT_THREADS) {
+					int ret = 0;
+					if (send_burst) {
+						ret = send(sockets[i], reinterpret_cast<char*>(burst), sizeof(burst), 0);
+						if (ret > 0) local_sent += ret / sizeof(CS_ROTATE_PACKET);
+					}
+					while (1) {
+						ret = recv(sockets[i], buf, sizeof(buf), 0);
+						if (ret <= 0) break;
+						local_recv += ret;
+					}
+				}
+				if (measuring) {
+					sent_packets += local_sent;
+					recv_bytes += local_recv;
+				}
+				local_sent = local_recv = 0;
+				if (false == send_burst) this_thread::sleep_for(1ms);
+			}
+			});
+	}
+
+	this_thread::sleep_for(BENCH_WARMUP);
+	SERVER_STATS begin;
+	auto snapshot = [](SERVER_STATS& st) {
+		st.recv_count = g_stats.recv_count.load();
+		st.send_count = g_stats.send_count.load();
+		st.send_bytes = g_stats.send_bytes.load();
+		st.packets_sent = g_stats.packets_sent.load();
+		st.io_syscalls = g_stats.io_syscalls.load();
+		st.busy_ns = g_stats.busy_ns.load();
+		for (int w = 0; w < g_job_scheduler.Workers(); ++w)
+			st.busy_ns += g_job_scheduler.Stats(w).busy_ns.load();
+		};
+	snapshot(begin);
+	measuring = true;
+	auto start_time = high_resolution_clock::now();
+	this_thread::sleep_for(BENCH_DURATION);
+	measuring = false;
+	SERVER_STATS end;
+	snapshot(end);
+	double seconds = duration_cast<microseconds>(high_resolution_clock::now() - start_time).count() / 1e6;
+	running = false;
+	for (auto& th : client_threads) th.join();
+	for (auto s : sockets) bench_close(s);
+
+	double packets_in = static_cast<double>(sent_packets.load());
+	double packets_out = static_cast<double>(recv_bytes.load()) / sizeof(SC_ROTATE_PLAYER_PACKET);
+	double syscalls = static_cast<double>(end.io_syscalls - begin.io_syscalls);
+	double busy_cores = (end.busy_ns - begin.busy_ns) / 1e9 / seconds;
+	printf("[BENCH] network (%s) - %d clients, %.1fs\n", IO_BACKEND_NAME, BENCH_CLIENTS, seconds);
+	printf("  packets in  : %.0f/s\n", packets_in / seconds);
+	printf("  packets out : %.0f/s\n", packets_out / seconds);
+	printf("  recv / send completions : %.0f/s / %.0f/s\n",
+		(end.recv_count - begin.recv_count) / seconds, (end.send_count - begin.send_count) / seconds);
+	double sends = static_cast<double>(end.send_count - begin.send_count);
+	printf("  coalescing  : %.2f packets/send, %.1f bytes/send\n",
+		(end.packets_sent - begin.packets_sent) / max(1.0, sends), (end.send_bytes - begin.send_bytes) / max(1.0, sends));
+	printf("  syscalls    : %.0f/s (%.3f per packet)\n", syscalls / seconds, syscalls / max(1.0, packets_in + packets_out));
+	printf("  busy cores  : %.2f -> %.0f packets/s per core\n", busy_cores,
+		(busy_cores > 0.0) ? (packets_in + packets_out) / seconds / busy_cores : 0.0);
+}
+
+// POOL_BENCH_THREADS 개의 스레드가 할당/반환을 반복하여 초당 처리 횟수(할당 + 반환)를 돌려준다.
+template<class ALLOC, class FREE>
+inline double bench_pool_run(ALLOC alloc, FREE release)
+{
+	auto start_time = high_resolution_clock::now();
+	vector<thread> threads;
+	for (int t = 0; t < POOL_BENCH_THREADS; ++t) {
+		threads.emplace_back([&]() {
+			OVER_EXP_BLOCK* blocks[POOL_BENCH_BATCH];
+			for (int r = 0; r < POOL_BENCH_ROUNDS; ++r) {
+				for (auto& b : blocks) {
+					b = alloc();
+					b->_data[0] = static_cast<char>(r);
+				}
+				for (auto& b : blocks) release(b);
+			}
+			});
+	}
+	for (auto& th : threads) th.join();
+	double seconds = duration_cast<microseconds>(high_resolution_clock::now() - start_time).count() / 1e6;
+	return 2.0 * POOL_BENCH_THREADS * POOL_BENCH_ROUNDS * POOL_BENCH_BATCH / seconds;
+}
+
+/**
+ * @brief OVER_EXP 할당 방식 비교 (new/delete, concurrent_queue 풀, 매거진 풀)
+ */
+inline void Benchmark_Pool()
+{
+	double new_delete = bench_pool_run([]() { return new OVER_EXP_BLOCK(); }, [](OVER_EXP_BLOCK* b) { delete b; });
+	double queue_pool = 0.0, magazine_pool = 0.0;
+	{
+		CQueueObjectPool<OVER_EXP_BLOCK> pool(4096);
+		queue_pool = bench_pool_run([&]() { return pool.GetMemory(); }, [&](OVER_EXP_BLOCK* b) { pool.ReturnMemory(b); });
+	}
+	{
+		CObjectPool<OVER_EXP_BLOCK> pool(4096);
+		magazine_pool = bench_pool_run([&]() { return pool.GetMemory(); }, [&](OVER_EXP_BLOCK* b) { pool.ReturnMemory(b); });
+		pool.PrintStats("magazine");
+	}
+	printf("[BENCH] OVER_EXP allocation - %d threads, batch %d\n", POOL_BENCH_THREADS, POOL_BENCH_BATCH);
+	printf("  new/delete       : %.1f Mops/s\n", new_delete / 1e6);
+	printf("  concurrent_queue : %.1f Mops/s\n", queue_pool / 1e6);
+	printf("  magazine         : %.1f Mops/s\n", magazine_pool / 1e6);
+}
+
+// 현재 스레드가 사용한 CPU 시간 (초)
+inline double bench_thread_cpu_seconds()
+{
+#ifdef _WIN32
+	FILETIME creation_time, exit_time, kernel_time, user_time;
+	GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time);
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel_time.dwLowDateTime;
+	k.HighPart = kernel_time.dwHighDateTime;
+	u.LowPart = user_time.dwLowDateTime;
+	u.HighPart = user_time.dwHighDateTime;
+	return (k.QuadPart + u.QuadPart) / 1e7;
+#else
+	timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+// 타이머 이벤트의 지연(실제 처리 시각 - wakeup_time) 분포 (0.01ms 단위, 100ms 이상은 마지막 칸)
+struct LATENCY_HISTOGRAM {
+	vector<unsigned long long> bins = vector<unsigned long long>(10001, 0);
+	unsigned long long count = 0;
+	double sum_ms = 0.0;
+	double max_ms = 0.0;
+
+	void Add(double ms)
+	{
+		if (ms < 0.0) ms = 0.0;
+		bins[min(static_cast<size_t>(ms * 100.0), bins.size() - 1)]++;
+		count++;
+		sum_ms += ms;
+		if (ms > max_ms) max_ms = ms;
+	}
+	double Percentile(double p) const
+	{
+		unsigned long long target = static_cast<unsigned long long>(count * p);
+		unsigned long long acc = 0;
+		for (size_t i = 0; i < bins.size(); ++i) {
+			acc += bins[i];
+			if (acc > target) return i / 100.0;
+		}
+		return max_ms;
+	}
+	void Print(const char* name, double cpu_seconds, double seconds) const
+	{
+		printf("  %-12s: lateness avg %.3fms p99 %.3fms max %.3fms | timer cpu %.1f%% | %.0f events/s\n",
+			name, count ? sum_ms / count : 0.0, Percentile(0.99), max_ms,
+			cpu_seconds / seconds * 100.0, count / seconds);
+	}
+};
+
+// 측정에 쓸 이벤트 - 시작 후 100ms 안에 고르게 흩어 놓는다.
+inline TIMER_EVENT bench_timer_event(int i, high_resolution_clock::time_point start_time)
+{
+	return TIMER_EVENT{ i / MONSTER_PER_STAGE, i % MONSTER_PER_STAGE,
+		start_time + microseconds((static_cast<long long>(i) * 7919) % 100000), EV_ROOM_TICK };
+}
+
+/**
+ * @brief 타이머 지연과 CPU 사용량 비교 (기존 우선순위 큐 폴링 / 타이밍 휠)
+ *
+ * TIMER_BENCH_EVENTS 개의 몬스터 업데이트가 100ms 마다 다시 예약되는 상황을 흉내 내어
+ * 예약 시각 대비 처리 지연과 타이머 스레드의 CPU 사용률을 출력합니다.
+ */
+inline void Benchmark_Timer()
+{
+	printf("[BENCH] timer - %d events every %lldms\n", TIMER_BENCH_EVENTS,
+		static_cast<long long>(duration_cast<milliseconds>(TIMER_BENCH_PERIOD).count()));
+	{
+		// 기존 Timer_Thread 방식 : 만료되지 않았으면 다시 넣고 1ms 쉰다.
+		concurrent_priority_queue<TIMER_EVENT> queue;
+		LATENCY_HISTOGRAM hist;
+		double cpu = 0.0;
+		auto start_time = high_resolution_clock::now();
+		for (int i = 0; i < TIMER_BENCH_EVENTS; ++i) queue.push(bench_timer_event(i, start_time));
+		thread th([&]() {
+			double cpu_begin = bench_thread_cpu_seconds();
+			while (high_resolution_clock::now() < start_time + TIMER_BENCH_DURATION) {
+				TIMER_EVENT ev;
+				auto current_time = high_resolution_clock::now();
+				if (queue.try_pop(ev)) {
+					if (ev.wakeup_time > current_time) {
+						queue.push(ev);
+						this_thread::sleep_for(1ms);
+						continue;
+					}
+					hist.Add(duration<double, milli>(current_time - ev.wakeup_time).count());
+					ev.wakeup_time += TIMER_BENCH_PERIOD;
+					queue.push(ev);
+				}
+				else this_thread::sleep_for(1ms);
+			}
+			cpu = bench_thread_cpu_seconds() - cpu_begin;
+			});
+		th.join();
+		hist.Print("polling pq", cpu, duration<double>(TIMER_BENCH_DURATION).count());
+	}
+	{
+		TimingWheel<TIMER_EVENT> wheel;
+		LATENCY_HISTOGRAM hist;
+		double cpu = 0.0;
+		auto start_time = high_resolution_clock::now();
+		for (int i = 0; i < TIMER_BENCH_EVENTS; ++i) wheel.Add(bench_timer_event(i, start_time));
+		thread th([&]() {
+			double cpu_begin = bench_thread_cpu_seconds();
+			vector<TIMER_EVENT> expired;
+			while (high_resolution_clock::now() < start_time + TIMER_BENCH_DURATION) {
+				wheel.WaitExpired(expired);
+				auto current_time = high_resolution_clock::now();
+				for (auto& ev : expired) {
+					hist.Add(duration<double, milli>(current_time - ev.wakeup_time).count());
+					ev.wakeup_time += TIMER_BENCH_PERIOD;
+					wheel.Add(ev);
+				}
+				expired.clear();
+			}
+			cpu = bench_thread_cpu_seconds() - cpu_begin;
+			});
+		th.join();
+		hist.Print("timing wheel", cpu, duration<double>(TIMER_BENCH_DURATION).count());
+	}
+}
+
+// 기록 파일이 없을 때 쓸 기록을 만든다. 방마다 플레이어 3명과 1스테이지 몬스터 10마리가 움직이는 상황을 흉내 낸다.
+inline void bench_make_state_record(vector<STATE_RECORD>& records)
+{
+	mt19937 gen(7);
+	uniform_real_distribution<float> unit(0.f, 1.f);
+	struct BENCH_PLAYER { PLAYER_STATE s; float turn_timer; };
+	struct BENCH_MONSTER { MONSTER_SNAPSHOT s; XMFLOAT3 dir; float state_timer; float bullet_timer; };
+	vector<BENCH_PLAYER> players(CODEC_BENCH_ROOMS * MAX_USER_PER_ROOM);
+	vector<BENCH_MONSTER> mons(CODEC_BENCH_ROOMS * MONSTER_PER_STAGE);
+	for (size_t i = 0; i < players.size(); ++i)
+		players[i] = BENCH_PLAYER{ PLAYER_STATE{ 5000.f, XMFLOAT3(300.f + 50.f * (i % 3), -63.f, 600.f), 0, XMFLOAT3(0, 0, 0), 0 }, 0.f };
+	for (size_t i = 0; i < mons.size(); ++i) {
+		MONSTER_SNAPSHOT m{ static_cast<short>(i % MONSTER_PER_STAGE), -1, XMFLOAT3(130.f + 420.f * unit(gen), -63.f, 1300.f + 1200.f * unit(gen)),
+			250, true, XMFLOAT3(5000, 5000, 5000), 0 };
+		mons[i] = BENCH_MONSTER{ m, XMFLOAT3(0, 0, 0), 0.f, 0.f };
+	}
+
+	STATE_RECORD r;
+	const int player_step_ms = 1000 / CODEC_BENCH_PLAYER_RATE;
+	const int monster_step_ms = 1000 / ROOM_TICK_RATE;
+	for (int t = 0; t < CODEC_BENCH_SECONDS * 1000; t += player_step_ms) {
+		float dt = player_step_ms / 1000.f;
+		for (size_t i = 0; i < players.size(); ++i) {
+			PLAYER_STATE& s = players[i].s;
+			players[i].turn_timer -= dt;
+			if (players[i].turn_timer <= 0.f) {
+				// 1~2초마다 멈추거나 다른 방향으로 달린다.
+				players[i].turn_timer = 1.f + unit(gen);
+				float angle = unit(gen) * 6.2832f;
+				float speed = (unit(gen) < 0.3f) ? 0.f : 100.f;
+				s.vel = XMFLOAT3(cosf(angle) * speed, 0.f, sinf(angle) * speed);
+				s.direction = (speed > 0.f) ? (1u << static_cast<int>(unit(gen) * 4)) : 0;
+			}
+			s.Pos.x = clamp(s.Pos.x + s.vel.x * dt, 0.f, static_cast<float>(MAP_X_SIZE));
+			s.Pos.z = clamp(s.Pos.z + s.vel.z * dt, 0.f, static_cast<float>(MAP_Z_SIZE));
+			if (unit(gen) < 0.002f) s.HP -= 60.f;
+			s.move_time = t;
+			r.time_ms = t;
+			r.kind = SR_PLAYER;
+			r.room_num = static_cast<short>(i / MAX_USER_PER_ROOM);
+			r.id = static_cast<short>(i);
+			r.player = s;
+			records.push_back(r);
+		}
+		if (t % monster_step_ms != 0) continue;
+		dt = monster_step_ms / 1000.f;
+		for (size_t i = 0; i < mons.size(); ++i) {
+			BENCH_MONSTER& m = mons[i];
+			m.state_timer -= dt;
+			if (m.state_timer <= 0.f) {
+				// 2~4초마다 제자리(Idle), 이동(Wander/Chase), 공격을 바꾼다.
+				m.state_timer = 2.f + 2.f * unit(gen);
+				float pick = unit(gen);
+				m.s.animation_track = (pick < 0.4f) ? 0 : (pick < 0.8f) ? 1 : 2;
+				float angle = unit(gen) * 6.2832f;
+				m.dir = (m.s.animation_track == 1) ? XMFLOAT3(cosf(angle), 0.f, sinf(angle)) : XMFLOAT3(0, 0, 0);
+				m.s.target_id = (m.s.animation_track == 0) ? -1 : static_cast<short>((i / MONSTER_PER_STAGE) * MAX_USER_PER_ROOM);
+				if (m.s.animation_track == 2 && m.s.id >= 7) {
+					// 마술사는 공격할 때 모자를 던진다.
+					m.s.BulletPos = Vector3::Add(m.s.Pos, XMFLOAT3(0, 10, 0));
+					m.bullet_timer = 2.f;
+				}
+			}
+			m.s.Pos.x = clamp(m.s.Pos.x + m.dir.x * 24.f * dt, 0.f, static_cast<float>(MAP_X_SIZE));
+			m.s.Pos.z = clamp(m.s.Pos.z + m.dir.z * 24.f * dt, 0.f, static_cast<float>(MAP_Z_SIZE));
+			if (m.bullet_timer > 0.f) {
+				m.bullet_timer -= dt;
+				m.s.BulletPos.z += 100.f * dt;
+				if (m.bullet_timer <= 0.f) m.s.BulletPos = XMFLOAT3(5000, 5000, 5000);
+			}
+			if (unit(gen) < 0.005f) m.s.HP -= 10;
+			r.time_ms = t;
+			r.kind = SR_MONSTER;
+			r.room_num = static_cast<short>(i / MONSTER_PER_STAGE);
+			r.id = m.s.id;
+			r.monster = m.s;
+			records.push_back(r);
+		}
+	}
+}
+
+// 인코딩 방식 하나의 누적 결과 (방 하나의 플레이어 한 명이 받는 양)
+struct CODEC_BENCH_RESULT {
+	unsigned long long packets = 0;
+	unsigned long long bytes = 0;
+	void Add(unsigned long long p, unsigned long long b) { packets += p; bytes += b; }
+	void Print(const char* name, double room_seconds) const
+	{
+		printf("  %-16s: %7.1f packets/s %8.2f KB/s per client | %.1f bytes/packet\n", name,
+			packets / room_seconds, bytes / room_seconds / 1024.0, packets ? static_cast<double>(bytes) / packets : 0.0);
+	}
+};
+
+/**
+ * @brief 기록된 상태를 재생하여 인코딩 방식별 대역폭 비교 (몬스터마다 패킷 / SC_MOVE_MONSTERS / 압축 인코딩)
+ *
+ * _RECORD_STATE 로 남긴 STATE_RECORD_FILE 이 있으면 그 기록을, 없으면 bench_make_state_record 로 만든 기록을 재생합니다.
+ * 압축 인코딩은 디코더로 다시 풀어서 위치 오차도 함께 확인합니다.
+ */
+inline void Benchmark_Codec()
+{
+	vector<STATE_RECORD> records;
+	bool recorded = Load_State_Record(STATE_RECORD_FILE, records);
+	if (false == recorded) bench_make_state_record(records);
+	if (records.empty()) return;
+
+	CODEC_BENCH_RESULT per_monster, batched, compact;
+	unordered_map<int, PLAYER_BASELINE> player_enc;
+	unordered_map<int, MONSTER_SNAPSHOT> monster_sent;
+	unordered_map<int, MONSTER_BASELINE> monster_enc;
+	unordered_map<int, STATE_DECODER> decoders;		// 방마다 수신 측 디코더
+	unordered_set<int> rooms;
+	float max_error = 0.f;
+	auto pos_error = [](const XMFLOAT3& a, const XMFLOAT3& b) {
+		return max(fabsf(a.x - b.x), max(fabsf(a.y - b.y), fabsf(a.z - b.z)));
+	};
+
+	for (size_t i = 0; i < records.size();) {
+		const STATE_RECORD& r = records[i];
+		rooms.insert(r.room_num);
+		if (r.kind == SR_PLAYER) {
+			per_monster.Add(1, sizeof(SC_UPDATE_PLAYER_PACKET));
+			batched.Add(1, sizeof(SC_UPDATE_PLAYER_PACKET));
+			unsigned char packet[MAX_PACKET_SIZE];
+			SC_UPDATE_PLAYER_Q_HEADER header;
+			int len = Encode_Player_State(packet + sizeof(header), MAX_PACKET_SIZE - sizeof(header), player_enc[r.id], r.player);
+			if (len > 0) {
+				header.size = static_cast<PACKET_SIZE>(sizeof(header) + len);
+				header.type = SC_UPDATE_PLAYER_Q;
+				header.id = r.id;
+				memcpy(packet, &header, sizeof(header));
+				compact.Add(1, header.size);
+				short id;
+				PLAYER_STATE decoded;
+				if (Decode_Player_Update(packet, decoders[r.room_num], id, decoded))
+					max_error = max(max_error, pos_error(decoded.Pos, r.player.Pos));
+			}
+			++i;
+			continue;
+		}
+
+		// 같은 방의 같은 틱에 기록된 몬스터를 한 번에 처리한다.
+		size_t end = i;
+		while (end < records.size() && records[end].kind == SR_MONSTER
+			&& records[end].room_num == r.room_num && records[end].time_ms == r.time_ms) ++end;
+
+		int changed = 0;
+		unsigned char packet[MAX_PACKET_SIZE];
+		int len = sizeof(SC_MOVE_MONSTERS_Q_HEADER);
+		int count = 0;
+		auto flush = [&]() {
+			if (count == 0) return;
+			SC_MOVE_MONSTERS_Q_HEADER header;
+			header.size = static_cast<PACKET_SIZE>(len);
+			header.type = SC_MOVE_MONSTERS_Q;
+#ifdef _STRESS_TEST
+			header.room_num = r.room_num;
+#endif
+			header.count = static_cast<unsigned char>(count);
+			memcpy(packet, &header, sizeof(header));
+			compact.Add(1, len);
+			Decode_Monster_Updates(packet, decoders[r.room_num], [&](const MONSTER_SNAPSHOT& m) {
+				for (size_t j = i; j < end; ++j) {
+					if (records[j].id != m.id) continue;
+					max_error = max(max_error, pos_error(m.Pos, records[j].monster.Pos));
+					max_error = max(max_error, pos_error(m.BulletPos, records[j].monster.BulletPos));
+				}
+				});
+			len = sizeof(SC_MOVE_MONSTERS_Q_HEADER);
+			count = 0;
+		};
+		for (size_t j = i; j < end; ++j) {
+			const MONSTER_SNAPSHOT& m = records[j].monster;
+			int key = r.room_num * MONSTER_PER_STAGE * STAGE_NUMBERS + m.id;
+			per_monster.Add(1, sizeof(SC_MOVE_MONSTER_PACKET));
+
+			auto sent = monster_sent.find(key);
+			if (sent == monster_sent.end() || 0 != memcmp(&sent->second, &m, sizeof(MONSTER_SNAPSHOT))) {
+				monster_sent[key] = m;
+				changed++;
+			}
+
+			unsigned char entry[MAX_PACKET_SIZE];
+			memcpy(entry, &m.id, sizeof(short));
+			int entry_len = Encode_Monster_State(entry + sizeof(short), MAX_PACKET_SIZE - sizeof(short) - sizeof(SC_MOVE_MONSTERS_Q_HEADER), monster_enc[key], m);
+			if (entry_len <= 0) continue;
+			entry_len += sizeof(short);
+			if (len + entry_len > MAX_PACKET_SIZE) flush();
+			memcpy(packet + len, entry, entry_len);
+			len += entry_len;
+			count++;
+		}
+		flush();
+		int batch_packets = (changed + MAX_MONSTER_SNAPSHOT - 1) / MAX_MONSTER_SNAPSHOT;
+		batched.Add(batch_packets, batch_packets * SC_MOVE_MONSTERS_HEADER_SIZE + changed * sizeof(MONSTER_SNAPSHOT));
+		i = end;
+	}
+
+	double seconds = (records.back().time_ms - records.front().time_ms) / 1000.0 + 0.1;
+	double room_seconds = seconds * rooms.size();
+	printf("[BENCH] state encoding - %s, %zu records, %zu rooms, %.1fs\n",
+		recorded ? STATE_RECORD_FILE : "synthetic", records.size(), rooms.size(), seconds);
+	per_monster.Print("SC_MOVE_MONSTER", room_seconds);
+	batched.Print("SC_MOVE_MONSTERS", room_seconds);
+	compact.Print("compact", room_seconds);
+	printf("  compact / batched bytes : %.1f%% | max position error %.3f\n",
+		batched.bytes ? 100.0 * compact.bytes / batched.bytes : 0.0, max_error);
+}
+
+// 패킷 내용 확인용 해시 (FNV-1a)
+inline uint32_t bench_hash(const char* data, int len)
+{
+	uint32_t h = 2166136261u;
+	for (int i = 0; i < len; ++i) h = (h ^ static_cast<unsigned char>(data[i])) * 16777619u;
+	return h;
+}
+
+/**
+ * @brief stream 을 recv 처럼 무작위 크기로 잘라 링에 넣고 Dispatch_Packets 로 꺼낸다.
+ * @return 링이 잘못된 길이를 만나 연결을 끊어야 하면 false
+ */
+template <class HANDLER>
+inline bool bench_feed_stream(const vector<char>& stream, mt19937& gen, HANDLER&& handler, bool& stalled)
+{
+	RECV_RING ring;
+	stalled = false;
+	size_t offset = 0;
+	while (offset < stream.size()) {
+		unsigned space = 0;
+		char* dst = ring.Write_Space(space);
+		if (space == 0) {
+			// 덜 온 패킷이 링을 다 채움 - 길이 검사가 있으면 일어나지 않는다
+			stalled = true;
+			return false;
+		}
+		unsigned len = uniform_int_distribution<unsigned>(1, space)(gen);
+		len = static_cast<unsigned>(min<size_t>(len, stream.size() - offset));
+		memcpy(dst, stream.data() + offset, len);
+		offset += len;
+		ring.Commit(len);
+		if (false == Dispatch_Packets(ring, handler)) return false;
+	}
+	return ring.Size() == 0;
+}
+
+/**
+ * @brief 수신 프레이밍(RECV_RING + Dispatch_Packets)의 퍼즈 테스트와 처리량 측정
+ *
+ * 1. 올바른 패킷 스트림을 무작위로 잘라 넣어 모든 패킷이 순서대로, 내용 그대로 나오는지 확인합니다.
+ * 2. 올바른 스트림의 바이트를 무작위로 바꾸거나 완전히 무작위인 스트림을 넣어,
+ *    잘못된 길이를 거부하고 handler 에 넘긴 패킷의 길이가 항상 범위 안인지 확인합니다.
+ * 3. 일반적인 입력 패킷 스트림을 BUF_SIZE 단위로 넣어 파서 처리량(MB/s)을 측정합니다.
+ *    모든 패킷을 복사하던 이전 방식과, 링 끝에 걸친 패킷만 복사하는 지금 방식을 비교합니다.
+ * 1, 2 의 확인이 하나라도 틀리면 결과를 출력한 뒤 bench_exit(1) 로 끝냅니다.
+ * 네트워크 백엔드와 상관없는 코드이므로 Linux 빌드에서도 그대로 실행됩니다.
+ */
+inline void Benchmark_Framing()
+{
+	mt19937 gen(11);
+	uniform_int_distribution<int> size_dist(PACKET_HEADER_SIZE, MAX_PACKET_SIZE);
+	uniform_int_distribution<int> byte_dist(0, 255);
+	auto make_stream = [&](vector<char>& stream, vector<pair<int, uint32_t>>& expected) {
+		stream.clear();
+		expected.clear();
+		for (int i = 0; i < FRAME_FUZZ_PACKETS; ++i) {
+			// 작은 패킷 위주로, 가끔 큰 묶음 패킷을 섞는다.
+			int size = (i % 8 == 0) ? size_dist(gen) : PACKET_HEADER_SIZE + byte_dist(gen) % 48;
+			size_t begin = stream.size();
+			stream.resize(begin + size);
+			PACKET_SIZE field = static_cast<PACKET_SIZE>(size);
+			memcpy(stream.data() + begin, &field, sizeof(field));
+			for (int b = sizeof(field); b < size; ++b) stream[begin + b] = static_cast<char>(byte_dist(gen));
+			expected.emplace_back(size, bench_hash(stream.data() + begin, size));
+		}
+		};
+
+	vector<char> stream;
+	vector<pair<int, uint32_t>> expected;
+	int valid_errors = 0;
+	for (int round = 0; round < FRAME_FUZZ_STREAMS; ++round) {
+		make_stream(stream, expected);
+		size_t next = 0;
+		bool stalled = false;
+		bool ok = bench_feed_stream(stream, gen, [&](char* packet, int size) {
+			if (next >= expected.size() || expected[next].first != size || expected[next].second != bench_hash(packet, size))
+				valid_errors++;
+			next++;
+			}, stalled);
+		if (false == ok || next != expected.size()) valid_errors++;
+	}
+
+	int mutated_rejected = 0, random_rejected = 0, bad_size = 0, stalls = 0;
+	for (int round = 0; round < FRAME_FUZZ_STREAMS * 2; ++round) {
+		bool random_stream = (round % 2 == 1);
+		if (random_stream) {
+			stream.resize(FRAME_FUZZ_PACKETS * 32);
+			for (auto& c : stream) c = static_cast<char>(byte_dist(gen));
+		}
+		else {
+			make_stream(stream, expected);
+			for (int flip = 0; flip < 4; ++flip)
+				stream[uniform_int_distribution<size_t>(0, stream.size() - 1)(gen)] = static_cast<char>(byte_dist(gen));
+		}
+		bool stalled = false;
+		bool ok = bench_feed_stream(stream, gen, [&](char* packet, int size) {
+			if (size < PACKET_HEADER_SIZE || size > MAX_PACKET_SIZE || size != Get_Packet_Size(packet)) bad_size++;
+			}, stalled);
+		if (stalled) stalls++;
+		if (false == ok) (random_stream ? random_rejected : mutated_rejected)++;
+	}
+
+	// 처리량 - 클라이언트가 보내는 입력 패킷 스트림
+	vector<char> traffic;
+	auto push_packet = [&](auto p) {
+		p.size = sizeof(p);
+		const char* bytes = reinterpret_cast<const char*>(&p);
+		traffic.insert(traffic.end(), bytes, bytes + sizeof(p));
+		};
+	while (traffic.size() < (1 << 20)) {
+		CS_HEARTBEAT_PACKET heartbeat{};
+		heartbeat.type = CS_HEARTBEAT;
+		push_packet(heartbeat);
+		CS_ROTATE_PACKET rotate{};
+		rotate.type = CS_ROTATE;
+		push_packet(rotate);
+		CS_ATTACK_PACKET attack{};
+		attack.type = CS_ATTACK;
+		push_packet(attack);
+	}
+	// copy_all 이면 모든 패킷을 임시 버퍼에 복사해서 넘기는 이전 방식으로 처리한다.
+	auto run_parser = [&](bool copy_all, double& mb_per_sec, double& straddle_ratio) {
+		RECV_RING ring;
+		unsigned long long packets = 0, copied = 0, type_sum = 0;
+		size_t fed = 0, offset = 0;
+		auto handler = [&](char* packet, int) {
+			packets++;
+			type_sum += Get_Packet_Type(packet);
+			const char* ring_begin = reinterpret_cast<const char*>(&ring);
+			if (packet < ring_begin || packet >= ring_begin + sizeof(ring)) copied++;
+			};
+		auto start_time = high_resolution_clock::now();
+		while (fed < FRAME_BENCH_BYTES) {
+			unsigned space = 0;
+			char* dst = ring.Write_Space(space);
+			unsigned len = static_cast<unsigned>(min<size_t>(min<unsigned>(space, BUF_SIZE), traffic.size() - offset));
+			memcpy(dst, traffic.data() + offset, len);
+			ring.Commit(len);
+			offset = (offset + len) % traffic.size();
+			fed += len;
+			if (copy_all) {
+				char packet[MAX_PACKET_SIZE];
+				while (ring.Size() >= sizeof(PACKET_SIZE)) {
+					PACKET_SIZE size;
+					ring.View(sizeof(size)).CopyTo(&size);
+					if (ring.Size() < size) break;
+					ring.View(size).CopyTo(packet);
+					ring.Consume(size);
+					handler(packet, size);
+				}
+			}
+			else Dispatch_Packets(ring, handler);
+		}
+		double seconds = duration_cast<microseconds>(high_resolution_clock::now() - start_time).count() / 1e6;
+		mb_per_sec = fed / 1048576.0 / seconds;
+		straddle_ratio = packets ? static_cast<double>(copied) / packets : 0.0;
+		return type_sum;
+		};
+	double copy_mb = 0.0, inplace_mb = 0.0, copy_ratio = 0.0, straddle_ratio = 0.0;
+	unsigned long long checksum = run_parser(true, copy_mb, copy_ratio);
+	checksum += run_parser(false, inplace_mb, straddle_ratio);
+
+	printf("[BENCH] framing (FRAME_VERSION %d, max packet %d bytes, ring %u bytes)\n", FRAME_VERSION, MAX_PACKET_SIZE, RECV_RING_SIZE);
+	printf("  valid streams   : %d x %d packets, %d errors\n", FRAME_FUZZ_STREAMS, FRAME_FUZZ_PACKETS, valid_errors);
+	printf("  mutated streams : %d, rejected %d\n", FRAME_FUZZ_STREAMS, mutated_rejected);
+	printf("  random streams  : %d, rejected %d\n", FRAME_FUZZ_STREAMS, random_rejected);
+	printf("  bad packet size : %d, ring stalls : %d\n", bad_size, stalls);
+	printf("  parse (copy all): %.0f MB/s\n", copy_mb);
+	printf("  parse (in place): %.0f MB/s, %.2f%% packets copied at the wrap point (checksum %llu)\n",
+		inplace_mb, straddle_ratio * 100.0, checksum % 10);
+
+	// 올바른 스트림이 그대로 나오지 않거나, 범위 밖 길이가 handler 로 넘어가거나, 링이 막히면 실패
+	if (valid_errors != 0 || bad_size != 0 || stalls != 0) {
+		printf("[BENCH] framing FAILED - %d valid stream errors, %d bad packet sizes, %d ring stalls\n", valid_errors, bad_size, stalls);
+		bench_exit(1);
+	}
+}
+
+struct BENCH_SLOT {
+	atomic<S_STATE> _state{ ST_FREE };
+};
+using BENCH_SLOTS = array<array<BENCH_SLOT, MAX_USER_PER_ROOM>, MAX_ROOM>;
+
+// 예전 get_new_client_id - 앞에서부터 ST_FREE 인 자리를 찾고, accept 에서 따로 ST_ALLOC 으로 바꾼다.
+inline int bench_scan_alloc(BENCH_SLOTS& slots)
+{
+	for (int i = 0; i < MAX_ROOM; ++i) {
+		for (int j = 0; j < MAX_USER_PER_ROOM; ++j) {
+			if (slots[i][j]._state.load() == ST_FREE) {
+				slots[i][j]._state.store(ST_ALLOC);
+				return i * MAX_USER_PER_ROOM + j;
+			}
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief 접속이 몰릴 때의 세션 자리 할당을 비교한다.
+ *
+ * SLOT_BENCH_THREADS 개의 스레드가 빈 자리가 없을 때까지 자리를 받아서 (STRESS_TEST 의 접속 증가 구간)
+ * 예전 선형 탐색과 SLOT_ALLOCATOR 의 초당 할당 수와 같은 자리를 두 번 준 횟수를 비교합니다.
+ * 이어서 짝수 방을 비우고 다시 채워서 비운 방만 재사용되는지 확인합니다.
+ */
+inline void Benchmark_Slots()
+{
+	auto slots = make_unique<BENCH_SLOTS>();
+	auto claims = make_unique<array<atomic<int>, MAX_USER>>();
+	auto reset = [&]() {
+		for (auto& room : *slots)
+			for (auto& slot : room) slot._state.store(ST_FREE);
+		for (auto& c : *claims) c.store(0);
+		};
+	// 자리가 없을 때까지 받는다. 걸린 시간(초), 받은 수, 중복 수를 돌려준다.
+	auto ramp = [&](auto&& alloc, double& seconds, int& allocated, int& duplicated) {
+		atomic<int> total = 0, dup = 0;
+		auto start_time = high_resolution_clock::now();
+		vector<thread> threads;
+		for (int t = 0; t < SLOT_BENCH_THREADS; ++t) {
+			threads.emplace_back([&]() {
+				int id;
+				while ((id = alloc()) != -1) {
+					total++;
+					if ((*claims)[id].fetch_add(1) != 0) dup++;
+				}
+				});
+		}
+		for (auto& th : threads) th.join();
+		seconds = duration_cast<microseconds>(high_resolution_clock::now() - start_time).count() / 1e6;
+		allocated = total.load();
+		duplicated = dup.load();
+		};
+
+	double scan_seconds = 0.0, alloc_seconds = 0.0;
+	int scan_dup = 0, alloc_dup = 0, scan_count = 0, alloc_count = 0;
+	unsigned long long retries = 0;
+	int reuse_count = 0, reuse_wrong = 0;
+	for (int round = 0; round < SLOT_BENCH_ROUNDS; ++round) {
+		double seconds;
+		int allocated, duplicated;
+		reset();
+		ramp([&]() { return bench_scan_alloc(*slots); }, seconds, allocated, duplicated);
+		scan_seconds += seconds;
+		scan_count += allocated;
+		scan_dup += duplicated;
+
+		reset();
+		auto allocator = make_unique<SLOT_ALLOCATOR<BENCH_SLOTS>>(*slots);
+		ramp([&]() { return allocator->Allocate(); }, seconds, allocated, duplicated);
+		alloc_seconds += seconds;
+		alloc_count += allocated;
+		alloc_dup += duplicated;
+
+		// disconnect 가 짝수 방을 비운 것처럼 돌려주고 다시 채운다.
+		for (int i = 0; i < MAX_ROOM; i += 2) {
+			for (auto& slot : (*slots)[i]) slot._state.store(ST_FREE);
+			allocator->Release_Room(i);
+		}
+		int id;
+		while ((id = allocator->Allocate()) != -1) {
+			reuse_count++;
+			if ((id / MAX_USER_PER_ROOM) % 2 != 0) reuse_wrong++;
+		}
+		retries += allocator->Retries();
+	}
+
+	printf("[BENCH] session slot allocation - %d threads, %d slots, %d rounds\n", SLOT_BENCH_THREADS, MAX_USER, SLOT_BENCH_ROUNDS);
+	printf("  linear scan    : %.0f accepts/s, %d duplicated slots\n", scan_count / scan_seconds, scan_dup);
+	printf("  slot allocator : %.0f accepts/s, %d duplicated slots, %llu CAS retries\n", alloc_count / alloc_seconds, alloc_dup, retries);
+	printf("  reuse          : %d slots from released rooms (expected %d), %d from busy rooms\n",
+		reuse_count, SLOT_BENCH_ROUNDS * ((MAX_ROOM + 1) / 2) * MAX_USER_PER_ROOM, reuse_wrong);
+}
+
+// 예전 구조를 흉내 낸 방 - 몬스터(m_lock)와 플레이어(_s_lock)마다 락을 가진다.
+struct BENCH_ROOM {
+	struct MONSTER { mutex m_lock; float HP = 1e9f; XMFLOAT3 pos{}; };
+	struct PLAYER { mutex s_lock; float HP = 1e9f; XMFLOAT3 pos{}; };
+	array<MONSTER, ROOM_MONSTER_COUNT> monsters;
+	array<PLAYER, MAX_USER_PER_ROOM> players;
+	BENCH_ROOM()
+	{
+		for (int i = 0; i < ROOM_MONSTER_COUNT; ++i) monsters[i].pos = XMFLOAT3(50.f * (i % 7), 0.f, 10.f * i);
+		for (int i = 0; i < MAX_USER_PER_ROOM; ++i) players[i].pos = XMFLOAT3(100.f * i, 0.f, 200.f * i);
+	}
+};
+
+// 락을 바로 잡지 못했을 때 기다린 시간을 잰다.
+struct BENCH_LOCK_WAIT {
+	unsigned long long wait_ns = 0, acquired = 0, contended = 0;
+	void Lock(mutex& m)
+	{
+		acquired++;
+		if (m.try_lock()) return;
+		contended++;
+		auto begin = high_resolution_clock::now();
+		m.lock();
+		wait_ns += duration_cast<nanoseconds>(high_resolution_clock::now() - begin).count();
+	}
+	void Unlock(mutex& m) { m.unlock(); }
+};
+
+// 방 실행기 안에서는 락을 잡지 않는다.
+struct BENCH_NO_LOCK {
+	void Lock(mutex&) {}
+	void Unlock(mutex&) {}
+};
+
+/**
+ * @brief 방의 작업 하나 - op 8개 중 1개는 방 틱, 나머지는 공격 패킷
+ *
+ * 방 틱은 몬스터를 움직이고 가까운 플레이어의 HP 를 깎으며 (Monster::Update),
+ * 공격은 몬스터를 하나씩 잡아 가장 가까운 몬스터를 찾은 뒤 그 몬스터를 다시 잡아 데미지를 줍니다. (process_packet 의 GUN)
+ */
+template<class LOCKER>
+inline void bench_room_op(BENCH_ROOM& room, unsigned op, LOCKER& locker)
+{
+	if (op % 8 == 0) {
+		for (auto& m : room.monsters) {
+			locker.Lock(m.m_lock);
+			m.pos.z += (op & 8) ? 0.5f : -0.5f;
+			for (auto& pl : room.players) {
+				if (fabsf(pl.pos.z - m.pos.z) > 20.f) continue;
+				locker.Lock(pl.s_lock);
+				pl.HP -= 1.f;
+				locker.Unlock(pl.s_lock);
+			}
+			locker.Unlock(m.m_lock);
+		}
+		return;
+	}
+	XMFLOAT3 pos = room.players[op % MAX_USER_PER_ROOM].pos;
+	int closest = -1;
+	float min_distance = FLT_MAX;
+	for (int i = 0; i < ROOM_MONSTER_COUNT; ++i) {
+		auto& m = room.monsters[i];
+		locker.Lock(m.m_lock);
+		float distance = fabsf(m.pos.x - pos.x) + fabsf(m.pos.z - pos.z);
+		if (m.HP > 0 && distance < min_distance) {
+			min_distance = distance;
+			closest = i;
+		}
+		locker.Unlock(m.m_lock);
+	}
+	if (closest < 0) return;
+	locker.Lock(room.monsters[closest].m_lock);
+	room.monsters[closest].HP -= 1.f;
+	locker.Unlock(room.monsters[closest].m_lock);
+}
+
+// 방 실행기 측정에서 작업 스레드가 처리하는 방과 처리한 작업 수
+inline BENCH_ROOM* g_bench_rooms = nullptr;
+inline atomic<unsigned long long> g_bench_room_done{ 0 };
+
+inline void bench_room_handler(ROOM_JOB* job)
+{
+	BENCH_NO_LOCK locker;
+	bench_room_op(g_bench_rooms[job->_room], static_cast<unsigned>(job->_id), locker);
+	g_bench_room_done.fetch_add(1, memory_order_relaxed);
+}
+
+struct ACTOR_BENCH_RESULT {
+	double seconds = 0;
+	double post_ns = 0;
+	unsigned long long steals = 0;
+	string utilization;		// 작업 스레드별 이용률
+};
+
+/**
+ * @brief ACTOR_BENCH_THREADS 개의 스레드가 방 실행기에 ROOM_JOB 을 넘기고, 같은 수의 작업 스레드가 처리한다.
+ * @param steal 작업 스레드가 다른 스레드의 방을 훔쳐 갈 수 있는지
+ * @param skewed true 면 작업의 3/4 를 작업 스레드 0 이 집인 방에 몰아준다
+ */
+inline ACTOR_BENCH_RESULT bench_room_actors(array<BENCH_ROOM, ACTOR_BENCH_ROOMS>& rooms, bool steal, bool skewed)
+{
+	const unsigned long long total_ops = static_cast<unsigned long long>(ACTOR_BENCH_THREADS) * ACTOR_BENCH_OPS;
+	JOB_SCHEDULER scheduler;
+	auto actors = make_unique<array<ROOM_ACTOR, ACTOR_BENCH_ROOMS>>();
+	for (int r = 0; r < ACTOR_BENCH_ROOMS; ++r)
+		(*actors)[r].Bind(&scheduler, r, bench_room_handler);
+	g_bench_rooms = rooms.data();
+	g_bench_room_done = 0;
+	scheduler.Start(ACTOR_BENCH_THREADS, -1, steal);
+
+	atomic<unsigned long long> post_ns = 0;
+	auto start_time = high_resolution_clock::now();
+	vector<thread> threads;
+	for (int t = 0; t < ACTOR_BENCH_THREADS; ++t) {
+		threads.emplace_back([&, t]() {
+			mt19937 rng(t + 1);
+			auto begin = high_resolution_clock::now();
+			for (int i = 0; i < ACTOR_BENCH_OPS; ++i) {
+				unsigned op = rng();
+				int room = op % ACTOR_BENCH_ROOMS;
+				if (skewed && (op >> 28) % 4 != 0) room -= room % ACTOR_BENCH_THREADS;
+				(*actors)[room].Post(ROOM_JOB::Create(RJ_PACKET, room, static_cast<int>(op / ACTOR_BENCH_ROOMS)));
+			}
+			post_ns += duration_cast<nanoseconds>(high_resolution_clock::now() - begin).count();
+			});
+	}
+	for (auto& th : threads) th.join();
+	while (g_bench_room_done.load() < total_ops) this_thread::yield();
+
+	ACTOR_BENCH_RESULT result;
+	result.seconds = duration_cast<microseconds>(high_resolution_clock::now() - start_time).count() / 1e6;
+	result.post_ns = static_cast<double>(post_ns.load());
+	for (int w = 0; w < scheduler.Workers(); ++w) {
+		const JOB_WORKER_STATS& ws = scheduler.Stats(w);
+		result.steals += ws.steals.load();
+		char buf[16];
+		snprintf(buf, sizeof(buf), "%s%.0f%%", w ? "/" : "", 100.0 * ws.busy_ns.load() / 1e9 / result.seconds);
+		result.utilization += buf;
+	}
+	scheduler.Stop();
+	return result;
+}
+
+/**
+ * @brief 방 실행기(RoomActor.h)와 예전 객체별 락의 경합 비교
+ *
+ * ACTOR_BENCH_THREADS 개의 워커가 ACTOR_BENCH_ROOMS 개의 방에 공격 패킷과 방 틱을 섞어 처리합니다.
+ *  - 객체별 락 : 워커가 직접 처리하면서 몬스터/플레이어 락을 잡는다. 락을 기다린 시간을 잰다.
+ *  - 방 실행기 : 워커는 ROOM_JOB 을 방의 실행기에 넘기기만 하고 작업 스레드(JobSystem.h)가 락 없이 처리한다.
+ *                우편함에 넣는 데 걸린 시간을 잰다.
+ * 부하가 작업 스레드 하나의 방에 몰릴 때 훔치기가 있을 때와 없을 때의 처리량과 작업 스레드별 이용률도 비교합니다.
+ */
+inline void Benchmark_Room_Actor()
+{
+	auto rooms = make_unique<array<BENCH_ROOM, ACTOR_BENCH_ROOMS>>();
+	const unsigned long long total_ops = static_cast<unsigned long long>(ACTOR_BENCH_THREADS) * ACTOR_BENCH_OPS;
+
+	// 객체별 락
+	unsigned long long lock_wait_ns = 0, lock_acquired = 0, lock_contended = 0;
+	mutex result_lock;
+	auto start_time = high_resolution_clock::now();
+	vector<thread> threads;
+	for (int t = 0; t < ACTOR_BENCH_THREADS; ++t) {
+		threads.emplace_back([&, t]() {
+			BENCH_LOCK_WAIT locker;
+			mt19937 rng(t + 1);
+			for (int i = 0; i < ACTOR_BENCH_OPS; ++i) {
+				unsigned op = rng();
+				bench_room_op((*rooms)[op % ACTOR_BENCH_ROOMS], op / ACTOR_BENCH_ROOMS, locker);
+			}
+			lock_guard<mutex> ll{ result_lock };
+			lock_wait_ns += locker.wait_ns;
+			lock_acquired += locker.acquired;
+			lock_contended += locker.contended;
+			});
+	}
+	for (auto& th : threads) th.join();
+	threads.clear();
+	double lock_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start_time).count() / 1e6;
+
+	// 방 실행기 - 고르게 흩어진 부하
+	ACTOR_BENCH_RESULT actor = bench_room_actors(*rooms, true, false);
+
+	// 방 실행기 - 작업 스레드 0 이 집인 방에 부하의 3/4 가 몰릴 때, 훔치기 없이 / 훔치기
+	ACTOR_BENCH_RESULT home_only = bench_room_actors(*rooms, false, true);
+	ACTOR_BENCH_RESULT stealing = bench_room_actors(*rooms, true, true);
+
+	printf("[BENCH] room actor - %d workers, %d rooms, %llu ops (1/8 room ticks)\n", ACTOR_BENCH_THREADS, ACTOR_BENCH_ROOMS, total_ops);
+	printf("  per-object locks : %.0f ops/s, lock wait %.1f ns/op, %.3f%% of %llu acquisitions contended\n",
+		total_ops / lock_seconds, static_cast<double>(lock_wait_ns) / total_ops,
+		lock_acquired ? 100.0 * lock_contended / lock_acquired : 0.0, lock_acquired);
+	printf("  room actors      : %.0f ops/s, lock wait 0 ns/op, post %.1f ns/op, %llu steals\n",
+		total_ops / actor.seconds, actor.post_ns / total_ops, actor.steals);
+	printf("  skewed, home only: %.0f ops/s, worker busy %s\n", total_ops / home_only.seconds, home_only.utilization.c_str());
+	printf("  skewed, stealing : %.0f ops/s, worker busy %s, %llu steals\n",
+		total_ops / stealing.seconds, stealing.utilization.c_str(), stealing.steals);
+}
+
+/**
+ * @brief 몬스터 길찾기(PathFinder.h) 측정 - 칸 단위 A* 와 Jump Point Search 비교
+ *
+ * 스테이지마다 몬스터 생성 위치끼리 짝을 지어 (시작, 목표) 쌍을 만들고, 실제 장애물 그리드(map.txt) 위에서
+ * Find_Direction 과 같은 조건(근접 공격 거리 안이면 도착)으로 두 방식 모두 같은 쌍의 경로를 찾습니다.
+ * 탐색 한 번에 꺼낸 노드 수(JPS 는 점프 지점 수), 평균/p99 시간, 평균 경로 길이, 예산(PATH_MAX_EXPANSIONS)을 넘긴 비율을 출력합니다.
+ */
+inline void Benchmark_Path()
+{
+	struct PAIR { int floor; PATH_CELL start, goal; };
+	vector<PAIR> pairs;
+	for (int stage = 0; stage < STAGE_NUMBERS; ++stage) {
+		for (int i = 0; i < MONSTER_PER_STAGE; ++i) {
+			for (int j = 0; j < MONSTER_PER_STAGE; ++j) {
+				if (i == j) continue;
+				const MonsterInfo& from = StagesInfo[stage * MONSTER_PER_STAGE + i];
+				const MonsterInfo& to = StagesInfo[stage * MONSTER_PER_STAGE + j];
+				pairs.push_back(PAIR{ (from.id < 20) ? 0 : 1, To_Cell(from.Pos), To_Cell(to.Pos) });
+			}
+		}
+	}
+
+	const float goal_range = static_cast<float>(MELEE_ATTACK_RANGE) / CELL_SIZE;
+	PATH_FINDER& finder = PATH_FINDER::Local();
+	vector<PATH_CELL> path, blocked;
+	printf("[BENCH] path finding - %zu stage start/goal pairs x %d rounds, budget %d nodes\n", pairs.size(), PATH_BENCH_ROUNDS, PATH_MAX_EXPANSIONS);
+	for (PATH_ALGORITHM algorithm : { PATH_ASTAR, PATH_JPS }) {
+		vector<long long> times;
+		unsigned long long expanded = 0, path_cells = 0;
+		double path_length = 0.0;
+		int found = 0, no_path = 0, budget = 0;
+		for (int round = 0; round < PATH_BENCH_ROUNDS; ++round) {
+			for (const PAIR& pair : pairs) {
+				auto begin = high_resolution_clock::now();
+				PATH_SEARCH_STATS result = (algorithm == PATH_JPS)
+					? finder.Find_Jump(ObstacleGrid[pair.floor], pair.start, pair.goal, goal_range, blocked, path)
+					: finder.Find(ObstacleGrid[pair.floor], pair.start, pair.goal, goal_range, blocked, path);
+				times.push_back(duration_cast<nanoseconds>(high_resolution_clock::now() - begin).count());
+				expanded += result.expanded;
+				if (result.result == PATH_FOUND) {
+					found++;
+					path_cells += path.size();
+					PATH_CELL prev = pair.start;
+					for (const PATH_CELL& c : path) {
+						path_length += (c.x != prev.x && c.z != prev.z) ? PATH_SQRT2 : 1.0;
+						prev = c;
+					}
+				}
+				else if (result.result == PATH_BUDGET) budget++;
+				else no_path++;
+			}
+		}
+
+		double total_ns = 0;
+		for (long long t : times) total_ns += static_cast<double>(t);
+		sort(times.begin(), times.end());
+		const double searches = static_cast<double>(times.size());
+		printf("  %-14s : %.0f nodes/search, avg %.1f us, p99 %.1f us\n", (algorithm == PATH_JPS) ? "jump point" : "grid A*",
+			expanded / searches, total_ns / searches / 1e3, times[times.size() * 99 / 100] / 1e3);
+		printf("  results        : found %.1f%% (avg %.0f cells, length %.1f), no path %.1f%%, budget hit %.2f%%\n",
+			100.0 * found / searches, found ? static_cast<double>(path_cells) / found : 0.0, found ? path_length / found : 0.0,
+			100.0 * no_path / searches, 100.0 * budget / searches);
+	}
+}
+
+/**
+ * @brief 몬스터끼리의 충돌 검사 - 방의 몬스터 전부를 도는 방식과 공간 해시(SpatialHash.h) 비교
+ *
+ * 몬스터 60마리를 두 가지로 배치하고, 매 라운드 모든 몬스터가 한 걸음(틱 이동 거리) 옮길 자리를 검사한 뒤 움직입니다.
+ *  - 생성 위치 : StagesInfo 의 자리 (스테이지마다 흩어져 있다)
+ *  - 몰림      : 한 플레이어를 쫓아 반지름 80 안에 모두 모여 있다
+ * 검사 한 번의 시간과 BoundingBox 로 확인한 몬스터 수를 출력합니다. 두 방식의 충돌 판정 수가 다르면 mismatch 로 셉니다.
+ */
+inline void Benchmark_Collision()
+{
+	constexpr int COUNT = MONSTER_PER_STAGE * STAGE_NUMBERS;
+	mt19937 rng(33);
+	uniform_real_distribution<float> unit(-1.f, 1.f);
+	const float step = 24.f * 0.1f;		// 몬스터 속도 24 로 100ms 틱 한 번
+
+	// chase 면 center 쪽으로 (흔들리면서) 다가간다.
+	auto run = [&](const char* name, vector<BoundingBox> boxes, bool chase, XMFLOAT3 center) {
+		struct RESULT { double ns = 0.0; unsigned long long tests = 0, hits = 0; };
+		RESULT brute, hashed;
+		SPATIAL_HASH<COUNT> hash;
+		for (int i = 0; i < COUNT; ++i) hash.Update(i, boxes[i].Center);
+		vector<XMFLOAT3> moves(COUNT);
+		for (int round = 0; round < COLLIDE_BENCH_ROUNDS; ++round) {
+			for (int i = 0; i < COUNT; ++i) {
+				XMFLOAT3 dir(unit(rng), 0.f, unit(rng));
+				if (chase) dir = Vector3::Add(dir, Vector3::XZNormalize(Vector3::Subtract(center, boxes[i].Center)));
+				dir = Vector3::XZNormalize(dir);
+				moves[i] = Vector3::Add(boxes[i].Center, Vector3::ScalarProduct(dir, step, false));
+			}
+			auto begin = high_resolution_clock::now();
+			for (int i = 0; i < COUNT; ++i) {
+				BoundingBox box(moves[i], boxes[i].Extents);
+				for (int j = 0; j < COUNT; ++j) {
+					if (j == i) continue;
+					brute.tests++;
+					if (boxes[j].Intersects(box)) {
+						brute.hits++;
+						break;
+					}
+				}
+			}
+			auto middle = high_resolution_clock::now();
+			for (int i = 0; i < COUNT; ++i) {
+				BoundingBox box(moves[i], boxes[i].Extents);
+				uint64_t candidates = hash.Query(box) & ~(1ull << i);
+				while (candidates) {
+					int j = countr_zero(candidates);
+					candidates &= candidates - 1;
+					hashed.tests++;
+					if (boxes[j].Intersects(box)) {
+						hashed.hits++;
+						break;
+					}
+				}
+			}
+			auto end = high_resolution_clock::now();
+			brute.ns += static_cast<double>(duration_cast<nanoseconds>(middle - begin).count());
+			hashed.ns += static_cast<double>(duration_cast<nanoseconds>(end - middle).count());
+			// 겹치지 않는 몬스터만 움직인다.
+			for (int i = 0; i < COUNT; ++i) {
+				BoundingBox box(moves[i], boxes[i].Extents);
+				bool blocked = false;
+				for (int j = 0; j < COUNT && false == blocked; ++j)
+					blocked = (j != i) && boxes[j].Intersects(box);
+				if (false == blocked) {
+					boxes[i].Center = moves[i];
+					hash.Update(i, moves[i]);
+				}
+			}
+		}
+		const double queries = static_cast<double>(COLLIDE_BENCH_ROUNDS) * COUNT;
+		printf("  %-12s : all monsters %.1f ns/query (%.1f box tests) | spatial hash %.1f ns/query (%.1f box tests) x%.1f%s\n",
+			name, brute.ns / queries, brute.tests / queries, hashed.ns / queries, hashed.tests / queries,
+			hashed.ns > 0.0 ? brute.ns / hashed.ns : 0.0, brute.hits == hashed.hits ? "" : " mismatch");
+		};
+
+	printf("[BENCH] monster collision - %d monsters x %d rounds, cell %.0f, %d buckets\n", COUNT, COLLIDE_BENCH_ROUNDS, SPATIAL_HASH_CELL, SPATIAL_HASH_BUCKETS);
+	auto extents = [](int id) {
+		switch (StagesInfo[id].type) {
+		case 0: return MONSTER_SIZE;
+		case 3: return BOSS_MONSTER_SIZE;
+		default: return SMALL_MONSTER_SIZE;
+		}
+		};
+	vector<BoundingBox> spawn(COUNT), crowd(COUNT);
+	for (int i = 0; i < COUNT; ++i) spawn[i] = BoundingBox(StagesInfo[i].Pos, extents(i));
+	// 몰림: 1 스테이지 가운데를 중심으로 겹치지 않게 둔다.
+	const XMFLOAT3 center(340.f, -63.f, 1900.f);
+	for (int i = 0; i < COUNT; ++i) {
+		float radius = 80.f;
+		while (true) {
+			XMFLOAT3 pos(center.x + unit(rng) * radius, center.y, center.z + unit(rng) * radius);
+			BoundingBox box(pos, extents(i));
+			bool overlap = false;
+			for (int j = 0; j < i && false == overlap; ++j) overlap = crowd[j].Intersects(box);
+			if (false == overlap) {
+				crowd[i] = box;
+				break;
+			}
+			radius += 0.5f;
+		}
+	}
+	run("spawn", spawn, false, center);
+	run("crowd", crowd, true, center);
+}
+
+/**
+ * @brief 비트 장애물 그리드(BitGrid.h)와 bool 배열(ObstacleGrid) 비교
+ *
+ * 그리드 전체에서 고른 위치로 세 가지 질의를 같은 입력에 던집니다.
+ *  - 칸 검사    : 몬스터 이동 판정처럼 위치가 있는 칸이 갈 수 있는지 (bool 배열은 .at())
+ *  - 선분 검사  : 한 틱 이동 거리(보폭)와 시야 길이의 선분이 모두 갈 수 있는 칸인지
+ *  - 첫 막힌 칸 : 시야 길이의 선분을 따라 처음 만나는 막힌 칸
+ * bool 배열 쪽은 같은 칸 순서(Walk_Columns)로 한 칸씩 읽으므로 두 결과는 같아야 하고, 다르면 mismatch 로 셉니다.
+ */
+inline void Benchmark_Grid()
+{
+	struct QUERY { int floor; float x0, z0, x1, z1; };
+	mt19937 rng(21);
+	uniform_real_distribution<float> rand_x(0.f, GRID_SIZE_X * CELL_SIZE - 1.f), rand_z(0.f, GRID_SIZE_Z * CELL_SIZE - 1.f);
+	uniform_real_distribution<float> rand_angle(0.f, 6.2831853f);
+	auto make_queries = [&](float length) {
+		vector<QUERY> queries(GRID_BENCH_QUERIES);
+		for (QUERY& q : queries) {
+			float angle = rand_angle(rng);
+			q.floor = static_cast<int>(rng() % GRID_SIZE_Y);
+			q.x0 = rand_x(rng);
+			q.z0 = rand_z(rng);
+			q.x1 = q.x0 + cosf(angle) * length;
+			q.z1 = q.z0 + sinf(angle) * length;
+		}
+		return queries;
+		};
+	const float stride = 24.f * 0.1f;		// 몬스터 속도 24 로 100ms 틱 한 번
+	vector<QUERY> strides = make_queries(stride), sights = make_queries(GRID_BENCH_SIGHT);
+
+	auto bool_walkable = [](int floor, int x, int z) {
+		return x >= 0 && x < GRID_SIZE_X && z >= 0 && z < GRID_SIZE_Z && ObstacleGrid[floor][x][z];
+		};
+	auto bool_span = [&](int floor, int x, int z_lo, int z_hi, bool forward, int& hit_z) {
+		for (int i = 0; i <= z_hi - z_lo; ++i) {
+			int z = forward ? z_lo + i : z_hi - i;
+			if (false == bool_walkable(floor, x, z)) {
+				hit_z = z;
+				return true;
+			}
+		}
+		return false;
+		};
+	auto measure = [](auto&& body) {
+		auto begin = high_resolution_clock::now();
+		unsigned long long check = body();
+		return make_pair(duration_cast<nanoseconds>(high_resolution_clock::now() - begin).count() / static_cast<double>(GRID_BENCH_QUERIES), check);
+		};
+
+	// 칸 검사
+	auto point_bool = measure([&] {
+		unsigned long long walkable = 0;
+		for (const QUERY& q : strides)
+			walkable += ObstacleGrid[q.floor].at(int(q.x0) / CELL_SIZE).at(int(q.z0) / CELL_SIZE);
+		return walkable;
+		});
+	auto point_bits = measure([&] {
+		unsigned long long walkable = 0;
+		for (const QUERY& q : strides)
+			walkable += ObstacleBits[q.floor].Walkable(int(q.x0) / CELL_SIZE, int(q.z0) / CELL_SIZE);
+		return walkable;
+		});
+
+	// 선분 검사
+	auto segment = [&](const vector<QUERY>& queries, bool bits) {
+		return measure([&] {
+			unsigned long long walkable = 0;
+			for (const QUERY& q : queries) {
+				const float x0 = q.x0 / CELL_SIZE, z0 = q.z0 / CELL_SIZE, x1 = q.x1 / CELL_SIZE, z1 = q.z1 / CELL_SIZE;
+				if (bits) walkable += ObstacleBits[q.floor].Segment_Walkable(x0, z0, x1, z1);
+				else walkable += false == OBSTACLE_BITS::Walk_Columns(x0, z0, x1, z1, [&](int x, int z_lo, int z_hi, bool forward) {
+					int hit_z;
+					return bool_span(q.floor, x, z_lo, z_hi, forward, hit_z);
+					});
+			}
+			return walkable;
+			});
+		};
+	auto stride_bool = segment(strides, false), stride_bits = segment(strides, true);
+	auto sight_bool = segment(sights, false), sight_bits = segment(sights, true);
+
+	// 첫 막힌 칸
+	auto ray = [&](bool bits) {
+		return measure([&] {
+			unsigned long long hash = 0;
+			for (const QUERY& q : sights) {
+				const float x0 = q.x0 / CELL_SIZE, z0 = q.z0 / CELL_SIZE, x1 = q.x1 / CELL_SIZE, z1 = q.z1 / CELL_SIZE;
+				PATH_CELL hit;
+				bool blocked = false;
+				if (bits) blocked = ObstacleBits[q.floor].First_Blocked(x0, z0, x1, z1, hit);
+				else blocked = OBSTACLE_BITS::Walk_Columns(x0, z0, x1, z1, [&](int x, int z_lo, int z_hi, bool forward) {
+					int hit_z;
+					if (false == bool_span(q.floor, x, z_lo, z_hi, forward, hit_z)) return false;
+					hit = PATH_CELL{ static_cast<short>(x), static_cast<short>(hit_z) };
+					return true;
+					});
+				if (blocked) hash = hash * 31 + static_cast<unsigned short>(hit.x) * 65536ull + static_cast<unsigned short>(hit.z);
+			}
+			return hash;
+			});
+		};
+	auto ray_bool = ray(false), ray_bits = ray(true);
+
+	printf("[BENCH] obstacle grid - %d queries each, bool array %zu KB vs bit grid %zu KB\n",
+		GRID_BENCH_QUERIES, sizeof(ObstacleGrid) / 1024, sizeof(ObstacleBits) / 1024);
+	auto print = [](const char* name, pair<double, unsigned long long> a, pair<double, unsigned long long> b) {
+		printf("  %-18s : bool %.1f ns, bits %.1f ns (x%.2f)%s\n", name, a.first, b.first, b.first > 0.0 ? a.first / b.first : 0.0,
+			a.second == b.second ? "" : " mismatch");
+		};
+	print("cell", point_bool, point_bits);
+	print("stride segment", stride_bool, stride_bits);
+	print("sight segment", sight_bool, sight_bits);
+	print("first blocked", ray_bool, ray_bits);
+}
+
+/**
+ * @brief 계층 경로 탐색(HierarchicalPath.h)과 칸 단위 A*, JPS 비교 - 스테이지를 건너는 긴 길찾기
+ *
+ * 같은 층의 서로 다른 스테이지 몬스터 생성 위치끼리 짝을 지어 (시작, 목표) 쌍을 만듭니다.
+ * 예산 없는 A* 로 구한 최단 경로 길이와 비교해 계층 탐색 경로가 얼마나 긴지도 출력합니다.
+ * 그래프를 새로 만드는 시간과 파일에 저장했다가 읽는 시간도 잽니다.
+ */
+inline void Benchmark_HPA()
+{
+	auto begin = high_resolution_clock::now();
+	array<PATH_GRAPH, GRID_SIZE_Y> graphs;
+	for (int floor = 0; floor < GRID_SIZE_Y; ++floor) graphs[floor].Build(ObstacleGrid[floor]);
+	double build_ms = duration_cast<microseconds>(high_resolution_clock::now() - begin).count() / 1e3;
+	{
+		std::ofstream out(HPA_BENCH_FILE, ios::binary | ios::trunc);
+		for (const PATH_GRAPH& graph : graphs) graph.Save(out);
+	}
+	begin = high_resolution_clock::now();
+	bool loaded = true;
+	{
+		std::ifstream in(HPA_BENCH_FILE, ios::binary);
+		for (int floor = 0; floor < GRID_SIZE_Y; ++floor) loaded = loaded && graphs[floor].Load(in, ObstacleGrid[floor]);
+	}
+	double load_ms = duration_cast<microseconds>(high_resolution_clock::now() - begin).count() / 1e3;
+	remove(HPA_BENCH_FILE);
+
+	struct PAIR { int floor; PATH_CELL start, goal; };
+	vector<PAIR> pairs;
+	for (int a = 0; a < STAGE_NUMBERS * MONSTER_PER_STAGE; ++a) {
+		for (int b = 0; b < STAGE_NUMBERS * MONSTER_PER_STAGE; ++b) {
+			const MonsterInfo& from = StagesInfo[a];
+			const MonsterInfo& to = StagesInfo[b];
+			int floor = (from.id < 20) ? 0 : 1;
+			if (a / MONSTER_PER_STAGE == b / MONSTER_PER_STAGE || floor != ((to.id < 20) ? 0 : 1)) continue;
+			pairs.push_back(PAIR{ floor, To_Cell(from.Pos), To_Cell(to.Pos) });
+		}
+	}
+
+	const float goal_range = static_cast<float>(MELEE_ATTACK_RANGE) / CELL_SIZE;
+	auto path_cost = [](const vector<PATH_CELL>& path, PATH_CELL start) {
+		double cost = 0.0;
+		PATH_CELL prev = start;
+		for (const PATH_CELL& c : path) {
+			cost += (c.x != prev.x && c.z != prev.z) ? PATH_SQRT2 : 1.0;
+			prev = c;
+		}
+		return cost;
+		};
+	struct RESULT {
+		vector<long long> times;
+		unsigned long long expanded = 0;
+		int found = 0, budget = 0;
+		double cost_ratio = 0.0;		// 최단 경로 대비 길이의 합 (둘 다 찾은 쌍)
+	};
+	RESULT flat, jump, hierarchical;
+	PATH_FINDER& finder = PATH_FINDER::Local();
+	vector<PATH_CELL> path, blocked;
+	for (const PAIR& pair : pairs) {
+		const auto& grid = ObstacleGrid[pair.floor];
+		PATH_SEARCH_STATS optimal = finder.Find(grid, pair.start, pair.goal, goal_range, blocked, path, PATH_FINDER::CELLS);
+		double optimal_cost = path_cost(path, pair.start);
+		for (int round = 0; round < PATH_BENCH_ROUNDS; ++round) {
+			auto t0 = high_resolution_clock::now();
+			PATH_SEARCH_STATS result = finder.Find(grid, pair.start, pair.goal, goal_range, blocked, path);
+			flat.times.push_back(duration_cast<nanoseconds>(high_resolution_clock::now() - t0).count());
+			flat.expanded += result.expanded;
+			if (round == 0 && result.result == PATH_FOUND) {
+				flat.found++;
+				if (optimal_cost > 0.0) flat.cost_ratio += path_cost(path, pair.start) / optimal_cost;
+			}
+			else if (round == 0 && result.result == PATH_BUDGET) flat.budget++;
+
+			t0 = high_resolution_clock::now();
+			result = finder.Find_Jump(grid, pair.start, pair.goal, goal_range, blocked, path);
+			jump.times.push_back(duration_cast<nanoseconds>(high_resolution_clock::now() - t0).count());
+			jump.expanded += result.expanded;
+			if (round == 0 && result.result == PATH_FOUND) {
+				jump.found++;
+				if (optimal_cost > 0.0) jump.cost_ratio += path_cost(path, pair.start) / optimal_cost;
+			}
+			else if (round == 0 && result.result == PATH_BUDGET) jump.budget++;
+
+			t0 = high_resolution_clock::now();
+			result = graphs[pair.floor].Find(grid, pair.start, pair.goal, goal_range, path);
+			hierarchical.times.push_back(duration_cast<nanoseconds>(high_resolution_clock::now() - t0).count());
+			hierarchical.expanded += result.expanded;
+			if (round == 0 && result.result == PATH_FOUND) {
+				hierarchical.found++;
+				if (optimal.result == PATH_FOUND && optimal_cost > 0.0)
+					hierarchical.cost_ratio += path_cost(path, pair.start) / optimal_cost;
+			}
+		}
+	}
+
+	printf("[BENCH] hierarchical path finding - %zu cross-stage pairs x %d rounds, cluster %d cells\n",
+		pairs.size(), PATH_BENCH_ROUNDS, HPA_CLUSTER_SIZE);
+	printf("  graph          : %zu + %zu nodes, %zu + %zu edges, build %.1f ms, cache load %.1f ms%s\n",
+		graphs[0].Nodes(), graphs[1].Nodes(), graphs[0].Edges(), graphs[1].Edges(), build_ms, load_ms, loaded ? "" : " (load failed)");
+	auto print = [&](const char* name, RESULT& r) {
+		if (r.times.empty()) return;
+		double total_ns = 0;
+		for (long long t : r.times) total_ns += static_cast<double>(t);
+		sort(r.times.begin(), r.times.end());
+		const double searches = static_cast<double>(r.times.size());
+		printf("  %-14s : avg %.1f us, p99 %.1f us, %.0f nodes/search, found %.1f%%, budget hit %.1f%%, length x%.3f\n",
+			name, total_ns / searches / 1e3, r.times[r.times.size() * 99 / 100] / 1e3, r.expanded / searches,
+			100.0 * r.found / pairs.size(), 100.0 * r.budget / pairs.size(), r.found ? r.cost_ratio / r.found : 0.0);
+		};
+	print("grid A*", flat);
+	print("jump point", jump);
+	print("hierarchical", hierarchical);
+}
+
+/**
+ * @brief 흐름장(FlowField.h)과 몬스터별 A* 비교 - 한 방의 몬스터 60마리가 모두 쫓는 상황
+ *
+ * 1 스테이지 구역에 플레이어 3명을 두고, 몬스터 60마리를 각자 목표 플레이어의 시야(400) 안에서 걸어갈 수 있는 칸에 둡니다.
+ * 매 틱 플레이어는 두 틱에 한 칸씩 돌아다니고, 근접 공격 거리 밖의 몬스터는 한 칸씩 다가갑니다.
+ *  - 몬스터별 A* : Find_Direction 처럼 목표 칸이 바뀌거나 경로를 벗어나면 경로 전체를 다시 찾는다.
+ *  - 흐름장     : 플레이어가 FLOW_REBUILD_CELLS 칸 넘게 옮기면 그 플레이어의 흐름장만 다시 계산하고,
+ *                 몬스터는 이웃 칸만 본다.
+ */
+inline void Benchmark_Flow()
+{
+	const int floor = 0;
+	const auto& grid = ObstacleGrid[floor];
+	const float goal_range = static_cast<float>(MELEE_ATTACK_RANGE) / CELL_SIZE;
+	const int view_cells = 400 / CELL_SIZE;
+	const int monster_count = MONSTER_PER_STAGE * STAGE_NUMBERS;
+	mt19937 rng(7);
+	auto random_cell = [&](int x0, int x1, int z0, int z1) {
+		while (true) {
+			PATH_CELL c{ static_cast<short>(uniform_int_distribution<int>(x0, x1)(rng)), static_cast<short>(uniform_int_distribution<int>(z0, z1)(rng)) };
+			if (c.x >= 0 && c.x < GRID_SIZE_X && c.z >= 0 && c.z < GRID_SIZE_Z && grid[c.x][c.z]) return c;
+		}
+		};
+	array<PATH_CELL, MAX_USER_PER_ROOM> start_players;
+	for (auto& p : start_players) p = random_cell(130 / CELL_SIZE, 550 / CELL_SIZE, 1300 / CELL_SIZE, 2500 / CELL_SIZE);
+	// 몬스터는 목표 플레이어까지 걸어갈 수 있는 시야 안의 칸에 둔다.
+	vector<PATH_CELL> start_monsters(monster_count);
+	{
+		auto reach = make_unique<array<ROOM_FLOW_FIELD, MAX_USER_PER_ROOM>>();
+		for (int p = 0; p < MAX_USER_PER_ROOM; ++p) (*reach)[p].Update(grid, floor, start_players[p]);
+		for (int m = 0; m < monster_count; ++m) {
+			int target = m % MAX_USER_PER_ROOM;
+			PATH_CELL t = start_players[target];
+			do {
+				start_monsters[m] = random_cell(t.x - view_cells, t.x + view_cells, t.z - view_cells, t.z + view_cells);
+			} while ((*reach)[target].Distance(start_monsters[m]) < 0.f);
+		}
+	}
+	auto in_range = [&](PATH_CELL a, PATH_CELL b) {
+		int dx = a.x - b.x, dz = a.z - b.z;
+		return static_cast<float>(dx * dx + dz * dz) <= goal_range * goal_range;
+		};
+	auto wander = [&](PATH_CELL& c, mt19937& walk) {
+		int dir = walk() % 8;
+		PATH_CELL n{ static_cast<short>(c.x + nx[dir]), static_cast<short>(c.z + nz[dir]) };
+		if (n.x >= 0 && n.x < GRID_SIZE_X && n.z >= 0 && n.z < GRID_SIZE_Z && grid[n.x][n.z]) c = n;
+		};
+
+	struct RESULT { double seconds = 0; unsigned long long searches = 0, expanded = 0, rebuilds = 0, fallbacks = 0, moves = 0; };
+	auto run = [&](bool use_flow) {
+		RESULT r;
+		array<PATH_CELL, MAX_USER_PER_ROOM> players = start_players;
+		vector<PATH_CELL> mons = start_monsters;
+		vector<vector<PATH_CELL>> paths(monster_count);
+		vector<size_t> path_index(monster_count, 0);
+		vector<PATH_CELL> path_goal(monster_count);
+		auto fields = make_unique<array<ROOM_FLOW_FIELD, MAX_USER_PER_ROOM>>();
+		vector<PATH_CELL> blocked;
+		mt19937 walk(11);
+		PATH_FINDER& finder = PATH_FINDER::Local();
+		auto a_star_step = [&](int m, PATH_CELL goal, PATH_CELL& next) {
+			bool follow = path_index[m] < paths[m].size() && path_goal[m] == goal;
+			if (false == follow) {
+				PATH_SEARCH_STATS st = finder.Find(grid, mons[m], goal, goal_range, blocked, paths[m]);
+				r.searches++;
+				r.expanded += st.expanded;
+				path_index[m] = 0;
+				path_goal[m] = goal;
+				if (paths[m].empty()) return false;
+			}
+			next = paths[m][path_index[m]++];
+			return true;
+			};
+
+		auto start_time = high_resolution_clock::now();
+		for (int tick = 0; tick < FLOW_BENCH_TICKS; ++tick) {
+			if (tick % 2 == 0)
+				for (auto& p : players) wander(p, walk);
+			for (int m = 0; m < monster_count; ++m) {
+				int target = m % MAX_USER_PER_ROOM;
+				if (in_range(mons[m], players[target])) continue;
+				PATH_CELL next;
+				bool moved = false;
+				if (use_flow) {
+					if ((*fields)[target].Update(grid, floor, players[target])) r.rebuilds++;
+					moved = (*fields)[target].Next_Cell(mons[m], next);
+					if (false == moved) {
+						r.fallbacks++;
+						moved = a_star_step(m, players[target], next);
+					}
+				}
+				else moved = a_star_step(m, players[target], next);
+				if (moved) {
+					mons[m] = next;
+					r.moves++;
+				}
+			}
+		}
+		r.seconds = duration_cast<nanoseconds>(high_resolution_clock::now() - start_time).count() / 1e9;
+		return r;
+		};
+
+	RESULT per_monster = run(false);
+	RESULT flow = run(true);
+	printf("[BENCH] flow field - %d monsters chasing %d players, %d ticks\n", monster_count, MAX_USER_PER_ROOM, FLOW_BENCH_TICKS);
+	printf("  per-monster A* : %.1f us/tick, %llu searches (%.0f nodes/search), %llu moves\n",
+		per_monster.seconds * 1e6 / FLOW_BENCH_TICKS, per_monster.searches,
+		per_monster.searches ? static_cast<double>(per_monster.expanded) / per_monster.searches : 0.0, per_monster.moves);
+	printf("  flow fields    : %.1f us/tick, %llu rebuilds, %llu A* fallbacks, %llu moves\n",
+		flow.seconds * 1e6 / FLOW_BENCH_TICKS, flow.rebuilds, flow.fallbacks, flow.moves);
+}
+
+/**
+ * @brief 몬스터 업데이트 처리량 - 한 마리씩 Update 하는 방식과 상태별로 모아서 돌리는 방식(Update_Room_Monsters) 비교
+ *
+ * 비어 있는 마지막 방에 몬스터 60마리를 모두 살려 두고, 플레이어 3명을 1, 3, 5 스테이지의 첫 몬스터 자리 둘레로
+ * 반지름 MONSTER_BENCH_RADIUS 의 원을 따라 돌게 합니다. (플레이어는 죽지 않게 매 틱 HP 를 채운다)
+ * 같은 시작 상태와 같은 난수로 100ms 틱을 MONSTER_BENCH_TICKS 번 돌리고, 이 스레드가 쓴 CPU 시간으로 코어당 처리량을 냅니다.
+ * Idle 몬스터의 목표 고르기(get_targetID 와 MONSTER_STORE::Select_Targets)만 따로 떼어 방 전체 한 번의 시간도 잽니다.
+ * 끝나면 방을 처음 상태로 되돌립니다.
+ */
+inline void Benchmark_Monsters()
+{
+	const int room = MAX_ROOM - 1;
+	const float dt = 0.1f;
+	Acquire_Room_Monsters(room);
+	array<XMFLOAT3, MAX_USER_PER_ROOM> anchors;
+	for (int p = 0; p < MAX_USER_PER_ROOM; ++p) anchors[p] = StagesInfo[p * 2 * MONSTER_PER_STAGE].Pos;
+	auto place_players = [&](float angle) {
+		for (int p = 0; p < MAX_USER_PER_ROOM; ++p) {
+			SESSION& player = clients[room][p];
+			float a = angle + p * 2.f;
+			player.SetPosition(Vector3::Add(anchors[p], XMFLOAT3(cosf(a) * MONSTER_BENCH_RADIUS, 0.f, sinf(a) * MONSTER_BENCH_RADIUS)));
+			player.UpdateBoundingBox();
+			player.HP = 1e9f;
+		}
+		};
+	auto reset = [&](bool alive) {
+		srand(17);
+		for (int i = 0; i < ROOM_MONSTER_COUNT; ++i) {
+			Monster* monster = monsters[room][i];
+			monster->Re_Initialize(StagesInfo[i].type, StagesInfo[i].Pos);
+			monster->BB.Center = monster->Pos;
+			monster->wander = false;
+			monster->wander_timer = 0.f;
+			monster->MagicPos = XMFLOAT3(5000, 5000, 5000);
+			monster->MagicLook = XMFLOAT3(0, 0, 0);
+			monster->alive.store(alive);
+			monster_hashes[room].Update(i, monster->Pos);
+			monster_stores[room].Move(i, monster->Pos);
+		}
+		for (int p = 0; p < MAX_USER_PER_ROOM; ++p) {
+			clients[room][p]._state.store(alive ? ST_INGAME : ST_FREE);
+			for (auto& field : flow_fields[room][p]) field.Release();
+		}
+		place_players(0.f);
+		};
+
+	struct RESULT { double seconds = 0; unsigned long long updates = 0; array<unsigned long long, 4> states{}; };
+	auto run = [&](bool batched) {
+		RESULT r;
+		reset(true);
+		double cpu_begin = bench_thread_cpu_seconds();
+		for (int tick = 0; tick < MONSTER_BENCH_TICKS; ++tick) {
+			place_players(tick * dt * 0.5f);
+			if (batched) {
+				r.updates += popcount(Update_Room_Monsters(room, dt));
+			}
+			else {
+				for (int i = 0; i < ROOM_MONSTER_COUNT; ++i) {
+					Monster* monster = monsters[room][i];
+					if (monster->alive.load() == false) continue;
+					monster->Update(dt);
+					monster_hashes[room].Update(i, monster->Pos);
+					monster_stores[room].Move(i, monster->Pos);
+					r.updates++;
+				}
+			}
+			for (int i = 0; i < ROOM_MONSTER_COUNT; ++i)
+				r.states[static_cast<int>(monsters[room][i]->GetState())]++;
+		}
+		r.seconds = bench_thread_cpu_seconds() - cpu_begin;
+		return r;
+		};
+
+	RESULT single = run(false);
+	RESULT batched = run(true);
+
+	// 목표 고르기만 - 모든 몬스터가 Idle 이라고 보고 방 전체를 한 번씩 고른다.
+	reset(true);
+	ROOM_MONSTER_STORE& store = monster_stores[room];
+	array<XMFLOAT3, MAX_USER_PER_ROOM> players;
+	double single_ns = 0.0, batched_ns = 0.0;
+	unsigned long long mismatch = 0;
+	array<int, ROOM_MONSTER_COUNT> targets;
+	for (int round = 0; round < TARGET_BENCH_ROUNDS; ++round) {
+		place_players(round * 0.01f);
+		for (int p = 0; p < MAX_USER_PER_ROOM; ++p) players[p] = clients[room][p].GetPosition();
+		auto begin = high_resolution_clock::now();
+		for (int i = 0; i < ROOM_MONSTER_COUNT; ++i) targets[i] = monsters[room][i]->get_targetID();
+		auto middle = high_resolution_clock::now();
+		store.Select_Targets(players, (1u << MAX_USER_PER_ROOM) - 1);
+		auto end = high_resolution_clock::now();
+		single_ns += static_cast<double>(duration_cast<nanoseconds>(middle - begin).count());
+		batched_ns += static_cast<double>(duration_cast<nanoseconds>(end - middle).count());
+		for (int i = 0; i < ROOM_MONSTER_COUNT; ++i)
+			if (targets[i] != store.Target(i)) mismatch++;
+	}
+	reset(false);
+	Release_Room_Monsters(room);
+
+	printf("[BENCH] monster update - %d monsters, %d players, %d ticks of %.0fms\n", ROOM_MONSTER_COUNT, MAX_USER_PER_ROOM, MONSTER_BENCH_TICKS, dt * 1000);
+	auto print = [&](const char* name, const RESULT& r) {
+		const double total = static_cast<double>(r.updates);
+		printf("  %-14s : %.0f monster updates/s per core (%.2f us/update) | idle %.0f%% chase %.0f%% attack %.0f%%\n",
+			name, r.seconds > 0.0 ? r.updates / r.seconds : 0.0, r.updates ? r.seconds * 1e6 / r.updates : 0.0,
+			100.0 * r.states[0] / total, 100.0 * r.states[1] / total, 100.0 * r.states[2] / total);
+		};
+	print("one by one", single);
+	print("state batches", batched);
+	const double selections = static_cast<double>(TARGET_BENCH_ROUNDS) * ROOM_MONSTER_COUNT;
+	printf("  target select  : get_targetID %.1f ns/monster | Select_Targets %.1f ns/monster x%.1f%s\n",
+		single_ns / selections, batched_ns / selections, batched_ns > 0.0 ? single_ns / batched_ns : 0.0,
+		mismatch ? " mismatch" : "");
+}
+
+/**
+ * @brief 잠든 방 - 플레이어가 모두 끊긴 방 수에 따른 작업 스레드 CPU 사용량
+ *
+ * 뒤 번호의 방부터 골라 1 스테이지 몬스터 10마리를 살려 두고 플레이어 3명을 ST_CRASHED 로 둔 뒤 틱을 시작합니다.
+ * 이런 방 수를 DORMANT_BENCH_ROOMS 로 바꿔가며 BENCH_WARMUP 뒤 DORMANT_BENCH_DURATION 동안의 초당 방 틱 수와
+ * 작업 스레드가 일한 시간(코어)을 잠들기(room_dormancy)를 켠 경우와 끈 경우로 잽니다.
+ * 끝나면 몬스터를 거두고 틱이 모두 멈출 때까지 기다린 뒤 방을 처음 상태로 되돌립니다.
+ */
+inline void Benchmark_Dormancy()
+{
+	auto worker_busy_ns = []() {
+		unsigned long long sum = 0;
+		for (int w = 0; w < g_job_scheduler.Workers(); ++w) sum += g_job_scheduler.Stats(w).busy_ns.load();
+		return sum;
+		};
+	struct RESULT { double ticks = 0, cores = 0; };
+	auto run = [&](int idle_rooms, bool dormancy) {
+		RESULT r;
+		room_dormancy.store(dormancy);
+		const int first = MAX_ROOM - idle_rooms;
+		for (int room = first; room < MAX_ROOM; ++room) {
+			for (auto& cl : clients[room]) cl._state.store(ST_CRASHED);
+			Acquire_Room_Monsters(room);
+			for (int i = 0; i < MONSTER_PER_STAGE; ++i) monsters[room][i]->alive.store(true);
+			Start_Room_Tick(room);
+		}
+		this_thread::sleep_for(BENCH_WARMUP);
+		unsigned long long ticks = g_stats.room_ticks.load(), busy = worker_busy_ns();
+		auto begin = high_resolution_clock::now();
+		this_thread::sleep_for(DORMANT_BENCH_DURATION);
+		double seconds = duration<double>(high_resolution_clock::now() - begin).count();
+		r.ticks = (g_stats.room_ticks.load() - ticks) / seconds;
+		r.cores = (worker_busy_ns() - busy) / 1e9 / seconds;
+
+		for (int room = first; room < MAX_ROOM; ++room)
+			for (auto& monster : monsters[room]) monster->alive.store(false);
+		for (int room = first; room < MAX_ROOM; ++room)
+			while (room_ticks[room].running.load()) this_thread::sleep_for(1ms);
+		for (int room = first; room < MAX_ROOM; ++room) {
+			Release_Room_Monsters(room);
+			for (auto& cl : clients[room]) cl._state.store(ST_FREE);
+			room_ticks[room].dormant = false;
+		}
+		return r;
+		};
+
+	printf("[BENCH] dormant rooms - %d stage-1 monsters per room, all players crashed, %d job workers\n", MONSTER_PER_STAGE, g_job_scheduler.Workers());
+	for (int idle_rooms : DORMANT_BENCH_ROOMS) {
+		RESULT on = run(idle_rooms, true);
+		RESULT off = run(idle_rooms, false);
+		printf("  idle rooms %4d : dormancy off %7.0f ticks/s %.3f core | on %7.0f ticks/s %.3f core\n",
+			idle_rooms, off.ticks, off.cores, on.ticks, on.cores);
+	}
+	room_dormancy.store(true);
+}
+
+/**
+ * @brief 방 수에 따른 메모리 - 방을 ROOM_BENCH_ROOMS 개까지 차례로 늘려가며 만드는 데 걸린 시간과 상주 메모리(RSS)
+ *
+ * 0번 방부터 세션(clients), 방 틱, 흐름장, 방 실행기를 만들고 몬스터 묶음을 꺼내(Acquire_Room_Monsters) 접속한 방처럼 둡니다.
+ * before 는 방을 하나도 만들지 않은 상태이므로, MAX_ROOM 에 비례해서 미리 잡힌 메모리가 있으면 여기에 나타납니다.
+ * 다른 측정이 방을 만들기 전에 재야 하므로 맨 처음에 돌립니다.
+ * 끝나면 몬스터 묶음을 풀에 돌려줍니다. (세션은 만든 방 번호에 그대로 남는다)
+ */
+inline void Benchmark_Rooms()
+{
+	const double mb = 1024.0 * 1024.0;
+	const size_t base = Process_Resident_Bytes();
+	printf("[BENCH] lazy rooms - sessions %zu, monster set %zu, tick %zu, flow fields %zu, actor %zu bytes per room | before %.1f MB RSS, %d rooms created\n",
+		sizeof(array<SESSION, MAX_USER_PER_ROOM>), sizeof(ROOM_MONSTER_POOL_TYPE::SET), sizeof(ROOM_TICK),
+		sizeof(array<array<ROOM_FLOW_FIELD, GRID_SIZE_Y>, MAX_USER_PER_ROOM>), sizeof(ROOM_ACTOR), base / mb, clients.Created_Count());
+	int active = 0;
+	for (int rooms : ROOM_BENCH_ROOMS) {
+		auto begin = high_resolution_clock::now();
+		for (; active < rooms; ++active) {
+			(void)clients[active];	// 세션을 만든다
+			(void)room_ticks[active];
+			(void)flow_fields[active];
+			(void)room_actors[active];
+			Acquire_Room_Monsters(active);
+		}
+		double ms = duration<double, milli>(high_resolution_clock::now() - begin).count();
+		size_t rss = Process_Resident_Bytes();
+		printf("  active rooms %4d : RSS %7.1f MB (+%.1f MB, %.1f KB/room) | created in %.2f ms | monster sets %d\n",
+			rooms, rss / mb, (rss - base) / mb, (rss - base) / 1024.0 / rooms, ms, monster_sets.Created());
+	}
+	for (int room = 0; room < active; ++room) Release_Room_Monsters(room);
+}
+
+/**
+ * @brief 접속 폭주 처리량 측정
+ *
+ * ACCEPT_BENCH_THREADS 개의 스레드가 루프백으로 ACCEPT_BENCH_WAVE 개의 연결을 쉬지 않고 맺고,
+ * 서버의 accept_count 가 그만큼 늘어날 때까지(세션 자리 할당과 recv 등록까지 끝날 때까지) 걸린 시간을 잽니다.
+ * 연결을 모두 끊고 세션이 정리되면 다음 웨이브를 시작합니다.
+ * listen 소켓 수와 미리 걸어둔 accept 수(NetworkIO.h 의 ACCEPT_POOL_SIZE)를 바꿔가며 비교합니다.
+ * 같은 측정을 Windows 에서는 STRESS_TEST 의 _CONNECT_BENCH 로 합니다.
+ */
+inline void Benchmark_Accept()
+{
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(PORT_NUM);
+	inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+	double total_seconds = 0, best_rate = 0;
+	int total_accepted = 0;
+	vector<long long> latencies;
+	for (int wave = 0; wave < ACCEPT_BENCH_WAVES; ++wave) {
+		vector<SOCKET> sockets(ACCEPT_BENCH_WAVE, INVALID_SOCKET);
+		vector<long long> wave_latencies(ACCEPT_BENCH_WAVE, 0);
+		atomic<int> failed = 0;
+		unsigned long long base = g_stats.accept_count.load();
+		auto start_time = high_resolution_clock::now();
+
+		vector<thread> threads;
+		for (int t = 0; t < ACCEPT_BENCH_THREADS; ++t) {
+			threads.emplace_back([&, t]() {
+				for (int i = t; i < ACCEPT_BENCH_WAVE; i += ACCEPT_BENCH_THREADS) {
+					SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
+					auto begin = high_resolution_clock::now();
+					if (connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+						bench_close(s);
+						failed++;
+						continue;
+					}
+					wave_latencies[i] = duration_cast<microseconds>(high_resolution_clock::now() - begin).count();
+					sockets[i] = s;
+				}
+				});
+		}
+		for (auto& th : threads) th.join();
+
+		// 서버가 맺어진 연결을 모두 accept 할 때까지 기다린다.
+		int expected = ACCEPT_BENCH_WAVE - failed.load();
+		while (g_stats.accept_count.load() - base < static_cast<unsigned long long>(expected)
+			&& high_resolution_clock::now() - start_time < ACCEPT_BENCH_TIMEOUT)
+			this_thread::yield();
+		double seconds = duration_cast<microseconds>(high_resolution_clock::now() - start_time).count() / 1e6;
+		int accepted = static_cast<int>(g_stats.accept_count.load() - base);
+		total_seconds += seconds;
+		total_accepted += accepted;
+		best_rate = max(best_rate, accepted / seconds);
+		for (int i = 0; i < ACCEPT_BENCH_WAVE; ++i)
+			if (sockets[i] != INVALID_SOCKET) latencies.push_back(wave_latencies[i]);
+
+		for (auto s : sockets)
+			if (s != INVALID_SOCKET) bench_close(s);
+		// 끊긴 세션이 정리되어 자리가 돌아올 때까지 기다린다.
+		this_thread::sleep_for(500ms);
+		if (failed > 0) printf("  wave %d : %d connects failed\n", wave, failed.load());
+	}
+
+	sort(latencies.begin(), latencies.end());
+	auto percentile = [&](int p) { return latencies.empty() ? 0ll : latencies[latencies.size() * p / 100]; };
+	printf("[BENCH] accept storm (%s) - %d listen sockets, %d outstanding accepts, %d threads x %d waves of %d\n",
+		IO_BACKEND_NAME, static_cast<int>(g_listen_sockets.size()),
+		IO_MULTISHOT_ACCEPT ? static_cast<int>(g_listen_sockets.size()) : ACCEPT_POOL_SIZE,
+		ACCEPT_BENCH_THREADS, ACCEPT_BENCH_WAVES, ACCEPT_BENCH_WAVE);
+	printf("  accepts/s : %.0f avg, %.0f best (%d accepted)\n", total_accepted / total_seconds, best_rate, total_accepted);
+	printf("  connect   : p50 %lldus, p99 %lldus\n", percentile(50), percentile(99));
+}
+
+/**
+ * @brief 측정을 차례로 실행하고 서버를 종료하는 스레드 함수
+ */
+inline void Benchmark_Thread()
+{
+	this_thread::sleep_for(500ms);
+	Benchmark_Rooms();
+	Benchmark_Pool();
+	Benchmark_Slots();
+	Benchmark_Room_Actor();
+	Benchmark_Collision();
+	Benchmark_Grid();
+	Benchmark_Path();
+	Benchmark_HPA();
+	Benchmark_Flow();
+	Benchmark_Monsters();
+	Benchmark_Dormancy();
+	Benchmark_Timer();
+	Benchmark_Codec();
+	Benchmark_Framing();
+	Benchmark_Network();
+	Benchmark_Accept();
+	OverPool.PrintStats("OVER_EXP");
+	SendBufferPool.PrintStats("SEND_BUFFER");
+	RoomJobPool.PrintStats("ROOM_JOB");
+	bench_exit(0);
+}
@@ -0,0 +1,170 @@
+#pragma once
+// BitGrid.h
+// 장애물 그리드를 칸당 1비트로 줄인 것 - 몬스터 이동 판정용
+//  - x 줄마다 z 칸을 64칸씩 uint64_t 에 담는다. (한 층 150 x 19 워드 = 22.8KB, 두 층이 L2 에 들어간다)
+//    bool 배열(한 층 180KB)보다 캐시를 덜 쓰고, 한 번에 64칸을 본다.
+//  - 그리드 밖은 막힌 칸이다. Walkable 은 범위 검사를 분기 대신 비교 결과와 인덱스 clamp 로 한다.
+//    (.at() 처럼 예외를 던지지 않는다)
+//  - 선분 검사는 선분이 지나는 x 줄마다 걸치는 z 구간이 이어져 있으므로 그 구간을 워드 마스크로 한 번에 본다.
+//    맵이 z 방향으로 길어서 대부분의 선분은 x 줄 몇 개, 워드 몇 개로 끝난다.
+//  - 좌표는 칸 단위 실수다. (칸 i 는 [i, i + 1)) 모서리를 스치는 칸도 지나는 칸으로 본다.
+// PathFinder.h (PATH_CELL) 를 먼저 include 해야 한다.
+
+#include "stdafx.h"
+#include <bit>
+
+/**
+ * @brief 칸당 1비트 장애물 그리드
+ * @tparam SIZE_X, SIZE_Z 그리드 크기 - 비트가 1 이면 갈 수 있는 칸
+ */
+template<int SIZE_X, int SIZE_Z>
+class BIT_GRID {
+public:
+	using GRID = array<array<bool, SIZE_Z>, SIZE_X>;
+	static constexpr int WORDS_Z = (SIZE_Z + 63) / 64;
+
+private:
+	static constexpr float EDGE_EPSILON = 1e-4f;		// 모서리를 스치는 칸을 넣기 위한 여유
+
+	array<uint64_t, SIZE_X * WORDS_Z> _bits{};		// [x * WORDS_Z + z / 64] 의 z % 64 번째 비트 (SIZE_Z 뒤의 비트는 0)
+
+	const uint64_t* Row(int x) const { return &_bits[x * WORDS_Z]; }
+
+	// floorf 는 SSE4.1 없이 빌드하면 함수 호출이 되므로 직접 내림한다.
+	static int Floor(float v)
+	{
+		int i = static_cast<int>(v);
+		return i - (v < static_cast<float>(i));
+	}
+
+	// 0 <= z0 <= z1 < SIZE_Z 구간에서 막힌 칸의 비트를 워드별로 넘긴다. visit 이 true 를 돌려주면 멈춘다.
+	template<class VISIT>
+	bool Visit_Blocked(int x, int z0, int z1, bool forward, VISIT&& visit) const
+	{
+		const uint64_t* row = Row(x);
+		const int w0 = z0 >> 6, w1 = z1 >> 6;
+		for (int i = 0; i <= w1 - w0; ++i) {
+			int w = forward ? w0 + i : w1 - i;
+			uint64_t mask = ~0ull;
+			if (w == w0) mask &= ~0ull << (z0 & 63);
+			if (w == w1) mask &= ~0ull >> (63 - (z1 & 63));
+			uint64_t blocked = ~row[w] & mask;
+			if (blocked != 0 && visit(w, blocked)) return true;
+		}
+		return false;
+	}
+
+	// x 줄의 [z0, z1] 가 모두 갈 수 있는 칸인가 (그리드 밖이 섞이면 false)
+	bool Span_Walkable(int x, int z0, int z1) const
+	{
+		if (static_cast<unsigned>(x) >= SIZE_X || z0 < 0 || z1 >= SIZE_Z) return false;
+		const uint64_t* row = Row(x);
+		const int w0 = z0 >> 6, w1 = z1 >> 6;
+		const uint64_t lo = ~0ull << (z0 & 63), hi = ~0ull >> (63 - (z1 & 63));
+		if (w0 == w1) return (~row[w0] & lo & hi) == 0;
+		uint64_t blocked = (~row[w0] & lo) | (~row[w1] & hi);
+		for (int w = w0 + 1; w < w1; ++w) blocked |= ~row[w];
+		return blocked == 0;
+	}
+
+	// x 줄의 [z0, z1] 에서 forward(z 증가) 또는 반대 방향으로 처음 만나는 막힌 칸 (그리드 밖 포함)
+	bool Span_First_Blocked(int x, int z0, int z1, bool forward, int& hit_z) const
+	{
+		if (static_cast<unsigned>(x) >= SIZE_X) {
+			hit_z = forward ? z0 : z1;
+			return true;
+		}
+		if (forward && z0 < 0) {
+			hit_z = z0;
+			return true;
+		}
+		if (false == forward && z1 >= SIZE_Z) {
+			hit_z = z1;
+			return true;
+		}
+		int lo = max(z0, 0), hi = min(z1, SIZE_Z - 1);
+		if (lo <= hi && Visit_Blocked(x, lo, hi, forward, [&](int w, uint64_t blocked) {
+			hit_z = w * 64 + (forward ? countr_zero(blocked) : 63 - countl_zero(blocked));
+			return true;
+			})) return true;
+		if (forward && z1 >= SIZE_Z) {
+			hit_z = max(z0, SIZE_Z);
+			return true;
+		}
+		if (false == forward && z0 < 0) {
+			hit_z = min(z1, -1);
+			return true;
+		}
+		return false;
+	}
+
+public:
+	void Build(const GRID& grid)
+	{
+		_bits.fill(0);
+		for (int x = 0; x < SIZE_X; ++x)
+			for (int z = 0; z < SIZE_Z; ++z)
+				if (grid[x][z]) _bits[x * WORDS_Z + (z >> 6)] |= 1ull << (z & 63);
+	}
+
+	// 갈 수 있는 칸인가 (그리드 밖이면 false)
+	bool Walkable(int x, int z) const
+	{
+		const unsigned ux = static_cast<unsigned>(x), uz = static_cast<unsigned>(z);
+		const bool inside = (ux < static_cast<unsigned>(SIZE_X)) & (uz < static_cast<unsigned>(SIZE_Z));
+		const unsigned index = inside ? ux * WORDS_Z + (uz >> 6) : 0u;		// 밖이면 0 번 워드를 읽고 결과는 버린다
+		return inside & static_cast<bool>((_bits[index] >> (uz & 63)) & 1);
+	}
+
+	/**
+	 * @brief (x0, z0) 에서 (x1, z1) 까지의 선분이 지나는 칸을 x 줄 순서대로 [z 최소, z 최대] 구간으로 넘긴다.
+	 * @param span (x, z_lo, z_hi, z 가 증가하는 방향인가) 를 받고 true 를 돌려주면 멈춘다
+	 * @return span 이 멈췄으면 true
+	 */
+	template<class SPAN>
+	static bool Walk_Columns(float x0, float z0, float x1, float z1, SPAN&& span)
+	{
+		const int cx0 = Floor(x0), cx1 = Floor(x1);
+		const int step = (cx1 >= cx0) ? 1 : -1;
+		const bool forward = z1 >= z0;
+		const float slope = (x1 != x0) ? (z1 - z0) / (x1 - x0) : 0.f;
+		float za = z0;		// 이번 x 줄에 들어올 때의 z
+		for (int cx = cx0; ; cx += step) {
+			float xb = (cx == cx1) ? x1 : static_cast<float>((step > 0) ? cx + 1 : cx);
+			float zb = (cx == cx1) ? z1 : z0 + (xb - x0) * slope;
+			int z_lo = Floor(min(za, zb) - EDGE_EPSILON);
+			int z_hi = Floor(max(za, zb) + EDGE_EPSILON);
+			if (span(cx, z_lo, z_hi, forward)) return true;
+			if (cx == cx1) return false;
+			za = zb;
+		}
+	}
+
+	// 선분이 지나는 칸이 모두 갈 수 있는 칸인가
+	bool Segment_Walkable(float x0, float z0, float x1, float z1) const
+	{
+		return false == Walk_Columns(x0, z0, x1, z1, [this](int x, int z_lo, int z_hi, bool) {
+			return false == Span_Walkable(x, z_lo, z_hi);
+			});
+	}
+
+	bool Segment_Walkable(PATH_CELL from, PATH_CELL to) const
+	{
+		return Segment_Walkable(from.x + 0.5f, from.z + 0.5f, to.x + 0.5f, to.z + 0.5f);
+	}
+
+	/**
+	 * @brief (x0, z0) 에서 (x1, z1) 로 가면서 처음 만나는 막힌 칸을 찾는다.
+	 * @param hit 처음 만난 막힌 칸 (그리드 밖이면 그리드 밖의 칸)
+	 * @return 막힌 칸이 없으면 false
+	 */
+	bool First_Blocked(float x0, float z0, float x1, float z1, PATH_CELL& hit) const
+	{
+		return Walk_Columns(x0, z0, x1, z1, [&](int x, int z_lo, int z_hi, bool forward) {
+			int hit_z;
+			if (false == Span_First_Blocked(x, z_lo, z_hi, forward, hit_z)) return false;
+			hit = PATH_CELL{ static_cast<short>(x), static_cast<short>(hit_z) };
+			return true;
+			});
+	}
+};
@@ -0,0 +1,170 @@
+#pragma once
+// FlowField.h
+// 플레이어를 목표로 하는 흐름장(flow field) - 방마다, 플레이어마다, 층마다 하나씩
+//  - 목표 플레이어가 있는 칸에서부터 거꾸로 Dijkstra 를 돌려 각 칸에서 목표까지의 거리를 구해 둔다.
+//    쫓는 몬스터는 지금 칸의 이웃 8칸 중 거리가 가장 짧은 칸으로 가면 되므로 O(1) 로 방향을 정한다.
+//  - 방의 몬스터가 몇 마리든 길찾기 비용은 플레이어 수(최대 3)만큼만 든다.
+//  - 목표가 계산한 칸에서 FLOW_REBUILD_CELLS 칸 넘게 옮겼을 때만 다시 계산한다.
+//    그 전까지는 목표 근처(근접 공격 거리보다 가까운 칸)로 가는 예전 거리 지도를 그대로 쓴다.
+//  - 다시 계산할 때도 한 번에 다 하지 않는다. 몬스터가 방향을 물어본 칸의 거리가 확정될 때까지만 Dijkstra 를 이어서 돈다.
+//    몬스터가 목표에 가까이 모여 있을수록 계산하는 칸이 적다.
+//  - 이동 비용이 정수(직선 10, 대각선 14)이므로 힙 대신 거리별 버킷(Dial)으로 돈다.
+//  - 계산 범위는 목표 칸 앞뒤 FLOW_RADIUS_Z 칸(몬스터 시야보다 넓다)이고, 그 밖의 몬스터는 A*(PathFinder.h)를 쓴다.
+//  - 거리 배열은 처음 쓸 때 만들고, 플레이어가 나가면 Release 로 돌려준다.
+// PathFinder.h (PATH_CELL) 를 먼저 include 해야 한다.
+
+#include "stdafx.h"
+
+constexpr int FLOW_RADIUS_Z = 128;					// 목표 칸 앞뒤로 계산하는 칸 수 (128칸 = 512, 몬스터 시야 400)
+constexpr int FLOW_REBUILD_CELLS = 2;				// 목표가 이만큼(칸) 넘게 옮기면 다시 계산한다 (8 < 근접 공격 거리 20)
+constexpr uint16_t FLOW_UNREACHED = 0xFFFF;
+constexpr uint16_t FLOW_COST_STRAIGHT = 10;
+constexpr uint16_t FLOW_COST_DIAGONAL = 14;
+constexpr uint16_t FLOW_MAX_COST = 60000;			// 이보다 먼 칸은 계산하지 않는다
+constexpr int FLOW_BUCKETS = 16;					// 가장 비싼 이동 비용보다 커야 한다
+
+/**
+ * @brief 한 목표 칸까지의 거리 지도
+ * @tparam SIZE_X, SIZE_Z 그리드 크기 - grid[x][z] 가 true 면 갈 수 있는 칸
+ */
+template<int SIZE_X, int SIZE_Z>
+class FLOW_FIELD {
+public:
+	using GRID = array<array<bool, SIZE_Z>, SIZE_X>;
+	static constexpr int WINDOW_Z = 2 * FLOW_RADIUS_Z + 1;
+
+private:
+	static constexpr int DX[8]{ -1, 1, 0, 0, -1, -1, 1, 1 };
+	static constexpr int DZ[8]{ 0, 0, 1, -1, -1, 1, -1, 1 };
+
+	vector<uint16_t> _dist;		// [x * WINDOW_Z + (z - _z0)] - 목표까지의 거리 (_cost 보다 작으면 확정)
+	array<vector<int>, FLOW_BUCKETS> _buckets;	// 아직 펼치지 않은 칸 (거리 % FLOW_BUCKETS)
+	int _cost = 0;				// 다음에 펼칠 거리
+	int _pending = 0;			// 버킷에 남은 칸 수
+	const GRID* _grid = nullptr;
+	PATH_CELL _target;
+	int _floor = -1;
+	int _z0 = 0;				// 계산 범위의 첫 z 칸
+	bool _valid = false;
+
+	static bool In_Grid(int x, int z) { return x >= 0 && x < SIZE_X && z >= 0 && z < SIZE_Z; }
+	bool In_Window(int x, int z) const { return In_Grid(x, z) && z >= _z0 && z < _z0 + WINDOW_Z; }
+	int Index(int x, int z) const { return x * WINDOW_Z + (z - _z0); }
+
+	// 대각선은 양 옆 칸이 모두 갈 수 있어야 한다. (PathFinder.h 와 같은 규칙)
+	bool Can_Move(int x, int z, int dir) const
+	{
+		const GRID& grid = *_grid;
+		int nx = x + DX[dir], nz = z + DZ[dir];
+		if (false == In_Grid(nx, nz) || false == grid[nx][nz]) return false;
+		return dir < 4 || (grid[nx][z] && grid[x][nz]);
+	}
+
+	// 거리가 _cost 인 칸을 모두 펼친다.
+	void Expand_Bucket()
+	{
+		vector<int>& bucket = _buckets[_cost % FLOW_BUCKETS];
+		while (false == bucket.empty()) {
+			int cell = bucket.back();
+			bucket.pop_back();
+			_pending--;
+			if (_dist[cell] != _cost) continue;		// 더 짧은 거리로 이미 펼친 칸
+			int x = cell / WINDOW_Z, z = cell % WINDOW_Z + _z0;
+			for (int dir = 0; dir < 8; ++dir) {
+				if (false == Can_Move(x, z, dir)) continue;
+				int nx = x + DX[dir], nz = z + DZ[dir];
+				if (false == In_Window(nx, nz)) continue;
+				int next_cost = _cost + ((dir < 4) ? FLOW_COST_STRAIGHT : FLOW_COST_DIAGONAL);
+				int next = Index(nx, nz);
+				if (next_cost > FLOW_MAX_COST || next_cost >= _dist[next]) continue;
+				_dist[next] = static_cast<uint16_t>(next_cost);
+				_buckets[next_cost % FLOW_BUCKETS].push_back(next);
+				_pending++;
+			}
+		}
+		_cost++;
+	}
+
+	// cell 과 그보다 가까운 칸의 거리가 모두 확정될 때까지 Dijkstra 를 이어서 돈다.
+	void Settle(int cell)
+	{
+		while (_pending > 0 && _cost <= _dist[cell]) Expand_Bucket();
+	}
+
+public:
+	/**
+	 * @brief 목표가 FLOW_REBUILD_CELLS 칸 넘게 옮겼거나 층이 바뀌었으면 거리 지도를 새로 시작한다.
+	 * @return 새로 시작했으면 true (실제 계산은 Next_Cell/Distance 에서 필요한 만큼만 한다)
+	 */
+	bool Update(const GRID& grid, int floor, PATH_CELL target)
+	{
+		if (_valid && floor == _floor &&
+			abs(target.x - _target.x) <= FLOW_REBUILD_CELLS && abs(target.z - _target.z) <= FLOW_REBUILD_CELLS) return false;
+		if (false == In_Grid(target.x, target.z)) {
+			_valid = false;
+			return false;
+		}
+		_grid = &grid;
+		_target = target;
+		_floor = floor;
+		_z0 = max(0, target.z - FLOW_RADIUS_Z);
+		if (_dist.empty()) _dist.resize(static_cast<size_t>(SIZE_X) * WINDOW_Z);
+		fill(_dist.begin(), _dist.end(), FLOW_UNREACHED);
+		for (auto& b : _buckets) b.clear();
+		int start = Index(target.x, target.z);
+		_dist[start] = 0;
+		_buckets[0].push_back(start);
+		_cost = 0;
+		_pending = 1;
+		_valid = true;
+		return true;
+	}
+
+	/**
+	 * @brief from 에서 목표 쪽으로 한 칸 간 칸을 구한다.
+	 * @return 계산 범위 밖이거나 목표까지 갈 수 없거나 이미 목표 칸이면 false
+	 */
+	bool Next_Cell(PATH_CELL from, PATH_CELL& next)
+	{
+		if (false == _valid || false == In_Window(from.x, from.z)) return false;
+		int cell = Index(from.x, from.z);
+		Settle(cell);
+		uint16_t best = _dist[cell];
+		if (best == 0 || best == FLOW_UNREACHED) return false;
+		bool found = false;
+		for (int dir = 0; dir < 8; ++dir) {
+			if (false == Can_Move(from.x, from.z, dir)) continue;
+			int nx = from.x + DX[dir], nz = from.z + DZ[dir];
+			if (false == In_Window(nx, nz)) continue;
+			uint16_t d = _dist[Index(nx, nz)];
+			if (d < best) {
+				best = d;
+				next = PATH_CELL{ static_cast<short>(nx), static_cast<short>(nz) };
+				found = true;
+			}
+		}
+		return found;
+	}
+
+	// 목표까지의 거리 (칸 단위, 갈 수 없으면 -1)
+	float Distance(PATH_CELL cell)
+	{
+		if (false == _valid || false == In_Window(cell.x, cell.z)) return -1.f;
+		int index = Index(cell.x, cell.z);
+		Settle(index);
+		uint16_t d = _dist[index];
+		return (d == FLOW_UNREACHED) ? -1.f : d / static_cast<float>(FLOW_COST_STRAIGHT);
+	}
+
+	// 지금 거리 지도를 계산한 목표 칸
+	PATH_CELL Target() const { return _target; }
+
+	// 거리 배열을 돌려준다. (플레이어가 나갔을 때)
+	void Release()
+	{
+		vector<uint16_t>().swap(_dist);
+		for (auto& b : _buckets) vector<int>().swap(b);
+		_pending = 0;
+		_valid = false;
+	}
+};
@@ -0,0 +1,417 @@
+#pragma once
+// HierarchicalPath.h
+// 긴 거리 몬스터 길찾기 - 장애물 그리드 위의 계층 경로 탐색 (HPA*)
+//  - 그리드를 HPA_CLUSTER_SIZE x HPA_CLUSTER_SIZE 칸 묶음(cluster)으로 나누고, 이웃한 묶음 사이의
+//    경계에서 양쪽이 모두 갈 수 있는 구간(entrance)마다 출입구 칸을 한두 개 정한다.
+//  - 같은 묶음 안의 출입구끼리는 묶음 안에서만 움직이는 최단 거리를 미리 구해 간선으로 잇고,
+//    경계를 건너는 출입구 쌍은 비용 1 간선으로 잇는다. 이 추상 그래프는 서버 시작 때 한 번 만든다.
+//  - 탐색은 시작/목표 칸을 자기 묶음의 출입구에 잠시 이어 붙인 뒤 추상 그래프에서 A* 를 돌리고,
+//    찾은 출입구 사이를 칸 단위 A*(PathFinder.h)로 짧게 이어서 전체 경로를 만든다.
+//  - 만든 그래프는 파일(HPA_CACHE_FILE)에 저장해 두고, 다음 시작 때 그리드가 같으면(해시 비교) 읽어서 쓴다.
+// PathFinder.h 를 먼저 include 해야 한다.
+
+#include "stdafx.h"
+#include <queue>
+
+constexpr int HPA_CLUSTER_SIZE = 16;		// 묶음 한 변의 칸 수
+constexpr int HPA_ENTRANCE_SPLIT = 6;		// 이 길이 이상인 경계 구간은 양 끝에 출입구를 둔다 (짧으면 가운데 하나)
+constexpr int HPA_MIN_CELLS = 48;			// 시작과 목표가 이보다(칸) 멀 때만 계층 탐색을 쓴다
+constexpr float HPA_UNREACHED = 1e30f;
+constexpr uint32_t HPA_CACHE_VERSION = 1;
+constexpr const char* HPA_CACHE_FILE = "hpa_cache.bin";
+
+struct HPA_EDGE {
+	int to;
+	float cost;
+};
+
+struct HPA_NODE {
+	PATH_CELL cell;
+	int cluster;
+};
+
+/**
+ * @brief 한 층의 계층 경로 그래프
+ * @tparam SIZE_X, SIZE_Z 그리드 크기 - grid[x][z] 가 true 면 갈 수 있는 칸
+ *
+ * 간선과 묶음별 출입구 목록은 CSR(시작 위치 배열 + 내용 배열)로 두어 그대로 파일에 쓰고 읽습니다.
+ */
+template<int SIZE_X, int SIZE_Z>
+class HPA_GRAPH {
+public:
+	using GRID = array<array<bool, SIZE_Z>, SIZE_X>;
+	using FINDER = GRID_PATH_FINDER<SIZE_X, SIZE_Z>;
+	static constexpr int CLUSTERS_X = (SIZE_X + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE;
+	static constexpr int CLUSTERS_Z = (SIZE_Z + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE;
+	static constexpr int CLUSTERS = CLUSTERS_X * CLUSTERS_Z;
+
+private:
+	static constexpr int DX[8]{ -1, 1, 0, 0, -1, -1, 1, 1 };
+	static constexpr int DZ[8]{ 0, 0, 1, -1, -1, 1, -1, 1 };
+	static constexpr int CLUSTER_CELLS = HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE;
+
+	vector<HPA_NODE> _nodes;
+	vector<int> _edge_begin;		// 노드 i 의 간선은 _edges[_edge_begin[i] .. _edge_begin[i + 1])
+	vector<HPA_EDGE> _edges;
+	vector<int> _cluster_begin;		// 묶음 c 의 출입구는 _cluster_nodes[_cluster_begin[c] .. _cluster_begin[c + 1])
+	vector<int> _cluster_nodes;
+	uint64_t _grid_hash = 0;
+
+	// 추상 그래프 탐색에 쓰는 배열 - 스레드마다 한 벌씩 두고 세대 번호로 다시 쓴다.
+	struct SEARCH {
+		vector<float> g;
+		vector<int> parent;
+		vector<uint32_t> gen;		// 이번 탐색에서 연 노드면 cur
+		vector<uint32_t> closed;	// 이번 탐색에서 닫은 노드면 cur
+		uint32_t cur = 0;
+		vector<PATH_CELL> segment;
+	};
+
+	static int Cluster_Of(PATH_CELL c) { return (c.x / HPA_CLUSTER_SIZE) * CLUSTERS_Z + c.z / HPA_CLUSTER_SIZE; }
+	static bool In_Grid(int x, int z) { return x >= 0 && x < SIZE_X && z >= 0 && z < SIZE_Z; }
+
+	static float Octile(PATH_CELL a, PATH_CELL b)
+	{
+		int dx = abs(a.x - b.x), dz = abs(a.z - b.z);
+		return static_cast<float>(max(dx, dz) - min(dx, dz)) + PATH_SQRT2 * min(dx, dz);
+	}
+
+	/**
+	 * @brief from 에서 같은 묶음 안에서만 움직이는 최단 거리 (Dijkstra)
+	 * @param dist 묶음 안 칸 번호((x - x0) * HPA_CLUSTER_SIZE + (z - z0)) 별 거리 - 갈 수 없으면 HPA_UNREACHED
+	 */
+	static void Cluster_Dijkstra(const GRID& grid, PATH_CELL from, array<float, CLUSTER_CELLS>& dist)
+	{
+		const int x0 = (from.x / HPA_CLUSTER_SIZE) * HPA_CLUSTER_SIZE, z0 = (from.z / HPA_CLUSTER_SIZE) * HPA_CLUSTER_SIZE;
+		const int x1 = min(x0 + HPA_CLUSTER_SIZE, SIZE_X), z1 = min(z0 + HPA_CLUSTER_SIZE, SIZE_Z);
+		dist.fill(HPA_UNREACHED);
+		using ITEM = pair<float, int>;
+		priority_queue<ITEM, vector<ITEM>, greater<ITEM>> open;
+		int s = (from.x - x0) * HPA_CLUSTER_SIZE + (from.z - z0);
+		dist[s] = 0.f;
+		open.push({ 0.f, s });
+		while (false == open.empty()) {
+			auto [d, local] = open.top();
+			open.pop();
+			if (d > dist[local]) continue;
+			int x = x0 + local / HPA_CLUSTER_SIZE, z = z0 + local % HPA_CLUSTER_SIZE;
+			for (int dir = 0; dir < 8; ++dir) {
+				int nx = x + DX[dir], nz = z + DZ[dir];
+				if (nx < x0 || nx >= x1 || nz < z0 || nz >= z1 || false == grid[nx][nz]) continue;
+				if (dir >= 4 && (false == grid[nx][z] || false == grid[x][nz])) continue;
+				float nd = d + ((dir < 4) ? 1.f : PATH_SQRT2);
+				int next = (nx - x0) * HPA_CLUSTER_SIZE + (nz - z0);
+				if (nd < dist[next]) {
+					dist[next] = nd;
+					open.push({ nd, next });
+				}
+			}
+		}
+	}
+
+	static float Local_Distance(const array<float, CLUSTER_CELLS>& dist, PATH_CELL c)
+	{
+		return dist[(c.x % HPA_CLUSTER_SIZE) * HPA_CLUSTER_SIZE + (c.z % HPA_CLUSTER_SIZE)];
+	}
+
+	static SEARCH& Local_Search()
+	{
+		static thread_local SEARCH search;
+		return search;
+	}
+
+	template<class T>
+	static void Write_Vector(ostream& out, const vector<T>& v)
+	{
+		uint64_t n = v.size();
+		out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+		out.write(reinterpret_cast<const char*>(v.data()), static_cast<streamsize>(n * sizeof(T)));
+	}
+
+	template<class T>
+	static bool Read_Vector(istream& in, vector<T>& v)
+	{
+		uint64_t n = 0;
+		if (false == static_cast<bool>(in.read(reinterpret_cast<char*>(&n), sizeof(n)))) return false;
+		if (n > (1ull << 28)) return false;
+		v.resize(static_cast<size_t>(n));
+		return static_cast<bool>(in.read(reinterpret_cast<char*>(v.data()), static_cast<streamsize>(n * sizeof(T))));
+	}
+
+	// 읽은 그래프의 번호가 모두 범위 안인지 확인한다. (해시가 맞아도 깨지거나 덜 쓴 파일이면 Find 가 범위 밖을 읽는다)
+	bool Validate() const
+	{
+		const int N = static_cast<int>(_nodes.size());
+		if (_edge_begin.size() != _nodes.size() + 1 || _cluster_begin.size() != CLUSTERS + 1 || _cluster_nodes.size() != _nodes.size()) return false;
+		for (const HPA_NODE& n : _nodes)
+			if (false == In_Grid(n.cell.x, n.cell.z) || n.cluster < 0 || n.cluster >= CLUSTERS || Cluster_Of(n.cell) != n.cluster) return false;
+		if (_edge_begin[0] != 0 || _edge_begin[N] != static_cast<int>(_edges.size())) return false;
+		for (int i = 0; i < N; ++i)
+			if (_edge_begin[i] > _edge_begin[i + 1]) return false;
+		for (const HPA_EDGE& e : _edges)
+			if (e.to < 0 || e.to >= N || false == (e.cost >= 0.f && e.cost < HPA_UNREACHED)) return false;
+		if (_cluster_begin[0] != 0 || _cluster_begin[CLUSTERS] != N) return false;
+		for (int c = 0; c < CLUSTERS; ++c) {
+			if (_cluster_begin[c] > _cluster_begin[c + 1]) return false;
+			for (int i = _cluster_begin[c]; i < _cluster_begin[c + 1]; ++i)
+				if (_cluster_nodes[i] < 0 || _cluster_nodes[i] >= N || _nodes[_cluster_nodes[i]].cluster != c) return false;
+		}
+		return true;
+	}
+
+public:
+	// 그리드 내용의 해시 (FNV-1a) - 저장한 그래프가 지금 map.txt 로 만든 것인지 확인한다.
+	static uint64_t Grid_Hash(const GRID& grid)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (int x = 0; x < SIZE_X; ++x)
+			for (int z = 0; z < SIZE_Z; ++z) {
+				hash ^= grid[x][z] ? 1u : 0u;
+				hash *= 1099511628211ull;
+			}
+		return hash;
+	}
+
+	/**
+	 * @brief 그리드에서 묶음, 출입구, 추상 그래프를 만든다.
+	 */
+	void Build(const GRID& grid)
+	{
+		_grid_hash = Grid_Hash(grid);
+		_nodes.clear();
+		unordered_map<int, int> node_of_cell;
+		vector<vector<HPA_EDGE>> adjacency;
+		auto add_node = [&](int x, int z) {
+			int key = x * SIZE_Z + z;
+			auto it = node_of_cell.find(key);
+			if (it != node_of_cell.end()) return it->second;
+			PATH_CELL cell{ static_cast<short>(x), static_cast<short>(z) };
+			int id = static_cast<int>(_nodes.size());
+			_nodes.push_back(HPA_NODE{ cell, Cluster_Of(cell) });
+			adjacency.emplace_back();
+			node_of_cell.emplace(key, id);
+			return id;
+			};
+		auto add_transition = [&](int ax, int az, int bx, int bz) {
+			int a = add_node(ax, az), b = add_node(bx, bz);
+			adjacency[a].push_back(HPA_EDGE{ b, 1.f });
+			adjacency[b].push_back(HPA_EDGE{ a, 1.f });
+			};
+		// 경계 한 줄에서 양쪽이 모두 갈 수 있는 구간을 찾아 출입구를 둔다.
+		// side(i) 가 경계의 i 번째 칸 쌍을 돌려준다.
+		auto scan_border = [&](int length, auto side) {
+			int run = 0;
+			for (int i = 0; i <= length; ++i) {
+				bool open = false;
+				if (i < length) {
+					auto [ax, az, bx, bz] = side(i);
+					open = grid[ax][az] && grid[bx][bz];
+				}
+				if (open) {
+					run++;
+					continue;
+				}
+				if (run > 0) {
+					int first = i - run, last = i - 1;
+					if (run < HPA_ENTRANCE_SPLIT) {
+						auto [ax, az, bx, bz] = side((first + last) / 2);
+						add_transition(ax, az, bx, bz);
+					}
+					else {
+						auto [ax, az, bx, bz] = side(first);
+						add_transition(ax, az, bx, bz);
+						auto [cx, cz, dx, dz] = side(last);
+						add_transition(cx, cz, dx, dz);
+					}
+				}
+				run = 0;
+			}
+			};
+		for (int cx = 0; cx < CLUSTERS_X; ++cx) {
+			for (int cz = 0; cz < CLUSTERS_Z; ++cz) {
+				const int x0 = cx * HPA_CLUSTER_SIZE, z0 = cz * HPA_CLUSTER_SIZE;
+				const int x1 = min(x0 + HPA_CLUSTER_SIZE, SIZE_X), z1 = min(z0 + HPA_CLUSTER_SIZE, SIZE_Z);
+				if (x1 < SIZE_X)		// x 방향 이웃 묶음과의 경계
+					scan_border(z1 - z0, [&](int i) { return array<int, 4>{ x1 - 1, z0 + i, x1, z0 + i }; });
+				if (z1 < SIZE_Z)		// z 방향 이웃 묶음과의 경계
+					scan_border(x1 - x0, [&](int i) { return array<int, 4>{ x0 + i, z1 - 1, x0 + i, z1 }; });
+			}
+		}
+
+		// 묶음별 출입구 목록
+		_cluster_begin.assign(CLUSTERS + 1, 0);
+		for (const HPA_NODE& n : _nodes) _cluster_begin[n.cluster + 1]++;
+		for (int c = 0; c < CLUSTERS; ++c) _cluster_begin[c + 1] += _cluster_begin[c];
+		_cluster_nodes.assign(_nodes.size(), 0);
+		vector<int> fill_pos(_cluster_begin.begin(), _cluster_begin.end() - 1);
+		for (int i = 0; i < static_cast<int>(_nodes.size()); ++i) _cluster_nodes[fill_pos[_nodes[i].cluster]++] = i;
+
+		// 같은 묶음 안의 출입구끼리 묶음 안 최단 거리로 잇는다.
+		array<float, CLUSTER_CELLS> dist;
+		for (int c = 0; c < CLUSTERS; ++c) {
+			for (int i = _cluster_begin[c]; i < _cluster_begin[c + 1]; ++i) {
+				int a = _cluster_nodes[i];
+				Cluster_Dijkstra(grid, _nodes[a].cell, dist);
+				for (int j = _cluster_begin[c]; j < _cluster_begin[c + 1]; ++j) {
+					int b = _cluster_nodes[j];
+					float d = Local_Distance(dist, _nodes[b].cell);
+					if (a != b && d < HPA_UNREACHED) adjacency[a].push_back(HPA_EDGE{ b, d });
+				}
+			}
+		}
+
+		_edge_begin.assign(_nodes.size() + 1, 0);
+		_edges.clear();
+		for (size_t i = 0; i < _nodes.size(); ++i) {
+			_edges.insert(_edges.end(), adjacency[i].begin(), adjacency[i].end());
+			_edge_begin[i + 1] = static_cast<int>(_edges.size());
+		}
+	}
+
+	void Save(ostream& out) const
+	{
+		uint32_t header[4] = { HPA_CACHE_VERSION, HPA_CLUSTER_SIZE, SIZE_X, SIZE_Z };
+		out.write(reinterpret_cast<const char*>(header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(&_grid_hash), sizeof(_grid_hash));
+		Write_Vector(out, _nodes);
+		Write_Vector(out, _edge_begin);
+		Write_Vector(out, _edges);
+		Write_Vector(out, _cluster_begin);
+		Write_Vector(out, _cluster_nodes);
+	}
+
+	/**
+	 * @brief Save 로 저장한 그래프를 읽는다.
+	 * @return 형식이나 버전이 다르거나, grid 로 만든 그래프가 아니거나, 번호가 범위 밖이면 false (다시 Build 해야 한다)
+	 */
+	bool Load(istream& in, const GRID& grid)
+	{
+		uint32_t header[4]{};
+		uint64_t hash = 0;
+		if (false == static_cast<bool>(in.read(reinterpret_cast<char*>(header), sizeof(header)))) return false;
+		if (header[0] != HPA_CACHE_VERSION || header[1] != HPA_CLUSTER_SIZE || header[2] != SIZE_X || header[3] != SIZE_Z) return false;
+		if (false == static_cast<bool>(in.read(reinterpret_cast<char*>(&hash), sizeof(hash)))) return false;
+		if (hash != Grid_Hash(grid)) return false;
+		if (false == Read_Vector(in, _nodes) || false == Read_Vector(in, _edge_begin) || false == Read_Vector(in, _edges) ||
+			false == Read_Vector(in, _cluster_begin) || false == Read_Vector(in, _cluster_nodes)) return false;
+		if (false == Validate()) {
+			_nodes.clear();
+			_edge_begin.clear();
+			_edges.clear();
+			_cluster_begin.clear();
+			_cluster_nodes.clear();
+			return false;
+		}
+		_grid_hash = hash;
+		return true;
+	}
+
+	size_t Nodes() const { return _nodes.size(); }
+	size_t Edges() const { return _edges.size(); }
+
+	/**
+	 * @brief start 에서 goal 까지의 경로를 추상 그래프로 찾고 칸 단위로 이어 붙인다.
+	 * @param goal_range goal 에서 이 거리(칸) 안에 들어가면 도착으로 보고 경로를 자른다
+	 * @param path 시작 칸 다음 칸부터 도착 칸까지
+	 *
+	 * 반환하는 expanded 는 추상 그래프에서 펼친 노드 수와 구간을 이을 때 펼친 칸 수의 합입니다.
+	 */
+	PATH_SEARCH_STATS Find(const GRID& grid, PATH_CELL start, PATH_CELL goal, float goal_range, vector<PATH_CELL>& path)
+	{
+		PATH_SEARCH_STATS stats;
+		path.clear();
+		if (false == In_Grid(start.x, start.z) || false == In_Grid(goal.x, goal.z) || _nodes.empty()) return stats;
+
+		// 시작/목표 칸에서 자기 묶음의 출입구까지의 거리
+		array<float, CLUSTER_CELLS> from_start, to_goal;
+		Cluster_Dijkstra(grid, start, from_start);
+		Cluster_Dijkstra(grid, goal, to_goal);
+		const int goal_cluster = Cluster_Of(goal);
+		const int N = static_cast<int>(_nodes.size());
+		const int S = N, G = N + 1;		// 시작/목표를 나타내는 임시 노드 번호
+
+		SEARCH& search = Local_Search();
+		if (search.g.size() < static_cast<size_t>(N + 2)) {
+			search.g.resize(N + 2);
+			search.parent.resize(N + 2);
+			search.gen.assign(N + 2, 0);
+			search.closed.assign(N + 2, 0);
+			search.cur = 0;
+		}
+		if (++search.cur == 0) {
+			fill(search.gen.begin(), search.gen.end(), 0u);
+			fill(search.closed.begin(), search.closed.end(), 0u);
+			search.cur = 1;
+		}
+		auto cell_of = [&](int n) { return (n == S) ? start : (n == G) ? goal : _nodes[n].cell; };
+		using ITEM = pair<float, int>;
+		priority_queue<ITEM, vector<ITEM>, greater<ITEM>> open;
+		auto relax = [&](int from, int to, float cost) {
+			float g = search.g[from] + cost;
+			if (search.closed[to] == search.cur || (search.gen[to] == search.cur && g >= search.g[to])) return;
+			search.gen[to] = search.cur;
+			search.g[to] = g;
+			search.parent[to] = from;
+			open.push({ g + Octile(cell_of(to), goal), to });
+			};
+		search.gen[S] = search.cur;
+		search.g[S] = 0.f;
+		search.parent[S] = -1;
+		open.push({ Octile(start, goal), S });
+		bool found = false;
+		while (false == open.empty()) {
+			int n = open.top().second;
+			open.pop();
+			if (search.closed[n] == search.cur) continue;		// 더 짧은 길로 이미 꺼낸 노드
+			search.closed[n] = search.cur;
+			stats.expanded++;
+			if (n == G) {
+				found = true;
+				break;
+			}
+			if (n == S) {
+				int c = Cluster_Of(start);
+				for (int i = _cluster_begin[c]; i < _cluster_begin[c + 1]; ++i) {
+					float d = Local_Distance(from_start, _nodes[_cluster_nodes[i]].cell);
+					if (d < HPA_UNREACHED) relax(S, _cluster_nodes[i], d);
+				}
+				if (c == goal_cluster && Local_Distance(from_start, goal) < HPA_UNREACHED)
+					relax(S, G, Local_Distance(from_start, goal));
+				continue;
+			}
+			for (int e = _edge_begin[n]; e < _edge_begin[n + 1]; ++e) relax(n, _edges[e].to, _edges[e].cost);
+			if (_nodes[n].cluster == goal_cluster) {
+				float d = Local_Distance(to_goal, _nodes[n].cell);
+				if (d < HPA_UNREACHED) relax(n, G, d);
+			}
+		}
+		if (false == found) return stats;
+
+		// 추상 경로의 노드 사이를 칸 단위 A* 로 잇는다. (같은 묶음이거나 경계 건너 한 칸이라 짧다)
+		vector<PATH_CELL> waypoints;
+		for (int n = G; n != -1; n = search.parent[n]) waypoints.push_back(cell_of(n));
+		reverse(waypoints.begin(), waypoints.end());
+		static const vector<PATH_CELL> no_blocked;
+		FINDER& finder = FINDER::Local();
+		const float range_sq = goal_range * goal_range;
+		for (size_t i = 0; i + 1 < waypoints.size(); ++i) {
+			if (waypoints[i] == waypoints[i + 1]) continue;
+			PATH_SEARCH_STATS seg = finder.Find(grid, waypoints[i], waypoints[i + 1], 0.f, no_blocked, search.segment);
+			stats.expanded += seg.expanded;
+			if (seg.result != PATH_FOUND) {
+				path.clear();
+				return stats;
+			}
+			for (const PATH_CELL& c : search.segment) {
+				path.push_back(c);
+				int dx = c.x - goal.x, dz = c.z - goal.z;
+				if (static_cast<float>(dx * dx + dz * dz) <= range_sq) {
+					stats.result = PATH_FOUND;
+					return stats;
+				}
+			}
+		}
+		stats.result = PATH_FOUND;
+		return stats;
+	}
+};
@@ -0,0 +1,47 @@
+#pragma once
+// Interest.h
+// 관심 영역(Area of Interest) - 받는 플레이어마다 어떤 상태를 얼마나 자주 보낼지 정한다.
+//  - 맵은 y = -100 을 경계로 위층(0)과 아래층(1)로 나뉜다. (SESSION::CheckPosition 의 스테이지 계산과 같은 기준)
+//  - 다른 층의 대상은 보내지 않는다.
+//  - 같은 층에서 AOI_NEAR_RANGE 안이면 매번, AOI_FAR_RANGE 안이거나 받는 쪽의 현재 스테이지(cur_stage)에 속한 대상이면
+//    줄인 주기로 보내고, 그 밖이면 보내지 않는다.
+//  - 죽음처럼 한 번만 일어나는 상태 변화는 관심 영역과 상관없이 모두에게 보낸다. (호출하는 쪽에서 처리)
+
+#include "stdafx.h"
+
+constexpr float FLOOR_SPLIT_Y = -100.f;			// 이 높이 위가 위층
+constexpr float AOI_NEAR_RANGE = 400.f;			// 몬스터 시야(view_range)와 같은 거리 - 매 틱 보낸다
+constexpr float AOI_FAR_RANGE = 1200.f;			// STAGE_SIZE - 줄인 주기로 보낸다
+constexpr int AOI_REDUCED_INTERVAL = 5;			// 줄인 주기 - 방 틱 5번에 한 번 (10Hz -> 2Hz)
+constexpr auto AOI_PLAYER_REDUCED_PERIOD = 200ms;	// 멀리 있는 플레이어 상태를 보내는 최소 간격
+
+enum INTEREST_LEVEL { INTEREST_NONE, INTEREST_REDUCED, INTEREST_FULL };
+
+inline int Get_Floor(const XMFLOAT3& pos)
+{
+	return (pos.y >= FLOOR_SPLIT_Y) ? 0 : 1;
+}
+
+// 위치가 속한 스테이지 - 위층은 z 가 커질수록, 아래층은 z 가 작아질수록 다음 스테이지다.
+inline short Get_Stage(const XMFLOAT3& pos)
+{
+	if (Get_Floor(pos) == 0)
+		return static_cast<short>((pos.z - 300.f) / STAGE_SIZE);
+	return 3 + static_cast<short>((MAP_Z_SIZE - pos.z) / STAGE_SIZE);
+}
+
+/**
+ * @brief viewer 에게 target 의 상태를 얼마나 자주 보낼지 정한다.
+ * @param viewer_stage 받는 플레이어의 현재 스테이지 (cur_stage)
+ * @param target_stage 대상이 속한 스테이지 (몬스터는 소환된 스테이지)
+ */
+inline INTEREST_LEVEL Get_Interest(const XMFLOAT3& viewer_pos, short viewer_stage, const XMFLOAT3& target_pos, short target_stage)
+{
+	if (Get_Floor(viewer_pos) != Get_Floor(target_pos)) return INTEREST_NONE;
+	float dx = viewer_pos.x - target_pos.x;
+	float dz = viewer_pos.z - target_pos.z;
+	float dist_sq = dx * dx + dz * dz;
+	if (dist_sq <= AOI_NEAR_RANGE * AOI_NEAR_RANGE) return INTEREST_FULL;
+	if (dist_sq <= AOI_FAR_RANGE * AOI_FAR_RANGE || target_stage == viewer_stage) return INTEREST_REDUCED;
+	return INTEREST_NONE;
+}
@@ -0,0 +1,307 @@
+#pragma once
+// JobSystem.h
+// 게임 로직(방 메시지, 방 틱, 몬스터 업데이트)을 돌리는 work-stealing 작업 스케줄러
+//  - 작업 스레드마다 자기만 넣고 빼는 작업 덱(Chase-Lev)과, 다른 스레드가 작업을 넣는 입력 큐가 있다.
+//  - 작업은 Submit 할 때 정한 "집" 작업 스레드의 입력 큐로 들어간다. 방은 방 번호로 집을 정하므로
+//    보통은 같은 코어에서 돌아 방의 데이터가 그 코어 캐시에 남는다.
+//  - 작업 스레드는 자기 덱 -> 자기 입력 큐 -> 다른 스레드의 덱/입력 큐(훔치기) 순으로 일을 찾고,
+//    일이 없으면 잠든다. 한 방에 부하가 몰려 집 스레드가 밀리면 쉬는 스레드가 가져가서 처리한다.
+//  - 네트워크 I/O 워커와 타이머/DB 스레드는 작업을 넣기만 하고 실행하지 않는다.
+//  - 같은 JOB 은 실행이 시작되기 전에는 다시 Submit 하지 않는다. (덱 하나에 같은 작업이 두 번 들어가지 않으므로
+//    덱 크기는 동시에 대기하는 작업 수 - 방 수 - 만큼이면 된다)
+
+#include "stdafx.h"
+#include <condition_variable>
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+constexpr int MAX_JOB_WORKERS = 64;
+constexpr int64_t JOB_DEQUE_SIZE = 4096;		// 작업 스레드 하나의 덱에 쌓일 수 있는 작업 수
+constexpr int64_t JOB_DEQUE_MASK = JOB_DEQUE_SIZE - 1;
+static_assert((JOB_DEQUE_SIZE & JOB_DEQUE_MASK) == 0, "JOB_DEQUE_SIZE must be a power of two");
+
+/**
+ * @brief 스케줄러가 실행하는 작업
+ *
+ * 방 실행기(RoomActor.h 의 ROOM_ACTOR)가 상속해서 Run 에서 우편함의 메시지를 처리합니다.
+ */
+class JOB {
+public:
+	virtual ~JOB() = default;
+	virtual void Run() = 0;
+};
+
+/**
+ * @brief 작업 스레드의 이용률 통계
+ *
+ * 작업 스레드 자신만 쓰고, Stats_Thread 는 읽기만 합니다.
+ */
+struct alignas(64) JOB_WORKER_STATS {
+	atomic<unsigned long long> jobs{ 0 };		// 실행한 작업 수
+	atomic<unsigned long long> steals{ 0 };		// 다른 스레드에서 훔쳐 온 작업 수
+	atomic<unsigned long long> busy_ns{ 0 };	// 작업 실행에 쓴 시간의 합
+	atomic<unsigned long long> sleeps{ 0 };		// 일이 없어 잠든 횟수
+};
+
+/**
+ * @brief Chase-Lev work-stealing 덱 (크기 고정)
+ *
+ * Push/Pop 은 주인 스레드만 아래쪽(bottom)에서, Steal 은 다른 스레드가 위쪽(top)에서 합니다.
+ * 마지막 하나를 주인과 도둑이 동시에 꺼내려 할 때만 top 의 CAS 로 경쟁합니다.
+ */
+class JOB_DEQUE {
+	alignas(64) atomic<int64_t> _top{ 0 };
+	alignas(64) atomic<int64_t> _bottom{ 0 };
+	array<atomic<JOB*>, JOB_DEQUE_SIZE> _buf{};
+public:
+	// 주인 스레드만 호출한다. 가득 찼으면 false
+	bool Push(JOB* job)
+	{
+		int64_t b = _bottom.load(memory_order_relaxed);
+		int64_t t = _top.load(memory_order_acquire);
+		if (b - t >= JOB_DEQUE_SIZE) return false;
+		_buf[b & JOB_DEQUE_MASK].store(job, memory_order_relaxed);
+		_bottom.store(b + 1, memory_order_release);
+		return true;
+	}
+
+	// 주인 스레드만 호출한다. 마지막에 넣은 작업부터 꺼낸다.
+	JOB* Pop()
+	{
+		int64_t b = _bottom.load(memory_order_relaxed) - 1;
+		_bottom.store(b, memory_order_seq_cst);
+		int64_t t = _top.load(memory_order_seq_cst);
+		if (t > b) {
+			_bottom.store(b + 1, memory_order_relaxed);
+			return nullptr;
+		}
+		JOB* job = _buf[b & JOB_DEQUE_MASK].load(memory_order_relaxed);
+		if (t == b) {
+			// 마지막 하나 - 도둑과 경쟁한다.
+			if (false == _top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+				job = nullptr;
+			_bottom.store(b + 1, memory_order_relaxed);
+		}
+		return job;
+	}
+
+	// 아무 스레드나 호출한다. 가장 먼저 넣은 작업을 가져간다.
+	JOB* Steal()
+	{
+		int64_t t = _top.load(memory_order_seq_cst);
+		int64_t b = _bottom.load(memory_order_seq_cst);
+		if (t >= b) return nullptr;
+		JOB* job = _buf[t & JOB_DEQUE_MASK].load(memory_order_relaxed);
+		if (false == _top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+			return nullptr;
+		return job;
+	}
+
+	bool Empty() const { return _top.load() >= _bottom.load(); }
+};
+
+/**
+ * @brief 지금 스레드를 cpu 번 코어에 고정한다.
+ * @return 실패하면 false (코어 번호가 코어 수보다 크면 나머지로 고친다)
+ */
+inline bool Pin_Thread(int cpu)
+{
+	int cores = max(1, static_cast<int>(thread::hardware_concurrency()));
+	cpu %= cores;
+#ifdef _WIN32
+	if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8)) return false;
+	return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#else
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+/**
+ * @brief work-stealing 작업 스케줄러
+ *
+ * Start 로 작업 스레드를 만들고, Submit 으로 작업을 집 스레드에 넘깁니다.
+ * 서버는 전역 g_job_scheduler 하나를 쓰고, 벤치마크는 따로 만들어서 씁니다.
+ */
+class JOB_SCHEDULER {
+	struct alignas(64) WORKER {
+		JOB_DEQUE deque;
+		mutex lock;					// inbox, sleeping 보호
+		condition_variable cv;
+		vector<JOB*> inbox;			// 다른 스레드가 넣은 작업 (들어온 순서대로)
+		bool sleeping = false;
+		JOB_WORKER_STATS stats;
+		thread th;
+	};
+
+	unique_ptr<WORKER[]> _workers;
+	int _num_workers = 0;
+	bool _steal = true;
+	atomic<int> _sleepers{ 0 };
+	atomic_bool _stopping{ false };
+
+	static inline thread_local JOB_SCHEDULER* t_scheduler = nullptr;
+	static inline thread_local int t_index = -1;
+
+	// 입력 큐에 쌓인 작업을 자기 덱으로 옮긴다. (덱이 가득 차면 남은 것은 입력 큐에 둔다)
+	void Drain_Inbox(WORKER& w, vector<JOB*>& batch)
+	{
+		batch.clear();
+		{
+			lock_guard<mutex> ll{ w.lock };
+			batch.swap(w.inbox);
+		}
+		size_t i = 0;
+		for (; i < batch.size(); ++i)
+			if (false == w.deque.Push(batch[i])) break;
+		if (i < batch.size()) {
+			lock_guard<mutex> ll{ w.lock };
+			w.inbox.insert(w.inbox.begin(), batch.begin() + i, batch.end());
+		}
+	}
+
+	// 다른 작업 스레드의 덱, 그다음 입력 큐에서 작업 하나를 가져온다.
+	JOB* Steal_From_Others(int me)
+	{
+		for (int k = 1; k < _num_workers; ++k) {
+			WORKER& victim = _workers[(me + k) % _num_workers];
+			if (JOB* job = victim.deque.Steal()) return job;
+		}
+		for (int k = 1; k < _num_workers; ++k) {
+			WORKER& victim = _workers[(me + k) % _num_workers];
+			unique_lock<mutex> ul{ victim.lock, try_to_lock };
+			if (false == ul.owns_lock() || victim.inbox.empty()) continue;
+			JOB* job = victim.inbox.front();
+			victim.inbox.erase(victim.inbox.begin());
+			return job;
+		}
+		return nullptr;
+	}
+
+	// 잠든 작업 스레드 하나를 깨워서 밀린 작업을 훔쳐 가게 한다.
+	void Wake_Idle(int except)
+	{
+		if (false == _steal || _sleepers.load() == 0) return;
+		for (int k = 1; k < _num_workers; ++k) {
+			WORKER& w = _workers[(except + k) % _num_workers];
+			bool wake = false;
+			{
+				lock_guard<mutex> ll{ w.lock };
+				wake = w.sleeping;
+				w.sleeping = false;
+			}
+			if (wake) {
+				w.cv.notify_one();
+				return;
+			}
+		}
+	}
+
+	void Worker_Loop(int me)
+	{
+		t_scheduler = this;
+		t_index = me;
+		WORKER& w = _workers[me];
+		vector<JOB*> batch;
+		while (true) {
+			JOB* job = w.deque.Pop();
+			if (job == nullptr) {
+				Drain_Inbox(w, batch);
+				job = w.deque.Pop();
+			}
+			if (job == nullptr && _steal && _num_workers > 1) {
+				job = Steal_From_Others(me);
+				if (job) w.stats.steals.fetch_add(1, memory_order_relaxed);
+			}
+			if (job == nullptr) {
+				unique_lock<mutex> ul{ w.lock };
+				if (_stopping.load()) return;
+				if (false == w.inbox.empty()) continue;
+				w.sleeping = true;
+				w.stats.sleeps.fetch_add(1, memory_order_relaxed);
+				_sleepers++;
+				w.cv.wait(ul, [&]() { return false == w.sleeping || _stopping.load(); });
+				w.sleeping = false;
+				_sleepers--;
+				continue;
+			}
+			auto begin_time = high_resolution_clock::now();
+			job->Run();
+			w.stats.busy_ns.fetch_add(duration_cast<nanoseconds>(high_resolution_clock::now() - begin_time).count(), memory_order_relaxed);
+			w.stats.jobs.fetch_add(1, memory_order_relaxed);
+		}
+	}
+
+public:
+	~JOB_SCHEDULER() { Stop(); }
+
+	/**
+	 * @brief 작업 스레드를 만든다.
+	 * @param num_workers 작업 스레드 수 (1 ~ MAX_JOB_WORKERS)
+	 * @param pin_first_cpu 0 이상이면 i 번 작업 스레드를 pin_first_cpu + i 번 코어에 고정한다
+	 * @param steal false 면 훔치지 않고 집 스레드에서만 실행한다 (비교 측정용)
+	 */
+	void Start(int num_workers, int pin_first_cpu = -1, bool steal = true)
+	{
+		_num_workers = min(max(1, num_workers), MAX_JOB_WORKERS);
+		_steal = steal;
+		_stopping = false;
+		_workers = make_unique<WORKER[]>(_num_workers);
+		for (int i = 0; i < _num_workers; ++i) {
+			_workers[i].th = thread([this, i, pin_first_cpu]() {
+				if (pin_first_cpu >= 0) Pin_Thread(pin_first_cpu + i);
+				Worker_Loop(i);
+				});
+		}
+	}
+
+	// 작업 스레드를 모두 끝낸다. 남은 작업은 실행하지 않는다.
+	void Stop()
+	{
+		if (_workers == nullptr) return;
+		_stopping = true;
+		for (int i = 0; i < _num_workers; ++i) {
+			{
+				lock_guard<mutex> ll{ _workers[i].lock };
+				_workers[i].sleeping = false;
+			}
+			_workers[i].cv.notify_all();
+		}
+		for (int i = 0; i < _num_workers; ++i)
+			if (_workers[i].th.joinable()) _workers[i].th.join();
+		_workers.reset();
+	}
+
+	/**
+	 * @brief 작업을 집 스레드(home % 작업 스레드 수)의 입력 큐에 넣는다. 아무 스레드나 호출할 수 있다.
+	 *
+	 * 집 스레드가 자고 있으면 깨우고, 일하는 중이면 잠든 다른 스레드를 하나 깨워 훔쳐 가게 합니다.
+	 */
+	void Submit(JOB* job, int home)
+	{
+		int index = home % _num_workers;
+		WORKER& w = _workers[index];
+		bool wake = false;
+		{
+			lock_guard<mutex> ll{ w.lock };
+			w.inbox.push_back(job);
+			wake = w.sleeping;
+			w.sleeping = false;
+		}
+		if (wake) w.cv.notify_one();
+		else if (t_scheduler != this || t_index != index) Wake_Idle(index);
+	}
+
+	int Workers() const { return _num_workers; }
+	const JOB_WORKER_STATS& Stats(int index) const { return _workers[index].stats; }
+
+	// 지금 스레드가 이 스케줄러의 작업 스레드면 그 번호, 아니면 -1
+	int Current_Worker() const { return (t_scheduler == this) ? t_index : -1; }
+};
+
+// 서버의 게임 로직 스케줄러 - main 에서 Start 한다.
+inline JOB_SCHEDULER g_job_scheduler;
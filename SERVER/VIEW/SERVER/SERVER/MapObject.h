@@ -2,10 +2,10 @@
 #include "stdafx.h"
 
 
-//۹ - 260 - 1200
-//1 - 1260 - 2550
-//2 - 2650 - 3550
-//ܹ - 3690 - 4500
+//시작방 - 260 - 1200
+//1번방 - 1260 - 2550
+//2번방 - 2650 - 3550
+//계단방 - 3690 - 4500
 
 class MapObject
 {
@@ -2,6 +2,8 @@
 
 #include <cassert>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include "stdafx.h"
 
 //#define _USE_MYLOCKFREEQUEUE 
@@ -86,19 +88,294 @@ public:
 };
 
 
+constexpr int MAGAZINE_SIZE = 64;          // 매거진 하나에 담는 객체 수
+constexpr int MAX_OBJECT_POOLS = 16;       // 동시에 살아있을 수 있는 CObjectPool 의 최대 개수 (풀이 없어지면 id 를 다시 쓴다)
+
+// 스레드별 캐시 - CObjectPool 마다 매거진 두 개(loaded, previous)를 가진다.
+struct POOL_THREAD_CACHE {
+    unsigned long long owner = 0;       // 캐시를 채운 풀의 일련번호 (id 는 다시 쓰이므로 이걸로 구분한다)
+    void* pool = nullptr;
+    void* loaded = nullptr;
+    void* previous = nullptr;
+    unsigned long long allocs = 0;      // 아직 풀의 카운터에 더하지 않은 할당/반환 수
+    unsigned long long frees = 0;
+    void (*flush)(void* pool, POOL_THREAD_CACHE& cache) = nullptr;
+};
+
+// id 마다 그 id 를 쓰는 살아있는 풀의 일련번호 (0 이면 빈 id)
+inline std::atomic<unsigned long long> g_pool_owners[MAX_OBJECT_POOLS]{};
+inline std::atomic<unsigned long long> g_pool_serial{ 0 };
+
+struct POOL_THREAD_CACHES {
+    POOL_THREAD_CACHE caches[MAX_OBJECT_POOLS];
+    ~POOL_THREAD_CACHES()
+    {
+        // 스레드가 끝나면 가지고 있던 매거진을 풀에 돌려준다. (이미 없어진 풀의 캐시는 버린다)
+        for (int i = 0; i < MAX_OBJECT_POOLS; ++i) {
+            POOL_THREAD_CACHE& cache = caches[i];
+            if (cache.flush != nullptr && g_pool_owners[i].load() == cache.owner) cache.flush(cache.pool, cache);
+        }
+    }
+};
+inline thread_local POOL_THREAD_CACHES t_pool_caches;
+
+struct POOL_STATS {
+    std::atomic<unsigned long long> allocs{ 0 };
+    std::atomic<unsigned long long> frees{ 0 };
+    std::atomic<unsigned long long> depot_gets{ 0 };    // 창고에서 매거진을 받아온 횟수
+    std::atomic<unsigned long long> depot_puts{ 0 };    // 창고에 가득 찬 매거진을 넘긴 횟수
+    std::atomic<unsigned long long> cas_retries{ 0 };   // 창고 CAS 실패 횟수 (경합)
+    std::atomic<unsigned long long> grows{ 0 };         // 창고가 비어 객체를 새로 만든 매거진 수
+    std::atomic<unsigned long long> trims{ 0 };         // high-water 를 넘어 객체를 해제한 매거진 수
+};
+
+// 포인터 상위 16비트에 태그를 붙여 ABA 를 막는 lock-free 스택
+// 노드(매거진)는 풀이 살아있는 동안 해제하지 않으므로 pop 중에 next 를 읽어도 안전하다.
+template<class N>
+class TaggedStack {
+    static constexpr uint64_t PTR_MASK = (1ull << 48) - 1;
+    static constexpr uint64_t TAG_ONE = 1ull << 48;
+    std::atomic<uint64_t> top{ 0 };
+public:
+    void push(N* node, std::atomic<unsigned long long>& retries)
+    {
+        uint64_t old_top = top.load(std::memory_order_relaxed);
+        while (true) {
+            node->next.store(reinterpret_cast<N*>(old_top & PTR_MASK), std::memory_order_relaxed);
+            uint64_t new_top = reinterpret_cast<uintptr_t>(node) | ((old_top & ~PTR_MASK) + TAG_ONE);
+            if (top.compare_exchange_weak(old_top, new_top, std::memory_order_release, std::memory_order_relaxed))
+                return;
+            retries.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    N* pop(std::atomic<unsigned long long>& retries)
+    {
+        uint64_t old_top = top.load(std::memory_order_acquire);
+        while (true) {
+            N* node = reinterpret_cast<N*>(old_top & PTR_MASK);
+            if (node == nullptr) return nullptr;
+            N* next = node->next.load(std::memory_order_relaxed);
+            uint64_t new_top = reinterpret_cast<uintptr_t>(next) | ((old_top & ~PTR_MASK) + TAG_ONE);
+            if (top.compare_exchange_weak(old_top, new_top, std::memory_order_acquire, std::memory_order_acquire))
+                return node;
+            retries.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+template<class T>
+struct Magazine {
+    std::atomic<Magazine*> next{ nullptr };
+    int count = 0;
+    T* objs[MAGAZINE_SIZE];
+};
+
+/**
+ * @brief 스레드별 매거진 캐시와 lock-free 공용 창고(depot)로 이루어진 오브젝트 풀
+ *
+ * 할당/반환은 대부분 자기 스레드의 매거진 안에서 끝나고, 매거진이 비거나 가득 찼을 때만
+ * 창고와 매거진을 통째로 주고받습니다. 창고의 매거진이 high-water 를 넘으면 low-water 까지
+ * 객체를 해제하여, 순간적으로 늘어난 메모리를 돌려줍니다.
+ */
 template<class T>
 class CObjectPool {
+    typedef Magazine<T> MAG;
+private:
+    TaggedStack<MAG> fullMagazines;         // 창고 - 객체가 들어있는 매거진
+    TaggedStack<MAG> emptyMagazines;
+    std::atomic<size_t> fullCount{ 0 };
+    size_t highWater;                       // 창고에 둘 매거진 수의 상한과 정리 후 목표
+    size_t lowWater;
+    int poolId = -1;
+    unsigned long long serial;              // 풀마다 다른 일련번호 - 스레드 캐시가 같은 id 를 쓰던 옛 풀의 것인지 가린다
+    std::mutex magazineLock;
+    vector<MAG*> allMagazines;              // 풀이 해제될 때 지울 매거진 목록
+public:
+    POOL_STATS stats;
+
+    CObjectPool(size_t MemorySize, size_t HighWater = 0)
+    {
+        // 빈 id 를 차지한다. 모두 쓰고 있으면 스레드 캐시 배열 밖을 쓰게 되므로 만들지 않는다.
+        serial = g_pool_serial.fetch_add(1) + 1;
+        for (int i = 0; i < MAX_OBJECT_POOLS && poolId < 0; ++i) {
+            unsigned long long expected = 0;
+            if (g_pool_owners[i].compare_exchange_strong(expected, serial)) poolId = i;
+        }
+        if (poolId < 0) throw std::length_error("CObjectPool - more than MAX_OBJECT_POOLS pools alive");
+        size_t count = (MemorySize + MAGAZINE_SIZE - 1) / MAGAZINE_SIZE;
+        highWater = (HighWater != 0) ? HighWater : ((count * 2 > 16) ? count * 2 : 16);
+        lowWater = highWater / 2;
+        for (size_t i = 0; i < count; ++i) {
+            MAG* mag = GetEmptyMagazine();
+            Fill(mag);
+            fullMagazines.push(mag, stats.cas_retries);
+            fullCount.fetch_add(1);
+        }
+    }
+    ~CObjectPool()
+    {
+        FlushThreadCache();
+        // 다른 스레드에 남은 이 풀의 캐시는 그 스레드가 다음에 같은 id 를 쓸 때나 끝날 때 버려진다. (그 안의 객체는 회수하지 못함)
+        g_pool_owners[poolId].store(0);
+        MAG* mag;
+        while ((mag = fullMagazines.pop(stats.cas_retries)) != nullptr) {
+            for (int i = 0; i < mag->count; ++i) delete mag->objs[i];
+        }
+        for (auto m : allMagazines) delete m;
+    }
+
+    T* GetMemory()
+    {
+        POOL_THREAD_CACHE& cache = GetCache();
+        MAG* loaded = static_cast<MAG*>(cache.loaded);
+        if (loaded->count == 0) {
+            MAG* previous = static_cast<MAG*>(cache.previous);
+            if (previous->count > 0) {
+                std::swap(cache.loaded, cache.previous);
+            }
+            else {
+                MAG* full = fullMagazines.pop(stats.cas_retries);
+                if (full != nullptr) {
+                    fullCount.fetch_sub(1);
+                    stats.depot_gets.fetch_add(1, std::memory_order_relaxed);
+                }
+                else {
+                    full = GetEmptyMagazine();
+                    Fill(full);
+                    stats.grows.fetch_add(1, std::memory_order_relaxed);
+                }
+                emptyMagazines.push(previous, stats.cas_retries);
+                cache.previous = cache.loaded;
+                cache.loaded = full;
+                SyncCounters(cache);
+            }
+            loaded = static_cast<MAG*>(cache.loaded);
+        }
+        cache.allocs++;
+        return loaded->objs[--loaded->count];
+    }
+    void ReturnMemory(T* Mem)
+    {
+        POOL_THREAD_CACHE& cache = GetCache();
+        MAG* loaded = static_cast<MAG*>(cache.loaded);
+        if (loaded->count == MAGAZINE_SIZE) {
+            MAG* previous = static_cast<MAG*>(cache.previous);
+            if (previous->count == 0) {
+                std::swap(cache.loaded, cache.previous);
+            }
+            else {
+                PutFull(previous);
+                cache.previous = cache.loaded;
+                cache.loaded = GetEmptyMagazine();
+                SyncCounters(cache);
+            }
+            loaded = static_cast<MAG*>(cache.loaded);
+        }
+        cache.frees++;
+        loaded->objs[loaded->count++] = Mem;
+    }
+
+    // 현재 스레드의 매거진을 창고에 돌려준다. (스레드가 끝날 때 자동으로 호출된다)
+    void FlushThreadCache()
+    {
+        POOL_THREAD_CACHE& cache = t_pool_caches.caches[poolId];
+        if (cache.owner == serial) FlushCache(this, cache);
+    }
+    void PrintSize()
+    {
+        cout << "CurrentSize - " << fullCount.load() * MAGAZINE_SIZE << endl;
+    }
+    void PrintStats(const char* name)
+    {
+        printf("[POOL] %s - alloc %llu free %llu | depot get %llu put %llu | cas retry %llu | grow %llu trim %llu\n",
+            name, stats.allocs.load(), stats.frees.load(), stats.depot_gets.load(), stats.depot_puts.load(),
+            stats.cas_retries.load(), stats.grows.load(), stats.trims.load());
+    }
+private:
+    POOL_THREAD_CACHE& GetCache()
+    {
+        POOL_THREAD_CACHE& cache = t_pool_caches.caches[poolId];
+        // 같은 id 를 쓰던 없어진 풀의 캐시 - 매거진은 그 풀과 함께 지워졌으므로 버린다.
+        if (cache.owner != serial) cache = POOL_THREAD_CACHE{};
+        if (cache.loaded == nullptr) {
+            cache.owner = serial;
+            cache.pool = this;
+            cache.flush = &CObjectPool::FlushCache;
+            cache.loaded = GetEmptyMagazine();
+            cache.previous = GetEmptyMagazine();
+        }
+        return cache;
+    }
+    static void FlushCache(void* pool, POOL_THREAD_CACHE& cache)
+    {
+        CObjectPool* self = static_cast<CObjectPool*>(pool);
+        for (void* m : { cache.loaded, cache.previous }) {
+            MAG* mag = static_cast<MAG*>(m);
+            if (mag == nullptr) continue;
+            if (mag->count > 0) self->PutFull(mag);
+            else self->emptyMagazines.push(mag, self->stats.cas_retries);
+        }
+        self->SyncCounters(cache);
+        cache.loaded = cache.previous = nullptr;
+        cache.owner = 0;
+        cache.pool = nullptr;
+        cache.flush = nullptr;
+    }
+    void SyncCounters(POOL_THREAD_CACHE& cache)
+    {
+        stats.allocs.fetch_add(cache.allocs, std::memory_order_relaxed);
+        stats.frees.fetch_add(cache.frees, std::memory_order_relaxed);
+        cache.allocs = cache.frees = 0;
+    }
+    MAG* GetEmptyMagazine()
+    {
+        MAG* mag = emptyMagazines.pop(stats.cas_retries);
+        if (mag != nullptr) return mag;
+        mag = new MAG();
+        std::lock_guard<std::mutex> ll{ magazineLock };
+        allMagazines.push_back(mag);
+        return mag;
+    }
+    void Fill(MAG* mag)
+    {
+        for (int i = 0; i < MAGAZINE_SIZE; ++i) mag->objs[i] = new T();
+        mag->count = MAGAZINE_SIZE;
+    }
+    void PutFull(MAG* mag)
+    {
+        fullMagazines.push(mag, stats.cas_retries);
+        stats.depot_puts.fetch_add(1, std::memory_order_relaxed);
+        if (fullCount.fetch_add(1) + 1 > highWater) Trim();
+    }
+    // 창고의 매거진이 lowWater 개가 될 때까지 객체를 해제한다.
+    void Trim()
+    {
+        while (fullCount.load() > lowWater) {
+            MAG* mag = fullMagazines.pop(stats.cas_retries);
+            if (mag == nullptr) return;
+            fullCount.fetch_sub(1);
+            for (int i = 0; i < mag->count; ++i) delete mag->objs[i];
+            mag->count = 0;
+            emptyMagazines.push(mag, stats.cas_retries);
+            stats.trims.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+// 큐 하나를 모든 스레드가 공유하는 풀 (CObjectPool 이전 구현 - Benchmark.h 에서 비교용으로 사용)
+template<class T>
+class CQueueObjectPool {
 #ifdef _USE_MYLOCKFREEQUEUE
 private:
     LockFreeQueue<T*> objectQueue;
 public:
-    CObjectPool(size_t MemorySize)
+    CQueueObjectPool(size_t MemorySize)
     {
         for (int i = 0; i < MemorySize; ++i) {
             objectQueue.push(new T());
         }
     }
-    ~CObjectPool()
+    ~CQueueObjectPool()
     {
         T* mem;
         while (objectQueue.pop(mem))
@@ -132,13 +409,13 @@ public:
 private:
     concurrent_queue<T*> objectQueue;
 public:
-    CObjectPool(size_t MemorySize)
+    CQueueObjectPool(size_t MemorySize)
     {
         for (int i = 0; i < MemorySize; ++i) {
             objectQueue.push(new T());
         }
     }
-    ~CObjectPool()
+    ~CQueueObjectPool()
     {
         T* mem;
         while (objectQueue.try_pop(mem))
@@ -170,86 +447,3 @@ public:
     }
 #endif
 };
-
-class A_star_Node
-{
-public:
-    float F = 0;
-    float G = 0;
-    float H = 0;
-    //A_star_Node* parent;
-    shared_ptr<A_star_Node> parent;
-    XMFLOAT3 Pos = { 0,0,0 };
-    A_star_Node() {}
-    A_star_Node(XMFLOAT3 _Pos, float _G, float _H, shared_ptr<A_star_Node> _parent)
-        : Pos(_Pos), G(_G), H(_H), F(_G + _H), parent(_parent) {}
-    void Reset()
-    {
-        F = G = H = 0;
-        parent = nullptr;
-        Pos = { 0, 0, 0 };
-    }
-};
-
-struct CompareNodes {
-    bool operator()(shared_ptr<A_star_Node>& node1, shared_ptr<A_star_Node>& node2) {
-        return node1->F > node2->F;
-    }
-};
-
-//class AStar_Pool {
-//private:
-//    concurrent_queue<A_star_Node*> objectQueue;
-//public:
-//    AStar_Pool()
-//    {
-//        for (int i = 0; i < 2000; ++i) {
-//            objectQueue.push(new A_star_Node());
-//        }
-//    }
-//    ~AStar_Pool() 
-//    {
-//        A_star_Node* mem;
-//        while (objectQueue.try_pop(mem))
-//        {
-//            delete mem;
-//        }
-//    }
-//
-//    A_star_Node* GetMemory(XMFLOAT3 _Pos, float _G, float _H, A_star_Node* _parent)
-//    {
-//        A_star_Node* front;
-//        if (objectQueue.try_pop(front) == false) {
-//            cout << "޸ \n";
-//            for (int i = 0; i < 50; ++i)
-//                objectQueue.push(new A_star_Node());
-//            objectQueue.try_pop(front);
-//            front->Pos = _Pos;
-//            front->G = _G;
-//            front->H = _H;
-//            front->F = _G + _H;
-//            front->parent = _parent;
-//            return front;
-//        }
-//        else {
-//            front->Pos = _Pos;
-//            front->G = _G;
-//            front->H = _H;
-//            front->F = _G + _H;
-//            front->parent = _parent;
-//            return front;
-//        }
-//    }
-//
-//    void ReturnMemory(A_star_Node* Mem)
-//    {
-//        Mem->Reset();
-//        objectQueue.push(Mem);
-//    }
-//    void PrintSize()
-//    {
-//        cout << "CurrentSize - " << objectQueue.unsafe_size() << endl;
-//    }
-//};
-
-
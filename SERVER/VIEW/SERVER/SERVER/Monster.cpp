@@ -4,13 +4,13 @@
 
 Monster::Monster(const Monster& other)
 {
-    lock_guard<mutex> ll{ other.m_lock };
     Pos = other.Pos;
     room_num = other.room_num;
     alive = other.alive.load();
     BB = other.BB;
     m_id = other.m_id;
     type = other.type;
+    path_algorithm = other.path_algorithm;
     HP = other.HP;
     power = other.power;
     view_range = other.view_range;
@@ -27,14 +27,13 @@ Monster& Monster::operator=(const Monster& other)
     if (this == &other) {
         return *this; 
     }
-    lock_guard<mutex> l1{ this->m_lock };
-    lock_guard<mutex> l2{ other.m_lock };
     Pos = other.Pos;
     room_num = other.room_num;
     alive = other.alive.load();
     BB = other.BB;
     m_id = other.m_id;
     type = other.type;
+    path_algorithm = other.path_algorithm;
     HP = other.HP;
     power = other.power;
     view_range = other.view_range;
@@ -64,19 +63,21 @@ void Monster::Re_Initialize(short _type, XMFLOAT3 _pos)
     }
     target_id = -1;
     attacked = false;
+    path.clear();
+    path_index = 0;
     switch (_type)
     {
-    case 0: // տ Į
+    case 0: // 손에 칼
         HP = 250;
         dead_timer = 3.3f;
         attack_timer = attack_cycle;
         break;
-    case 1: // ٱ ٸ
+    case 1: // 뼈다귀 다리
         HP = 150;
         dead_timer = 3.3f;
         attack_timer = attack_cycle;
         break;
-    case 2: // 
+    case 2: // 마술사
         HP = 50;
         dead_timer = 3.3f;
         attack_timer = attack_cycle;
@@ -86,7 +87,7 @@ void Monster::Re_Initialize(short _type, XMFLOAT3 _pos)
         dead_timer = 3.3f;
         attack_timer = attack_cycle;
         break;
-    case 4: // ͽ
+    case 4: // 귀신
         HP = 50;
         dead_timer = 3.3f;
         attack_timer = attack_cycle;
@@ -114,50 +115,54 @@ void Monster::Initialize(short _roomNum, short _id, short _type, XMFLOAT3 _pos)
     attacked = false;
     switch (_type)
     {
-    case 0: // տ Į
+    case 0: // 손에 칼
         type = 0;
+        path_algorithm = MONSTER_PATH_ALGORITHM;
         HP = 250;
         power = 60;
         view_range = 400;
         speed = 24.f;
         attack_range = 21.f;
-        attack_cycle = (71.f / 30.f); // 2.366667
+        attack_cycle = (71.f / 30.f); // 2.366667초
         attack_timer = attack_cycle;
         BB = BoundingBox(_pos, MONSTER_SIZE);
         dead_timer = 3.3f;
         break;
-    case 1: // ٱ ٸ
+    case 1: // 뼈다귀 다리
         type = 1;
+        path_algorithm = MONSTER_PATH_ALGORITHM;
         HP = 150;
         power = 60;
         view_range = 400;
         speed = 24.f;
         attack_range = 15.f;
-        attack_cycle = (56.f / 30.f); // 2.366667
+        attack_cycle = (56.f / 30.f); // 2.366667초
         attack_timer = attack_cycle;
         BB = BoundingBox(_pos, SMALL_MONSTER_SIZE);
         dead_timer = 3.3f;
         break;
-    case 2: // 
+    case 2: // 마술사
         type = 2;
+        path_algorithm = SORCERER_PATH_ALGORITHM;
         HP = 50;
         power = 150;
         view_range = 400;
         speed = 24.f;
         attack_range = 150.f;
-        attack_cycle = (8.f / 3.f); // 2.666664
+        attack_cycle = (8.f / 3.f); // 2.666664초
         attack_timer = attack_cycle;
         BB = BoundingBox(_pos, SMALL_MONSTER_SIZE);
         dead_timer = 3.3f;
         break;
-    case 3: //  
+    case 3: // 보스 몬스터
         type = 3;
+        path_algorithm = BOSS_PATH_ALGORITHM;
         HP = 2000;
         power = 200;
         view_range = 100;
         speed = 24.f;
         attack_range = 75.f;
-        attack_cycle = (10.f / 3.f); // 3.333333
+        attack_cycle = (10.f / 3.f); // 3.333333초
         attack_timer = attack_cycle;
         BB = BoundingBox(_pos, BOSS_MONSTER_SIZE);
         dead_timer = 1.f;
@@ -1,6 +1,7 @@
 #pragma once
 #include "stdafx.h"
 #include "MemoryPool.h"
+#include "PathFinder.h"
 
 #define MONSTER_SIZE XMFLOAT3{15,15,15}
 #define SMALL_MONSTER_SIZE XMFLOAT3{7,7,7}
@@ -9,6 +10,13 @@
 #define MAGIC_ATTACK_RANGE 150
 #define BOSS_ATTACK_RANGE 75
 
+// 몬스터 종류별 길찾기 방식 (PathFinder.h) - 보스는 좁은 방에서 가까운 거리만 쫓으므로 A* 로 충분하다.
+constexpr PATH_ALGORITHM MONSTER_PATH_ALGORITHM = PATH_JPS;
+constexpr PATH_ALGORITHM SORCERER_PATH_ALGORITHM = PATH_JPS;
+constexpr PATH_ALGORITHM BOSS_PATH_ALGORITHM = PATH_ASTAR;
+
+class SESSION;
+
 enum class NPC_State
 {
     Idle,
@@ -42,18 +50,21 @@ public:
     XMFLOAT3 Pos;
     float attack_cycle = 0.f;
     float attack_range = 0.f;
-    short room_num; //   ü ϴ   ѹ
-    short target_id = -1; // ϴ ÷̾ ID
-    short m_id = -1;    //  üID
+    short room_num; // 이 몬스터 객체가 존재하는 게임 룸 넘버
+    short target_id = -1; // 추적하는 플레이어의 방 안 자리 번호 (clients[room_num][target_id], 패킷에는 전역 id 로 보낸다)
+    short m_id = -1;    // 몬스터 자체ID
     float dead_timer = 0;
     float attack_timer = 0;
     float wander_timer = 0;
     bool attacked = false;
     bool wander = false;
-    mutable mutex m_lock; // const Լ lock ϱ  mutable 
+    vector<PATH_CELL> path;     // Find_Direction 이 찾은 경로 (칸 단위)
+    size_t path_index = 0;      // 다음에 갈 path 의 칸
+    PATH_CELL path_goal;        // path 를 찾을 때의 목표 칸
+    PATH_ALGORITHM path_algorithm = MONSTER_PATH_ALGORITHM;   // Find_Direction 이 쓰는 길찾기 방식
     Monster() { }
     Monster(const Monster& other);
-    ~Monster();
+    virtual ~Monster();
     Monster& operator=(const Monster& other);
     void Initialize(short _roomNum, short _id, short _type, XMFLOAT3 _pos);
     void Re_Initialize(short _type, XMFLOAT3 _pos);
@@ -67,8 +78,18 @@ public:
     }
 
     int get_targetID();
+    // 상태마다 한 틱 - Room_Tick 이 같은 상태의 몬스터를 모아서 부른다. (MonsterStore.h)
+    void Idle_Update(int target, float distance);
+    void Chase_Update(float fTimeElapsed);
+    void Attack_Update(float fTimeElapsed);
+    void Dead_Update(float fTimeElapsed);
+    bool Magic_Update(float fTimeElapsed);
+    // 공격 모션 중간에 한 번 - 종류마다 다르다.
+    virtual void Attack_Hit(SESSION* targetPlayer, const XMFLOAT3& distanceVector);
     XMFLOAT3 Find_Direction(float fTimeElapsed, XMFLOAT3 start_Pos, XMFLOAT3 dest_Pos);
-    virtual void Update(float fTimeElapsed);
+    XMFLOAT3 Chase_Step(float fTimeElapsed, int target);
+    bool Blocked_By_Monster(const XMFLOAT3& newPos);
+    void Update(float fTimeElapsed);
     XMFLOAT3 GetPosition() { return Pos; }
     float GetSpeed() { return speed; }
     short GetPower() { return power; }
@@ -76,19 +97,18 @@ public:
     NPC_State GetState() const { return curState; }
     void SetAttackTimer(float time) { attack_timer = time; }
     float GetAttackTimer() const { return attack_timer; }
-    bool check_path(const XMFLOAT3& _pos, unordered_set<XMFLOAT3, PointHash, PointEqual>& CloseList, BoundingBox& check_box);
 };
 
 class SorcererMonster : public Monster
 {
 public:
-    void Update(float fTimeElapsed) override;
+    void Attack_Hit(SESSION* targetPlayer, const XMFLOAT3& distanceVector) override;
 };
 
 class BossMonster : public Monster
 {
 public:
-    void Update(float fTimeElapsed) override;
+    void Attack_Hit(SESSION* targetPlayer, const XMFLOAT3& distanceVector) override;
 };
 
 class MonsterInfo
@@ -0,0 +1,73 @@
+#pragma once
+// MonsterStore.h
+// 방 하나의 몬스터를 상태별로 모아 한 번에 돌리기 위한 배열 묶음 (SoA)
+//  - 몬스터 객체(Monster)는 그대로 두고, 매 틱 모든 몬스터가 읽는 값(위치, 시야, 목표)만 몬스터 번호 순서의 배열로 따로 둔다.
+//    종류(칼, 뼈다귀, 마술사, 보스)와 상관없이 같은 배열에 있으므로 한 루프로 방 전체를 본다.
+//  - Room_Tick(Update_Room_Monsters) 은 틱 시작에 몬스터를 상태별 비트 마스크로 나누고, 상태마다 그 마스크의 몬스터를 한 번에 처리한다.
+//    이번 틱에 상태가 바뀐 몬스터는 다음 틱에 새 상태로 처리된다. (한 마리씩 Update 할 때와 같다)
+//  - Idle 몬스터의 목표 고르기(Monster::get_targetID)는 몬스터 x 플레이어 거리 계산을 분기 없는 고정 길이 루프로 해서 컴파일러가 벡터화한다.
+//  - 몬스터가 움직이면 Move 로 알려준다. 상태는 패킷 처리에서도 바뀌므로 여기 두지 않고 틱마다 몬스터에서 읽는다. (그 방의 실행기만 부른다)
+
+#include "stdafx.h"
+
+/**
+ * @brief 한 방의 몬스터 배열 묶음
+ * @tparam MAX_OBJECTS 방의 몬스터 수 (64 이하)
+ * @tparam MAX_PLAYERS 방의 플레이어 자리 수
+ */
+template<int MAX_OBJECTS, int MAX_PLAYERS>
+class MONSTER_STORE {
+	static_assert(MAX_OBJECTS <= 64, "objects are tracked in a 64-bit mask");
+
+	alignas(32) array<float, MAX_OBJECTS> _x{}, _z{};		// 위치
+	alignas(32) array<float, MAX_OBJECTS> _view_sq{};		// 시야의 제곱 (0 이면 빈 자리)
+	alignas(32) array<float, MAX_OBJECTS> _distance_sq{};	// Select_Targets 가 고른 플레이어까지의 xz 거리의 제곱
+	alignas(32) array<int, MAX_OBJECTS> _target{};			// Select_Targets 가 고른 플레이어 자리 (-1 이면 없음)
+	array<uint64_t, 4> _type_mask{};						// 종류별 몬스터 (0 칼, 1 뼈다귀, 2 마술사, 3 보스)
+
+public:
+	// id 번 자리에 몬스터를 둔다. (InitializeMonsters)
+	void Reset(int id, int type, const XMFLOAT3& pos, float view_range)
+	{
+		for (auto& mask : _type_mask) mask &= ~(1ull << id);
+		if (type >= 0 && type < static_cast<int>(_type_mask.size())) _type_mask[type] |= 1ull << id;
+		_view_sq[id] = view_range * view_range;
+		Move(id, pos);
+	}
+
+	void Move(int id, const XMFLOAT3& pos)
+	{
+		_x[id] = pos.x;
+		_z[id] = pos.z;
+	}
+
+	uint64_t Type_Mask(int type) const { return _type_mask[type]; }
+	int Target(int id) const { return _target[id]; }
+	float Distance(int id) const { return sqrtf(_distance_sq[id]); }	// 제곱근은 목표가 생긴 몬스터만 구한다.
+
+	/**
+	 * @brief 모든 몬스터가 시야 안의 가장 가까운 플레이어를 한 번에 고른다. (Monster::get_targetID 를 방 전체로 한 것)
+	 * @param players 플레이어 자리마다 위치
+	 * @param in_game 게임 중인 플레이어 자리의 비트 마스크
+	 *
+	 * 거리가 같으면 앞 자리를 고르고, 시야와 같은 거리는 고르지 않는 것도 get_targetID 와 같습니다.
+	 * 몬스터 수만큼 도는 안쪽 루프는 분기 없이 비교 결과로 값을 고르므로 SIMD 로 묶입니다.
+	 * (목표 번호는 float 비교 결과로 int 를 고르면 if 변환이 안 되는 컴파일러가 있어 비트 마스크로 고른다)
+	 */
+	void Select_Targets(const array<XMFLOAT3, MAX_PLAYERS>& players, unsigned in_game)
+	{
+		_distance_sq = _view_sq;
+		_target.fill(-1);
+		for (int p = 0; p < MAX_PLAYERS; ++p) {
+			if ((in_game & (1u << p)) == 0) continue;
+			const float px = players[p].x, pz = players[p].z;
+			for (int i = 0; i < MAX_OBJECTS; ++i) {
+				float dx = px - _x[i], dz = pz - _z[i];
+				float d = dx * dx + dz * dz;
+				int closer = -static_cast<int>(d < _distance_sq[i]);
+				_distance_sq[i] = (d < _distance_sq[i]) ? d : _distance_sq[i];
+				_target[i] = (_target[i] & ~closer) | (p & closer);
+			}
+		}
+	}
+};
@@ -1,25 +1,34 @@
+#pragma once
 #include "main.h"
+#ifdef _WIN32
 #include <sqlext.h>
 #include <sql.h>
 #include <sqltypes.h>
+#endif
 
-SOCKET g_s_socket, g_c_socket;
-OVER_EXP g_a_over;
-HANDLE h_iocp;
-
+#ifdef _WIN32
 void HandleDiagnosticRecord(SQLHANDLE hHandle, SQLSMALLINT hType, RETCODE RetCode);
+#endif
 void DB_Thread();
 void process_packet(const int c_id, char* packet);
-void worker_thread(HANDLE h_iocp);
+void worker_thread();
 void Timer_Thread();
 
+// DB 처리 결과를 요청한 세션의 방 실행기에 넘긴다. (세션 상태는 방 실행기가 바꾼다)
+void Post_DB_Result(int c_id, const DB_RESULT& result)
+{
+	Post_Room_Job(ROOM_JOB::Create(RJ_DB_RESULT, c_id / MAX_USER_PER_ROOM, c_id, &result, sizeof(result)));
+}
+
+#ifdef _WIN32
+
 /**
- * @brief SQL    óϰ ϴ Լ
- * @param hHandle SQL ڵ
- * @param hType ڵ Ÿ
- * @param RetCode ȯ ڵ
+ * @brief SQL 에러 진단 정보를 처리하고 출력하는 함수
+ * @param hHandle SQL 핸들
+ * @param hType 핸들 타입
+ * @param RetCode 반환 코드
  *
- * SQL ۾   ߻     մϴ.
+ * SQL 작업 수행 중 발생한 에러에 대한 상세 정보를 출력합니다.
  */
 void HandleDiagnosticRecord(SQLHANDLE hHandle, SQLSMALLINT hType, RETCODE RetCode) {
 	SQLSMALLINT iRec = 0;
@@ -43,14 +52,15 @@ void HandleDiagnosticRecord(SQLHANDLE hHandle, SQLSMALLINT hType, RETCODE RetCod
 }
 
 /**
- * @brief ͺ̽    ó ϴ  Լ
+ * @brief 데이터베이스 연결 및 쿼리 처리를 담당하는 스레드 함수
  *
- * ֿ :
- * - ODBC  ͺ̽  
- * - ȸ(sign_up)  α(sign_in) ν ó
- * - ͺ̽ ̺Ʈ ť ͸  ó
+ * 주요 기능:
+ * - ODBC를 통한 데이터베이스 연결 
+ * - 회원가입(sign_up) 및 로그인(sign_in) 프로시저 처리
+ * - 데이터베이스 이벤트 큐 모니터링 및 처리
+ * - 처리 결과는 세션의 방 실행기에 메시지로 넘김 (Post_DB_Result)
  *
- * @note ͺ̽  5 ŸӾƿ ˴ϴ.
+ * @note 데이터베이스 연결은 5초 타임아웃으로 설정됩니다.
  */
 void DB_Thread()
 {
@@ -60,7 +70,7 @@ void DB_Thread()
 	SQLRETURN retcode;
 	SQLLEN OutSize{};
 
-	// ѱ ó   
+	// 한글 처리를 위한 로케일 설정
 	setlocale(LC_ALL, "korean");
 
 	SQLLEN cbID = 0, cbPWD = 0, cbClearTime = 0, cbCurStage = 0;
@@ -116,29 +126,17 @@ void DB_Thread()
 
 								retcode = SQLExecute(hstmt);
 								if (retcode == SQL_SUCCESS || retcode == SQL_SUCCESS_WITH_INFO) {
-									SC_SIGN_PACKET p;
-									p.success = true;
-									p.type = SC_SIGNUP;
-									p.size = sizeof(p);
-									requested_session->do_send(&p);
+									Post_DB_Result(ev.session_id, DB_RESULT{ EV_SIGNUP, true });
 									wcout << "SIGNUP SUCCEED \n";
 								}
 								else {
-									SC_SIGN_PACKET p;
-									p.success = false;
-									p.type = SC_SIGNUP;
-									p.size = sizeof(p);
-									requested_session->do_send(&p);
+									Post_DB_Result(ev.session_id, DB_RESULT{ EV_SIGNUP, false });
 									wcout << "SIGNUP FAILED \n";
 									HandleDiagnosticRecord(hdbc, SQL_HANDLE_DBC, retcode);
 								}
 							}
 							else {
-								SC_SIGN_PACKET p;
-								p.success = false;
-								p.type = SC_SIGNUP;
-								p.size = sizeof(p);
-								requested_session->do_send(&p);
+								Post_DB_Result(ev.session_id, DB_RESULT{ EV_SIGNUP, false });
 								printf("SQLPrepare failed\n");
 								HandleDiagnosticRecord(hdbc, SQL_HANDLE_DBC, retcode);
 							}
@@ -146,14 +144,9 @@ void DB_Thread()
 							break;
 						}
 						case EV_SIGNIN: {
-							wcscpy_s(requested_session->_name, sizeof(ev.user_id) / sizeof(ev.user_id[0]), ev.user_id);
-
-
-							SC_SIGN_PACKET p;
-							p.success = true;
-							p.type = SC_SIGNIN;
-							p.size = sizeof(p);
-							requested_session->do_send(&p);
+							DB_RESULT name_result{ EV_SIGNIN, true, true };
+							wcscpy_s(name_result.user_id, IDPW_SIZE, ev.user_id);
+							Post_DB_Result(ev.session_id, name_result);
 							wcout << "SIGNIN SUCCEED\n";
 
 							retcode = SQLPrepare(hstmt, (SQLWCHAR*)L"{CALL sign_in(?, ?)}", SQL_NTS);
@@ -163,41 +156,26 @@ void DB_Thread()
 
 								retcode = SQLExecute(hstmt);
 								if (retcode == SQL_SUCCESS || retcode == SQL_SUCCESS_WITH_INFO) {
-									SQLBindCol(hstmt, 4, SQL_C_LONG, &requested_session->cur_stage, sizeof(requested_session->cur_stage), &OutSize);
+									SQLINTEGER cur_stage = 0;
+									SQLBindCol(hstmt, 4, SQL_C_LONG, &cur_stage, sizeof(cur_stage), &OutSize);
 									retcode = SQLFetch(hstmt);
 									if (retcode == SQL_SUCCESS || retcode == SQL_SUCCESS_WITH_INFO) {
-										SC_SIGN_PACKET p;
-										p.success = true;
-										p.type = SC_SIGNIN;
-										p.size = sizeof(p);
-										requested_session->do_send(&p);
+										Post_DB_Result(ev.session_id, DB_RESULT{ EV_SIGNIN, true, false, true, cur_stage });
 										wcout << "SIGNIN SUCCEED\n";
 									}
 									else {
-										SC_SIGN_PACKET p;
-										p.success = false;
-										p.type = SC_SIGNIN;
-										p.size = sizeof(p);
-										requested_session->do_send(&p);
+										Post_DB_Result(ev.session_id, DB_RESULT{ EV_SIGNIN, false });
 										printf("SIGNIN FAILED - The ID does not exist.  \n");
 									}
 								}
 								else {
-									SC_SIGN_PACKET p;
-									p.success = false;
-									p.type = SC_SIGNIN;
-									p.size = sizeof(p);
-									requested_session->do_send(&p);
+									Post_DB_Result(ev.session_id, DB_RESULT{ EV_SIGNIN, false });
 									printf("SIGNIN FAILED - The query has not been performed.  \n");
 									HandleDiagnosticRecord(hdbc, SQL_HANDLE_DBC, retcode);
 								}
 							}
 							else {
-								SC_SIGN_PACKET p;
-								p.success = false;
-								p.type = SC_SIGNIN;
-								p.size = sizeof(p);
-								requested_session->do_send(&p);
+								Post_DB_Result(ev.session_id, DB_RESULT{ EV_SIGNIN, false });
 								printf("SQLPrepare failed\n");
 								HandleDiagnosticRecord(hdbc, SQL_HANDLE_DBC, retcode);
 							}
@@ -219,57 +197,94 @@ void DB_Thread()
 		SQLFreeHandle(SQL_HANDLE_ENV, henv);
 	}
 }
+#else
+// #define _DEV_ACCEPT_ANY_SIGNIN	// 개발용 - Linux 에서 DB 없이 아무 계정으로나 로그인을 받는다. (배포 빌드에서 켜지 말 것)
+
+/**
+ * @brief Linux 빌드용 DB 스레드
+ *
+ * SQL Server ODBC 드라이버를 사용할 수 없으므로 계정을 확인할 수 없습니다.
+ * 회원가입과 로그인 모두 실패로 응답합니다. _DEV_ACCEPT_ANY_SIGNIN 을 정의한 개발 빌드에서만
+ * 로그인을 DB 조회 없이 이름만 기록한 뒤 성공으로 응답합니다. (결과는 방 실행기에 넘긴다)
+ */
+void DB_Thread()
+{
+	while (1)
+	{
+		DB_EVENT ev;
+		if (db_queue.try_pop(ev)) {
+			auto requested_session = getClient(ev.session_id);
+			if (requested_session == nullptr) {
+				cout << "wrong session_id - DB Request\n";
+				continue;
+			}
+			DB_RESULT result{ ev._event };
+			switch (ev._event) {
+			case EV_SIGNUP:
+				result.success = false;
+				break;
+			case EV_SIGNIN:
+#ifdef _DEV_ACCEPT_ANY_SIGNIN
+				result.success = true;
+				result.set_name = true;
+				wcscpy_s(result.user_id, IDPW_SIZE, ev.user_id);
+#else
+				result.success = false;
+#endif
+				break;
+			default:
+				continue;
+			}
+			Post_DB_Result(ev.session_id, result);
+		}
+		else this_thread::sleep_for(100ms);
+	}
+}
+#endif
 
 
 /**
- * @brief Ÿ̸ ̺Ʈ óϴ  Լ
+ * @brief 타이머 이벤트를 처리하는 스레드 함수
  *
- * Ÿ̸ ť ͸ϰ  ̺Ʈ óմϴ.
- *   ̺Ʈ:
- * - EV_MONSTER_UPDATE:   Ʈ
+ * 타이머 큐를 모니터링하고 예약된 이벤트를 처리합니다.
+ * 현재 구현된 이벤트:
+ * - EV_ROOM_TICK: 방의 몬스터 상태 업데이트 (방 틱) - 방의 실행기에 RJ_TICK 으로 넘긴다
  *
- * @note ̺Ʈ  wakeup_time ó˴ϴ.
- * @note 1ms  Ÿ̸ ť Ȯմϴ.
+ * @note 이벤트는 지정된 wakeup_time에 처리됩니다.
+ * @note 타이밍 휠에서 다음 만료 시각까지 기다렸다가, 만료된 이벤트를 한꺼번에 처리합니다.
  */
 void Timer_Thread()
 {
+	vector<TIMER_EVENT> expired;
 	while (1)
 	{
-		TIMER_EVENT ev;
-		auto current_time = high_resolution_clock::now();
-		if (timer_queue.try_pop(ev)) {
-			if (ev.wakeup_time > current_time) {
-				timer_queue.push(ev);
-				this_thread::sleep_for(1ms);
-				continue;
-			}
+		timer_queue.WaitExpired(expired);
+		for (auto& ev : expired) {
 			switch (ev.event_id) {
-			case EV_MONSTER_UPDATE: {
-				OVER_EXP* ov = new OVER_EXP();
-				ov->_comp_type = OP_NPC_UPDATE;
-				PostQueuedCompletionStatus(h_iocp, 1, ev.room_id * 100 + ev.obj_id, &ov->_over);
+			case EV_ROOM_TICK: {
+				Post_Room_Job(ROOM_JOB::Create(RJ_TICK, ev.room_id, -1));
 			}
 								  break;
 			}
 		}
-		else this_thread::sleep_for(1ms);
+		expired.clear();
 	}
 }
 
 /**
- * @brief Ŭ̾Ʈκ  Ŷ óϴ Լ
- * @param c_id Ŭ̾Ʈ ID
- * @param packet ŵ Ŷ 
+ * @brief 클라이언트로부터 수신한 패킷을 처리하는 함수
+ * @param c_id 클라이언트 ID
+ * @param packet 수신된 패킷 데이터
  *
- * óϴ Ŷ Ÿ:
- * - CS_LOGIN:  α  Ī
- * - CS_SIGNUP: ȸ
- * - CS_SIGNIN: α
- * - CS_HEARTBEAT: ġ Ʈ
- * - CS_ROTATE: ȸ 
- * - CS_ATTACK:  ó
- * - CS_INTERACTION: ȣۿ( Ʈ ȹ)
- * - CS_CHANGEWEAPON:  
+ * 처리하는 패킷 타입:
+ * - CS_LOGIN: 게임 로그인 및 매칭
+ * - CS_SIGNUP: 회원가입
+ * - CS_SIGNIN: 로그인
+ * - CS_HEARTBEAT: 위치 업데이트
+ * - CS_ROTATE: 회전 정보
+ * - CS_ATTACK: 공격 처리
+ * - CS_INTERACTION: 상호작용(퍼즐 오브젝트 획득)
+ * - CS_CHANGEWEAPON: 무기 변경
  */
 void process_packet(const int c_id, char* packet)
 {
@@ -279,12 +294,12 @@ void process_packet(const int c_id, char* packet)
 		cout << "Wrong session_id - process_packet" << endl;
 		return;
 	}
-	switch (packet[1]) {
+	switch (Get_Packet_Type(packet)) {
 	case CS_LOGIN: {
 		CS_LOGIN_PACKET* p = reinterpret_cast<CS_LOGIN_PACKET*>(packet);
 		CL->_state.store(ST_INGAME);
 
-		// 3 Ī  ؾ ϴ 
+		// 3인 매칭 후 시작해야 하는 경우
 		for (auto& pl : *Room) {
 			if (pl._state.load() != ST_INGAME) return;
 			pl.Initialize();
@@ -297,7 +312,7 @@ void process_packet(const int c_id, char* packet)
 			}
 		}
 
-		// 1  - ׽Ʈ
+		// 1인 게임 - 테스트용
 		//CL.Initialize();
 		//CL.send_game_start_packet();
 		//for (auto& pl : Room) {
@@ -315,8 +330,8 @@ void process_packet(const int c_id, char* packet)
 		CS_SIGN_PACKET* p = reinterpret_cast<CS_SIGN_PACKET*>(packet);
 		DB_EVENT ev;
 		ev._event = EV_SIGNUP;
-		wcscpy_s(ev.user_id, sizeof(ev.user_id) / sizeof(wchar_t), p->id);
-		wcscpy_s(ev.user_password, sizeof(ev.user_password) / sizeof(wchar_t), p->password);
+		wcscpy_s(ev.user_id, IDPW_SIZE, p->id);
+		wcscpy_s(ev.user_password, IDPW_SIZE, p->password);
 		ev.session_id = c_id;
 		db_queue.push(ev);
 	}
@@ -325,8 +340,8 @@ void process_packet(const int c_id, char* packet)
 		CS_SIGN_PACKET* p = reinterpret_cast<CS_SIGN_PACKET*>(packet);
 		DB_EVENT ev;
 		ev._event = EV_SIGNIN;
-		wcscpy_s(ev.user_id, sizeof(ev.user_id) / sizeof(wchar_t), p->id);
-		wcscpy_s(ev.user_password, sizeof(ev.user_password) / sizeof(wchar_t), p->password);
+		wcscpy_s(ev.user_id, IDPW_SIZE, p->id);
+		wcscpy_s(ev.user_password, IDPW_SIZE, p->password);
 		ev.session_id = c_id;
 		db_queue.push(ev);
 	}
@@ -334,17 +349,14 @@ void process_packet(const int c_id, char* packet)
 	case CS_HEARTBEAT: {
 		CS_HEARTBEAT_PACKET* p = reinterpret_cast<CS_HEARTBEAT_PACKET*>(packet);
 		CL->Update(p);
-		for (auto& cl : *Room) {
-			if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)  cl.send_update_packet(CL);
-		}
+		Broadcast_Player_Update(CL);
 	}
 					 break;
 	case CS_ROTATE: {
 		CS_ROTATE_PACKET* p = reinterpret_cast<CS_ROTATE_PACKET*>(packet);
 		CL->Rotate(p->cxDelta, p->cyDelta, p->czDelta);
-		for (auto& cl : *Room) {
-			if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)  cl.send_rotate_packet(CL);
-		}
+		SC_ROTATE_PLAYER_PACKET rotate_packet = CL->make_rotate_packet();
+		Broadcast_Packet(c_id / MAX_USER_PER_ROOM, &rotate_packet);
 	}
 				  break;
 	case CS_ATTACK: {
@@ -354,40 +366,38 @@ void process_packet(const int c_id, char* packet)
 			break;
 		}
 		CS_ATTACK_PACKET* p = reinterpret_cast<CS_ATTACK_PACKET*>(packet);
-		for (auto& cl : *Room) {
-			if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)   cl.send_attack_packet(CL);
-		}
+		SC_ATTACK_PACKET attack_packet = CL->make_attack_packet();
+		Broadcast_Packet(c_id / MAX_USER_PER_ROOM, &attack_packet);
 		XMFLOAT3 Cur_LookVector = CL->GetLookVector();
 		XMFLOAT3 Cur_Pos = CL->GetPosition();
 		switch (CL->weapon_type)
 		{
-		// BLADE:   Ÿ 15 ̳ ù° Ϳ 
+		// BLADE: 근접 공격으로 거리 15 이내의 첫번째 몬스터에게 데미지
 		case BLADE:
 		{
 			Cur_Pos = Vector3::Add(Cur_Pos, Vector3::ScalarProduct(Cur_LookVector, 15, false));
 			for (auto& monster : *Monsters) {
 				if (monster->alive == false) continue;
-				lock_guard<mutex> mm{ monster->m_lock };
 				if (monster->HP > 0 && Vector3::Length(Vector3::Subtract(Cur_Pos, monster->GetPosition())) < 30)
 				{
 					monster->HP -= 100;
-					monster->target_id = CL->_id;
+					monster->target_id = c_id % MAX_USER_PER_ROOM;
 					if (monster->GetState() == NPC_State::Idle)
 					{
 						monster->SetState(NPC_State::Chase);
 					}
-					for (auto& cl : *Room) {
-						if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)   cl.send_monster_damaged_packet(c_id, monster->m_id, monster->HP);
-					}
+					SC_MONSTER_DAMAGED_PACKET damaged_packet = SESSION::make_monster_damaged_packet(c_id, monster->m_id, monster->HP);
+					Broadcast_Packet(c_id / MAX_USER_PER_ROOM, &damaged_packet);
 					if (monster->HP <= 0) {
 						monster->SetState(NPC_State::Dead);
 					}
+					Wake_Room_Tick(c_id / MAX_USER_PER_ROOM);	// 잠든 방이면 맞은 몬스터부터 다시 움직인다
 					break;
 				}
 			}
 		}
 		break;
-		// GUN: ĳƮ  ֹ  Ÿ 
+		// GUN: 레이캐스트 방식으로 장애물에 막히는 원거리 공격
 		case GUN:
 		{
 			XMVECTOR Bullet_Origin = XMLoadFloat3(&Cur_Pos);
@@ -396,7 +406,6 @@ void process_packet(const int c_id, char* packet)
 
 			for (auto& monster : *Monsters) {
 				if (monster->alive == false) continue;
-				lock_guard<mutex> monster_lock{ monster->m_lock };
 				float bullet_monster_distance = Vector3::Length(Vector3::Subtract(monster->BB.Center, Cur_Pos));
 				if (monster->HP > 0 && monster->BB.Intersects(Bullet_Origin, Bullet_Direction, bullet_monster_distance))
 				{
@@ -410,7 +419,6 @@ void process_packet(const int c_id, char* packet)
 				Monster* closestMonster = nullptr;
 				for (auto& monster : monstersInRange)
 				{
-					lock_guard<mutex> monster_lock{ monster->m_lock };
 					float distance = Vector3::Length(Vector3::Subtract(monster->BB.Center, Cur_Pos));
 					if (distance < minDistance)
 					{
@@ -420,7 +428,6 @@ void process_packet(const int c_id, char* packet)
 				}
 				if (closestMonster)
 				{
-					lock_guard<mutex> monster_lock{ closestMonster->m_lock };
 					int _min = static_cast<int>(min(Cur_Pos.z / AREA_SIZE, closestMonster->BB.Center.z / AREA_SIZE));
 					int _max = static_cast<int>(max(Cur_Pos.z / AREA_SIZE, closestMonster->BB.Center.z / AREA_SIZE));
 					for (int i = _min; i <= _max; i++)
@@ -435,43 +442,42 @@ void process_packet(const int c_id, char* packet)
 						}
 					}
 					closestMonster->HP -= 100;
-					closestMonster->target_id = CL->_id;
+					closestMonster->target_id = c_id % MAX_USER_PER_ROOM;
 					if (closestMonster->GetState() == NPC_State::Idle)
 					{
 						closestMonster->SetState(NPC_State::Chase);
 					}
-					for (auto& cl : *Room) {
-						if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)   cl.send_monster_damaged_packet(c_id, closestMonster->m_id, closestMonster->HP);
-					}
+					SC_MONSTER_DAMAGED_PACKET damaged_packet = SESSION::make_monster_damaged_packet(c_id, closestMonster->m_id, closestMonster->HP);
+					Broadcast_Packet(c_id / MAX_USER_PER_ROOM, &damaged_packet);
 					if (closestMonster->HP <= 0) {
 						closestMonster->SetState(NPC_State::Dead);
 					}
+					Wake_Room_Tick(c_id / MAX_USER_PER_ROOM);	// 잠든 방이면 맞은 몬스터부터 다시 움직인다
 					return;
 				}
 			}
 			break;
 		}
-		// PUNCH:   Ÿ 10 ̳ ù° Ϳ 
+		// PUNCH: 근접 공격으로 거리 10 이내의 첫번째 몬스터에게 데미지
 		case PUNCH:
 		{
 			Cur_Pos = Vector3::Add(Cur_Pos, Vector3::ScalarProduct(Cur_LookVector, 10, false));
 			for (auto& monster : *Monsters) {
 				if (monster->alive == false) continue;
-				lock_guard<mutex> mm{ monster->m_lock };
 				if (monster->HP > 0 && Vector3::Length(Vector3::Subtract(Cur_Pos, monster->GetPosition())) < 20)
 				{
 					monster->HP -= 50;
-					monster->target_id = CL->_id;
+					monster->target_id = c_id % MAX_USER_PER_ROOM;
 					if (monster->GetState() == NPC_State::Idle)
 					{
 						monster->SetState(NPC_State::Chase);
 					}
-					for (auto& cl : *Room) {
-						if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)   cl.send_monster_damaged_packet(c_id, monster->m_id, monster->HP);
-					}
+					SC_MONSTER_DAMAGED_PACKET damaged_packet = SESSION::make_monster_damaged_packet(c_id, monster->m_id, monster->HP);
+					Broadcast_Packet(c_id / MAX_USER_PER_ROOM, &damaged_packet);
 					if (monster->HP <= 0) {
 						monster->SetState(NPC_State::Dead);
 					}
+					Wake_Room_Tick(c_id / MAX_USER_PER_ROOM);	// 잠든 방이면 맞은 몬스터부터 다시 움직인다
 					break;
 				}
 			}
@@ -485,17 +491,17 @@ void process_packet(const int c_id, char* packet)
 		int cur_stage = CL->cur_stage.load();
 		for (int i = 0; i < Key_Items[cur_stage].size(); i++) {
 			if (Key_Items[cur_stage][i].m_xmOOBB.Intersects(CL->m_xmOOBB)) {
-				for (auto& cl : *Room) {
+				for (auto& cl : *Room)
 					cl.clear_percentage += Key_Items[cur_stage][i].percent;
-					if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)   cl.send_interaction_packet(cur_stage, i);
-				}
+				SC_INTERACTION_PACKET interaction_packet = SESSION::make_interaction_packet(cur_stage, i);
+				Broadcast_Packet(c_id / MAX_USER_PER_ROOM, &interaction_packet);
 			}
 		}
 
 		if (CL->clear_percentage >= 1.f && get_remain_Monsters(CL->_id) == 0) {
+			SC_OPEN_DOOR_PACKET door_packet = SESSION::make_open_door_packet(CL->cur_stage);
+			Broadcast_Packet(c_id / MAX_USER_PER_ROOM, &door_packet);
 			for (auto& cl : *Room) {
-				if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)
-					cl.send_open_door_packet(CL->cur_stage);
 				cl.clear_percentage = 0.f;
 				if (cl.cur_stage >= 0) cl.clear_percentage = 1.f;
 			}
@@ -505,40 +511,95 @@ void process_packet(const int c_id, char* packet)
 	case CS_CHANGEWEAPON: {
 		CS_CHANGEWEAPON_PACKET* p = reinterpret_cast<CS_CHANGEWEAPON_PACKET*>(packet);
 		CL->weapon_type = static_cast<WEAPON_TYPE>((CL->weapon_type + 1) % 3);
-		for (auto& cl : *Room) {
-			if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)   cl.send_changeweapon_packet(CL);
-		}
+		SC_CHANGEWEAPON_PACKET weapon_packet = CL->make_changeweapon_packet();
+		Broadcast_Packet(c_id / MAX_USER_PER_ROOM, &weapon_packet);
 	}
 						break;
 	}
 }
 
+// 방의 실행기에서 DB 처리 결과를 세션에 반영하고 응답을 보낸다.
+void Apply_DB_Result(int c_id, const DB_RESULT& result)
+{
+	SESSION* CL = getClient(c_id);
+	if (CL == nullptr) {
+		cout << "wrong session_id - DB Result\n";
+		return;
+	}
+	if (result.set_name) wcscpy_s(CL->_name, IDPW_SIZE, result.user_id);
+	if (result.set_stage) CL->cur_stage.store(static_cast<short>(result.cur_stage));
+	SC_SIGN_PACKET p;
+	p.size = sizeof(p);
+	p.type = (result._event == EV_SIGNUP) ? SC_SIGNUP : SC_SIGNIN;
+	p.success = result.success;
+	CL->do_send(&p);
+}
+
+// 방의 실행기(ROOM_ACTOR::Run)가 작업 스레드에서 메시지 하나를 처리할 때 부른다.
+void Run_Room_Job(ROOM_JOB* job)
+{
+	// 넣은 뒤에 세션이 정리되었거나 자리가 새 연결에 넘어갔으면 옛 연결의 메시지이므로 버린다.
+	if (job->_id >= 0 && job->_generation != getClient(job->_id)->_generation.load()) return;
+	switch (job->_type) {
+	case RJ_PACKET:
+		// 방의 몬스터는 방이 처음 패킷을 받을 때 준비한다. (이미 정리된 자리의 패킷이면 빈 방에 몬스터를 다시 잡지 않는다)
+		if (ST_FREE != getClient(job->_id)->_state.load()) Acquire_Room_Monsters(job->_room);
+		process_packet(job->_id, job->_data);
+		break;
+	case RJ_TICK:
+		Room_Tick(job->_room);
+		break;
+	case RJ_DISCONNECT:
+		disconnect(job->_id);
+		break;
+	case RJ_DB_RESULT:
+		Apply_DB_Result(job->_id, *job->Payload<DB_RESULT>());
+		break;
+	}
+}
+
 /**
- * @brief IOCP Ŀ  Լ
- * @param h_iocp IOCP ڵ
+ * @brief 네트워크 I/O 워커 스레드 함수
+ *
+ * NetworkIO.h 의 완료 통지(Windows - IOCP, Linux - epoll)를 받아 처리합니다.
+ * 방의 게임 상태는 건드리지 않고, 받은 패킷과 연결 종료는 방의 실행기에 넘깁니다.
  *
- * óϴ ۾ Ÿ:
- * - OP_ACCEPT: ο Ŭ̾Ʈ  
- * - OP_RECV:   ó
- * - OP_SEND:  ۽ Ϸ ó
- * - OP_NPC_UPDATE: NPC  Ʈ
+ * 처리하는 작업 타입:
+ * - OP_ACCEPT: 새로운 클라이언트 연결 수락
+ * - OP_RECV: 데이터 수신 - 완성된 패킷을 RJ_PACKET 으로 방의 실행기에 넘김
+ * - OP_SEND: 데이터 송신 완료 처리
  *
  */
-void worker_thread(HANDLE h_iocp)
+void worker_thread()
 {
 	while (1) {
-		DWORD num_bytes;
-		ULONG_PTR key;
-		WSAOVERLAPPED* over = nullptr;
-		BOOL ret = GetQueuedCompletionStatus(h_iocp, &num_bytes, &key, &over, INFINITE);
-		OVER_EXP* ex_over = reinterpret_cast<OVER_EXP*>(over);
-		if (FALSE == ret) {
+		DWORD num_bytes = 0;
+		ULONG_PTR key = 0;
+		OVER_EXP* ex_over = nullptr;
+		bool ret = IO_GetCompletion(&num_bytes, &key, &ex_over);
+		if (ex_over == nullptr) continue;
+#ifdef _COLLECT_STATS
+		auto begin_time = high_resolution_clock::now();
+#endif
+		if (ex_over->_comp_type != OP_ACCEPT) {
+			// 소켓을 등록한 뒤 세대가 바뀌었으면 닫힌 옛 연결의 완료이므로 버린다. (자리를 새 연결이 받았을 수 있다)
+			// recv 의 OVER_EXP 는 세션의 _recv_over 라 새 연결이 쓰고 있을 수 있으므로 건드리지 않는다.
+			SESSION* CL = getClient(Session_Key_Id(key));
+			if (CL == nullptr || false == Session_Key_Current(key, CL->_generation.load())) {
+				if (ex_over->_comp_type == OP_SEND)
+					delete ex_over;
+				continue;
+			}
+		}
+		if (false == ret) {
 			if (ex_over->_comp_type == OP_ACCEPT) {
 				cout << "Accept Error" << endl;
+				if (ex_over->_accept_socket != INVALID_SOCKET) IO_Close(ex_over->_accept_socket);
+				IO_Accept(ex_over->_listen_socket, ex_over);
 			}
 			else {
-				cout << "GQCS Error on client[" << key << "]\n";
-				disconnect(static_cast<int>(key));
+				cout << "GQCS Error on client[" << Session_Key_Id(key) << "]\n";
+				Post_Disconnect(Session_Key_Id(key));
 				if (ex_over->_comp_type == OP_SEND)
 					delete ex_over;
 			}
@@ -546,7 +607,7 @@ void worker_thread(HANDLE h_iocp)
 		}
 
 		if ((0 == num_bytes) && ((ex_over->_comp_type == OP_RECV) || (ex_over->_comp_type == OP_SEND))) {
-			disconnect(static_cast<int>(key));
+			Post_Disconnect(Session_Key_Id(key));
 			if (ex_over->_comp_type == OP_SEND)
 				delete ex_over;
 			continue;
@@ -554,32 +615,37 @@ void worker_thread(HANDLE h_iocp)
 
 		switch (ex_over->_comp_type) {
 		case OP_ACCEPT: {
+#ifdef _COLLECT_STATS
+			auto alloc_begin = high_resolution_clock::now();
+#endif
 			int client_id = get_new_client_id();
+#ifdef _COLLECT_STATS
+			STAT_ADD(slot_alloc_ns, duration_cast<nanoseconds>(high_resolution_clock::now() - alloc_begin).count());
+#endif
 			if (client_id != -1) {
 				SESSION* CL = getClient(client_id);
 				if (CL == nullptr) {
 					cout << "wrong session_id - Accept Session" << endl;
 					break;
 				}
-				CL->_state.store(ST_ALLOC);
-				CL->_socket = g_c_socket;
+				// 정리된 뒤에 넣어진 옛 연결의 메시지와 옛 소켓의 완료가 새 연결에 쓰이지 않게 한다
+				unsigned generation = CL->_generation.fetch_add(1) + 1;
 				CL->_id = client_id;
-				CreateIoCompletionPort(reinterpret_cast<HANDLE>(g_c_socket),
-					h_iocp, client_id, 0);
+				CL->reset_send();
+				CL->reset_recv();
+				CL->open_socket(ex_over->_accept_socket, Make_Session_Key(client_id, generation));
+				STAT_ADD(accept_count, 1);
 				CL->do_recv();
 			}
 			else {
 				cout << "Max user exceeded.\n";
-				closesocket(g_c_socket);
+				IO_Close(ex_over->_accept_socket);
 			}
-			g_c_socket = WSASocket(AF_INET, SOCK_STREAM, 0, NULL, 0, WSA_FLAG_OVERLAPPED);
-			ZeroMemory(&g_a_over._over, sizeof(g_a_over._over));
-			int addr_size = sizeof(SOCKADDR_IN);
-			AcceptEx(g_s_socket, g_c_socket, g_a_over._send_buf, 0, addr_size + 16, addr_size + 16, 0, &g_a_over._over);
+			IO_Accept(ex_over->_listen_socket, ex_over);
 		}
 					  break;
 		case OP_RECV: {
-			SESSION* CL = getClient(static_cast<int>(key));
+			SESSION* CL = getClient(Session_Key_Id(key));
 			if (CL == nullptr) {
 				cout << "wrong session_id - Recv Packet" << endl;
 				break;
@@ -587,51 +653,32 @@ void worker_thread(HANDLE h_iocp)
 			if (CL->_state.load() == ST_DEAD) {
 				break;
 			}
-			int remain_data = num_bytes + CL->_prev_remain;
-			char* p = ex_over->_send_buf;
-			while (remain_data > 0) {
-				int packet_size = p[0];
-				if (packet_size <= remain_data) {
-					process_packet(static_cast<int>(key), p);
-					p += packet_size;
-					remain_data -= packet_size;
-				}
-				else break;
-			}
-			CL->_prev_remain = remain_data;
-			if (remain_data > 0) {
-				memcpy(ex_over->_send_buf, p, remain_data);
+			STAT_ADD(recv_count, 1);
+			STAT_ADD(recv_bytes, num_bytes);
+			int c_id = Session_Key_Id(key);
+			bool valid = CL->recv_complete(num_bytes, [&](char* packet, int size) {
+				STAT_ADD(packets_recv, 1);
+				Post_Room_Job(ROOM_JOB::Create(RJ_PACKET, c_id / MAX_USER_PER_ROOM, c_id, packet, size));
+				});
+			if (false == valid) {
+				cout << "wrong packet size - Recv Packet" << endl;
+				Post_Disconnect(c_id);
+				break;
 			}
 			CL->do_recv();
 		}
 					break;
 		case OP_SEND: {
+			STAT_ADD(send_count, 1);
+			STAT_ADD(send_bytes, num_bytes);
+			SESSION* CL = getClient(Session_Key_Id(key));
+			if (CL != nullptr) CL->send_complete(ex_over);
 			delete ex_over;
 		}
 					break;
-		case OP_NPC_UPDATE: {
-			int roomNum = static_cast<int>(key) / 100;
-			short mon_id = static_cast<int>(key) % 100;
-			auto& monster = monsters[roomNum][mon_id];
-
-			if (monster->alive.load() == true) {
-				{
-					//  ¸ ֱ Ʈϰ  Ŭ̾Ʈ ȭ
-					lock_guard<mutex> mm{ monster->m_lock };
-					monster->Update(duration_cast<milliseconds>(high_resolution_clock::now() - monster->recent_updateTime).count() / 1000.f);
-					monster->recent_updateTime = high_resolution_clock::now();
-				}
-				for (auto& cl : clients[roomNum]) {
-					if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)  cl.send_monster_update_packet(monster);
-				}
-
-				// Ʈ   Ʈ  Ÿ̸ ̺Ʈ 
-				TIMER_EVENT ev{ roomNum, mon_id, monster->recent_updateTime + 100ms, EV_MONSTER_UPDATE };
-				timer_queue.push(ev);
-			}
-			delete ex_over;
-		}
-						  break;
 		}
+#ifdef _COLLECT_STATS
+		STAT_ADD(busy_ns, duration_cast<nanoseconds>(high_resolution_clock::now() - begin_time).count());
+#endif
 	}
 }
@@ -0,0 +1,1275 @@
+#pragma once
+// NetworkIO.h
+// 서버의 비동기 I/O 를 플랫폼과 상관없이 같은 완료(Completion) 모델로 다루기 위한 계층
+//  - Windows : IOCP (AcceptEx / WSARecv / WSASend / GetQueuedCompletionStatus)
+//  - Linux   : epoll 로 소켓 준비 상태를 받아 워커가 직접 accept/recv/send 를 수행하고
+//              그 결과를 IOCP 의 완료 통지와 같은 형태(bytes, key, OVER_EXP*)로 돌려준다.
+//              edge-triggered(EPOLLET) 대신 EPOLLONESHOT 을 쓴다. (아래 epoll 절 참고)
+//  - Linux + _USE_IO_URING : io_uring 의 완료 큐를 그대로 사용한다. (커널 6.0 이상, liburing 2.4 이상)
+//              multishot accept/recv 로 요청을 다시 걸지 않고, send 는 등록된 고정 버퍼(SEND_BUFFER 슬랩)에서 보낸다.
+//
+// 워커 스레드는 IO_GetCompletion() 으로 완료를 하나씩 받아 처리하며,
+// 소켓마다 recv 는 한 번에 하나만 걸려 있다는 기존 IOCP 코드의 가정을 그대로 유지한다.
+//
+// Linux 빌드는 같은 디렉터리의 CMakeLists.txt 를 사용한다. (DirectXMath 헤더 경로 필요)
+//   cmake -S . -B build -DDIRECTXMATH_INCLUDE_DIR=<DirectXMath/Inc> && cmake --build build
+//   (io_uring 백엔드는 -DSERVER_USE_IO_URING=ON, liburing 필요)
+
+#include "protocol.h"
+#include "Stats.h"
+#include "MemoryPool.h"
+
+#ifdef _WIN32
+#include <WS2tcpip.h>
+#include <MSWSock.h>
+#pragma comment(lib, "WS2_32.lib")
+#pragma comment(lib, "MSWSock.lib")
+#else
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <signal.h>
+#ifdef _USE_IO_URING
+#include <liburing.h>
+#endif
+#endif
+
+constexpr int MAX_SEND_GATHER = 16;		// send 한 번에 모아 보내는 SEND_BUFFER 의 최대 개수
+
+/**
+ * @brief 직렬화된 패킷을 담는 송신 버퍼
+ *
+ * 방 전체에 보내는 패킷은 한 번만 만들어 두고, 받는 세션들의 송신 큐가 참조 카운트로 공유합니다.
+ * 마지막 참조가 해제되면 SendBufferPool 로 돌아갑니다.
+ */
+class SEND_BUFFER {
+public:
+	atomic<int> _ref_count;
+	bool _shared;				// 여러 세션이 공유하는 버퍼 - 뒤에 패킷을 이어 붙이지 않는다
+	unsigned short _size;
+	char _buf[BUF_SIZE];
+#ifdef _USE_IO_URING
+	// 버퍼가 io_uring 에 등록된 고정 버퍼 영역에 놓이도록 슬랩에서 할당
+	static void* operator new(size_t size);
+	static void operator delete(void* p);
+#endif
+	SEND_BUFFER() : _ref_count(0), _shared(false), _size(0) {}
+
+	static SEND_BUFFER* Create(const void* packet, bool shared);
+
+	// 남은 공간이 있으면 패킷을 뒤에 이어 붙인다.
+	bool Append(const void* packet)
+	{
+		int size = Get_Packet_Size(packet);
+		if (_shared || _size + size > BUF_SIZE) return false;
+		memcpy(_buf + _size, packet, size);
+		_size += size;
+		return true;
+	}
+	void AddRef() { _ref_count.fetch_add(1, memory_order_relaxed); }
+	void Release();
+};
+inline CObjectPool<SEND_BUFFER> SendBufferPool{ 2000 };
+
+inline SEND_BUFFER* SEND_BUFFER::Create(const void* packet, bool shared)
+{
+	SEND_BUFFER* buf = SendBufferPool.GetMemory();
+	buf->_ref_count.store(1, memory_order_relaxed);
+	buf->_shared = false;
+	buf->_size = 0;
+	buf->Append(packet);
+	buf->_shared = shared;
+	return buf;
+}
+
+inline void SEND_BUFFER::Release()
+{
+	if (_ref_count.fetch_sub(1, memory_order_acq_rel) == 1)
+		SendBufferPool.ReturnMemory(this);
+}
+
+enum COMP_TYPE { OP_ACCEPT, OP_RECV, OP_SEND };
+
+// IO_Send 의 결과
+//  - IO_SEND_DONE    : 즉시 전부 보냈다. 완료 통지가 오지 않으므로 호출한 쪽에서 over 를 해제한다.
+//  - IO_SEND_PENDING : 완료 통지(성공 또는 실패)가 나중에 온다. over 는 완료를 처리할 때 해제한다.
+//  - IO_SEND_FAILED  : 바로 실패했고 완료 통지도 오지 않는다. 호출한 쪽에서 over 를 해제하고 연결을 끊는다.
+enum IO_SEND_RESULT { IO_SEND_DONE, IO_SEND_PENDING, IO_SEND_FAILED };
+class OVER_EXP {
+public:
+	WSAOVERLAPPED _over;
+	WSABUF _wsabuf;
+	char _send_buf[BUF_SIZE];
+	COMP_TYPE _comp_type;
+	SOCKET _accept_socket;	// OP_ACCEPT 완료 시 접속한 클라이언트 소켓
+	SOCKET _listen_socket;	// OP_ACCEPT 를 건 listen 소켓 - 완료를 처리한 워커가 같은 소켓에 다시 건다
+	SEND_BUFFER* _send_refs[MAX_SEND_GATHER];	// OP_SEND : 모아 보내는 송신 버퍼 (완료 후 참조 해제)
+	WSABUF _send_wsabufs[MAX_SEND_GATHER];
+	int _send_count = 0;
+#ifdef _USE_IO_URING
+	SOCKET _send_socket = INVALID_SOCKET;	// 일부만 보낸 send 를 이어서 보낼 소켓
+	ULONG_PTR _key = 0;						// send 완료 통지에 돌려줄 세션 키
+	DWORD _send_offset = 0;					// 이미 보낸 바이트 수
+	iovec _iov[MAX_SEND_GATHER];
+	msghdr _msg;
+#endif
+	// 패킷/타이머마다 생기는 OVER_EXP 는 OverPool 에서 할당한다.
+	static void* operator new(size_t size);
+	static void operator delete(void* p);
+
+	OVER_EXP()
+	{
+		_wsabuf.len = BUF_SIZE;
+		_wsabuf.buf = _send_buf;
+		_comp_type = OP_RECV;
+		_accept_socket = INVALID_SOCKET;
+		_listen_socket = INVALID_SOCKET;
+		ZeroMemory(&_over, sizeof(_over));
+	}
+	OVER_EXP(char* packet)
+	{
+		_wsabuf.len = Get_Packet_Size(packet);
+		_wsabuf.buf = _send_buf;
+		ZeroMemory(&_over, sizeof(_over));
+		_comp_type = OP_SEND;
+		_accept_socket = INVALID_SOCKET;
+		_listen_socket = INVALID_SOCKET;
+		memcpy(_send_buf, packet, _wsabuf.len);
+	}
+	~OVER_EXP() { release_send_buffers(); }
+
+	// 송신 버퍼를 send 대상에 추가한다. (참조는 호출한 쪽에서 넘겨받는다)
+	void add_send_buffer(SEND_BUFFER* buf)
+	{
+		_send_refs[_send_count] = buf;
+		_send_wsabufs[_send_count].buf = buf->_buf;
+		_send_wsabufs[_send_count].len = buf->_size;
+		++_send_count;
+	}
+	void release_send_buffers()
+	{
+		for (int i = 0; i < _send_count; ++i) _send_refs[i]->Release();
+		_send_count = 0;
+	}
+
+	// send 할 버퍼 목록 - 송신 버퍼가 없으면 _wsabuf 하나를 보낸다.
+	WSABUF* send_bufs() { return (_send_count > 0) ? _send_wsabufs : &_wsabuf; }
+	DWORD send_buf_count() { return (_send_count > 0) ? _send_count : 1; }
+	DWORD send_length()
+	{
+		DWORD len = 0;
+		WSABUF* bufs = send_bufs();
+		for (DWORD i = 0; i < send_buf_count(); ++i) len += bufs[i].len;
+		return len;
+	}
+};
+
+// OverPool 이 관리하는 OVER_EXP 크기의 메모리 블록 (생성/소멸은 OVER_EXP 의 new/delete 가 한다)
+struct OVER_EXP_BLOCK {
+	alignas(OVER_EXP) char _data[sizeof(OVER_EXP)];
+};
+inline CObjectPool<OVER_EXP_BLOCK> OverPool{ 4096 };
+
+inline void* OVER_EXP::operator new([[maybe_unused]] size_t size)
+{
+	// 풀의 블록은 OVER_EXP 크기 - 파생 클래스를 이 연산자로 만들면 안 된다.
+	assert(size <= sizeof(OVER_EXP_BLOCK));
+	return OverPool.GetMemory();
+}
+
+inline void OVER_EXP::operator delete(void* p)
+{
+	OverPool.ReturnMemory(static_cast<OVER_EXP_BLOCK*>(p));
+}
+
+#ifndef _WIN32
+// 보낼 버퍼 목록에서 앞의 offset 바이트를 건너뛴 iovec 배열을 만든다.
+inline int linux_build_iov(OVER_EXP* over, DWORD offset, iovec* iov)
+{
+	int count = 0;
+	WSABUF* bufs = over->send_bufs();
+	for (DWORD i = 0; i < over->send_buf_count(); ++i) {
+		if (offset >= bufs[i].len) {
+			offset -= bufs[i].len;
+			continue;
+		}
+		iov[count].iov_base = bufs[i].buf + offset;
+		iov[count].iov_len = bufs[i].len - offset;
+		offset = 0;
+		++count;
+	}
+	return count;
+}
+
+// I/O 워커 번호 (IO_Bind_Worker 로 정한다)
+// epoll / io_uring 백엔드는 워커마다 epoll(링)을 따로 두고, 소켓은 IO_Register 를 호출한 워커의 것에 속한다.
+inline thread_local int t_io_shard = -1;
+inline int g_num_shards = 1;
+
+// 지금 스레드가 등록하는 소켓이 속할 워커 - 워커가 아닌 스레드(main)는 0번
+inline int io_current_shard() { return (t_io_shard >= 0) ? t_io_shard : 0; }
+
+// 워커 스레드가 IO_GetCompletion 을 부르기 전에 자기 번호를 정한다. (0 ~ IO_Initialize 에 넘긴 워커 수 - 1)
+inline void IO_Bind_Worker(int index)
+{
+	t_io_shard = index % g_num_shards;
+}
+#endif
+
+
+constexpr int ACCEPT_POOL_SIZE = 64;		// 미리 걸어두는 accept 요청 수 (listen 소켓 전체 합)
+constexpr ULONG_PTR LISTEN_KEY = 9999;		// listen 소켓의 완료 키 (세션 id 와 겹치지 않는 값)
+inline vector<SOCKET> g_listen_sockets;		// IO_Start_Accept 가 연 listen 소켓
+
+#ifdef _WIN32
+//////////////////////////////////////////////////////////////////////////////////
+// Windows - IOCP
+
+constexpr const char* IO_BACKEND_NAME = "IOCP";
+constexpr bool IO_LISTEN_SHARDING = false;	// SO_REUSEPORT 로 접속을 나눠 받는 기능이 없다 - listen 소켓 하나에 AcceptEx 를 여러 개 건다
+constexpr bool IO_MULTISHOT_ACCEPT = false;
+inline HANDLE h_iocp;
+
+// 워커 수는 쓰지 않는다. (IOCP 하나를 모든 워커가 공유)
+inline bool IO_Initialize(int)
+{
+	WSADATA WSAData;
+	if (WSAStartup(MAKEWORD(2, 2), &WSAData) == SOCKET_ERROR) return false;
+	h_iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, 0, 0, 0);
+	return h_iocp != NULL;
+}
+
+// reuse_port 는 무시한다. (IO_LISTEN_SHARDING 참고)
+inline SOCKET IO_Listen(short port, bool reuse_port = false)
+{
+	SOCKET s = WSASocket(AF_INET, SOCK_STREAM, 0, NULL, 0, WSA_FLAG_OVERLAPPED);
+	SOCKADDR_IN server_addr;
+	memset(&server_addr, 0, sizeof(server_addr));
+	server_addr.sin_family = AF_INET;
+	server_addr.sin_port = htons(port);
+	server_addr.sin_addr.S_un.S_addr = INADDR_ANY;
+	if (bind(s, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)) != 0 || listen(s, SOMAXCONN) != 0) {
+		closesocket(s);
+		return INVALID_SOCKET;
+	}
+	return s;
+}
+
+inline void IO_Register(SOCKET s, ULONG_PTR key, int = -1)
+{
+	CreateIoCompletionPort(reinterpret_cast<HANDLE>(s), h_iocp, key, 0);
+}
+
+inline void IO_Bind_Worker(int) {}
+
+inline void IO_Accept(SOCKET listen_socket, OVER_EXP* over)
+{
+	int addr_size = sizeof(SOCKADDR_IN);
+	over->_comp_type = OP_ACCEPT;
+	over->_listen_socket = listen_socket;
+	over->_accept_socket = WSASocket(AF_INET, SOCK_STREAM, 0, NULL, 0, WSA_FLAG_OVERLAPPED);
+	ZeroMemory(&over->_over, sizeof(over->_over));
+	AcceptEx(listen_socket, over->_accept_socket, over->_send_buf, 0, addr_size + 16, addr_size + 16, 0, &over->_over);
+}
+
+inline void IO_Recv(SOCKET s, OVER_EXP* over)
+{
+	DWORD recv_flag = 0;
+	ZeroMemory(&over->_over, sizeof(over->_over));
+	STAT_ADD(io_syscalls, 1);
+	WSARecv(s, &over->_wsabuf, 1, 0, &recv_flag, &over->_over, 0);
+}
+
+// 바로 끝난 send 도 완료는 IOCP 로 전달된다. WSA_IO_PENDING 이 아닌 오류만 완료 통지 없이 실패한다.
+inline IO_SEND_RESULT IO_Send(SOCKET s, OVER_EXP* over)
+{
+	STAT_ADD(io_syscalls, 1);
+	if (SOCKET_ERROR == WSASend(s, over->send_bufs(), over->send_buf_count(), 0, 0, &over->_over, 0)
+		&& WSAGetLastError() != WSA_IO_PENDING)
+		return IO_SEND_FAILED;
+	return IO_SEND_PENDING;
+}
+
+inline void IO_Post(DWORD num_bytes, ULONG_PTR key, OVER_EXP* over)
+{
+	PostQueuedCompletionStatus(h_iocp, num_bytes, key, &over->_over);
+}
+
+inline bool IO_GetCompletion(DWORD* num_bytes, ULONG_PTR* key, OVER_EXP** over)
+{
+	WSAOVERLAPPED* ov = nullptr;
+	BOOL ret = GetQueuedCompletionStatus(h_iocp, num_bytes, key, &ov, INFINITE);
+	STAT_ADD(io_syscalls, 1);
+	*over = reinterpret_cast<OVER_EXP*>(ov);
+	return ret == TRUE;
+}
+
+inline void IO_Close(SOCKET s)
+{
+	closesocket(s);
+}
+
+inline void IO_Finalize()
+{
+	for (SOCKET s : g_listen_sockets) closesocket(s);
+	g_listen_sockets.clear();
+	WSACleanup();
+}
+
+#elif !defined(_USE_IO_URING)
+//////////////////////////////////////////////////////////////////////////////////
+// Linux - epoll
+// 소켓은 EPOLLONESHOT 으로 등록하여 한 번의 준비 통지를 한 워커만 처리하게 하고,
+// 처리 후 걸려있는 요청(recv/accept, 보내지 못한 send)이 있을 때만 다시 등록한다.
+// I/O 워커마다 epoll(EPOLL_SHARD)을 하나씩 두고, 소켓은 IO_Register 를 호출한 워커의 epoll 에 속한다.
+// 한 소켓의 통지는 그 워커만 받으므로 워커들이 준비 통지를 두고 다투지 않고, epoll_wait 로 여러 개를 한 번에 받는다.
+// EPOLLET 만 쓰면 워커가 한 소켓을 처리하는 도중에 데이터가 더 오면 다른 워커도 같은 소켓의 통지를 받는다.
+// 그러면 소켓마다 recv 를 하나씩만 처리한다는 IOCP 의 가정이 깨지고 recv_queue 의 OVER_EXP 를 두 워커가 나눠 갖게 된다.
+// ONESHOT 은 다시 등록할 때까지 통지가 없으므로 ET 처럼 같은 준비 상태로 여러 번 깨어나지 않으면서 이 가정을 지킨다.
+// (대신 처리할 때마다 epoll_ctl 이 한 번 든다)
+// PostQueuedCompletionStatus 는 epoll 마다 둔 eventfd + 완료 큐로 대신한다.
+
+constexpr const char* IO_BACKEND_NAME = "epoll";
+constexpr bool IO_LISTEN_SHARDING = true;
+constexpr bool IO_MULTISHOT_ACCEPT = false;
+constexpr int MAX_SOCKET_FD = 65536;
+constexpr int EPOLL_WAIT_BATCH = 64;	// epoll_wait 한 번에 받는 준비 통지 수
+
+struct IO_COMPLETION {
+	DWORD num_bytes;
+	ULONG_PTR key;
+	OVER_EXP* over;
+	bool success;
+};
+
+struct EPOLL_SOCKET {
+	mutex lock;
+	bool registered = false;
+	ULONG_PTR key = 0;
+	int shard = 0;					// 소켓이 등록된 epoll (g_epoll_shards 의 번호)
+	deque<OVER_EXP*> recv_queue;	// 걸려있는 recv(세션) 또는 accept(listen 소켓) 요청
+	deque<OVER_EXP*> send_queue;	// 커널 송신 버퍼가 가득 차 아직 다 보내지 못한 send 요청
+	DWORD send_offset = 0;			// send_queue.front() 에서 이미 보낸 바이트 수
+};
+
+// I/O 워커 하나가 맡는 epoll 과 그 워커에게 직접 넘기는 완료
+struct EPOLL_SHARD {
+	int epoll = -1;
+	int post_event = -1;
+	concurrent_queue<IO_COMPLETION> post_queue;
+};
+
+// 워커가 epoll_wait 로 받아 두고 아직 처리하지 않은 준비 통지
+struct EPOLL_READY {
+	epoll_event events[EPOLL_WAIT_BATCH];
+	int count = 0;
+	int next = 0;
+};
+
+inline EPOLL_SHARD* g_epoll_shards = nullptr;
+inline EPOLL_SOCKET* g_epoll_sockets = nullptr;
+inline thread_local EPOLL_READY t_epoll_ready;
+
+// shard 번 워커의 완료 큐에 넣고 eventfd 로 깨운다.
+inline void IO_PostResult(DWORD num_bytes, ULONG_PTR key, OVER_EXP* over, bool success, int shard)
+{
+	EPOLL_SHARD& sh = g_epoll_shards[shard];
+	sh.post_queue.push(IO_COMPLETION{ num_bytes, key, over, success });
+	uint64_t one = 1;
+	STAT_ADD(io_syscalls, 1);
+	if (write(sh.post_event, &one, sizeof(one)) != sizeof(one)) perror("eventfd write");
+}
+
+inline void IO_Post(DWORD num_bytes, ULONG_PTR key, OVER_EXP* over)
+{
+	IO_PostResult(num_bytes, key, over, true, io_current_shard());
+}
+
+// I/O 워커마다 epoll 과 eventfd 를 하나씩 만든다.
+inline bool IO_Initialize(int num_workers)
+{
+	g_num_shards = max(1, num_workers);
+	g_epoll_shards = new EPOLL_SHARD[g_num_shards];
+	for (int i = 0; i < g_num_shards; ++i) {
+		EPOLL_SHARD& sh = g_epoll_shards[i];
+		sh.epoll = epoll_create1(EPOLL_CLOEXEC);
+		sh.post_event = eventfd(0, EFD_NONBLOCK | EFD_SEMAPHORE | EFD_CLOEXEC);
+		if (sh.epoll < 0 || sh.post_event < 0) return false;
+
+		epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.fd = sh.post_event;
+		if (epoll_ctl(sh.epoll, EPOLL_CTL_ADD, sh.post_event, &ev) != 0) return false;
+	}
+	g_epoll_sockets = new EPOLL_SOCKET[MAX_SOCKET_FD];
+	return true;
+}
+
+/**
+ * @brief listen 소켓 생성
+ * @param reuse_port SO_REUSEPORT 를 켜서 같은 포트에 listen 소켓을 여러 개 열 수 있게 한다.
+ *                   커널이 들어오는 접속을 소켓들에 나눠 주므로 accept 대기열과 락이 소켓마다 따로 생긴다.
+ *                   (IO_Start_Accept 가 i 번 소켓을 i 번 워커의 epoll 에 등록하므로 소켓마다 accept 를 처리하는 워커가 정해진다)
+ */
+inline SOCKET IO_Listen(short port, bool reuse_port = false)
+{
+	SOCKET s = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	int opt = 1;
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+	if (reuse_port) setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+	sockaddr_in server_addr;
+	memset(&server_addr, 0, sizeof(server_addr));
+	server_addr.sin_family = AF_INET;
+	server_addr.sin_port = htons(port);
+	server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(s, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)) != 0 || listen(s, SOMAXCONN) != 0) {
+		close(s);
+		return INVALID_SOCKET;
+	}
+	return s;
+}
+
+// 걸려있는 요청에 맞춰 소켓을 다시 감시 대상으로 등록한다. (ctx.lock 을 잡은 상태에서 호출)
+inline void epoll_rearm(SOCKET s, EPOLL_SOCKET& ctx)
+{
+	epoll_event ev{};
+	ev.events = EPOLLONESHOT;
+	if (false == ctx.recv_queue.empty()) ev.events |= EPOLLIN;
+	if (false == ctx.send_queue.empty()) ev.events |= EPOLLOUT;
+	ev.data.fd = s;
+	STAT_ADD(io_syscalls, 1);
+	epoll_ctl(g_epoll_shards[ctx.shard].epoll, EPOLL_CTL_MOD, s, &ev);
+}
+
+/**
+ * @brief 소켓을 워커의 epoll 에 등록한다.
+ * @param shard 소켓이 속할 epoll - 생략하면 호출한 워커의 것 (accept 를 처리한 워커가 그 접속을 계속 맡는다)
+ */
+inline void IO_Register(SOCKET s, ULONG_PTR key, int shard = -1)
+{
+	if (s < 0 || s >= MAX_SOCKET_FD) {
+		cout << "socket fd out of range - IO_Register\n";
+		return;
+	}
+	int flags = fcntl(s, F_GETFL, 0);
+	fcntl(s, F_SETFL, flags | O_NONBLOCK);
+
+	EPOLL_SOCKET& ctx = g_epoll_sockets[s];
+	lock_guard<mutex> ll{ ctx.lock };
+	ctx.registered = true;
+	ctx.key = key;
+	ctx.shard = (shard >= 0) ? shard % g_num_shards : io_current_shard();
+	ctx.recv_queue.clear();
+	ctx.send_queue.clear();
+	ctx.send_offset = 0;
+	epoll_event ev{};
+	ev.events = EPOLLONESHOT;
+	ev.data.fd = s;
+	epoll_ctl(g_epoll_shards[ctx.shard].epoll, EPOLL_CTL_ADD, s, &ev);
+}
+
+inline void IO_Accept(SOCKET listen_socket, OVER_EXP* over)
+{
+	over->_comp_type = OP_ACCEPT;
+	over->_accept_socket = INVALID_SOCKET;
+	over->_listen_socket = listen_socket;
+	EPOLL_SOCKET& ctx = g_epoll_sockets[listen_socket];
+	lock_guard<mutex> ll{ ctx.lock };
+	ctx.recv_queue.push_back(over);
+	epoll_rearm(listen_socket, ctx);
+}
+
+inline void IO_Recv(SOCKET s, OVER_EXP* over)
+{
+	if (s < 0 || s >= MAX_SOCKET_FD) return;
+	EPOLL_SOCKET& ctx = g_epoll_sockets[s];
+	lock_guard<mutex> ll{ ctx.lock };
+	if (false == ctx.registered) return;
+	ctx.recv_queue.push_back(over);
+	epoll_rearm(s, ctx);
+}
+
+// offset 이후의 데이터를 sendmsg 한 번으로 보낸다.
+inline ssize_t epoll_send_gather(SOCKET s, OVER_EXP* over, DWORD offset)
+{
+	iovec iov[MAX_SEND_GATHER];
+	msghdr msg{};
+	msg.msg_iov = iov;
+	msg.msg_iovlen = linux_build_iov(over, offset, iov);
+	STAT_ADD(io_syscalls, 1);
+	return sendmsg(s, &msg, MSG_NOSIGNAL);
+}
+
+// 보내지 못하고 쌓인 send 를 순서대로 보내고, 다 보낸 요청은 완료 큐로 넘긴다. (ctx.lock 을 잡은 상태에서 호출)
+inline void epoll_flush_sends(SOCKET s, EPOLL_SOCKET& ctx)
+{
+	while (false == ctx.send_queue.empty()) {
+		OVER_EXP* over = ctx.send_queue.front();
+		DWORD length = over->send_length();
+		ssize_t ret = epoll_send_gather(s, over, ctx.send_offset);
+		if (ret > 0) {
+			ctx.send_offset += static_cast<DWORD>(ret);
+			if (ctx.send_offset < length) continue;
+			ctx.send_queue.pop_front();
+			ctx.send_offset = 0;
+			IO_PostResult(length, ctx.key, over, true, ctx.shard);
+			continue;
+		}
+		if (ret < 0 && errno == EINTR) continue;
+		if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+		// 연결 오류 : 남은 send 는 모두 실패로 완료시킨다.
+		for (auto& ov : ctx.send_queue)
+			IO_PostResult(0, ctx.key, ov, false, ctx.shard);
+		ctx.send_queue.clear();
+		ctx.send_offset = 0;
+		break;
+	}
+}
+
+/**
+ * @brief 송신 요청
+ *
+ * 앞서 보내지 못한 데이터가 없으면 바로 send 하고, 커널 버퍼가 가득 찬 경우에만
+ * EPOLLOUT 을 걸어 나머지를 워커 스레드가 보내게 한다.
+ * send 오류는 실패 완료로 돌려준다. (IO_SEND_PENDING)
+ */
+inline IO_SEND_RESULT IO_Send(SOCKET s, OVER_EXP* over)
+{
+	if (s < 0 || s >= MAX_SOCKET_FD) return IO_SEND_FAILED;
+	EPOLL_SOCKET& ctx = g_epoll_sockets[s];
+	lock_guard<mutex> ll{ ctx.lock };
+	if (false == ctx.registered) return IO_SEND_FAILED;
+
+	if (ctx.send_queue.empty()) {
+		ssize_t ret = epoll_send_gather(s, over, 0);
+		if (ret == static_cast<ssize_t>(over->send_length())) {
+			STAT_ADD(send_count, 1);
+			STAT_ADD(send_bytes, ret);
+			return IO_SEND_DONE;
+		}
+		if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+			IO_PostResult(0, ctx.key, over, false, ctx.shard);
+			return IO_SEND_PENDING;
+		}
+		ctx.send_offset = (ret > 0) ? static_cast<DWORD>(ret) : 0;
+	}
+	ctx.send_queue.push_back(over);
+	epoll_rearm(s, ctx);
+	return IO_SEND_PENDING;
+}
+
+// 준비된 소켓의 요청을 처리한다. recv/accept 가 끝났으면 true 와 함께 완료 정보를 채운다.
+inline bool epoll_handle_event(SOCKET s, uint32_t events, DWORD* num_bytes, ULONG_PTR* key, OVER_EXP** over, bool* success)
+{
+	EPOLL_SOCKET& ctx = g_epoll_sockets[s];
+	lock_guard<mutex> ll{ ctx.lock };
+	if (false == ctx.registered) return false;
+
+	if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+		epoll_flush_sends(s, ctx);
+
+	bool completed = false;
+	if ((events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && false == ctx.recv_queue.empty()) {
+		OVER_EXP* ov = ctx.recv_queue.front();
+		if (ov->_comp_type == OP_ACCEPT) {
+			STAT_ADD(io_syscalls, 1);
+			SOCKET c_socket = accept4(s, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if (c_socket >= 0) {
+				ov->_accept_socket = c_socket;
+				*num_bytes = 0;
+				*success = true;
+				completed = true;
+			}
+			else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				*num_bytes = 0;
+				*success = false;
+				completed = true;
+			}
+		}
+		else {
+			STAT_ADD(io_syscalls, 1);
+			ssize_t ret = recv(s, ov->_wsabuf.buf, ov->_wsabuf.len, 0);
+			if (ret >= 0) {
+				*num_bytes = static_cast<DWORD>(ret);
+				*success = true;
+				completed = true;
+			}
+			else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				*num_bytes = 0;
+				*success = false;
+				completed = true;
+			}
+		}
+		if (completed) {
+			ctx.recv_queue.pop_front();
+			*key = ctx.key;
+			*over = ov;
+		}
+	}
+
+	if (false == ctx.recv_queue.empty() || false == ctx.send_queue.empty())
+		epoll_rearm(s, ctx);
+	return completed;
+}
+
+// 자기 epoll 의 준비 통지를 EPOLL_WAIT_BATCH 개까지 한 번에 받아 두고 하나씩 처리한다.
+// 받아 둔 뒤 닫히고 번호가 재사용된 소켓의 통지는 새 소켓에 대해 recv 가 EAGAIN 으로 끝날 뿐이다.
+inline bool IO_GetCompletion(DWORD* num_bytes, ULONG_PTR* key, OVER_EXP** over)
+{
+	EPOLL_SHARD& sh = g_epoll_shards[io_current_shard()];
+	EPOLL_READY& ready = t_epoll_ready;
+	while (1) {
+		if (ready.next >= ready.count) {
+			ready.next = ready.count = 0;
+			int n = epoll_wait(sh.epoll, ready.events, EPOLL_WAIT_BATCH, -1);
+			STAT_ADD(io_syscalls, 1);
+			if (n <= 0) continue;
+			ready.count = n;
+		}
+		epoll_event& ev = ready.events[ready.next++];
+
+		if (ev.data.fd == sh.post_event) {
+			uint64_t count;
+			if (read(sh.post_event, &count, sizeof(count)) != sizeof(count)) continue;
+			IO_COMPLETION c;
+			if (false == sh.post_queue.try_pop(c)) continue;
+			*num_bytes = c.num_bytes;
+			*key = c.key;
+			*over = c.over;
+			return c.success;
+		}
+
+		bool success = false;
+		if (epoll_handle_event(ev.data.fd, ev.events, num_bytes, key, over, &success))
+			return success;
+	}
+}
+
+// 소켓을 닫는다. 보내지 못한 send 는 버퍼 해제를 위해 완료 큐로 넘긴다.
+inline void IO_Close(SOCKET s)
+{
+	if (s < 0) return;
+	if (s >= MAX_SOCKET_FD) {
+		close(s);
+		return;
+	}
+	EPOLL_SOCKET& ctx = g_epoll_sockets[s];
+	lock_guard<mutex> ll{ ctx.lock };
+	if (false == ctx.registered) {
+		close(s);
+		return;
+	}
+	ctx.registered = false;
+	epoll_ctl(g_epoll_shards[ctx.shard].epoll, EPOLL_CTL_DEL, s, nullptr);
+	for (auto& ov : ctx.send_queue)
+		IO_PostResult(ov->send_length(), ctx.key, ov, true, ctx.shard);
+	ctx.send_queue.clear();
+	ctx.recv_queue.clear();
+	ctx.send_offset = 0;
+	close(s);
+}
+
+inline void IO_Finalize()
+{
+	for (SOCKET s : g_listen_sockets) close(s);
+	g_listen_sockets.clear();
+	for (int i = 0; i < g_num_shards; ++i) {
+		close(g_epoll_shards[i].post_event);
+		close(g_epoll_shards[i].epoll);
+	}
+	delete[] g_epoll_shards;
+	delete[] g_epoll_sockets;
+}
+
+#else
+//////////////////////////////////////////////////////////////////////////////////
+// Linux - io_uring
+// I/O 워커마다 링(URING_SHARD)을 하나씩 두고, 소켓은 IO_Register 를 호출한 워커의 링에 속한다.
+// 링의 완료(CQ)는 그 워커만 읽으므로 잠그지 않는다.
+// 제출(SQ)은 다른 스레드(다른 워커나 작업 스레드의 send, 타이머)도 채우므로 링마다 sq_lock 으로 보호한다.
+// 워커가 자기 링에 건 요청은 바로 제출하지 않고 다음 완료 대기 직전에 한 번의 io_uring_enter 로 모아서 제출하고,
+// 다른 스레드가 건 요청은 바로 제출한다. 다른 링의 소켓에 생긴 완료는 그 링에 NOP 을 넣어 주인 워커에게 넘긴다.
+//  - accept : listen 소켓에 multishot accept 하나만 걸어둔다.
+//  - recv   : 세션마다 multishot recv 를 걸고 커널이 고른 제공 버퍼(buffer ring)로 받는다.
+//             세션이 do_recv 로 걸어둔 버퍼(수신 링의 빈 공간)가 있으면 제공 버퍼에서 바로 복사한다.
+//             세션이 아직 앞의 완료를 처리 중이면 그동안 온 데이터만 pending 에 모았다가 다음 IO_Recv 때 넘겨서
+//             "세션당 recv 완료는 한 번에 하나" 라는 가정을 지킨다. (세션이 링을 읽는 중에는 링에 쓸 수 없다)
+//             pending 이 URING_PENDING_LIMIT 에 닿으면 multishot recv 를 취소하고, 세션이 가져가 줄어들면 다시 건다.
+//  - send   : SEND_BUFFER 를 등록된 슬랩에서 할당하여, 버퍼 하나짜리 send 는 IORING_OP_WRITE_FIXED 로,
+//             여러 버퍼를 모은 send 는 sendmsg 로 보낸다.
+// 소켓별 상태는 fd 로 찾고, recv 의 user_data 에는 세대 번호를 넣어 닫힌 뒤 늦게 온 완료를 버린다.
+
+constexpr const char* IO_BACKEND_NAME = "io_uring";
+constexpr bool IO_LISTEN_SHARDING = true;
+constexpr bool IO_MULTISHOT_ACCEPT = true;	// listen 소켓마다 multishot accept 하나면 계속 받는다
+constexpr int MAX_SOCKET_FD = 65536;
+constexpr unsigned URING_ENTRIES = 4096;
+constexpr unsigned URING_RECV_BUFFERS = 4096;		// 링마다 두는 제공 버퍼 수 (2의 거듭제곱)
+constexpr unsigned short URING_RECV_GROUP = 0;
+constexpr size_t URING_FIXED_BUFFERS = 32768;		// 고정 버퍼로 등록할 SEND_BUFFER 수
+constexpr size_t URING_PENDING_LIMIT = 2 * BUF_SIZE;	// 세션이 가져가지 않은 수신 데이터의 상한 (세션 수신 링 하나 크기)
+constexpr uint64_t URING_TAG_POST = 1;
+constexpr uint64_t URING_TAG_CANCEL = 2;
+constexpr uint64_t URING_TAG_RECV = 1ull << 63;
+constexpr uint64_t URING_TAG_ACCEPT = 1ull << 62;
+
+struct IO_COMPLETION {
+	DWORD num_bytes;
+	ULONG_PTR key;
+	OVER_EXP* over;
+	bool success;
+};
+
+struct URING_SOCKET {
+	mutex lock;
+	bool registered = false;
+	int shard = 0;						// 소켓이 속한 링 (g_uring_shards 의 번호)
+	uint32_t generation = 0;
+	ULONG_PTR key = 0;
+	bool multishot = false;				// multishot recv/accept 가 걸려 있는지
+	OVER_EXP* recv_over = nullptr;		// 세션이 do_recv 로 넘긴 버퍼 (없으면 nullptr)
+	vector<char> pending;				// 세션이 아직 가져가지 않은 수신 데이터 ([pending_head, size) 가 남은 것)
+	size_t pending_head = 0;
+	bool throttled = false;				// pending 이 가득 차 multishot recv 취소를 건 상태
+	bool closed = false;				// 상대가 연결을 끊었거나 오류가 발생함
+	bool error = false;
+	OVER_EXP* accept_over = nullptr;	// listen 소켓 : IO_Accept 로 처음 넘겨받은 OVER_EXP
+};
+
+// I/O 워커 하나의 링과 수신용 제공 버퍼
+struct URING_SHARD {
+	io_uring ring;
+	mutex sq_lock;
+	io_uring_buf_ring* recv_ring = nullptr;
+	char* recv_buffers = nullptr;
+	concurrent_queue<IO_COMPLETION> post_queue;	// 다른 스레드가 이 워커에게 넘긴 완료
+};
+
+inline URING_SHARD* g_uring_shards = nullptr;
+inline URING_SOCKET* g_uring_sockets = nullptr;
+inline thread_local bool t_io_worker = false;			// IO_GetCompletion 을 호출하는 워커 스레드인지
+inline thread_local deque<IO_COMPLETION> t_ready;		// 이 워커가 바로 처리할 완료
+
+// SEND_BUFFER 슬랩 - 통째로 io_uring 고정 버퍼 0번으로 등록한다.
+// SendBufferPool 이 전역 초기화 때 미리 만드는 버퍼도 슬랩에 놓이도록 처음 할당할 때 만든다.
+// 종료할 때 SendBufferPool 의 소멸자가 버퍼를 돌려주므로 소멸자가 필요 없는 멤버만 둔다. (빈 목록도 배열로 둔다)
+struct URING_SLAB {
+	mutex lock;
+	char* memory = nullptr;
+	bool registered = false;
+	void** free_list = nullptr;
+	size_t free_count = 0;
+};
+inline URING_SLAB g_buffer_slab;
+
+// g_buffer_slab.lock 을 잡은 상태에서 호출
+inline void uring_slab_init()
+{
+	if (g_buffer_slab.memory != nullptr) return;
+	g_buffer_slab.memory = static_cast<char*>(aligned_alloc(4096, URING_FIXED_BUFFERS * sizeof(SEND_BUFFER)));
+	g_buffer_slab.free_list = new void*[URING_FIXED_BUFFERS];
+	for (size_t i = URING_FIXED_BUFFERS; i > 0; --i)
+		g_buffer_slab.free_list[g_buffer_slab.free_count++] = g_buffer_slab.memory + (i - 1) * sizeof(SEND_BUFFER);
+}
+
+inline bool uring_in_slab(const void* p)
+{
+	const char* c = reinterpret_cast<const char*>(p);
+	return g_buffer_slab.memory != nullptr && c >= g_buffer_slab.memory && c < g_buffer_slab.memory + URING_FIXED_BUFFERS * sizeof(SEND_BUFFER);
+}
+
+inline void* SEND_BUFFER::operator new(size_t size)
+{
+	{
+		lock_guard<mutex> ll{ g_buffer_slab.lock };
+		uring_slab_init();
+		if (g_buffer_slab.free_count > 0)
+			return g_buffer_slab.free_list[--g_buffer_slab.free_count];
+	}
+	return ::operator new(size);
+}
+
+inline void SEND_BUFFER::operator delete(void* p)
+{
+	if (uring_in_slab(p)) {
+		lock_guard<mutex> ll{ g_buffer_slab.lock };
+		g_buffer_slab.free_list[g_buffer_slab.free_count++] = p;
+		return;
+	}
+	::operator delete(p);
+}
+
+// 지금 스레드가 shard 번 링의 워커인지
+inline bool uring_is_owner(int shard) { return t_io_worker && t_io_shard == shard; }
+
+// SQE 를 하나 얻는다. SQ 가 가득 찼으면 먼저 제출한다. (sh.sq_lock 을 잡은 상태에서 호출)
+inline io_uring_sqe* uring_get_sqe(URING_SHARD& sh)
+{
+	io_uring_sqe* sqe = io_uring_get_sqe(&sh.ring);
+	while (sqe == nullptr) {
+		STAT_ADD(io_syscalls, 1);
+		io_uring_submit(&sh.ring);
+		sqe = io_uring_get_sqe(&sh.ring);
+	}
+	return sqe;
+}
+
+// 링의 워커는 대기 직전에 모아서 제출하고, 그 외 스레드는 바로 제출한다. (sq_lock 을 잡은 상태에서 호출)
+inline void uring_submit_if_needed(int shard)
+{
+	if (uring_is_owner(shard)) return;
+	STAT_ADD(io_syscalls, 1);
+	io_uring_submit(&g_uring_shards[shard].ring);
+}
+
+// 완료를 만든다. shard 번 링의 워커라면 자신이 바로 처리하고, 아니면 그 링에 NOP 을 넣어 워커를 깨운다.
+inline void uring_complete(DWORD num_bytes, ULONG_PTR key, OVER_EXP* over, bool success, int shard)
+{
+	if (uring_is_owner(shard)) {
+		t_ready.push_back(IO_COMPLETION{ num_bytes, key, over, success });
+		return;
+	}
+	URING_SHARD& sh = g_uring_shards[shard];
+	sh.post_queue.push(IO_COMPLETION{ num_bytes, key, over, success });
+	lock_guard<mutex> sl{ sh.sq_lock };
+	io_uring_sqe* sqe = uring_get_sqe(sh);
+	io_uring_prep_nop(sqe);
+	io_uring_sqe_set_data64(sqe, URING_TAG_POST);
+	STAT_ADD(io_syscalls, 1);
+	io_uring_submit(&sh.ring);
+}
+
+inline void IO_Post(DWORD num_bytes, ULONG_PTR key, OVER_EXP* over)
+{
+	uring_complete(num_bytes, key, over, true, io_current_shard());
+}
+
+// I/O 워커 수만큼 링을 만든다.
+inline bool IO_Initialize(int num_workers)
+{
+	// IORING_OP_WRITE_FIXED 에는 MSG_NOSIGNAL 을 줄 수 없어 끊긴 상대에게 보내면 SIGPIPE 로 서버가 종료된다.
+	// 프로세스 전체에서 무시하고 -EPIPE 완료로 처리한다.
+	signal(SIGPIPE, SIG_IGN);
+	g_num_shards = max(1, num_workers);
+	g_uring_shards = new URING_SHARD[g_num_shards];
+	g_uring_sockets = new URING_SOCKET[MAX_SOCKET_FD];
+	{
+		lock_guard<mutex> ll{ g_buffer_slab.lock };
+		uring_slab_init();
+	}
+	iovec slab_iov{ g_buffer_slab.memory, URING_FIXED_BUFFERS * sizeof(SEND_BUFFER) };
+	g_buffer_slab.registered = true;
+
+	for (int i = 0; i < g_num_shards; ++i) {
+		URING_SHARD& sh = g_uring_shards[i];
+		io_uring_params params{};
+		params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_CQSIZE;
+		params.cq_entries = URING_ENTRIES * 4;
+		if (io_uring_queue_init_params(URING_ENTRIES, &sh.ring, &params) < 0) return false;
+
+		// 수신용 제공 버퍼
+		int ret = 0;
+		sh.recv_ring = io_uring_setup_buf_ring(&sh.ring, URING_RECV_BUFFERS, URING_RECV_GROUP, 0, &ret);
+		if (sh.recv_ring == nullptr) return false;
+		sh.recv_buffers = new char[URING_RECV_BUFFERS * BUF_SIZE];
+		for (unsigned b = 0; b < URING_RECV_BUFFERS; ++b)
+			io_uring_buf_ring_add(sh.recv_ring, sh.recv_buffers + b * BUF_SIZE, BUF_SIZE, b, io_uring_buf_ring_mask(URING_RECV_BUFFERS), b);
+		io_uring_buf_ring_advance(sh.recv_ring, URING_RECV_BUFFERS);
+
+		// SEND_BUFFER 슬랩을 링마다 고정 버퍼로 등록 (하나라도 실패하면 모두 일반 send 로 동작)
+		if (io_uring_register_buffers(&sh.ring, &slab_iov, 1) != 0) g_buffer_slab.registered = false;
+	}
+	if (false == g_buffer_slab.registered)
+		cout << "io_uring fixed buffer registration failed - fallback to send\n";
+	return true;
+}
+
+// reuse_port - epoll 백엔드의 IO_Listen 과 같다.
+inline SOCKET IO_Listen(short port, bool reuse_port = false)
+{
+	SOCKET s = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	int opt = 1;
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+	if (reuse_port) setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+	sockaddr_in server_addr;
+	memset(&server_addr, 0, sizeof(server_addr));
+	server_addr.sin_family = AF_INET;
+	server_addr.sin_port = htons(port);
+	server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(s, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr)) != 0 || listen(s, SOMAXCONN) != 0) {
+		close(s);
+		return INVALID_SOCKET;
+	}
+	return s;
+}
+
+/**
+ * @brief 소켓을 링에 등록한다.
+ * @param shard 소켓이 속할 링 - 생략하면 호출한 워커의 링 (accept 를 처리한 워커가 그 접속을 계속 맡는다)
+ */
+inline void IO_Register(SOCKET s, ULONG_PTR key, int shard = -1)
+{
+	if (s < 0 || s >= MAX_SOCKET_FD) {
+		cout << "socket fd out of range - IO_Register\n";
+		return;
+	}
+	URING_SOCKET& ctx = g_uring_sockets[s];
+	lock_guard<mutex> ll{ ctx.lock };
+	ctx.registered = true;
+	ctx.shard = (shard >= 0) ? shard % g_num_shards : io_current_shard();
+	ctx.generation++;
+	ctx.key = key;
+	ctx.multishot = false;
+	ctx.recv_over = nullptr;
+	ctx.pending.clear();
+	ctx.pending_head = 0;
+	ctx.throttled = false;
+	ctx.closed = false;
+	ctx.error = false;
+}
+
+/**
+ * @brief accept 요청
+ *
+ * listen 소켓에 multishot accept 를 한 번만 걸고, 완료마다 OVER_EXP 복사본을 만들어 돌려줍니다.
+ * 워커가 복사본으로 다시 IO_Accept 를 호출하면 복사본은 해제되고,
+ * multishot 이 끝난 경우에만 처음 넘겨받은 OVER_EXP 로 다시 겁니다.
+ */
+inline void IO_Accept(SOCKET listen_socket, OVER_EXP* over)
+{
+	URING_SOCKET& ctx = g_uring_sockets[listen_socket];
+	lock_guard<mutex> ll{ ctx.lock };
+	if (ctx.accept_over == nullptr) ctx.accept_over = over;
+	if (over != ctx.accept_over) delete over;
+	if (ctx.multishot) return;
+
+	ctx.accept_over->_comp_type = OP_ACCEPT;
+	ctx.accept_over->_listen_socket = listen_socket;
+	ctx.multishot = true;
+	URING_SHARD& sh = g_uring_shards[ctx.shard];
+	lock_guard<mutex> sl{ sh.sq_lock };
+	io_uring_sqe* sqe = uring_get_sqe(sh);
+	io_uring_prep_multishot_accept(sqe, listen_socket, nullptr, nullptr, SOCK_CLOEXEC);
+	io_uring_sqe_set_data64(sqe, URING_TAG_ACCEPT | static_cast<uint64_t>(listen_socket));
+	uring_submit_if_needed(ctx.shard);
+}
+
+inline size_t uring_pending_size(const URING_SOCKET& ctx) { return ctx.pending.size() - ctx.pending_head; }
+
+// 모아둔 수신 데이터를 세션 버퍼로 옮기고 완료시킨다. (ctx.lock 을 잡은 상태에서 호출)
+inline void uring_deliver_recv(URING_SOCKET& ctx)
+{
+	if (ctx.recv_over == nullptr) return;
+	OVER_EXP* over = ctx.recv_over;
+	if (uring_pending_size(ctx) > 0) {
+		DWORD len = min(static_cast<DWORD>(uring_pending_size(ctx)), static_cast<DWORD>(over->_wsabuf.len));
+		memcpy(over->_wsabuf.buf, ctx.pending.data() + ctx.pending_head, len);
+		ctx.pending_head += len;
+		if (ctx.pending_head == ctx.pending.size()) {
+			ctx.pending.clear();
+			ctx.pending_head = 0;
+		}
+		ctx.recv_over = nullptr;
+		uring_complete(len, ctx.key, over, true, ctx.shard);
+	}
+	else if (ctx.closed) {
+		ctx.recv_over = nullptr;
+		uring_complete(0, ctx.key, over, false == ctx.error, ctx.shard);
+	}
+}
+
+/**
+ * @brief 받은 데이터를 세션에 넘긴다. (ctx.lock 을 잡은 상태에서 호출)
+ *
+ * 세션이 걸어둔 버퍼가 있고 앞서 모아둔 데이터가 없으면 제공 버퍼에서 세션 수신 링으로 바로 복사합니다.
+ * 들어가지 않은 나머지와 세션이 버퍼를 걸지 않은 동안 온 데이터만 pending 에 모읍니다.
+ */
+inline void uring_store_recv(URING_SOCKET& ctx, const char* data, DWORD len)
+{
+	if (ctx.recv_over != nullptr && uring_pending_size(ctx) == 0) {
+		OVER_EXP* over = ctx.recv_over;
+		DWORD copied = min(len, static_cast<DWORD>(over->_wsabuf.len));
+		memcpy(over->_wsabuf.buf, data, copied);
+		ctx.recv_over = nullptr;
+		uring_complete(copied, ctx.key, over, true, ctx.shard);
+		data += copied;
+		len -= copied;
+	}
+	if (len > 0) ctx.pending.insert(ctx.pending.end(), data, data + len);
+}
+
+inline uint64_t uring_recv_data(SOCKET s, const URING_SOCKET& ctx)
+{
+	return URING_TAG_RECV | (static_cast<uint64_t>(ctx.generation & 0x7FFFFFFF) << 32) | static_cast<uint64_t>(s);
+}
+
+// multishot recv 를 건다. (ctx.lock 을 잡은 상태에서 호출)
+inline void uring_arm_recv(SOCKET s, URING_SOCKET& ctx)
+{
+	ctx.multishot = true;
+	URING_SHARD& sh = g_uring_shards[ctx.shard];
+	lock_guard<mutex> sl{ sh.sq_lock };
+	io_uring_sqe* sqe = uring_get_sqe(sh);
+	io_uring_prep_recv_multishot(sqe, s, nullptr, 0, 0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = URING_RECV_GROUP;
+	io_uring_sqe_set_data64(sqe, uring_recv_data(s, ctx));
+	uring_submit_if_needed(ctx.shard);
+}
+
+// 받을 수 있는 상태면 recv 를 다시 걸고, pending 이 가득 찼으면 걸려 있는 multishot recv 를 취소한다. (ctx.lock 을 잡은 상태에서 호출)
+inline void uring_update_recv(SOCKET s, URING_SOCKET& ctx)
+{
+	if (ctx.closed) return;
+	const bool full = uring_pending_size(ctx) >= URING_PENDING_LIMIT;
+	if (false == full) ctx.throttled = false;
+	if (false == ctx.multishot) {
+		if (false == full) uring_arm_recv(s, ctx);
+		return;
+	}
+	if (false == full || ctx.throttled) return;
+	// 취소가 처리되기 전에 이미 받은 완료는 pending 에 더 쌓일 수 있다. (몇 개의 제공 버퍼 크기까지)
+	ctx.throttled = true;
+	URING_SHARD& sh = g_uring_shards[ctx.shard];
+	lock_guard<mutex> sl{ sh.sq_lock };
+	io_uring_sqe* sqe = uring_get_sqe(sh);
+	io_uring_prep_cancel64(sqe, uring_recv_data(s, ctx), 0);
+	io_uring_sqe_set_data64(sqe, URING_TAG_CANCEL);
+	uring_submit_if_needed(ctx.shard);
+}
+
+inline void IO_Recv(SOCKET s, OVER_EXP* over)
+{
+	if (s < 0 || s >= MAX_SOCKET_FD) return;
+	URING_SOCKET& ctx = g_uring_sockets[s];
+	lock_guard<mutex> ll{ ctx.lock };
+	if (false == ctx.registered) return;
+	ctx.recv_over = over;
+	uring_deliver_recv(ctx);
+	uring_update_recv(s, ctx);
+}
+
+// _send_offset 이후의 데이터를 보내는 send 를 건다. (sh.sq_lock 을 잡은 상태에서 호출)
+inline void uring_prep_send(URING_SHARD& sh, OVER_EXP* over)
+{
+	io_uring_sqe* sqe = uring_get_sqe(sh);
+	WSABUF* bufs = over->send_bufs();
+	if (g_buffer_slab.registered && over->send_buf_count() == 1 && uring_in_slab(bufs[0].buf)) {
+		io_uring_prep_write_fixed(sqe, over->_send_socket, bufs[0].buf + over->_send_offset,
+			bufs[0].len - over->_send_offset, static_cast<uint64_t>(-1), 0);
+	}
+	else {
+		memset(&over->_msg, 0, sizeof(over->_msg));
+		over->_msg.msg_iov = over->_iov;
+		over->_msg.msg_iovlen = linux_build_iov(over, over->_send_offset, over->_iov);
+		io_uring_prep_sendmsg(sqe, over->_send_socket, &over->_msg, MSG_NOSIGNAL);
+	}
+	io_uring_sqe_set_data64(sqe, reinterpret_cast<uint64_t>(over));
+}
+
+// 완료는 항상 소켓이 속한 링의 CQE 로 전달된다.
+inline IO_SEND_RESULT IO_Send(SOCKET s, OVER_EXP* over)
+{
+	if (s < 0 || s >= MAX_SOCKET_FD) return IO_SEND_FAILED;
+	over->_send_socket = s;
+	int shard = 0;
+	{
+		// key 와 shard 는 IO_Register 가 ctx.lock 을 잡고 바꾼다.
+		lock_guard<mutex> ll{ g_uring_sockets[s].lock };
+		over->_key = g_uring_sockets[s].key;
+		shard = g_uring_sockets[s].shard;
+	}
+	over->_send_offset = 0;
+	URING_SHARD& sh = g_uring_shards[shard];
+	lock_guard<mutex> sl{ sh.sq_lock };
+	uring_prep_send(sh, over);
+	uring_submit_if_needed(shard);
+	return IO_SEND_PENDING;
+}
+
+// 이 워커의 링(sh)에서 꺼낸 CQE 하나를 처리하여 완료가 생기면 t_ready 에 넣는다.
+inline void uring_process_cqe(URING_SHARD& sh, io_uring_cqe* cqe)
+{
+	uint64_t data = io_uring_cqe_get_data64(cqe);
+	int res = cqe->res;
+	bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+	if (data == URING_TAG_POST) {
+		IO_COMPLETION c;
+		if (sh.post_queue.try_pop(c)) t_ready.push_back(c);
+		return;
+	}
+	// 취소 요청 자체의 완료 - 취소된 recv 는 -ECANCELED 로 따로 온다.
+	if (data == URING_TAG_CANCEL) return;
+
+	if (data & URING_TAG_RECV) {
+		SOCKET s = static_cast<SOCKET>(data & 0xFFFFFFFF);
+		uint32_t generation = static_cast<uint32_t>((data >> 32) & 0x7FFFFFFF);
+		char* buffer = nullptr;
+		unsigned short bid = 0;
+		if (cqe->flags & IORING_CQE_F_BUFFER) {
+			bid = static_cast<unsigned short>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+			buffer = sh.recv_buffers + bid * BUF_SIZE;
+		}
+		URING_SOCKET& ctx = g_uring_sockets[s];
+		{
+			lock_guard<mutex> ll{ ctx.lock };
+			if (ctx.registered && (ctx.generation & 0x7FFFFFFF) == generation) {
+				if (false == more) ctx.multishot = false;
+				if (res > 0 && buffer != nullptr) {
+					uring_store_recv(ctx, buffer, static_cast<DWORD>(res));
+				}
+				else if (res != -ENOBUFS && res != -ECANCELED && res <= 0) {
+					// 0 은 상대가 연결을 끊음, 음수는 오류
+					// (ENOBUFS 는 제공 버퍼가 잠시 모자란 것이고 ECANCELED 는 pending 이 가득 차 취소한 것이므로 다시 건다)
+					ctx.closed = true;
+					ctx.error = (res < 0);
+				}
+				uring_deliver_recv(ctx);
+				uring_update_recv(s, ctx);
+			}
+		}
+		// 데이터는 이미 옮겼으므로 제공 버퍼는 바로 돌려준다.
+		if (buffer != nullptr) {
+			io_uring_buf_ring_add(sh.recv_ring, buffer, BUF_SIZE, bid, io_uring_buf_ring_mask(URING_RECV_BUFFERS), 0);
+			io_uring_buf_ring_advance(sh.recv_ring, 1);
+		}
+		return;
+	}
+
+	if (data & URING_TAG_ACCEPT) {
+		SOCKET listen_socket = static_cast<SOCKET>(data & 0xFFFFFFFF);
+		URING_SOCKET& ctx = g_uring_sockets[listen_socket];
+		lock_guard<mutex> ll{ ctx.lock };
+		if (false == more) ctx.multishot = false;
+		OVER_EXP* over = new OVER_EXP();
+		over->_comp_type = OP_ACCEPT;
+		over->_listen_socket = listen_socket;
+		over->_accept_socket = (res >= 0) ? res : INVALID_SOCKET;
+		t_ready.push_back(IO_COMPLETION{ 0, ctx.key, over, res >= 0 });
+		return;
+	}
+
+	// send 완료
+	OVER_EXP* over = reinterpret_cast<OVER_EXP*>(data);
+	if (res > 0) over->_send_offset += res;
+	bool registered = false;
+	if (res > 0 && over->_send_offset < over->send_length()) {
+		lock_guard<mutex> ll{ g_uring_sockets[over->_send_socket].lock };
+		registered = g_uring_sockets[over->_send_socket].registered;
+	}
+	if (registered) {
+		// 일부만 보낸 경우 나머지를 이어서 보낸다.
+		lock_guard<mutex> sl{ sh.sq_lock };
+		uring_prep_send(sh, over);
+		return;
+	}
+	t_ready.push_back(IO_COMPLETION{ (res > 0) ? over->_send_offset : 0, over->_key, over, res > 0 });
+}
+
+inline bool IO_GetCompletion(DWORD* num_bytes, ULONG_PTR* key, OVER_EXP** over)
+{
+	t_io_worker = true;
+	URING_SHARD& sh = g_uring_shards[io_current_shard()];
+	while (1) {
+		if (false == t_ready.empty()) {
+			IO_COMPLETION c = t_ready.front();
+			t_ready.pop_front();
+			*num_bytes = c.num_bytes;
+			*key = c.key;
+			*over = c.over;
+			return c.success;
+		}
+
+		// 이 워커가 쌓아둔 요청을 한 번에 제출
+		{
+			lock_guard<mutex> sl{ sh.sq_lock };
+			if (io_uring_sq_ready(&sh.ring) > 0) {
+				STAT_ADD(io_syscalls, 1);
+				io_uring_submit(&sh.ring);
+			}
+		}
+
+		// 완료 큐는 이 워커만 읽으므로 잠그지 않고 기다린다.
+		io_uring_cqe* cqes[32];
+		unsigned count = io_uring_peek_batch_cqe(&sh.ring, cqes, 32);
+		if (count == 0) {
+			io_uring_cqe* cqe = nullptr;
+			STAT_ADD(io_syscalls, 1);
+			if (io_uring_wait_cqe(&sh.ring, &cqe) < 0) continue;
+			count = io_uring_peek_batch_cqe(&sh.ring, cqes, 32);
+		}
+		for (unsigned i = 0; i < count; ++i)
+			uring_process_cqe(sh, cqes[i]);
+		io_uring_cq_advance(&sh.ring, count);
+	}
+}
+
+// 소켓을 닫는다. shutdown 으로 걸려있는 multishot recv 와 send 를 끝낸 뒤 닫는다.
+inline void IO_Close(SOCKET s)
+{
+	if (s < 0) return;
+	if (s < MAX_SOCKET_FD) {
+		URING_SOCKET& ctx = g_uring_sockets[s];
+		lock_guard<mutex> ll{ ctx.lock };
+		ctx.registered = false;
+		ctx.recv_over = nullptr;
+		ctx.pending.clear();
+		ctx.pending_head = 0;
+	}
+	shutdown(s, SHUT_RDWR);
+	close(s);
+}
+
+inline void IO_Finalize()
+{
+	for (SOCKET s : g_listen_sockets) close(s);
+	g_listen_sockets.clear();
+	for (int i = 0; i < g_num_shards; ++i) {
+		io_uring_queue_exit(&g_uring_shards[i].ring);
+		delete[] g_uring_shards[i].recv_buffers;
+	}
+	delete[] g_uring_shards;
+	delete[] g_uring_sockets;
+	// 슬랩은 SendBufferPool 이 가진 버퍼가 아직 사용하므로 해제하지 않는다.
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////
+// listen 소켓과 미리 걸어두는 accept (공통)
+
+/**
+ * @brief listen 소켓을 열고 accept 요청을 미리 걸어둔다.
+ * @param num_listeners 열 listen 소켓 수 - 보통 워커 스레드 수 (Linux 는 i 번 소켓을 i 번 워커에 묶는다)
+ * @return 연 listen 소켓 수 (0 이면 실패)
+ *
+ * - Windows  : listen 소켓 하나에 ACCEPT_POOL_SIZE 개의 AcceptEx 를 건다. 요청마다 자기 OVER_EXP 와 소켓을 가진다.
+ * - epoll    : SO_REUSEPORT 로 num_listeners 개의 listen 소켓을 열고 ACCEPT_POOL_SIZE 개의 요청을 나눠 건다.
+ * - io_uring : SO_REUSEPORT 로 num_listeners 개의 listen 소켓을 열고 소켓마다 multishot accept 를 하나씩 건다.
+ * Linux 의 i 번 listen 소켓은 i 번 워커의 epoll(링)에 등록되므로 그 소켓의 접속은 i 번 워커만 받고,
+ * 받은 접속도 그 워커의 epoll(링)에 속한다.
+ * 완료를 처리한 워커는 OVER_EXP::_listen_socket 에 같은 OVER_EXP 로 다시 IO_Accept 를 호출한다.
+ * SO_REUSEPORT 로 두 번째 소켓을 열지 못하면 열린 소켓만 사용한다.
+ */
+inline int IO_Start_Accept(short port, int num_listeners)
+{
+	if (false == IO_LISTEN_SHARDING || num_listeners < 1) num_listeners = 1;
+	for (int i = 0; i < num_listeners; ++i) {
+		SOCKET s = IO_Listen(port, num_listeners > 1);
+		if (s == INVALID_SOCKET) break;
+		IO_Register(s, LISTEN_KEY, i);
+		g_listen_sockets.push_back(s);
+	}
+	if (g_listen_sockets.empty()) return 0;
+
+	int accepts = IO_MULTISHOT_ACCEPT ? 1 : max(1, ACCEPT_POOL_SIZE / static_cast<int>(g_listen_sockets.size()));
+	for (SOCKET s : g_listen_sockets)
+		for (int i = 0; i < accepts; ++i)
+			IO_Accept(s, new OVER_EXP());
+	return static_cast<int>(g_listen_sockets.size());
+}
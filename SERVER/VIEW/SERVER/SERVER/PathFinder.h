@@ -0,0 +1,406 @@
+#pragma once
+// PathFinder.h
+// 몬스터 길찾기 - 장애물 그리드(ObstacleGrid) 칸 단위 A*
+//  - 칸 번호(x * SIZE_Z + z)로 바로 찾는 평평한 배열에 f/g 값, 부모 방향, 힙 위치를 둔다.
+//    (해시 테이블 조회나 노드마다 shared_ptr 할당이 없다)
+//  - 칸마다 세대 번호를 찍어서 "이번 탐색에서 연 칸" 을 표시하므로 탐색할 때마다 배열을 지우지 않는다.
+//  - 열린 목록은 칸의 힙 위치를 기억하는 이진 힙이라 더 짧은 길을 찾으면 그 자리에서 키를 줄인다.
+//  - 배열은 스레드마다 한 벌씩(Local) 두고 계속 다시 쓴다. 같은 방은 한 번에 한 작업 스레드에서만 돌므로
+//    작업 스레드 수만큼만 메모리를 쓴다.
+//  - 시간 대신 펼친 칸 수(PATH_MAX_EXPANSIONS)로 탐색을 끊으므로 서버가 바빠도 결과가 같다.
+//    예산을 넘기면 목표에 가장 가까이 간 칸까지의 경로를 돌려준다.
+//  - 대각선 이동은 양 옆 칸이 모두 갈 수 있을 때만 허용해서 벽 모서리를 파고들지 않는다.
+//  - Find_Jump 는 같은 배열로 도는 Jump Point Search 다. 이동 비용이 모두 같은 그리드에서는 벽 모서리(강제 이웃)가
+//    나올 때까지 한 방향으로 쭉 뛰어가서 그 사이 칸을 열린 목록에 넣지 않는다. 경로 길이는 A* 와 같다.
+//    (goal_range 가 있으면 범위에 처음 들어가는 칸이 달라서 몇 칸 차이 날 수 있다)
+
+#include "stdafx.h"
+
+constexpr int PATH_MAX_EXPANSIONS = 20000;	// 탐색 한 번에 펼치는 칸 수 상한
+constexpr float PATH_SQRT2 = 1.41421356f;
+
+enum PATH_RESULT { PATH_FOUND, PATH_NO_PATH, PATH_BUDGET };
+enum PATH_ALGORITHM { PATH_ASTAR, PATH_JPS };		// 몬스터 종류마다 고르는 길찾기 방식
+
+struct PATH_CELL {
+	short x = -1;
+	short z = -1;
+	bool operator==(const PATH_CELL& other) const { return x == other.x && z == other.z; }
+	bool operator!=(const PATH_CELL& other) const { return false == (*this == other); }
+};
+
+struct PATH_SEARCH_STATS {
+	PATH_RESULT result = PATH_NO_PATH;
+	int expanded = 0;		// 펼친(닫은) 칸 수
+};
+
+/**
+ * @brief 2차원 장애물 그리드 위의 8방향 A*
+ * @tparam SIZE_X, SIZE_Z 그리드 크기 - grid[x][z] 가 true 면 갈 수 있는 칸
+ */
+template<int SIZE_X, int SIZE_Z>
+class GRID_PATH_FINDER {
+public:
+	using GRID = array<array<bool, SIZE_Z>, SIZE_X>;
+	static constexpr int CELLS = SIZE_X * SIZE_Z;
+
+private:
+	static constexpr int DX[8]{ -1, 1, 0, 0, -1, -1, 1, 1 };
+	static constexpr int DZ[8]{ 0, 0, 1, -1, -1, 1, -1, 1 };
+	static constexpr unsigned char NO_PARENT = 0xFF;
+
+	unique_ptr<float[]> _f;
+	unique_ptr<float[]> _g;
+	unique_ptr<int[]> _heap_pos;			// 열린 칸의 힙 위치, 닫힌 칸은 -1
+	unique_ptr<unsigned char[]> _parent;	// 부모 칸에서 온 방향 (DX/DZ 번호)
+	unique_ptr<uint32_t[]> _open_gen;		// 이번 탐색에서 연 칸이면 _gen (_f, _g, _heap_pos, _parent 가 유효)
+	unique_ptr<uint32_t[]> _blocked_gen;	// 이번 탐색에서 막힌 칸(다른 몬스터 자리)이면 _gen
+	unique_ptr<int[]> _parent_cell;			// Find_Jump 에서 부모 점프 지점의 칸 번호
+	vector<int> _heap;						// 열린 칸 번호
+	uint32_t _gen = 0;
+
+	static int Index(int x, int z) { return x * SIZE_Z + z; }
+	static bool In_Grid(int x, int z) { return x >= 0 && x < SIZE_X && z >= 0 && z < SIZE_Z; }
+
+	// 8방향 이동 비용의 하한 (octile distance)
+	static float Heuristic(int x, int z, PATH_CELL goal)
+	{
+		int dx = abs(x - goal.x), dz = abs(z - goal.z);
+		return static_cast<float>(max(dx, dz) - min(dx, dz)) + PATH_SQRT2 * min(dx, dz);
+	}
+
+	// f 가 같으면 g 가 큰(목표에 가까운) 칸을 먼저 꺼낸다. 트인 곳에서 펼치는 칸 수가 크게 준다.
+	bool Less(int a, int b) const
+	{
+		return _f[a] < _f[b] || (_f[a] == _f[b] && _g[a] > _g[b]);
+	}
+
+	void Sift_Up(int i)
+	{
+		int cell = _heap[i];
+		while (i > 0) {
+			int p = (i - 1) / 2;
+			if (false == Less(cell, _heap[p])) break;
+			_heap[i] = _heap[p];
+			_heap_pos[_heap[i]] = i;
+			i = p;
+		}
+		_heap[i] = cell;
+		_heap_pos[cell] = i;
+	}
+
+	void Sift_Down(int i)
+	{
+		int n = static_cast<int>(_heap.size());
+		int cell = _heap[i];
+		while (true) {
+			int c = 2 * i + 1;
+			if (c >= n) break;
+			if (c + 1 < n && Less(_heap[c + 1], _heap[c])) c++;
+			if (false == Less(_heap[c], cell)) break;
+			_heap[i] = _heap[c];
+			_heap_pos[_heap[i]] = i;
+			i = c;
+		}
+		_heap[i] = cell;
+		_heap_pos[cell] = i;
+	}
+
+	int Pop_Min()
+	{
+		int top = _heap[0];
+		_heap[0] = _heap.back();
+		_heap.pop_back();
+		if (false == _heap.empty()) Sift_Down(0);
+		_heap_pos[top] = -1;
+		return top;
+	}
+
+	void Next_Generation()
+	{
+		if (++_gen == 0) {
+			// 세대 번호가 한 바퀴 돌면 표시를 모두 지운다.
+			fill(_open_gen.get(), _open_gen.get() + CELLS, 0u);
+			fill(_blocked_gen.get(), _blocked_gen.get() + CELLS, 0u);
+			_gen = 1;
+		}
+		_heap.clear();
+	}
+
+	// cell 에서 부모를 따라 시작 칸까지 거슬러 올라가 path 에 시작 칸 다음부터 순서대로 담는다.
+	void Build_Path(int cell, vector<PATH_CELL>& path) const
+	{
+		path.clear();
+		int x = cell / SIZE_Z, z = cell % SIZE_Z;
+		while (_parent[Index(x, z)] != NO_PARENT) {
+			path.push_back(PATH_CELL{ static_cast<short>(x), static_cast<short>(z) });
+			int dir = _parent[Index(x, z)];
+			x -= DX[dir];
+			z -= DZ[dir];
+		}
+		reverse(path.begin(), path.end());
+	}
+
+	// Find_Jump 의 경로 - 점프 지점 사이는 곧은 줄(직선 또는 대각선)이므로 한 칸씩 채워 넣는다.
+	void Build_Jump_Path(int cell, vector<PATH_CELL>& path) const
+	{
+		path.clear();
+		while (_parent_cell[cell] >= 0) {
+			int parent = _parent_cell[cell];
+			int x = cell / SIZE_Z, z = cell % SIZE_Z;
+			int px = parent / SIZE_Z, pz = parent % SIZE_Z;
+			int dx = (px > x) - (px < x), dz = (pz > z) - (pz < z);
+			while (x != px || z != pz) {
+				path.push_back(PATH_CELL{ static_cast<short>(x), static_cast<short>(z) });
+				x += dx;
+				z += dz;
+			}
+			cell = parent;
+		}
+		reverse(path.begin(), path.end());
+	}
+
+	bool Walkable(const GRID& grid, int x, int z) const
+	{
+		return In_Grid(x, z) && grid[x][z] && _blocked_gen[Index(x, z)] != _gen;
+	}
+
+	static bool In_Range(int x, int z, PATH_CELL goal, float range_sq)
+	{
+		int gx = x - goal.x, gz = z - goal.z;
+		return static_cast<float>(gx * gx + gz * gz) <= range_sq;
+	}
+
+	// (x, z) 에서 직선 (dx, dz) 방향으로 뛰어 다음 점프 지점(강제 이웃이 생기는 칸이나 목표 범위의 칸)을 찾는다.
+	int Jump_Straight(const GRID& grid, int x, int z, int dx, int dz, PATH_CELL goal, float range_sq) const
+	{
+		while (true) {
+			x += dx;
+			z += dz;
+			if (false == Walkable(grid, x, z)) return -1;
+			if (In_Range(x, z, goal, range_sq)) return Index(x, z);
+			// 지나온 쪽 옆이 막혔는데 지금 칸 옆이 트였으면 그 옆으로 도는 길은 이 칸을 거쳐야 가장 짧다.
+			if (dx != 0) {
+				if ((Walkable(grid, x, z - 1) && false == Walkable(grid, x - dx, z - 1)) ||
+					(Walkable(grid, x, z + 1) && false == Walkable(grid, x - dx, z + 1))) return Index(x, z);
+			}
+			else {
+				if ((Walkable(grid, x - 1, z) && false == Walkable(grid, x - 1, z - dz)) ||
+					(Walkable(grid, x + 1, z) && false == Walkable(grid, x + 1, z - dz))) return Index(x, z);
+			}
+		}
+	}
+
+	// (x, z) 에서 (dx, dz) 방향으로 뛴다. 대각선이면 한 칸마다 두 직선 방향을 먼저 살펴본다.
+	int Jump(const GRID& grid, int x, int z, int dx, int dz, PATH_CELL goal, float range_sq) const
+	{
+		if (dx == 0 || dz == 0) return Jump_Straight(grid, x, z, dx, dz, goal, range_sq);
+		while (true) {
+			if (false == Walkable(grid, x + dx, z) || false == Walkable(grid, x, z + dz)) return -1;
+			x += dx;
+			z += dz;
+			if (false == Walkable(grid, x, z)) return -1;
+			if (In_Range(x, z, goal, range_sq)) return Index(x, z);
+			if (Jump_Straight(grid, x, z, dx, 0, goal, range_sq) >= 0 || Jump_Straight(grid, x, z, 0, dz, goal, range_sq) >= 0)
+				return Index(x, z);
+		}
+	}
+
+public:
+	GRID_PATH_FINDER()
+		: _f(make_unique<float[]>(CELLS)), _g(make_unique<float[]>(CELLS)), _heap_pos(make_unique<int[]>(CELLS)),
+		_parent(make_unique<unsigned char[]>(CELLS)), _open_gen(make_unique<uint32_t[]>(CELLS)),
+		_blocked_gen(make_unique<uint32_t[]>(CELLS)), _parent_cell(make_unique<int[]>(CELLS))
+	{
+		_heap.reserve(4096);
+	}
+
+	/**
+	 * @brief start 에서 goal 까지의 경로를 찾는다.
+	 * @param goal_range goal 에서 이 거리(칸) 안에 들어가면 도착으로 본다
+	 * @param blocked 이번 탐색에서만 막을 칸 (다른 몬스터가 서 있는 칸)
+	 * @param path 시작 칸 다음 칸부터 도착 칸까지 - PATH_BUDGET 이면 목표에 가장 가까이 간 칸까지
+	 */
+	PATH_SEARCH_STATS Find(const GRID& grid, PATH_CELL start, PATH_CELL goal, float goal_range,
+		const vector<PATH_CELL>& blocked, vector<PATH_CELL>& path, int max_expansions = PATH_MAX_EXPANSIONS)
+	{
+		PATH_SEARCH_STATS stats;
+		path.clear();
+		if (false == In_Grid(start.x, start.z) || false == In_Grid(goal.x, goal.z)) return stats;
+
+		Next_Generation();
+		for (const PATH_CELL& b : blocked)
+			if (In_Grid(b.x, b.z)) _blocked_gen[Index(b.x, b.z)] = _gen;
+
+		const float range_sq = goal_range * goal_range;
+		int s = Index(start.x, start.z);
+		_open_gen[s] = _gen;
+		_g[s] = 0.f;
+		_f[s] = Heuristic(start.x, start.z, goal);
+		_parent[s] = NO_PARENT;
+		_heap.push_back(s);
+		_heap_pos[s] = 0;
+
+		int best = s;
+		float best_h = _f[s];
+		while (false == _heap.empty()) {
+			if (stats.expanded >= max_expansions) {
+				stats.result = PATH_BUDGET;
+				Build_Path(best, path);
+				return stats;
+			}
+			int cell = Pop_Min();
+			stats.expanded++;
+			int x = cell / SIZE_Z, z = cell % SIZE_Z;
+			int gx = x - goal.x, gz = z - goal.z;
+			if (static_cast<float>(gx * gx + gz * gz) <= range_sq) {
+				stats.result = PATH_FOUND;
+				Build_Path(cell, path);
+				return stats;
+			}
+			float h = _f[cell] - _g[cell];
+			if (h < best_h) {
+				best_h = h;
+				best = cell;
+			}
+
+			for (int dir = 0; dir < 8; ++dir) {
+				int nx = x + DX[dir], nz = z + DZ[dir];
+				if (false == In_Grid(nx, nz) || false == grid[nx][nz]) continue;
+				int next = Index(nx, nz);
+				if (_blocked_gen[next] == _gen) continue;
+				if (dir >= 4 && (false == grid[x + DX[dir]][z] || false == grid[x][z + DZ[dir]])) continue;
+
+				float g = _g[cell] + ((dir < 4) ? 1.f : PATH_SQRT2);
+				if (_open_gen[next] != _gen) {
+					_open_gen[next] = _gen;
+					_g[next] = g;
+					_f[next] = g + Heuristic(nx, nz, goal);
+					_parent[next] = static_cast<unsigned char>(dir);
+					_heap.push_back(next);
+					Sift_Up(static_cast<int>(_heap.size()) - 1);
+				}
+				else if (_heap_pos[next] >= 0 && g < _g[next]) {
+					_f[next] -= _g[next] - g;
+					_g[next] = g;
+					_parent[next] = static_cast<unsigned char>(dir);
+					Sift_Up(_heap_pos[next]);
+				}
+			}
+		}
+		stats.result = PATH_NO_PATH;
+		return stats;
+	}
+
+	/**
+	 * @brief Find 와 같은 조건으로 Jump Point Search 를 돌린다.
+	 *
+	 * 열린 목록에는 점프 지점만 들어가므로 max_expansions 와 반환하는 expanded 는 꺼낸 점프 지점 수입니다.
+	 * path 는 Find 와 같이 한 칸씩 이어진 경로입니다.
+	 */
+	PATH_SEARCH_STATS Find_Jump(const GRID& grid, PATH_CELL start, PATH_CELL goal, float goal_range,
+		const vector<PATH_CELL>& blocked, vector<PATH_CELL>& path, int max_expansions = PATH_MAX_EXPANSIONS)
+	{
+		PATH_SEARCH_STATS stats;
+		path.clear();
+		if (false == In_Grid(start.x, start.z) || false == In_Grid(goal.x, goal.z)) return stats;
+
+		Next_Generation();
+		for (const PATH_CELL& b : blocked)
+			if (In_Grid(b.x, b.z)) _blocked_gen[Index(b.x, b.z)] = _gen;
+
+		const float range_sq = goal_range * goal_range;
+		int s = Index(start.x, start.z);
+		_open_gen[s] = _gen;
+		_g[s] = 0.f;
+		_f[s] = Heuristic(start.x, start.z, goal);
+		_parent_cell[s] = -1;
+		_heap.push_back(s);
+		_heap_pos[s] = 0;
+
+		int best = s;
+		float best_h = _f[s];
+		while (false == _heap.empty()) {
+			if (stats.expanded >= max_expansions) {
+				stats.result = PATH_BUDGET;
+				Build_Jump_Path(best, path);
+				return stats;
+			}
+			int cell = Pop_Min();
+			stats.expanded++;
+			int x = cell / SIZE_Z, z = cell % SIZE_Z;
+			if (In_Range(x, z, goal, range_sq)) {
+				stats.result = PATH_FOUND;
+				Build_Jump_Path(cell, path);
+				return stats;
+			}
+			float h = _f[cell] - _g[cell];
+			if (h < best_h) {
+				best_h = h;
+				best = cell;
+			}
+
+			// 부모에서 온 방향으로 뛸 방향을 줄인다. (시작 칸은 8방향 모두)
+			int dirs[8][2];
+			int count = 0;
+			if (_parent_cell[cell] < 0) {
+				for (int dir = 0; dir < 8; ++dir) {
+					dirs[count][0] = DX[dir];
+					dirs[count++][1] = DZ[dir];
+				}
+			}
+			else {
+				int px = _parent_cell[cell] / SIZE_Z, pz = _parent_cell[cell] % SIZE_Z;
+				int dx = (x > px) - (x < px), dz = (z > pz) - (z < pz);
+				if (dx != 0 && dz != 0) {
+					int candidates[3][2] = { { dx, 0 }, { 0, dz }, { dx, dz } };
+					for (auto& c : candidates) {
+						dirs[count][0] = c[0];
+						dirs[count++][1] = c[1];
+					}
+				}
+				else {
+					// 직선으로 왔으면 앞, 양옆, 앞쪽 대각선 (양옆이 막혔으면 Jump 에서 바로 끝난다)
+					int sx = (dx == 0) ? 1 : 0, sz = (dz == 0) ? 1 : 0;
+					int candidates[5][2] = { { dx, dz }, { sx, sz }, { -sx, -sz }, { dx + sx, dz + sz }, { dx - sx, dz - sz } };
+					for (auto& c : candidates) {
+						dirs[count][0] = c[0];
+						dirs[count++][1] = c[1];
+					}
+				}
+			}
+
+			for (int i = 0; i < count; ++i) {
+				int next = Jump(grid, x, z, dirs[i][0], dirs[i][1], goal, range_sq);
+				if (next < 0) continue;
+				int nx = next / SIZE_Z, nz = next % SIZE_Z;
+				int ax = abs(nx - x), az = abs(nz - z);
+				float g = _g[cell] + static_cast<float>(max(ax, az) - min(ax, az)) + PATH_SQRT2 * min(ax, az);
+				if (_open_gen[next] != _gen) {
+					_open_gen[next] = _gen;
+					_g[next] = g;
+					_f[next] = g + Heuristic(nx, nz, goal);
+					_parent_cell[next] = cell;
+					_heap.push_back(next);
+					Sift_Up(static_cast<int>(_heap.size()) - 1);
+				}
+				else if (_heap_pos[next] >= 0 && g < _g[next]) {
+					_f[next] -= _g[next] - g;
+					_g[next] = g;
+					_parent_cell[next] = cell;
+					Sift_Up(_heap_pos[next]);
+				}
+			}
+		}
+		stats.result = PATH_NO_PATH;
+		return stats;
+	}
+
+	// 스레드마다 한 벌씩 두는 탐색기 (처음 부를 때 만든다)
+	static GRID_PATH_FINDER& Local()
+	{
+		static thread_local unique_ptr<GRID_PATH_FINDER> finder;
+		if (finder == nullptr) finder = make_unique<GRID_PATH_FINDER>();
+		return *finder;
+	}
+};
@@ -0,0 +1,128 @@
+#pragma once
+// Platform.h
+// Linux 에서 서버를 빌드할 때 Windows 전용 타입/함수와 PPL(concurrency) 컨테이너를 대신한다.
+// stdafx.h 에서 _WIN32 가 아닐 때만 포함된다.
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <mutex>
+#include <deque>
+#include <queue>
+#include <vector>
+
+typedef unsigned char		BYTE;
+typedef unsigned int		UINT;
+typedef uint32_t			DWORD;
+typedef unsigned long		ULONG;
+typedef uintptr_t			ULONG_PTR;
+typedef int					BOOL;
+typedef int					SOCKET;
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+constexpr SOCKET INVALID_SOCKET = -1;
+constexpr int SOCKET_ERROR = -1;
+
+// IOCP 의 WSABUF/WSAOVERLAPPED 자리를 채우기 위한 구조체 (epoll/io_uring 백엔드에서는 버퍼 정보만 사용)
+struct WSABUF {
+	ULONG len;
+	char* buf;
+};
+struct WSAOVERLAPPED {
+	uint64_t Internal;
+	uint64_t InternalHigh;
+	uint64_t Offset;
+	void* hEvent;
+};
+
+#define ZeroMemory(dst, len) memset((dst), 0, (len))
+
+inline int fopen_s(FILE** pFile, const char* filename, const char* mode)
+{
+	*pFile = fopen(filename, mode);
+	return (*pFile == nullptr) ? errno : 0;
+}
+
+inline int strcpy_s(char* dst, size_t size, const char* src)
+{
+	size_t len = strlen(src);
+	if (len >= size) len = size - 1;
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+	return 0;
+}
+
+inline int wcscpy_s(char16_t* dst, size_t size, const char16_t* src)
+{
+	size_t i = 0;
+	for (; i + 1 < size && src[i] != u'\0'; ++i) dst[i] = src[i];
+	dst[i] = u'\0';
+	return 0;
+}
+
+// PPL 의 concurrent_queue / concurrent_priority_queue 중 서버가 사용하는 기능만 mutex 로 구현
+namespace concurrency
+{
+	template<class T>
+	class concurrent_queue
+	{
+		mutable std::mutex q_lock;
+		std::deque<T> q;
+	public:
+		void push(const T& value)
+		{
+			std::lock_guard<std::mutex> ll{ q_lock };
+			q.push_back(value);
+		}
+		bool try_pop(T& value)
+		{
+			std::lock_guard<std::mutex> ll{ q_lock };
+			if (q.empty()) return false;
+			value = q.front();
+			q.pop_front();
+			return true;
+		}
+		bool empty() const
+		{
+			std::lock_guard<std::mutex> ll{ q_lock };
+			return q.empty();
+		}
+		size_t unsafe_size() const
+		{
+			std::lock_guard<std::mutex> ll{ q_lock };
+			return q.size();
+		}
+	};
+
+	template<class T, class Compare = std::less<T>>
+	class concurrent_priority_queue
+	{
+		mutable std::mutex q_lock;
+		std::priority_queue<T, std::vector<T>, Compare> q;
+	public:
+		void push(const T& value)
+		{
+			std::lock_guard<std::mutex> ll{ q_lock };
+			q.push(value);
+		}
+		bool try_pop(T& value)
+		{
+			std::lock_guard<std::mutex> ll{ q_lock };
+			if (q.empty()) return false;
+			value = q.top();
+			q.pop();
+			return true;
+		}
+		bool empty() const
+		{
+			std::lock_guard<std::mutex> ll{ q_lock };
+			return q.empty();
+		}
+	};
+}
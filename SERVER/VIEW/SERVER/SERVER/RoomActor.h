@@ -0,0 +1,123 @@
+#pragma once
+// RoomActor.h
+// 방 단위 실행기 (actor) - 방의 게임 상태를 한 번에 한 스레드에서만 다루기 위한 메시지 큐
+//  - 방마다 우편함이 하나 있고, 메시지가 쌓이면 작업 스케줄러(JobSystem.h)가 작업 스레드 하나에서 처리한다.
+//    평소에는 방 번호로 정한 집 작업 스레드에서 돌고, 그 스레드가 밀리면 쉬는 작업 스레드가 훔쳐 간다.
+//  - 방의 게임 상태(세션의 위치/HP/상태, 몬스터, 방 틱)는 한 번에 한 작업 스레드만 건드리므로
+//    몬스터/세션마다 잡던 락이 필요 없다.
+//  - I/O 워커는 받은 패킷과 연결 종료를, 타이머 스레드는 방 틱을, DB 스레드는 처리 결과를
+//    방의 실행기에 메시지(ROOM_JOB)로 넘긴다. 메시지는 도착한 순서대로 처리된다.
+//  - 방의 우편함(mailbox)은 넣을 때와 한꺼번에 꺼낼 때만 잠깐 락을 잡는다.
+// protocol.h (MAX_PACKET_SIZE) 와 MemoryPool.h 를 먼저 include 해야 한다.
+
+#include "MemoryPool.h"
+#include "JobSystem.h"
+
+enum ROOM_JOB_TYPE { RJ_PACKET, RJ_TICK, RJ_DISCONNECT, RJ_DB_RESULT };
+
+/**
+ * @brief 방 실행기에 넘기는 메시지
+ *
+ * RJ_PACKET 은 받은 패킷을, RJ_DB_RESULT 는 DB 처리 결과를 _data 에 복사해서 넘깁니다.
+ * (받은 패킷은 다음 recv 를 걸면 링 버퍼에서 덮어써지므로 복사해야 한다)
+ * 세션에 관한 메시지는 넣을 때 세션의 세대(_generation)를 적어 두고, 처리할 때 세대가 바뀌었으면 버립니다.
+ * (이미 정리된 세션의 두 번째 연결 종료나, 자리가 새 플레이어에게 넘어간 뒤 도착한 옛 연결의 패킷)
+ */
+struct ROOM_JOB {
+	ROOM_JOB_TYPE _type;
+	int _room;
+	int _id;				// 관련된 세션 id (RJ_TICK 은 -1)
+	unsigned _generation;	// 넣을 때 세션의 세대 (Post_Room_Job 이 적는다)
+	unsigned short _size;	// _data 에 담긴 바이트 수
+	alignas(8) char _data[MAX_PACKET_SIZE];
+
+	template<class T>
+	T* Payload()
+	{
+		static_assert(sizeof(T) <= MAX_PACKET_SIZE, "ROOM_JOB payload too large");
+		return reinterpret_cast<T*>(_data);
+	}
+
+	static ROOM_JOB* Create(ROOM_JOB_TYPE type, int room, int id, const void* data = nullptr, unsigned size = 0);
+	void Release();
+};
+inline CObjectPool<ROOM_JOB> RoomJobPool{ 4096 };
+
+inline ROOM_JOB* ROOM_JOB::Create(ROOM_JOB_TYPE type, int room, int id, const void* data, unsigned size)
+{
+	ROOM_JOB* job = RoomJobPool.GetMemory();
+	job->_type = type;
+	job->_room = room;
+	job->_id = id;
+	job->_generation = 0;
+	job->_size = static_cast<unsigned short>(size);
+	if (size > 0) memcpy(job->_data, data, size);
+	return job;
+}
+
+inline void ROOM_JOB::Release()
+{
+	RoomJobPool.ReturnMemory(this);
+}
+
+/**
+ * @brief 방 실행기 - 방 하나의 우편함
+ *
+ * 여러 스레드가 Post 하고, 쌓인 메시지는 작업 스케줄러(JobSystem.h)의 작업 스레드가 Run 에서 한 번에 꺼내 처리합니다.
+ * 우편함이 비어 있다가 처음 메시지가 들어올 때만 스케줄러에 넘기고(_scheduled), 처리하는 동안 들어온 메시지는
+ * Run 이 끝날 때 다시 넘깁니다. 그래서 어느 작업 스레드에서 돌든 한 방의 메시지는 한 번에 한 스레드만 처리합니다.
+ */
+class alignas(64) ROOM_ACTOR : public JOB {
+	mutex _lock;				// _mailbox, _scheduled 보호
+	vector<ROOM_JOB*> _mailbox;
+	bool _scheduled = false;	// 스케줄러에 넘겨져 있거나 실행 중
+	vector<ROOM_JOB*> _batch;	// 실행 중인 작업 스레드만 사용
+	JOB_SCHEDULER* _scheduler = nullptr;
+	void (*_handler)(ROOM_JOB*) = nullptr;
+	int _room = 0;
+public:
+	/**
+	 * @brief 실행할 스케줄러와 메시지 처리 함수를 정한다. Post 하기 전에 한 번 부른다.
+	 * @param room 방 번호 - 스케줄러의 집 작업 스레드를 정한다
+	 */
+	void Bind(JOB_SCHEDULER* scheduler, int room, void (*handler)(ROOM_JOB*))
+	{
+		_scheduler = scheduler;
+		_room = room;
+		_handler = handler;
+	}
+
+	void Post(ROOM_JOB* job)
+	{
+		bool schedule = false;
+		{
+			lock_guard<mutex> ll{ _lock };
+			_mailbox.push_back(job);
+			schedule = (false == _scheduled);
+			_scheduled = true;
+		}
+		if (schedule) _scheduler->Submit(this, _room);
+	}
+
+	void Run() override
+	{
+		{
+			lock_guard<mutex> ll{ _lock };
+			_batch.swap(_mailbox);
+		}
+		for (ROOM_JOB* job : _batch) {
+			_handler(job);
+			job->Release();
+		}
+		_batch.clear();
+		{
+			lock_guard<mutex> ll{ _lock };
+			if (_mailbox.empty()) {
+				_scheduled = false;
+				return;
+			}
+		}
+		// 처리하는 동안 들어온 메시지는 다음 차례에 처리한다. (다른 방이 굶지 않게 스케줄러 뒤로 보낸다)
+		_scheduler->Submit(this, _room);
+	}
+};
@@ -0,0 +1,142 @@
+#pragma once
+// RoomArena.h
+// 방을 처음 쓸 때 만드는 방 단위 메모리
+//  - ROOM_MONSTER_SET : 방 하나의 몬스터를 한 덩어리 메모리에 몬스터 번호 순서로 이어서 만든다. (종류마다 따로 new 하지 않는다)
+//    방이 처음 패킷을 받을 때 ROOM_MONSTER_POOL 에서 꺼내고, disconnect 가 방을 비우면 빈 묶음 스택(TaggedStack)에 돌려준다.
+//    몬스터 번호마다 종류가 정해져 있으므로(StagesInfo) 돌려받은 묶음은 객체를 다시 만들지 않고 Initialize 만 해서 다른 방에 준다.
+//  - LAZY_ROOMS : [방][자리] 로 접근하는 세션 배열, 방 틱, 흐름장, 방 실행기를 방마다 처음 접근할 때 만든다.
+//    기본값이 0 이 아닌 방 단위 상태를 array<..., MAX_ROOM> 으로 두면 시작할 때 모든 방의 페이지를 건드리게 된다.
+//    늦게 도착한 I/O 완료가 옛 c_id 로 세션을 찾을 수 있으므로 만든 방은 그 방 번호에 계속 둔다.
+//    SLOT_ALLOCATOR 가 비운 방을 먼저 다시 꺼내므로 만들어지는 방 수는 동시에 쓰인 방 수의 최대값이다.
+//  - 두 가지 모두 메모리가 MAX_ROOM 이 아니라 실제로 쓰인 방 수만큼 늘어난다.
+
+#include "MemoryPool.h"
+#include "Monster.h"
+
+/**
+ * @brief 방 하나의 몬스터 묶음 (한 번의 할당)
+ * @tparam COUNT 방의 몬스터 수
+ */
+template<int COUNT>
+class ROOM_MONSTER_SET {
+	static constexpr size_t SLOT_ALIGN = max({ alignof(Monster), alignof(SorcererMonster), alignof(BossMonster) });
+	static constexpr size_t SLOT_SIZE = (max({ sizeof(Monster), sizeof(SorcererMonster), sizeof(BossMonster) }) + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+
+	alignas(SLOT_ALIGN) std::byte _storage[COUNT][SLOT_SIZE];	// 몬스터 번호 순서로 이어진 자리
+	array<Monster*, COUNT> _monsters{};
+
+public:
+	atomic<ROOM_MONSTER_SET*> next{ nullptr };	// 빈 묶음 스택 (TaggedStack)
+
+	// 몬스터 번호마다 infos 의 종류(2 마술사, 3 보스, 나머지 일반)로 객체를 만든다.
+	explicit ROOM_MONSTER_SET(const vector<MonsterInfo>& infos)
+	{
+		for (int i = 0; i < COUNT; ++i) {
+			if (infos[i].type == 2) _monsters[i] = new (_storage[i]) SorcererMonster();
+			else if (infos[i].type == 3) _monsters[i] = new (_storage[i]) BossMonster();
+			else _monsters[i] = new (_storage[i]) Monster();
+		}
+	}
+	~ROOM_MONSTER_SET()
+	{
+		for (auto monster : _monsters) monster->~Monster();
+	}
+	ROOM_MONSTER_SET(const ROOM_MONSTER_SET&) = delete;
+	ROOM_MONSTER_SET& operator=(const ROOM_MONSTER_SET&) = delete;
+
+	Monster* operator[](int i) const { return _monsters[i]; }
+};
+
+/**
+ * @brief 몬스터 묶음 풀 - 빈 묶음을 lock-free 스택에 모아 두고 다시 쓴다.
+ *
+ * 묶음은 풀이 없어질 때까지 지우지 않습니다. (TaggedStack 의 노드는 지우면 안 됨)
+ * 방의 실행기가 각자 꺼내고 돌려주므로 여러 작업 스레드가 동시에 부릅니다.
+ */
+template<int COUNT>
+class ROOM_MONSTER_POOL {
+public:
+	using SET = ROOM_MONSTER_SET<COUNT>;
+
+private:
+	TaggedStack<SET> _free_sets;
+	atomic<unsigned long long> _retries{ 0 };
+	atomic<int> _created{ 0 };
+	atomic<int> _in_use{ 0 };
+
+public:
+	ROOM_MONSTER_POOL() = default;
+	~ROOM_MONSTER_POOL()
+	{
+		SET* set;
+		while ((set = _free_sets.pop(_retries)) != nullptr) delete set;
+	}
+	ROOM_MONSTER_POOL(const ROOM_MONSTER_POOL&) = delete;
+	ROOM_MONSTER_POOL& operator=(const ROOM_MONSTER_POOL&) = delete;
+
+	// 빈 묶음을 꺼낸다. 없으면 새로 만든다.
+	SET* Acquire(const vector<MonsterInfo>& infos)
+	{
+		_in_use.fetch_add(1);
+		SET* set = _free_sets.pop(_retries);
+		if (set != nullptr) return set;
+		_created.fetch_add(1);
+		return new SET(infos);
+	}
+
+	void Release(SET* set)
+	{
+		_free_sets.push(set, _retries);
+		_in_use.fetch_sub(1);
+	}
+
+	int Created() const { return _created.load(); }
+	int In_Use() const { return _in_use.load(); }
+};
+
+/**
+ * @brief 방마다 처음 접근할 때 만드는 배열 (array<ROOM, ROOMS> 대신)
+ * @tparam ROOM 방 하나의 값 (array<SESSION, MAX_USER_PER_ROOM>)
+ *
+ * 여러 스레드가 같은 방을 처음 동시에 접근하면 CAS 에 이긴 쪽의 것을 쓰고 진 쪽은 지웁니다.
+ * 만든 뒤에는 atomic load 하나로 접근합니다.
+ * init 을 주면 만든 방을 다른 스레드에 보이기 전에 방 번호와 함께 부릅니다. (진 쪽의 것에도 불릴 수 있다)
+ */
+template<class ROOM, int ROOMS>
+class LAZY_ROOMS {
+public:
+	using INIT = void (*)(ROOM& room, int index);
+
+private:
+	array<atomic<ROOM*>, ROOMS> _rooms{};
+	atomic<int> _created{ 0 };
+	INIT _init = nullptr;
+
+public:
+	LAZY_ROOMS() = default;
+	explicit LAZY_ROOMS(INIT init) : _init(init) {}
+	~LAZY_ROOMS()
+	{
+		for (auto& room : _rooms) delete room.load();
+	}
+	LAZY_ROOMS(const LAZY_ROOMS&) = delete;
+	LAZY_ROOMS& operator=(const LAZY_ROOMS&) = delete;
+
+	ROOM& operator[](size_t i)
+	{
+		ROOM* room = _rooms[i].load(memory_order_acquire);
+		if (room != nullptr) return *room;
+		ROOM* created = new ROOM();
+		if (_init != nullptr) _init(*created, static_cast<int>(i));
+		if (_rooms[i].compare_exchange_strong(room, created, memory_order_acq_rel, memory_order_acquire)) {
+			_created.fetch_add(1);
+			return *created;
+		}
+		delete created;
+		return *room;
+	}
+
+	bool Created(size_t i) const { return _rooms[i].load(memory_order_acquire) != nullptr; }
+	int Created_Count() const { return _created.load(); }
+	static constexpr size_t size() { return ROOMS; }
+};
@@ -1,67 +1,59 @@
 #pragma once
 
-#include <WS2tcpip.h>
-#include <MSWSock.h>
 #include <thread>
 #include <mutex>
 #include <unordered_set>
 #include "protocol.h"
+#include "PacketCodec.h"
+#include "Interest.h"
 #include "Monster.h"
 #include "MemoryPool.h"
+#include "NetworkIO.h"
+#include "RecvRing.h"
 
-#pragma comment(lib, "WS2_32.lib")
-#pragma comment(lib, "MSWSock.lib")
 
+enum S_STATE { ST_FREE, ST_ALLOC, ST_CRASHED, ST_INGAME, ST_DEAD };
 
-enum COMP_TYPE { OP_ACCEPT, OP_RECV, OP_SEND, OP_NPC_UPDATE };
-class OVER_EXP {
-public:
-	WSAOVERLAPPED _over;
-	WSABUF _wsabuf;
-	char _send_buf[BUF_SIZE];
-	COMP_TYPE _comp_type;
-	OVER_EXP()
-	{
-		_wsabuf.len = BUF_SIZE;
-		_wsabuf.buf = _send_buf;
-		_comp_type = OP_RECV;
-		ZeroMemory(&_over, sizeof(_over));
-	}
-	OVER_EXP(char* packet)
-	{
-		_wsabuf.len = packet[0];
-		_wsabuf.buf = _send_buf;
-		ZeroMemory(&_over, sizeof(_over));
-		_comp_type = OP_SEND;
-		memcpy(_send_buf, packet, packet[0]);
-	}
-};
-
+void Post_Disconnect(int c_id);		// main.h
 
-enum S_STATE { ST_FREE, ST_ALLOC, ST_CRASHED, ST_INGAME, ST_DEAD };
+// 세션 소켓의 완료 키 - 세션 id 와 소켓을 등록할 때의 세대를 16비트씩 담는다. (32비트 ULONG_PTR 에도 들어가도록)
+// 닫힌 옛 소켓의 완료(취소된 recv, 실패한 send)가 같은 자리를 받은 새 연결을 끊지 않도록 워커가 세대를 비교한다.
+inline ULONG_PTR Make_Session_Key(int c_id, unsigned generation)
+{
+	return (static_cast<ULONG_PTR>(generation & 0xFFFF) << 16) | static_cast<ULONG_PTR>(c_id & 0xFFFF);
+}
+inline int Session_Key_Id(ULONG_PTR key) { return static_cast<int>(key & 0xFFFF); }
+inline bool Session_Key_Current(ULONG_PTR key, unsigned generation) { return ((key >> 16) & 0xFFFF) == (generation & 0xFFFF); }
 enum WEAPON_TYPE {BLADE, GUN, PUNCH};
 class SESSION {
 	OVER_EXP _recv_over;
+	RECV_RING _recv_ring;	// 받았지만 아직 처리하지 않은 데이터 (워커 하나만 접근 - 세션당 recv 는 하나씩만 건다)
 public:
-	mutex _s_lock;
+	// 아래의 게임 상태는 방의 실행기(RoomActor.h)만 바꾸므로 락 없이 다룬다.
 	atomic<S_STATE> _state;
+	atomic<unsigned> _generation{ 0 };	// 자리를 받을 때와 정리될 때마다 1 늘린다 - 옛 연결의 방 메시지(RoomActor.h)와 I/O 완료(완료 키)를 가려낸다
 	short _id;
-	wchar_t _name[IDPW_SIZE]{};
+	PACKET_WCHAR _name[IDPW_SIZE]{};
 	SOCKET _socket;
 	XMFLOAT3 m_xmf3Position, m_xmf3Look, m_xmf3Up, m_xmf3Right, m_xmf3Velocity; 
 	float HP;
 	atomic<DWORD> direction;
-	unsigned short	_prev_remain;
 	BoundingBox m_xmOOBB;
 	atomic<short> cur_stage;
 	WEAPON_TYPE weapon_type;
 	int recent_updateTime;
 	float clear_percentage;
+
+	mutex _send_lock;					// 송신 큐와 _socket 보호 - send 완료는 I/O 워커에서 처리된다
+	deque<SEND_BUFFER*> _send_queue;	// 아직 보내지 않은 송신 버퍼 (모아서 한 번에 보낸다)
+	OVER_EXP* _send_over = nullptr;		// 전송 중인 send - 소켓당 최대 하나만 걸어둔다
 public:
+	array<PLAYER_BASELINE, MAX_USER_PER_ROOM> _sent_state;	// 방의 플레이어마다 마지막으로 보낸 이 플레이어의 상태 (압축 인코딩의 기준)
+	array<high_resolution_clock::time_point, MAX_USER_PER_ROOM> _last_sent_to{};	// 방의 플레이어마다 이 플레이어의 상태를 마지막으로 보낸 시각
 	SESSION()
 	{
 		_id = -1;
-		_socket = 0;
+		_socket = INVALID_SOCKET;
 		m_xmf3Position = { 0.f,0.f,0.f };
 		m_xmf3Velocity = { 0.f,0.f,0.f };
 		m_xmf3Look = { 0.f,0.f,1.f };
@@ -70,7 +62,6 @@ public:
 		direction = 0;
 		cur_stage = 0;
 		_state = ST_FREE;
-		_prev_remain = 0;
 		m_xmOOBB = BoundingBox(m_xmf3Position, XMFLOAT3(15, 10, 15));
 		weapon_type = BLADE;
 		HP = 0;
@@ -82,10 +73,9 @@ public:
 	void Initialize()
 	{
 		//_id = id;
-		m_xmf3Position = XMFLOAT3{ 300 + 50.f * (_id % 3), -63,600 };// ߰ǥ   ġ Ƿ   //-259,4500
+		m_xmf3Position = XMFLOAT3{ 300 + 50.f * (_id % 3), -63,600 };// 중간발표 데모를 위해 시작위치를 임의로 조정  //-259,4500
 		m_xmf3Velocity = { 0.f,0.f,0.f };
 		direction = 0;
-		_prev_remain = 0;
 		m_xmf3Up = { 0,1,0 };
 		m_xmf3Right = { 1,0,0 };
 		m_xmf3Look = { 0,0,1 };
@@ -93,24 +83,122 @@ public:
 		cur_stage = 0;
 		weapon_type = BLADE;
 		HP =  5000;
-		clear_percentage = 0.f; // ߰ǥ   ġ Ƿ 
+		clear_percentage = 0.f; // 중간발표 데모를 위해 시작위치를 임의로 조정
+		for (auto& base : _sent_state) base.valid = false;	// 새 게임의 첫 상태는 키프레임으로 보낸다
 	}
 	void do_recv()
 	{
-		DWORD recv_flag = 0;
-		memset(&_recv_over._over, 0, sizeof(_recv_over._over));
-		_recv_over._wsabuf.len = BUF_SIZE - _prev_remain;
-		_recv_over._wsabuf.buf = _recv_over._send_buf + _prev_remain;
-		int ret = WSARecv(_socket, &_recv_over._wsabuf, 1, 0, &recv_flag, &_recv_over._over, 0);
-		//if (ret != 0 && WSAGetLastError() != WSA_IO_PENDING) err_display("WSARecv()");
+		unsigned len = 0;
+		_recv_over._wsabuf.buf = _recv_ring.Write_Space(len);
+		_recv_over._wsabuf.len = len;
+		IO_Recv(_socket, &_recv_over);
 	}
 
+	/**
+	 * @brief 패킷을 송신 큐에 넣는다.
+	 *
+	 * 큐의 마지막 버퍼가 이 세션 전용이고 공간이 남았으면 뒤에 이어 붙이고, 아니면 새 버퍼를 받는다.
+	 * 전송 중인 send 가 없으면 바로 보내고, 있으면 완료될 때까지 큐에 모아뒀다가
+	 * send_complete 에서 한 번에 보낸다.
+	 */
 	void do_send(void* packet)
-	{		
-		//OVER_EXP* sdata = OverPool.GetMemory(reinterpret_cast<char*>(packet));
-		OVER_EXP* sdata = new OVER_EXP{ reinterpret_cast<char*>(packet) };
-		int ret = WSASend(_socket, &sdata->_wsabuf, 1, 0, 0, &sdata->_over, 0);
-		//if (ret != 0 && WSAGetLastError() != WSA_IO_PENDING) err_display("WSASend()");
+	{
+		STAT_ADD(packets_sent, 1);
+		lock_guard<mutex> ll{ _send_lock };
+		if (_send_queue.empty() || false == _send_queue.back()->Append(packet))
+			_send_queue.push_back(SEND_BUFFER::Create(packet, false));
+		if (_send_over == nullptr) flush_send();
+	}
+
+	// 다른 세션과 공유하는 송신 버퍼를 큐에 넣는다. (Broadcast_Packet 에서 사용)
+	void do_send(SEND_BUFFER* buf)
+	{
+		STAT_ADD(packets_sent, 1);
+		buf->AddRef();
+		lock_guard<mutex> ll{ _send_lock };
+		_send_queue.push_back(buf);
+		if (_send_over == nullptr) flush_send();
+	}
+
+	// 모아둔 송신 버퍼를 하나의 send 로 보낸다. (_send_lock 을 잡은 상태에서 호출)
+	void flush_send()
+	{
+		// close_socket 뒤에는 보낼 곳이 없으므로 버린다. (disconnect 가 이미 진행 중)
+		if (_socket == INVALID_SOCKET) {
+			for (auto buf : _send_queue) buf->Release();
+			_send_queue.clear();
+			return;
+		}
+		while (false == _send_queue.empty()) {
+			OVER_EXP* sdata = new OVER_EXP();
+			sdata->_comp_type = OP_SEND;
+			while (false == _send_queue.empty() && sdata->_send_count < MAX_SEND_GATHER) {
+				sdata->add_send_buffer(_send_queue.front());
+				_send_queue.pop_front();
+			}
+			_send_over = sdata;
+			IO_SEND_RESULT result = IO_Send(_socket, sdata);
+			if (result == IO_SEND_PENDING) return;
+
+			// 즉시 전송이 끝났거나(Linux epoll) 바로 실패한 경우 완료 통지가 오지 않는다.
+			_send_over = nullptr;
+			delete sdata;
+			if (result == IO_SEND_FAILED) {
+				// 남은 송신 큐는 disconnect 의 reset_send 가 정리한다.
+				Post_Disconnect(_id);
+				return;
+			}
+		}
+	}
+
+	// send 완료 시 워커 스레드에서 호출. 그동안 쌓인 패킷을 이어서 보낸다.
+	void send_complete(OVER_EXP* over)
+	{
+		lock_guard<mutex> ll{ _send_lock };
+		if (_send_over != over) return;		// 이전 연결에서 걸어둔 send
+		_send_over = nullptr;
+		flush_send();
+	}
+
+	/**
+	 * @brief recv 완료로 받은 num_bytes 를 링에 넣고 완성된 패킷을 handler 로 넘긴다.
+	 * @return 길이 필드가 잘못된 패킷을 받았으면 false
+	 */
+	template <class HANDLER>
+	bool recv_complete(DWORD num_bytes, HANDLER&& handler)
+	{
+		_recv_ring.Commit(num_bytes);
+		return Dispatch_Packets(_recv_ring, handler);
+	}
+
+	void reset_recv()
+	{
+		_recv_ring.Clear();
+	}
+
+	// 새 연결의 소켓을 받아 I/O 백엔드에 등록한다. (flush_send 와 close_socket 이 읽고 바꾸므로 _send_lock 을 잡는다)
+	void open_socket(SOCKET s, ULONG_PTR key)
+	{
+		lock_guard<mutex> ll{ _send_lock };
+		_socket = s;
+		IO_Register(s, key);
+	}
+
+	// 소켓을 닫는다. 같은 세션에 대해 disconnect 가 두 번 불려도 한 번만 닫히도록 비워둔다.
+	void close_socket()
+	{
+		lock_guard<mutex> ll{ _send_lock };
+		if (_socket == INVALID_SOCKET) return;
+		IO_Close(_socket);
+		_socket = INVALID_SOCKET;
+	}
+
+	void reset_send()
+	{
+		lock_guard<mutex> ll{ _send_lock };
+		for (auto buf : _send_queue) buf->Release();
+		_send_queue.clear();
+		_send_over = nullptr;
 	}
 	void send_game_start_packet()
 	{
@@ -121,43 +209,60 @@ public:
 		p.pos = m_xmf3Position;
 		do_send(&p);
 	}
-	void send_update_packet(SESSION* Player)
+	// 방 전체에 보내는 패킷은 한 번만 만들어 Broadcast_Packet 으로 보내므로 패킷 생성과 전송을 나눠둔다.
+	SC_UPDATE_PLAYER_PACKET make_update_packet()
 	{
 		SC_UPDATE_PLAYER_PACKET p;
-		p.id = Player->_id;
+		p.id = _id;
 		p.size = sizeof(SC_UPDATE_PLAYER_PACKET);
 		p.type = SC_UPDATE_PLAYER;
-		p.Pos = Player->GetPosition();
-		p.direction = Player->direction.load();
-		p.HP = Player->HP;
-		p.vel = Player->GetVelocity();
+		p.Pos = GetPosition();
+		p.direction = direction.load();
+		p.HP = HP;
+		p.vel = GetVelocity();
 #ifdef _STRESS_TEST
-		p.move_time = Player->recent_updateTime;
+		p.move_time = recent_updateTime;
 #endif
-		do_send(&p);
+		return p;
 	}
-
-	void send_rotate_packet(SESSION* Player)
+	PLAYER_STATE make_player_state()
+	{
+		PLAYER_STATE s;
+		s.HP = HP;
+		s.Pos = GetPosition();
+		s.direction = direction.load();
+		s.vel = GetVelocity();
+		s.move_time = recent_updateTime;
+		return s;
+	}
+	SC_ROTATE_PLAYER_PACKET make_rotate_packet()
 	{
 		SC_ROTATE_PLAYER_PACKET p;
-		p.id = Player->_id;
+		p.id = _id;
 		p.size = sizeof(SC_ROTATE_PLAYER_PACKET);
 		p.type = SC_ROTATE_PLAYER;
-		p.Look = Player->GetLookVector();
-		p.Right = Player->GetRightVector();
-		do_send(&p);
+		p.Look = GetLookVector();
+		p.Right = GetRightVector();
+		return p;
 	}
-	void send_attack_packet(SESSION* Player)
+	SC_ATTACK_PACKET make_attack_packet()
 	{
 		SC_ATTACK_PACKET p;
-		p.id = Player->_id;
+		p.id = _id;
 		p.size = sizeof(SC_ATTACK_PACKET);
 		p.type = SC_ATTACK;
-		//p.damaged_monster_id = damaged_monster_id;
-		do_send(&p);
+		return p;
 	}
-
-	void send_monster_damaged_packet(int player_id, int monster_id, int monster_HP)
+	SC_CHANGEWEAPON_PACKET make_changeweapon_packet()
+	{
+		SC_CHANGEWEAPON_PACKET p;
+		p.id = _id;
+		p.size = sizeof(SC_CHANGEWEAPON_PACKET);
+		p.type = SC_CHANGEWEAPON;
+		p.cur_weaponType = weapon_type;
+		return p;
+	}
+	static SC_MONSTER_DAMAGED_PACKET make_monster_damaged_packet(int player_id, int monster_id, int monster_HP)
 	{
 		SC_MONSTER_DAMAGED_PACKET p;
 		p.size = sizeof(SC_MONSTER_DAMAGED_PACKET);
@@ -165,26 +270,124 @@ public:
 		p.monster_id = monster_id;
 		p.player_id = player_id;
 		p.remain_HP = monster_HP;
-		do_send(&p);
+		return p;
 	}
-
-	void send_interaction_packet(int _stage_id, int _obj_id)
+	static SC_INTERACTION_PACKET make_interaction_packet(int _stage_id, int _obj_id)
 	{
 		SC_INTERACTION_PACKET p;
 		p.stage_id = _stage_id;
 		p.obj_id = _obj_id;
 		p.size = sizeof(SC_INTERACTION_PACKET);
 		p.type = SC_INTERACTION;
+		return p;
+	}
+	static SC_SUMMON_MONSTER_PACKET make_summon_monster_packet(Monster* M)
+	{
+		SC_SUMMON_MONSTER_PACKET summon_packet;
+		summon_packet.id = M->m_id;
+		summon_packet.size = sizeof(summon_packet);
+		summon_packet.type = SC_SUMMON_MONSTER;
+		summon_packet.Pos = M->GetPosition();
+#ifdef _STRESS_TEST
+		summon_packet.room_num = M->room_num;
+#endif
+		summon_packet.monster_type = M->getType();
+		return summon_packet;
+	}
+	// 몬스터의 target_id 는 방 안의 자리 번호이므로, 클라이언트가 비교하는 전역 id(c_id)로 바꿔 보낸다.
+	static short make_target_id(Monster* M)
+	{
+		if (M->target_id < 0) return -1;
+		return static_cast<short>(M->room_num * MAX_USER_PER_ROOM + M->target_id);
+	}
+	static SC_MOVE_MONSTER_PACKET make_monster_update_packet(Monster* M)
+	{
+		SC_MOVE_MONSTER_PACKET p;
+		p.id = M->m_id;
+		p.size = sizeof(SC_MOVE_MONSTER_PACKET);
+		p.type = SC_MOVE_MONSTER;
+		p.target_id = make_target_id(M);
+		p.Pos = M->GetPosition();
+		p.HP = M->HP;
+		p.is_alive = M->alive;
+		p.animation_track = (short)M->GetState();
+		p.BulletPos = M->MagicPos;
+
+#ifdef _STRESS_TEST
+		p.room_num = M->room_num;
+#endif
+		return p;
+	}
+	static MONSTER_SNAPSHOT make_monster_snapshot(Monster* M)
+	{
+		MONSTER_SNAPSHOT s;
+		s.id = M->m_id;
+		s.target_id = make_target_id(M);
+		s.Pos = M->GetPosition();
+		s.HP = M->HP;
+		s.is_alive = M->alive;
+		s.BulletPos = M->MagicPos;
+		s.animation_track = (short)M->GetState();
+		return s;
+	}
+	static SC_OPEN_DOOR_PACKET make_open_door_packet(int door_num)
+	{
+		SC_OPEN_DOOR_PACKET packet;
+		packet.size = sizeof(SC_OPEN_DOOR_PACKET);
+		packet.type = SC_OPEN_DOOR;
+		packet.door_num = door_num;
+		return packet;
+	}
+	static SC_REMOVE_PLAYER_PACKET make_remove_player_packet(int c_id)
+	{
+		SC_REMOVE_PLAYER_PACKET p;
+		p.id = c_id;
+		p.size = sizeof(SC_REMOVE_PLAYER_PACKET);
+		p.type = SC_REMOVE_PLAYER;
+		return p;
+	}
+
+	// 이 플레이어에게 pos 에 있는 stage 소속 대상의 상태를 얼마나 자주 보낼지 (Interest.h)
+	INTEREST_LEVEL Interest_Of(const XMFLOAT3& pos, short stage)
+	{
+		return Get_Interest(GetPosition(), cur_stage.load(), pos, stage);
+	}
+
+	void send_update_packet(SESSION* Player)
+	{
+		// 관심 영역 밖의 다른 플레이어는 보내지 않는다. (죽은 상태는 항상 보낸다)
+		if (Player != this && Player->HP > 0 && Interest_Of(Player->GetPosition(), Player->cur_stage.load()) == INTEREST_NONE)
+			return;
+		SC_UPDATE_PLAYER_PACKET p = Player->make_update_packet();
+		do_send(&p);
+	}
+
+	void send_rotate_packet(SESSION* Player)
+	{
+		SC_ROTATE_PLAYER_PACKET p = Player->make_rotate_packet();
+		do_send(&p);
+	}
+	void send_attack_packet(SESSION* Player)
+	{
+		SC_ATTACK_PACKET p = Player->make_attack_packet();
+		do_send(&p);
+	}
+
+	void send_monster_damaged_packet(int player_id, int monster_id, int monster_HP)
+	{
+		SC_MONSTER_DAMAGED_PACKET p = make_monster_damaged_packet(player_id, monster_id, monster_HP);
+		do_send(&p);
+	}
+
+	void send_interaction_packet(int _stage_id, int _obj_id)
+	{
+		SC_INTERACTION_PACKET p = make_interaction_packet(_stage_id, _obj_id);
 		do_send(&p);
 	}
 
 	void send_changeweapon_packet(SESSION* Player)
 	{
-		SC_CHANGEWEAPON_PACKET p;
-		p.id = Player->_id;
-		p.size = sizeof(SC_CHANGEWEAPON_PACKET);
-		p.type = SC_CHANGEWEAPON;
-		p.cur_weaponType = Player->weapon_type;
+		SC_CHANGEWEAPON_PACKET p = Player->make_changeweapon_packet();
 		do_send(&p);
 	}
 
@@ -205,44 +408,23 @@ public:
 
 	void send_summon_monster_packet(Monster* M)
 	{
-		SC_SUMMON_MONSTER_PACKET summon_packet;
-		summon_packet.id = M->m_id;
-		summon_packet.size = sizeof(summon_packet);
-		summon_packet.type = SC_SUMMON_MONSTER;
-		summon_packet.Pos = M->GetPosition();
-#ifdef _STRESS_TEST
-		summon_packet.room_num = M->room_num;
-#endif
-		summon_packet.monster_type = M->getType();
+		SC_SUMMON_MONSTER_PACKET summon_packet = make_summon_monster_packet(M);
 		do_send(&summon_packet);
 	}
 
 	void send_monster_update_packet(Monster* M)
 	{
-		SC_MOVE_MONSTER_PACKET p;
-		p.id = M->m_id;
-		p.size = sizeof(SC_MOVE_MONSTER_PACKET);
-		p.type = SC_MOVE_MONSTER;
-		p.target_id = M->target_id;
-		p.Pos = M->GetPosition();
-		p.HP = M->HP;
-		p.is_alive = M->alive;
-		p.animation_track = (short)M->GetState();
-		p.BulletPos = M->MagicPos;
-
-#ifdef _STRESS_TEST
-		p.room_num = M->room_num;
-#endif
+		// 관심 영역 밖의 몬스터는 보내지 않는다. (죽은 상태는 항상 보낸다)
+		if (M->alive && Interest_Of(M->GetPosition(), M->m_id / MONSTER_PER_STAGE + 1) == INTEREST_NONE)
+			return;
+		SC_MOVE_MONSTER_PACKET p = make_monster_update_packet(M);
 		do_send(&p);
 	}
 
 
 	void send_open_door_packet(int door_num)
 	{
-		SC_OPEN_DOOR_PACKET packet;
-		packet.size = sizeof(SC_OPEN_DOOR_PACKET);
-		packet.type = SC_OPEN_DOOR;
-		packet.door_num = door_num;
+		SC_OPEN_DOOR_PACKET packet = make_open_door_packet(door_num);
 		do_send(&packet);
 	}
 
@@ -256,10 +438,7 @@ public:
 
 	void send_remove_player_packet(int c_id)
 	{
-		SC_REMOVE_PLAYER_PACKET p;
-		p.id = c_id;
-		p.size = sizeof(SC_REMOVE_PLAYER_PACKET);
-		p.type = SC_REMOVE_PLAYER;
+		SC_REMOVE_PLAYER_PACKET p = make_remove_player_packet(c_id);
 		do_send(&p);
 	}
 	void Rotate(float x, float y, float z)
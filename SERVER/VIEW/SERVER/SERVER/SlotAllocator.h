@@ -0,0 +1,96 @@
+#pragma once
+// SlotAllocator.h
+// 접속한 클라이언트에게 방의 자리(세션 슬롯)를 나눠주는 lock-free 할당기
+//  - 지금 채우는 방(filling room) 하나를 두고, 그 방의 빈 자리를 _state 의 CAS(ST_FREE -> ST_ALLOC)로 차지한다.
+//    접속 순서대로 같은 방에 모이므로 3인 매칭은 예전처럼 먼저 들어온 3명끼리 이루어진다.
+//  - 채우는 방이 다 차면 빈 방 스택(TaggedStack)에서 다음 방을 꺼낸다. 할당은 방 수와 상관없이 O(1) 이다.
+//  - disconnect 가 방을 비우면 Release_Room 으로 빈 방 스택에 돌려준다.
+//  - 방마다 in_pool 플래그로 "빈 방 스택에 있거나 채우는 중" 인지 표시해서 같은 방이 두 번 들어가지 않게 한다.
+
+#include "MemoryPool.h"
+#include "SESSION.h"
+
+struct ROOM_NODE {
+	atomic<ROOM_NODE*> next{ nullptr };
+	atomic_bool in_pool{ false };		// 빈 방 스택에 있거나 지금 채우는 방
+};
+
+/**
+ * @brief 방 단위로 세션 슬롯을 할당한다.
+ * @tparam SLOTS [방][자리]._state (atomic<S_STATE>) 로 접근할 수 있는 배열
+ */
+template<class SLOTS>
+class SLOT_ALLOCATOR {
+	SLOTS& _slots;
+	array<ROOM_NODE, MAX_ROOM> _rooms;
+	TaggedStack<ROOM_NODE> _free_rooms;
+	atomic<int> _filling{ -1 };
+	atomic<unsigned long long> _retries{ 0 };
+
+	int Index_Of(ROOM_NODE* node) const { return static_cast<int>(node - _rooms.data()); }
+
+	bool Has_Free_Slot(int room) const
+	{
+		for (int j = 0; j < MAX_USER_PER_ROOM; ++j)
+			if (_slots[room][j]._state.load() == ST_FREE) return true;
+		return false;
+	}
+
+	// 다 찬 방을 채우는 방에서 내린다. 그 사이에 비워졌으면 다시 빈 방 스택에 넣는다.
+	void Retire(int room)
+	{
+		_rooms[room].in_pool.store(false);
+		if (Has_Free_Slot(room)) Release_Room(room);
+	}
+
+public:
+	SLOT_ALLOCATOR(SLOTS& slots) : _slots(slots)
+	{
+		// 0번 방부터 꺼내지도록 거꾸로 넣는다.
+		for (int i = MAX_ROOM - 1; i >= 0; --i) {
+			_rooms[i].in_pool.store(true);
+			_free_rooms.push(&_rooms[i], _retries);
+		}
+	}
+
+	/**
+	 * @brief 빈 자리 하나를 차지해서 세션 id 를 돌려준다. 자리의 _state 는 ST_ALLOC 이 된다.
+	 * @return 빈 자리가 없으면 -1
+	 */
+	int Allocate()
+	{
+		while (true) {
+			int room = _filling.load();
+			if (room >= 0) {
+				for (int j = 0; j < MAX_USER_PER_ROOM; ++j) {
+					S_STATE expected = ST_FREE;
+					if (_slots[room][j]._state.compare_exchange_strong(expected, ST_ALLOC))
+						return room * MAX_USER_PER_ROOM + j;
+				}
+			}
+			// 채우는 방이 다 찼으면 빈 방을 꺼내서 바꾼다.
+			ROOM_NODE* node = _free_rooms.pop(_retries);
+			if (node == nullptr) {
+				if (room == _filling.load()) return -1;
+				continue;
+			}
+			if (_filling.compare_exchange_strong(room, Index_Of(node))) {
+				if (room >= 0) Retire(room);
+			}
+			else {
+				// 다른 스레드가 먼저 바꿨으면 꺼낸 방은 돌려놓는다. (in_pool 은 그대로 true)
+				_free_rooms.push(node, _retries);
+			}
+		}
+	}
+
+	// 방의 모든 자리가 ST_FREE 가 된 뒤에 부른다.
+	void Release_Room(int room)
+	{
+		bool expected = false;
+		if (_rooms[room].in_pool.compare_exchange_strong(expected, true))
+			_free_rooms.push(&_rooms[room], _retries);
+	}
+
+	unsigned long long Retries() const { return _retries.load(); }
+};
@@ -0,0 +1,83 @@
+#pragma once
+// SpatialHash.h
+// 방 안 몬스터끼리의 충돌 검사용 균일 공간 해시
+//  - 월드를 SPATIAL_HASH_CELL x SPATIAL_HASH_CELL_Y x SPATIAL_HASH_CELL 칸으로 나누고, 칸 좌표를 해시해서 SPATIAL_HASH_BUCKETS 개 버킷 중 하나에 넣는다.
+//  - 버킷은 64비트 마스크 하나다. (방의 몬스터 번호 = 비트 번호) 버킷 크기가 고정이라 할당이 없고 넘칠 일도 없다.
+//  - 몬스터는 중심이 있는 칸에만 넣는다. 질의는 상자를 SPATIAL_HASH_REACH(가장 큰 몬스터의 반폭)만큼 넓혀서
+//    걸치는 칸의 버킷을 OR 하므로, 겹칠 수 있는 몬스터를 빠뜨리지 않는다.
+//  - 다른 칸이 같은 버킷에 들어갈 수 있으므로 결과는 후보다. 실제로 겹치는지는 부르는 쪽이 BoundingBox 로 확인한다.
+//  - 몬스터가 움직이면 Update 로 알려준다. 칸이 바뀔 때만 비트를 옮긴다. (그 방의 실행기만 부른다)
+
+#include "stdafx.h"
+
+constexpr float SPATIAL_HASH_CELL = 64.f;		// 칸의 x, z 변 (보스 폭 60 보다 크게)
+constexpr float SPATIAL_HASH_CELL_Y = 256.f;	// 칸의 높이 - 층(y -63, -304)마다 보통 한 칸에 들어가게 크게 둔다
+constexpr float SPATIAL_HASH_REACH = 30.f;		// 가장 큰 몬스터(보스)의 반폭
+constexpr int SPATIAL_HASH_BUCKETS = 256;		// 2의 거듭제곱
+
+/**
+ * @brief 한 방의 몬스터 공간 해시
+ * @tparam MAX_OBJECTS 방의 몬스터 수 (64 이하)
+ */
+template<int MAX_OBJECTS>
+class SPATIAL_HASH {
+	static_assert(MAX_OBJECTS <= 64, "objects are tracked in a 64-bit mask");
+	static_assert((SPATIAL_HASH_BUCKETS & (SPATIAL_HASH_BUCKETS - 1)) == 0, "bucket count must be a power of two");
+
+	array<uint64_t, SPATIAL_HASH_BUCKETS> _buckets{};
+	array<short, MAX_OBJECTS> _bucket_of{};			// 몬스터가 들어 있는 버킷 + 1 (0 이면 없음 - 0 으로 채워진 채 시작하므로 쓰지 않는 방은 메모리를 건드리지 않는다)
+	array<array<int, 3>, MAX_OBJECTS> _cell_of{};	// 몬스터가 들어 있는 칸
+
+	// floorf 는 SSE4.1 없이 빌드하면 함수 호출이 되므로 직접 내림한다. (BitGrid.h 와 같다)
+	static int Floor(float v)
+	{
+		int i = static_cast<int>(v);
+		return i - (v < static_cast<float>(i));
+	}
+	static int Cell(float v) { return Floor(v * (1.f / SPATIAL_HASH_CELL)); }
+	static int Cell_Y(float v) { return Floor(v * (1.f / SPATIAL_HASH_CELL_Y)); }
+
+	static int Bucket(int cx, int cy, int cz)
+	{
+		uint32_t h = static_cast<uint32_t>(cx) * 73856093u ^ static_cast<uint32_t>(cy) * 19349663u ^ static_cast<uint32_t>(cz) * 83492791u;
+		return static_cast<int>(h & (SPATIAL_HASH_BUCKETS - 1));
+	}
+
+public:
+	// id 번 몬스터가 pos 로 옮겼다. (처음이면 넣는다)
+	void Update(int id, const XMFLOAT3& pos)
+	{
+		array<int, 3> cell = { Cell(pos.x), Cell_Y(pos.y), Cell(pos.z) };
+		if (_bucket_of[id] != 0 && cell == _cell_of[id]) return;
+		Remove(id);
+		int bucket = Bucket(cell[0], cell[1], cell[2]);
+		_buckets[bucket] |= 1ull << id;
+		_bucket_of[id] = static_cast<short>(bucket + 1);
+		_cell_of[id] = cell;
+	}
+
+	void Remove(int id)
+	{
+		if (_bucket_of[id] == 0) return;
+		_buckets[_bucket_of[id] - 1] &= ~(1ull << id);
+		_bucket_of[id] = 0;
+	}
+
+	/**
+	 * @brief box 와 겹칠 수 있는 몬스터 후보
+	 * @return 후보 몬스터 번호의 비트 마스크
+	 */
+	uint64_t Query(const BoundingBox& box) const
+	{
+		const float rx = box.Extents.x + SPATIAL_HASH_REACH, ry = box.Extents.y + SPATIAL_HASH_REACH, rz = box.Extents.z + SPATIAL_HASH_REACH;
+		const int x0 = Cell(box.Center.x - rx), x1 = Cell(box.Center.x + rx);
+		const int y0 = Cell_Y(box.Center.y - ry), y1 = Cell_Y(box.Center.y + ry);
+		const int z0 = Cell(box.Center.z - rz), z1 = Cell(box.Center.z + rz);
+		uint64_t candidates = 0;
+		for (int cx = x0; cx <= x1; ++cx)
+			for (int cy = y0; cy <= y1; ++cy)
+				for (int cz = z0; cz <= z1; ++cz)
+					candidates |= _buckets[Bucket(cx, cy, cz)];
+		return candidates;
+	}
+};
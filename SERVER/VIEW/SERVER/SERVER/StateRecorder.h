@@ -0,0 +1,89 @@
+#pragma once
+// StateRecorder.h
+// 방에 보낸 플레이어/몬스터 상태를 파일에 기록한다.
+// _RECORD_STATE 를 정의하면 서버가 보내는 상태를 STATE_RECORD_FILE 에 남기고,
+// Benchmark.h 의 Benchmark_Codec 이 그 기록을 다시 재생해서 인코딩 방식별 대역폭을 비교한다.
+
+#include "stdafx.h"
+#include "protocol.h"
+#include "PacketCodec.h"
+
+// #define _RECORD_STATE
+
+constexpr const char* STATE_RECORD_FILE = "state_record.bin";
+
+enum STATE_RECORD_KIND : unsigned char { SR_PLAYER, SR_MONSTER };
+
+#pragma pack (push, 1)
+struct STATE_RECORD {
+	unsigned time_ms;			// 서버 시작 후 경과 시간
+	STATE_RECORD_KIND kind;
+	short room_num;
+	short id;
+	union {
+		PLAYER_STATE player;
+		MONSTER_SNAPSHOT monster;
+	};
+};
+#pragma pack (pop)
+
+class STATE_RECORDER {
+	mutex _lock;
+	FILE* _file = nullptr;
+	high_resolution_clock::time_point _start = high_resolution_clock::now();
+
+	void Write(STATE_RECORD& r)
+	{
+		r.time_ms = static_cast<unsigned>(duration_cast<milliseconds>(high_resolution_clock::now() - _start).count());
+		lock_guard<mutex> ll{ _lock };
+		if (_file == nullptr) {
+			_file = fopen(STATE_RECORD_FILE, "wb");
+			if (_file == nullptr) return;
+		}
+		fwrite(&r, sizeof(r), 1, _file);
+	}
+
+public:
+	~STATE_RECORDER()
+	{
+		if (_file != nullptr) fclose(_file);
+	}
+	void RecordPlayer(int roomNum, short id, const PLAYER_STATE& s)
+	{
+		STATE_RECORD r;
+		r.kind = SR_PLAYER;
+		r.room_num = static_cast<short>(roomNum);
+		r.id = id;
+		r.player = s;
+		Write(r);
+	}
+	void RecordMonster(int roomNum, const MONSTER_SNAPSHOT& s)
+	{
+		STATE_RECORD r;
+		r.kind = SR_MONSTER;
+		r.room_num = static_cast<short>(roomNum);
+		r.id = s.id;
+		r.monster = s;
+		Write(r);
+	}
+};
+inline STATE_RECORDER g_state_recorder;
+
+#ifdef _RECORD_STATE
+#define RECORD_PLAYER_STATE(roomNum, id, state) g_state_recorder.RecordPlayer((roomNum), (id), (state))
+#define RECORD_MONSTER_STATE(roomNum, state) g_state_recorder.RecordMonster((roomNum), (state))
+#else
+#define RECORD_PLAYER_STATE(roomNum, id, state) ((void)0)
+#define RECORD_MONSTER_STATE(roomNum, state) ((void)0)
+#endif
+
+// 기록 파일을 읽는다. 파일이 없으면 false
+inline bool Load_State_Record(const char* path, vector<STATE_RECORD>& records)
+{
+	FILE* f = fopen(path, "rb");
+	if (f == nullptr) return false;
+	STATE_RECORD r;
+	while (fread(&r, sizeof(r), 1, f) == 1) records.push_back(r);
+	fclose(f);
+	return true;
+}
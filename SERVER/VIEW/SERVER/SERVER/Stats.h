@@ -0,0 +1,141 @@
+#pragma once
+// Stats.h
+// 네트워크 처리량 측정용 카운터
+// _PRINT_STATS 를 정의하면 Stats_Thread 가 1초마다 초당 처리량과 코어당 처리량을 출력한다.
+// 부하는 STRESS_TEST 클라이언트로 걸고, 워커 스레드 수를 바꿔가며 코어당 처리량을 비교한다.
+
+#include "stdafx.h"
+#include "JobSystem.h"
+#ifdef _WIN32
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#endif
+
+// #define _PRINT_STATS
+// #define _BENCHMARK		// Benchmark.h 의 측정을 실행하고 종료
+
+#if defined(_PRINT_STATS) || defined(_BENCHMARK)
+#define _COLLECT_STATS
+#endif
+
+struct SERVER_STATS {
+	atomic<unsigned long long> accept_count{ 0 };
+	atomic<unsigned long long> recv_count{ 0 };
+	atomic<unsigned long long> recv_bytes{ 0 };
+	atomic<unsigned long long> send_count{ 0 };
+	atomic<unsigned long long> send_bytes{ 0 };
+	atomic<unsigned long long> packets_recv{ 0 };	// 처리한 수신 패킷 수
+	atomic<unsigned long long> packets_sent{ 0 };	// do_send 로 큐에 넣은 송신 패킷 수
+	atomic<unsigned long long> io_syscalls{ 0 };	// 송수신/이벤트 대기에 사용된 시스템 콜 수
+	atomic<unsigned long long> busy_ns{ 0 };		// 워커 스레드가 완료 처리에 쓴 시간의 합
+	atomic<unsigned long long> room_ticks{ 0 };		// 처리한 방 틱 수
+	atomic<unsigned long long> room_tick_ns{ 0 };	// 방 틱 처리에 쓴 시간의 합
+	atomic<unsigned long long> interest_skipped{ 0 };	// 관심 영역 밖이라 보내지 않은(미룬) 상태 수
+	atomic<unsigned long long> slot_alloc_ns{ 0 };	// accept 에서 세션 자리를 찾는 데 쓴 시간의 합
+	atomic<unsigned long long> room_jobs{ 0 };		// 방 실행기에 넘긴 메시지 수 (RoomActor.h)
+	atomic<unsigned long long> path_searches{ 0 };	// 몬스터 길찾기 횟수 (PathFinder.h)
+	atomic<unsigned long long> path_expanded{ 0 };	// 길찾기에서 펼친 칸 수의 합
+	atomic<unsigned long long> path_budget_hits{ 0 };	// 펼칠 칸 수 예산을 넘긴 길찾기 수
+	atomic<unsigned long long> path_ns{ 0 };		// 길찾기에 쓴 시간의 합
+	atomic<unsigned long long> path_hierarchical{ 0 };	// 계층 경로 그래프로 찾은 긴 길찾기 수 (HierarchicalPath.h)
+	atomic<unsigned long long> flow_rebuilds{ 0 };	// 흐름장을 다시 계산한 횟수 (FlowField.h)
+	atomic<unsigned long long> flow_ns{ 0 };		// 흐름장 계산과 방향 찾기에 쓴 시간의 합
+	atomic<unsigned long long> flow_steps{ 0 };		// 흐름장을 따라 움직인 몬스터 이동 수
+	atomic<unsigned long long> collide_queries{ 0 };	// 몬스터끼리 겹치는지 확인한 횟수 (SpatialHash.h)
+	atomic<unsigned long long> collide_box_tests{ 0 };	// 그때 BoundingBox 로 확인한 몬스터 수의 합
+	atomic<unsigned long long> monster_updates{ 0 };	// 방 틱에서 업데이트한 몬스터 수 (MonsterStore.h)
+	atomic<unsigned long long> monster_dormant{ 0 };	// 잠든 스테이지라 건너뛴 몬스터 업데이트 수
+	atomic<unsigned long long> room_dormancies{ 0 };	// 깨어 있는 몬스터가 없어 틱을 멈춘(잠든) 방 수
+	atomic<unsigned long long> room_wakes{ 0 };		// 스테이지 이동이나 공격으로 다시 깨운 방 수
+};
+inline SERVER_STATS g_stats;
+
+#ifdef _COLLECT_STATS
+#define STAT_ADD(counter, value) g_stats.counter.fetch_add((value), memory_order_relaxed)
+#else
+#define STAT_ADD(counter, value) ((void)0)
+#endif
+
+// 프로세스가 실제로 차지한 물리 메모리 (RSS, 바이트) - 알 수 없으면 0
+inline size_t Process_Resident_Bytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (FALSE == GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.WorkingSetSize;
+#else
+	std::ifstream statm("/proc/self/statm");
+	size_t pages = 0, resident = 0;
+	if (!(statm >> pages >> resident)) return 0;
+	return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/**
+ * @brief 1초마다 서버 처리량을 출력하는 스레드 함수
+ *
+ * 초당 accept/recv/send 횟수와 MB/s, 그리고 I/O 워커와 작업 스레드가 실제로 일한 시간(busy core)으로 나눈
+ * 코어당 처리량을 출력합니다. 작업 스레드(JobSystem.h)마다 이용률과 실행/훔친 작업 수도 출력합니다.
+ */
+inline void Stats_Thread()
+{
+	unsigned long long prev[28]{};
+	unsigned long long prev_job[MAX_JOB_WORKERS][3]{};
+	while (1)
+	{
+		this_thread::sleep_for(1s);
+		unsigned long long cur[28] = {
+			g_stats.accept_count.load(), g_stats.recv_count.load(), g_stats.recv_bytes.load(),
+			g_stats.send_count.load(), g_stats.send_bytes.load(), g_stats.io_syscalls.load(),
+			g_stats.busy_ns.load(), g_stats.packets_recv.load(), g_stats.packets_sent.load(),
+			g_stats.room_ticks.load(), g_stats.room_tick_ns.load(), g_stats.interest_skipped.load(),
+			g_stats.slot_alloc_ns.load(), g_stats.room_jobs.load(), g_stats.path_searches.load(),
+			g_stats.path_expanded.load(), g_stats.path_budget_hits.load(), g_stats.path_ns.load(),
+			g_stats.flow_rebuilds.load(), g_stats.flow_ns.load(), g_stats.flow_steps.load(), g_stats.path_hierarchical.load(),
+			g_stats.collide_queries.load(), g_stats.collide_box_tests.load(), g_stats.monster_updates.load(),
+			g_stats.monster_dormant.load(), g_stats.room_dormancies.load(), g_stats.room_wakes.load() };
+		unsigned long long d[28];
+		for (int i = 0; i < 28; ++i) {
+			d[i] = cur[i] - prev[i];
+			prev[i] = cur[i];
+		}
+		// 작업 스레드별 이용률
+		string workers_line;
+		unsigned long long job_busy_ns = 0;
+		for (int w = 0; w < g_job_scheduler.Workers(); ++w) {
+			const JOB_WORKER_STATS& ws = g_job_scheduler.Stats(w);
+			unsigned long long job_cur[3] = { ws.busy_ns.load(), ws.jobs.load(), ws.steals.load() };
+			unsigned long long jd[3];
+			for (int i = 0; i < 3; ++i) {
+				jd[i] = job_cur[i] - prev_job[w][i];
+				prev_job[w][i] = job_cur[i];
+			}
+			job_busy_ns += jd[0];
+			char buf[80];
+			snprintf(buf, sizeof(buf), " | w%d %.0f%% %llu jobs %llu steals", w, jd[0] / 1e7, jd[1], jd[2]);
+			workers_line += buf;
+		}
+		double busy_cores = (d[6] + job_busy_ns) / 1e9;
+		double per_core = (busy_cores > 0.0) ? 1.0 / busy_cores : 0.0;
+		printf("[STATS] accept %llu/s (slot %.0fns) | recv %llu/s %.2fMB/s | send %llu/s %.2fMB/s | syscall %llu/s | busy %.2f core\n",
+			d[0], d[0] ? static_cast<double>(d[12]) / d[0] : 0.0, d[1], d[2] / 1048576.0, d[3], d[4] / 1048576.0, d[5], busy_cores);
+		printf("[STATS] per core : accept %.0f/s | recv %.0f/s | send %.0f/s\n",
+			d[0] * per_core, d[1] * per_core, d[3] * per_core);
+		printf("[STATS] packets in %llu/s out %llu/s | %.2f packets/send | %.1f bytes/send | %.3f syscalls/packet\n",
+			d[7], d[8], d[3] ? static_cast<double>(d[8]) / d[3] : 0.0, d[3] ? static_cast<double>(d[4]) / d[3] : 0.0,
+			(d[7] + d[8]) ? static_cast<double>(d[5]) / (d[7] + d[8]) : 0.0);
+		printf("[STATS] room ticks %llu/s | avg tick %.3fms | monster updates %llu/s | interest skipped %llu/s | room jobs %llu/s\n",
+			d[9], d[9] ? d[10] / 1e6 / d[9] : 0.0, d[24], d[11], d[13]);
+		printf("[STATS] dormancy : rooms slept %llu/s | woke %llu/s | monster updates skipped %llu/s\n",
+			d[26], d[27], d[25]);
+		printf("[STATS] path searches %llu/s | %.0f nodes/search | %.1f us/search | budget hit %.2f%% | hierarchical %llu/s\n",
+			d[14], d[14] ? static_cast<double>(d[15]) / d[14] : 0.0, d[14] ? d[17] / 1e3 / d[14] : 0.0,
+			d[14] ? 100.0 * d[16] / d[14] : 0.0, d[21]);
+		printf("[STATS] flow field rebuilds %llu/s | flow steps %llu/s | flow time %.2f ms/s\n",
+			d[18], d[20], d[19] / 1e6);
+		printf("[STATS] monster collision %llu queries/s | %.2f box tests/query\n",
+			d[22], d[22] ? static_cast<double>(d[23]) / d[22] : 0.0);
+		if (false == workers_line.empty())
+			printf("[STATS] job workers %.2f core%s\n", job_busy_ns / 1e9, workers_line.c_str());
+	}
+}
@@ -0,0 +1,156 @@
+#pragma once
+// TimingWheel.h
+// 계층형 타이밍 휠 - 타이머 이벤트의 등록과 만료를 O(1) 로 처리한다.
+//  - 1ms 틱, 단계마다 256칸인 4단계 휠 (256ms / 65초 / 4.6시간 / 49일)
+//  - 위 단계의 칸은 아래 단계가 한 바퀴 돌 때마다 아래 단계로 내려보낸다. (cascade)
+//  - 여러 스레드가 Add 한 이벤트는 입력 버퍼에 모아두고 휠은 타이머 스레드만 다룬다.
+//  - 타이머 스레드는 다음 만료 시각까지 condition_variable 로 잠들고,
+//    그보다 이른 이벤트가 등록될 때만 깨어난다.
+// EVENT 는 wakeup_time(high_resolution_clock::time_point) 멤버를 가져야 한다.
+
+#include "stdafx.h"
+#include <condition_variable>
+#include <bit>
+
+constexpr int WHEEL_LEVELS = 4;
+constexpr int WHEEL_BITS = 8;
+constexpr int WHEEL_SLOTS = 1 << WHEEL_BITS;
+constexpr uint64_t WHEEL_MASK = WHEEL_SLOTS - 1;
+constexpr uint64_t WHEEL_NO_WAKEUP = UINT64_MAX;
+
+template<class EVENT>
+class TimingWheel {
+	struct ENTRY {
+		uint64_t tick;		// 만료 틱
+		EVENT ev;
+	};
+
+	high_resolution_clock::time_point _base;	// 0번 틱의 시각
+	uint64_t _cur_tick = 0;						// 다음에 처리할 틱
+	size_t _count = 0;							// 휠에 들어있는 이벤트 수
+	array<array<vector<ENTRY>, WHEEL_SLOTS>, WHEEL_LEVELS> _slots;
+	array<uint64_t, WHEEL_SLOTS / 64> _level0_bits{};	// 0단계에서 이벤트가 있는 칸
+	vector<ENTRY> _pending;						// 입력 버퍼에서 옮겨온 이벤트 (타이머 스레드 전용)
+
+	mutex _lock;								// _intake, _wakeup_tick 보호
+	condition_variable _cv;
+	vector<ENTRY> _intake;						// 다른 스레드가 등록한 이벤트
+	uint64_t _intake_min = WHEEL_NO_WAKEUP;		// _intake 에서 가장 이른 틱
+	uint64_t _wakeup_tick = 0;					// 타이머 스레드가 깨어나기로 한 틱 (깨어 있으면 0)
+
+public:
+	TimingWheel() : _base(high_resolution_clock::now()) {}
+
+	// 만료 시각을 틱으로 바꾼다. 이른 만료를 막기 위해 올림한다.
+	uint64_t ToTick(high_resolution_clock::time_point tp) const
+	{
+		if (tp <= _base) return 0;
+		return static_cast<uint64_t>(chrono::ceil<milliseconds>(tp - _base).count());
+	}
+
+	void Add(const EVENT& ev)
+	{
+		uint64_t tick = ToTick(ev.wakeup_time);
+		lock_guard<mutex> ll{ _lock };
+		_intake.push_back(ENTRY{ tick, ev });
+		if (tick < _intake_min) _intake_min = tick;
+		if (tick < _wakeup_tick) {
+			// 타이머 스레드가 이 이벤트보다 늦게 깨어날 예정일 때만 깨운다.
+			_wakeup_tick = tick;
+			_cv.notify_one();
+		}
+	}
+
+	/**
+	 * @brief 만료된 이벤트를 expired 에 모아서 돌려줍니다. (타이머 스레드 전용)
+	 *
+	 * 만료된 이벤트가 없으면 다음 만료 시각까지, 또는 더 이른 이벤트가 등록될 때까지 기다립니다.
+	 * 한 번 깨어나면 그 사이에 지난 모든 틱의 이벤트를 한꺼번에 돌려줍니다.
+	 */
+	void WaitExpired(vector<EVENT>& expired)
+	{
+		while (true) {
+			{
+				lock_guard<mutex> ll{ _lock };
+				_pending.swap(_intake);
+				_intake_min = WHEEL_NO_WAKEUP;
+				_wakeup_tick = 0;
+			}
+			for (auto& e : _pending) Insert(e);
+			_pending.clear();
+
+			auto now = high_resolution_clock::now();
+			uint64_t now_tick = (now > _base) ? static_cast<uint64_t>(duration_cast<milliseconds>(now - _base).count()) : 0;
+			while (_cur_tick <= now_tick) {
+				Expire(expired);
+				++_cur_tick;
+			}
+			if (false == expired.empty()) return;
+
+			uint64_t next = NextTick();
+			unique_lock<mutex> ul{ _lock };
+			if (_intake_min < next) continue;
+			_wakeup_tick = next;
+			if (next == WHEEL_NO_WAKEUP)
+				_cv.wait(ul, [&]() { return _wakeup_tick != next; });
+			else
+				_cv.wait_until(ul, _base + milliseconds(next), [&]() { return _wakeup_tick != next; });
+		}
+	}
+
+	size_t size() const { return _count; }
+
+private:
+	void Insert(const ENTRY& e)
+	{
+		uint64_t tick = (e.tick < _cur_tick) ? _cur_tick : e.tick;
+		uint64_t delta = tick - _cur_tick;
+		int level = 0;
+		while (level < WHEEL_LEVELS - 1 && delta >= (1ull << (WHEEL_BITS * (level + 1)))) ++level;
+		// 휠 범위를 넘는 이벤트는 마지막 칸에 두었다가 내려올 때 다시 넣는다.
+		uint64_t limit = _cur_tick + (1ull << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+		uint64_t slot_tick = (tick > limit) ? limit : tick;
+		int idx = static_cast<int>((slot_tick >> (WHEEL_BITS * level)) & WHEEL_MASK);
+		_slots[level][idx].push_back(ENTRY{ tick, e.ev });
+		if (level == 0) _level0_bits[idx / 64] |= 1ull << (idx % 64);
+		++_count;
+	}
+
+	// _cur_tick 의 이벤트를 만료시킨다. 0단계가 한 바퀴 돌았으면 위 단계의 칸을 먼저 내려보낸다.
+	void Expire(vector<EVENT>& expired)
+	{
+		if ((_cur_tick & WHEEL_MASK) == 0) {
+			for (int level = 1; level < WHEEL_LEVELS; ++level) {
+				int idx = static_cast<int>((_cur_tick >> (WHEEL_BITS * level)) & WHEEL_MASK);
+				_pending.swap(_slots[level][idx]);
+				_count -= _pending.size();
+				for (auto& e : _pending) Insert(e);
+				_pending.clear();
+				if (idx != 0) break;
+			}
+		}
+		int idx = static_cast<int>(_cur_tick & WHEEL_MASK);
+		auto& slot = _slots[0][idx];
+		if (slot.empty()) return;
+		for (auto& e : slot) expired.push_back(e.ev);
+		_count -= slot.size();
+		slot.clear();
+		_level0_bits[idx / 64] &= ~(1ull << (idx % 64));
+	}
+
+	// 다음에 깨어날 틱 - 0단계의 남은 칸에서 찾고, 없으면 다음 cascade 시점
+	uint64_t NextTick() const
+	{
+		if (_count == 0) return WHEEL_NO_WAKEUP;
+		int start = static_cast<int>(_cur_tick & WHEEL_MASK);
+		if (start == 0 && _cur_tick != 0) return _cur_tick;	// cascade 가 필요한 틱
+		for (int word = start / 64; word < WHEEL_SLOTS / 64; ++word) {
+			uint64_t bits = _level0_bits[word];
+			if (word == start / 64) bits &= ~0ull << (start % 64);
+			if (bits == 0) continue;
+			int idx = word * 64 + countr_zero(bits);
+			return (_cur_tick & ~WHEEL_MASK) + idx;
+		}
+		return (_cur_tick | WHEEL_MASK) + 1;
+	}
+};
@@ -1,66 +1,97 @@
 ﻿#define _CRT_SECURE_NO_WARNINGS
 #define _CRT_NON_CONFORMING_SWPRINTFS
-#include <WS2tcpip.h>
-#include <MSWSock.h>
 #include <thread>
 #include <mutex>
 #include <unordered_set>
 #include "MyThread.h"
-#include <sqlext.h>
-#include <sql.h>
-#include <sqltypes.h>
-#pragma comment(lib, "WS2_32.lib")
-#pragma comment(lib, "MSWSock.lib")
+#include "Benchmark.h"
 
 using namespace std;
 using namespace chrono;
 
-int main()
+// 실행 인자로 정하는 스레드 구성
+//   SERVER [-jobs N] [-io N] [-pin]
+//   -jobs N : 게임 로직 작업 스레드 수 (기본 - 코어 수의 절반)
+//   -io N   : 네트워크 I/O 워커 수 (기본 - 남은 코어에서 타이머 스레드 몫 하나를 뺀 수)
+//   -pin    : 작업 스레드를 0번 코어부터, I/O 워커를 그 다음 코어부터 하나씩 고정한다
+struct SERVER_CONFIG {
+	int job_workers = 0;
+	int io_workers = 0;
+	bool pin = false;
+};
+
+SERVER_CONFIG Parse_Server_Config(int argc, char* argv[])
 {
+	SERVER_CONFIG config;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-jobs") == 0 && i + 1 < argc) config.job_workers = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-io") == 0 && i + 1 < argc) config.io_workers = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-pin") == 0) config.pin = true;
+		else cout << "unknown option " << argv[i] << " (SERVER [-jobs N] [-io N] [-pin])\n";
+	}
+	int num_threads = max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	if (config.job_workers <= 0) config.job_workers = max(1, num_threads / 2);
+	config.job_workers = min(config.job_workers, MAX_JOB_WORKERS);
+	if (config.io_workers <= 0) config.io_workers = max(1, num_threads - 1 - config.job_workers);
+	return config;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef _WIN32
 	// 콘솔 한글 출력 지원
 	wcout.imbue(locale("korean"));
 	setlocale(LC_ALL, "korean");
+#endif
 
 	// 맵, 몬스터정보 등 게임 환경 초기화
+	// 방(세션, 몬스터)은 처음 쓸 때 만들므로 시작 시간과 메모리는 MAX_ROOM 과 상관없다. (RoomArena.h)
+	auto startup_begin = high_resolution_clock::now();
 	InitializeMap();
 	InitializeMonsterInfo();
 	InitializeGrid();
-	InitializeMonsters();
-
-	// 서버 소켓 생성 -> 바인딩
-	WSADATA WSAData;
-	int ErrorStatus = WSAStartup(MAKEWORD(2, 2), &WSAData);
-	if (ErrorStatus == SOCKET_ERROR) return 0;
-	g_s_socket = WSASocket(AF_INET, SOCK_STREAM, 0, NULL, 0, WSA_FLAG_OVERLAPPED);
-	SOCKADDR_IN server_addr;
-	memset(&server_addr, 0, sizeof(server_addr));
-	server_addr.sin_family = AF_INET;
-	server_addr.sin_port = htons(PORT_NUM);
-	server_addr.sin_addr.S_un.S_addr = INADDR_ANY;
-	bind(g_s_socket, reinterpret_cast<sockaddr*>(&server_addr), sizeof(server_addr));
-	listen(g_s_socket, SOMAXCONN);
-	SOCKADDR_IN cl_addr;
-	int addr_size = sizeof(cl_addr);
-
-	// IOCP 초기화
-	h_iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, 0, 0, 0);
-	CreateIoCompletionPort(reinterpret_cast<HANDLE>(g_s_socket), h_iocp, 9999, 0);
-
-	// 클라이언트 연결 승인
-	g_c_socket = WSASocket(AF_INET, SOCK_STREAM, 0, NULL, 0, WSA_FLAG_OVERLAPPED);
-	g_a_over._comp_type = OP_ACCEPT;
-	AcceptEx(g_s_socket, g_c_socket, g_a_over._send_buf, 0, addr_size + 16, addr_size + 16, 0, &g_a_over._over);
-
-
-	cout << "SERVER READY\n";
-
-	// CPU 코어 개수에 따른 스레드 생성 및 역할 분배
+	InitializePathGraph();
+	if (false == InitializeMonsters()) return 0;
+
+	// 게임 로직 작업 스레드(JobSystem.h)와 I/O 워커(송수신) 수는 실행 인자로 정한다.
+	SERVER_CONFIG config = Parse_Server_Config(argc, argv);
+	int num_io_workers = config.io_workers;
+
+	// I/O 백엔드(IOCP / epoll / io_uring) 초기화 - epoll / io_uring 은 I/O 워커마다 epoll(링)을 만든다.
+	if (false == IO_Initialize(num_io_workers)) return 0;
+
+	// 서버 소켓 생성 -> 바인딩, 클라이언트 연결 승인
+	// accept 요청을 미리 여러 개 걸어두고, Linux 는 워커 수만큼 SO_REUSEPORT listen 소켓을 연다. (i 번 소켓은 i 번 워커의 epoll / io_uring 에 등록)
+	int num_listeners = IO_Start_Accept(PORT_NUM, num_io_workers);
+	if (num_listeners == 0) return 0;
+
+
+	cout << "SERVER READY (" << num_listeners << " listen sockets, " << config.job_workers << " job workers, "
+		<< num_io_workers << " io workers" << (config.pin ? ", pinned" : "") << ")\n";
+	cout << "startup " << duration_cast<milliseconds>(high_resolution_clock::now() - startup_begin).count() << "ms, RSS "
+		<< Process_Resident_Bytes() / (1024 * 1024) << "MB\n";
+
+	// 스레드 생성 및 역할 분배
+	// 방의 메시지(패킷, 방 틱, 연결 종료, DB 결과)는 작업 스레드가, 송수신 완료는 I/O 워커가 처리한다.
+	g_job_scheduler.Start(config.job_workers, config.pin ? 0 : -1);
 	vector <thread> worker_threads;
-	int num_threads = std::thread::hardware_concurrency();
 	thread Event_Thread{ Timer_Thread };
 	thread Database_thread{ DB_Thread };
-	for (int i = 0; i < num_threads - 1; ++i)
-		worker_threads.emplace_back(worker_thread, h_iocp);
+	for (int i = 0; i < num_io_workers; ++i) {
+		worker_threads.emplace_back([i, &config]() {
+			if (config.pin) Pin_Thread(config.job_workers + i);
+			IO_Bind_Worker(i);
+			worker_thread();
+			});
+	}
+#ifdef _PRINT_STATS
+	thread Statistics_Thread{ Stats_Thread };
+	Statistics_Thread.detach();
+#endif
+#ifdef _BENCHMARK
+	thread Benchmarking_Thread{ Benchmark_Thread };
+	Benchmarking_Thread.detach();
+#endif
 
 
 	for (auto& th : worker_threads)
@@ -68,10 +99,10 @@ int main()
 	Event_Thread.join();
 	Database_thread.join();
 
+	g_job_scheduler.Stop();
 	FinalizeMonsters();
 
-	closesocket(g_s_socket);
-	WSACleanup();
+	IO_Finalize();
 }
 
 
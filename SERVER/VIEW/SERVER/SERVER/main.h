@@ -4,9 +4,20 @@
 #include "MemoryPool.h"
 #include "MapObject.h"
 #include "Monster.h"
+#include "TimingWheel.h"
+#include "StateRecorder.h"
+#include "SlotAllocator.h"
+#include "RoomActor.h"
+#include "PathFinder.h"
+#include "FlowField.h"
+#include "HierarchicalPath.h"
+#include "BitGrid.h"
+#include "SpatialHash.h"
+#include "MonsterStore.h"
+#include "RoomArena.h"
 
 // 게임 로직 이벤트 타입
-enum EVENT_TYPE { EV_MONSTER_UPDATE };
+enum EVENT_TYPE { EV_ROOM_TICK };
 
 // DB I/O 이벤트 타입
 enum DB_EVENT_TYPE { EV_SIGNIN, EV_SIGNUP, EV_SAVE, EV_RESET };
@@ -26,11 +37,21 @@ struct TIMER_EVENT {
 // DB 이벤트
 struct DB_EVENT {
 	unsigned short session_id = -1; // 해당 작업과 연관된 세션 ID
-	wchar_t user_id[IDPW_SIZE]{}; // 사용자 계정 정보
-	wchar_t user_password[IDPW_SIZE]{};
+	PACKET_WCHAR user_id[IDPW_SIZE]{}; // 사용자 계정 정보
+	PACKET_WCHAR user_password[IDPW_SIZE]{};
 	DB_EVENT_TYPE _event;
 };
 
+// DB 처리 결과 - DB 스레드가 세션 상태를 바로 바꾸지 않고 방 실행기에 RJ_DB_RESULT 로 넘긴다.
+struct DB_RESULT {
+	DB_EVENT_TYPE _event;
+	bool success = false;
+	bool set_name = false;			// user_id 를 세션 이름으로 기록
+	bool set_stage = false;			// cur_stage 를 세션에 기록
+	int cur_stage = 0;
+	PACKET_WCHAR user_id[IDPW_SIZE]{};
+};
+
 // 맵의 그리드의 크기
 constexpr int GRID_SIZE_X = 150;  
 constexpr int GRID_SIZE_Y = 2;
@@ -40,14 +61,40 @@ constexpr int CELL_SIZE = 4; // 각 그리드 셀의 크기
 
 // 맵의 장애물 정보를 저장하는 3차원 배열
 array<array<array<bool, GRID_SIZE_Z>, GRID_SIZE_X>,GRID_SIZE_Y> ObstacleGrid = { false };
+// ObstacleGrid 를 칸당 1비트로 줄인 것 (BitGrid.h) - 몬스터 이동 판정은 이쪽을 본다. InitializeGrid 에서 만든다.
+using OBSTACLE_BITS = BIT_GRID<GRID_SIZE_X, GRID_SIZE_Z>;
+array<OBSTACLE_BITS, GRID_SIZE_Y> ObstacleBits;
 
 // 타이머 기반 이벤트 처리
-concurrent_priority_queue<TIMER_EVENT> timer_queue;
+TimingWheel<TIMER_EVENT> timer_queue;
 // 데이터베이스 작업 처리
 concurrent_queue<DB_EVENT> db_queue;
 
-array<array<SESSION, MAX_USER_PER_ROOM>, MAX_ROOM> clients;
-array<array<Monster*, MONSTER_PER_STAGE* STAGE_NUMBERS>, MAX_ROOM> monsters;
+// 방마다 처음 접근할 때(SLOT_ALLOCATOR 가 자리를 줄 때) 세션을 만든다. (RoomArena.h)
+LAZY_ROOMS<array<SESSION, MAX_USER_PER_ROOM>, MAX_ROOM> clients;
+SLOT_ALLOCATOR<decltype(clients)> slot_allocator{ clients };
+
+// 방 실행기 (RoomActor.h) - 방마다 하나씩, g_job_scheduler 의 작업 스레드에서 돈다. 방에 처음 메시지를 넣을 때 만들고 Bind 한다.
+void Run_Room_Job(ROOM_JOB* job);	// MyThread.h
+void Bind_Room_Actor(ROOM_ACTOR& actor, int room)
+{
+	actor.Bind(&g_job_scheduler, room, Run_Room_Job);
+}
+LAZY_ROOMS<ROOM_ACTOR, MAX_ROOM> room_actors{ Bind_Room_Actor };
+static_assert(MAX_ROOM <= JOB_DEQUE_SIZE, "every room must fit in one worker deque");
+// 방의 몬스터 - 방이 처음 패킷을 받을 때 monster_sets 에서 묶음을 꺼내 채우고(Acquire_Room_Monsters), 방이 비면 돌려준다. (그 전과 후는 nullptr)
+array<array<Monster*, MONSTER_PER_STAGE* STAGE_NUMBERS>, MAX_ROOM> monsters{};
+using ROOM_MONSTER_POOL_TYPE = ROOM_MONSTER_POOL<MONSTER_PER_STAGE* STAGE_NUMBERS>;
+ROOM_MONSTER_POOL_TYPE monster_sets;
+array<ROOM_MONSTER_POOL_TYPE::SET*, MAX_ROOM> room_monster_sets{};	// 방마다 쓰고 있는 몬스터 묶음
+// 방마다 몬스터 위치를 담는 공간 해시 (SpatialHash.h) - 몬스터 번호(m_id)가 비트 번호다. 그 방의 실행기만 다룬다.
+array<SPATIAL_HASH<MONSTER_PER_STAGE* STAGE_NUMBERS>, MAX_ROOM> monster_hashes;
+// 방마다 몬스터 위치, 시야, 목표를 몬스터 번호 순서로 모은 배열 묶음 (MonsterStore.h) - 그 방의 실행기만 다룬다.
+using ROOM_MONSTER_STORE = MONSTER_STORE<MONSTER_PER_STAGE* STAGE_NUMBERS, MAX_USER_PER_ROOM>;
+array<ROOM_MONSTER_STORE, MAX_ROOM> monster_stores;
+// 방마다, 플레이어 자리마다, 층마다 하나씩 두는 흐름장 (FlowField.h) - 그 방의 실행기만 다룬다. 처음 쫓을 때 만든다.
+using ROOM_FLOW_FIELD = FLOW_FIELD<GRID_SIZE_X, GRID_SIZE_Z>;
+LAZY_ROOMS<array<array<ROOM_FLOW_FIELD, GRID_SIZE_Y>, MAX_USER_PER_ROOM>, MAX_ROOM> flow_fields;
 
 vector<MonsterInfo> StagesInfo;
 
@@ -87,6 +134,40 @@ array<Monster*, MONSTER_PER_STAGE* STAGE_NUMBERS>* getRoom_Monsters(int c_id)
 	}
 }
 
+/**
+ * @brief 방의 몬스터를 준비한다. 이미 있으면 아무것도 하지 않는다.
+ *
+ * 빈 묶음을 꺼내 몬스터마다 Initialize 하고 공간 해시와 배열 묶음에 넣습니다.
+ * 방의 실행기에서 호출합니다. (Run_Room_Job 의 RJ_PACKET)
+ */
+void Acquire_Room_Monsters(int roomNum)
+{
+	if (room_monster_sets[roomNum] != nullptr) return;
+	auto set = monster_sets.Acquire(StagesInfo);
+	room_monster_sets[roomNum] = set;
+	for (size_t j = 0; j < monsters[roomNum].size(); ++j) {
+		Monster* monster = (*set)[j];
+		monster->Initialize(roomNum, StagesInfo[j].id, StagesInfo[j].type, StagesInfo[j].Pos);
+		monsters[roomNum][j] = monster;
+		monster_hashes[roomNum].Update(j, monster->Pos);
+		monster_stores[roomNum].Reset(j, StagesInfo[j].type, monster->Pos, monster->view_range);
+	}
+}
+
+// 방이 비었을 때 몬스터를 처음 상태로 되돌려 묶음을 풀에 돌려준다. (disconnect)
+void Release_Room_Monsters(int roomNum)
+{
+	auto set = room_monster_sets[roomNum];
+	if (set == nullptr) return;
+	for (size_t j = 0; j < monsters[roomNum].size(); ++j) {
+		monsters[roomNum][j]->Re_Initialize(StagesInfo[j].type, StagesInfo[j].Pos);
+		monsters[roomNum][j] = nullptr;
+		monster_hashes[roomNum].Remove(j);
+	}
+	room_monster_sets[roomNum] = nullptr;
+	monster_sets.Release(set);
+}
+
 vector<MapObject*>* getRoom_Obstacles(XMFLOAT3 Pos)
 {
 	try {
@@ -98,6 +179,91 @@ vector<MapObject*>* getRoom_Obstacles(XMFLOAT3 Pos)
 	}
 }
 
+constexpr unsigned ALL_RECEIVERS = (1u << MAX_USER_PER_ROOM) - 1;
+
+/**
+ * @brief 방 안에서 receivers 비트(방 안의 자리 번호)에 해당하는 플레이어에게만 같은 버퍼를 보낸다.
+ *
+ * 패킷을 송신 버퍼 하나에 한 번만 직렬화하고, 각 세션의 송신 큐는 그 버퍼를 참조 카운트로 공유합니다.
+ * 이미 패킷을 담은 버퍼를 보내고 만든 쪽의 참조를 해제합니다.
+ */
+void Multicast_Buffer(int roomNum, SEND_BUFFER* buf, unsigned receivers)
+{
+	buf->_shared = true;
+	for (int i = 0; i < MAX_USER_PER_ROOM; ++i) {
+		if ((receivers & (1u << i)) == 0) continue;
+		SESSION& cl = clients[roomNum][i];
+		if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD) cl.do_send(buf);
+	}
+	buf->Release();
+}
+
+/**
+ * @brief 방 안의 모든 플레이어에게 같은 패킷을 보낸다.
+ * @param except_id 보내지 않을 세션 id (-1 이면 모두에게 보낸다)
+ */
+void Broadcast_Buffer(int roomNum, SEND_BUFFER* buf, int except_id = -1)
+{
+	unsigned receivers = ALL_RECEIVERS;
+	if (except_id >= 0 && except_id / MAX_USER_PER_ROOM == roomNum)
+		receivers &= ~(1u << (except_id % MAX_USER_PER_ROOM));
+	Multicast_Buffer(roomNum, buf, receivers);
+}
+
+void Broadcast_Packet(int roomNum, void* packet, int except_id = -1)
+{
+	Broadcast_Buffer(roomNum, SEND_BUFFER::Create(packet, true), except_id);
+}
+
+/**
+ * @brief 플레이어의 현재 상태를 관심 영역(Interest.h)에 따라 방의 플레이어들에게 보낸다.
+ *
+ * 자신과 가까운 플레이어에게는 매번, 멀리 있는 플레이어에게는 AOI_PLAYER_REDUCED_PERIOD 마다,
+ * 다른 층의 플레이어에게는 보내지 않습니다. 죽은 상태(HP <= 0)는 모두에게 보냅니다.
+ * _COMPACT_STATE 이면 받는 플레이어마다 지난번에 보낸 상태에 대한 델타(SC_UPDATE_PLAYER_Q)를 보냅니다.
+ * 방의 실행기에서만 호출되므로 인코딩한 순서와 세션 송신 큐에 들어가는 순서가 같습니다.
+ */
+void Broadcast_Player_Update(SESSION* player)
+{
+	int roomNum = player->_id / MAX_USER_PER_ROOM;
+	PLAYER_STATE state = player->make_player_state();
+	RECORD_PLAYER_STATE(roomNum, player->_id, state);
+	bool force = (state.HP <= 0.f);
+
+	auto now = high_resolution_clock::now();
+	unsigned receivers = 0;
+	for (int i = 0; i < MAX_USER_PER_ROOM; ++i) {
+		SESSION& cl = clients[roomNum][i];
+		if (false == force && &cl != player) {
+			INTEREST_LEVEL level = cl.Interest_Of(state.Pos, player->cur_stage.load());
+			if (level == INTEREST_NONE || (level == INTEREST_REDUCED && now - player->_last_sent_to[i] < AOI_PLAYER_REDUCED_PERIOD)) {
+				STAT_ADD(interest_skipped, 1);
+				continue;
+			}
+		}
+		player->_last_sent_to[i] = now;
+		receivers |= 1u << i;
+	}
+	if (receivers == 0) return;
+#ifdef _COMPACT_STATE
+	for (int i = 0; i < MAX_USER_PER_ROOM; ++i) {
+		if ((receivers & (1u << i)) == 0) continue;
+		unsigned char packet[MAX_PACKET_SIZE];
+		SC_UPDATE_PLAYER_Q_HEADER header;
+		int len = Encode_Player_State(packet + sizeof(header), MAX_PACKET_SIZE - sizeof(header), player->_sent_state[i], state);
+		if (len <= 0) continue;
+		header.size = static_cast<PACKET_SIZE>(sizeof(header) + len);
+		header.type = SC_UPDATE_PLAYER_Q;
+		header.id = player->_id;
+		memcpy(packet, &header, sizeof(header));
+		Multicast_Buffer(roomNum, SEND_BUFFER::Create(packet, true), 1u << i);
+	}
+#else
+	SC_UPDATE_PLAYER_PACKET p = player->make_update_packet();
+	Multicast_Buffer(roomNum, SEND_BUFFER::Create(&p, true), receivers);
+#endif
+}
+
 short get_remain_Monsters(int c_id)
 {
 	short cnt = 0;
@@ -114,8 +280,28 @@ short get_remain_Monsters(int c_id)
 }
 
 
+// 방의 실행기에 메시지를 넘긴다. 방의 게임 상태를 바꾸는 일은 모두 이 함수를 거친다.
+// 세션에 관한 메시지는 지금 세션의 세대를 적어 둔다. (Run_Room_Job 이 세대가 다르면 버린다)
+void Post_Room_Job(ROOM_JOB* job)
+{
+	STAT_ADD(room_jobs, 1);
+	if (job->_id >= 0) job->_generation = getClient(job->_id)->_generation.load();
+	room_actors[job->_room].Post(job);
+}
+
+// I/O 워커에서 연결 종료를 방의 실행기에 넘긴다.
+void Post_Disconnect(int c_id)
+{
+	Post_Room_Job(ROOM_JOB::Create(RJ_DISCONNECT, c_id / MAX_USER_PER_ROOM, c_id));
+}
+
+// 방의 실행기에서 호출한다. (I/O 워커는 Post_Disconnect 를 사용)
+// 세션의 세대를 늘려 이미 넣어 둔 이 연결의 메시지(두 번째 RJ_DISCONNECT, 늦게 온 RJ_PACKET)가 버려지게 한다.
 void disconnect(int c_id)
 {
+	// 이미 정리된 자리 - 방의 세션과 몬스터를 다시 돌려주면 안 된다.
+	SESSION* target = getClient(c_id);
+	if (target == nullptr || ST_FREE == target->_state.load() || ST_CRASHED == target->_state.load()) return;
 	bool game_in_progress = false;
 	auto Monsters = getRoom_Monsters(c_id);
 	auto Room_Clients = getRoom_Clients(c_id);
@@ -124,35 +310,429 @@ void disconnect(int c_id)
 		return;
 	}
 	for (auto& pl : *Room_Clients) {
-
 		if ((ST_INGAME != pl._state.load() && ST_DEAD != pl._state.load()) || pl._id == c_id) continue;
-
-		pl.send_remove_player_packet(c_id);
 		game_in_progress = true;
 	}
+	if (game_in_progress) {
+		SC_REMOVE_PLAYER_PACKET p = SESSION::make_remove_player_packet(c_id);
+		Broadcast_Packet(c_id / MAX_USER_PER_ROOM, &p, c_id);
+	}
 	SESSION* CL = getClient(c_id);
 	if (CL == nullptr) {
 		cout << "wrong session_id - disconnect" << endl;
 		return;
 	}
-	closesocket(CL->_socket);
+	CL->_generation.fetch_add(1);
+	CL->reset_send();
+	CL->close_socket();
+	if (flow_fields.Created(c_id / MAX_USER_PER_ROOM))
+		for (auto& field : flow_fields[c_id / MAX_USER_PER_ROOM][c_id % MAX_USER_PER_ROOM])
+			field.Release();
 
 	if (game_in_progress) {
 		CL->_state.store(ST_CRASHED);
 	}
 
 	else {
+		// 방을 돌려주므로 아직 연결된 다른 플레이어(게임 시작 전)도 소켓을 닫고 정리한다.
 		for (auto& pl : *Room_Clients) {
 			if (pl._state.load() == ST_FREE) continue;
+			if (pl._id != c_id) {
+				pl._generation.fetch_add(1);
+				pl.reset_send();
+				pl.close_socket();
+			}
 			pl._state = ST_FREE;
 		}
 
-		for (auto& mon : *getRoom_Monsters(c_id)) {
-			mon->Re_Initialize(StagesInfo[mon->m_id].type, StagesInfo[mon->m_id].Pos);
+		Release_Room_Monsters(c_id / MAX_USER_PER_ROOM);
+		slot_allocator.Release_Room(c_id / MAX_USER_PER_ROOM);
+	}
+}
+
+
+constexpr int ROOM_TICK_RATE = 10;	// 방 틱 기본 주기 (초당 횟수)
+constexpr int ROOM_MONSTER_COUNT = MONSTER_PER_STAGE * STAGE_NUMBERS;
+static_assert(ROOM_MONSTER_COUNT <= 64, "room monsters are tracked in a 64-bit mask");
+constexpr int DORMANT_STAGE_REACH = 1;	// 게임 중인 플레이어가 있는 스테이지에서 이만큼 떨어진 스테이지까지 몬스터가 깨어 있다
+
+// false 면 잠들기 없이 살아있는 몬스터를 모두 매 틱 업데이트한다. (측정 비교용)
+atomic_bool room_dormancy = true;
+
+// 방마다 고정 주기로 살아있는 몬스터를 한 번에 업데이트하는 틱 상태
+struct ROOM_TICK {
+	atomic_bool running = false;						// 틱 이벤트가 예약되어 있는지
+	atomic<int> tick_rate = ROOM_TICK_RATE;
+	high_resolution_clock::time_point next_tick;		// 다음 틱 예정 시각 (틱을 처리하는 스레드만 사용)
+	high_resolution_clock::time_point last_tick;
+	atomic<long long> last_tick_us = 0;					// 마지막 틱 처리에 걸린 시간 (마이크로초)
+	unsigned tick_count = 0;							// 처리한 틱 수 (관심 영역의 줄인 주기 계산용)
+	bool dormant = false;								// 깨어 있는 몬스터가 없어 틱을 멈춘 방 (살아있는 몬스터와 sent 는 그대로 둔다)
+	array<short, MAX_USER_PER_ROOM> player_stage{};		// 플레이어마다 마지막으로 본 위치의 스테이지 (CheckPosition)
+	array<MONSTER_SNAPSHOT, ROOM_MONSTER_COUNT> sent;	// 몬스터마다 마지막 틱의 상태 (id 가 -1 이면 아직 없음)
+	array<uint64_t, MAX_USER_PER_ROOM> pending{};		// 플레이어마다 바뀌었지만 관심 영역 밖이라 아직 보내지 않은 몬스터 (비트)
+#ifdef _COMPACT_STATE
+	array<array<MONSTER_BASELINE, ROOM_MONSTER_COUNT>, MAX_USER_PER_ROOM> sent_q;	// 플레이어마다 압축 인코딩의 기준 상태
+#endif
+};
+// 방에 처음 틱을 걸거나 플레이어가 움직일 때 만든다. (tick_rate, sent 처럼 0 이 아닌 기본값이 있어 미리 두면 모든 방의 메모리를 쓴다)
+LAZY_ROOMS<ROOM_TICK, MAX_ROOM> room_ticks;
+
+void Set_Room_Tick_Rate(int roomNum, int tick_rate)
+{
+	room_ticks[roomNum].tick_rate.store((tick_rate > 0) ? tick_rate : 1);
+}
+
+/**
+ * @brief 방의 틱이 멈춰 있으면 시작한다.
+ * @param resend true 면 첫 틱에서 모든 몬스터를 다시 보낸다.
+ *
+ * 틱이 멈춰 있던 동안의 상태는 믿을 수 없으므로 보통은 다시 보냅니다.
+ * 잠든 방을 깨울 때(Wake_Room_Tick)는 그동안 몬스터가 그대로였으므로 마지막으로 보낸 상태를 이어서 씁니다.
+ */
+void Start_Room_Tick(int roomNum, bool resend = true)
+{
+	ROOM_TICK& rt = room_ticks[roomNum];
+	bool old_state = false;
+	if (false == rt.running.compare_exchange_strong(old_state, true))
+		return;
+	rt.dormant = false;
+	if (resend) {
+		for (auto& snapshot : rt.sent) snapshot.id = -1;
+		rt.pending.fill(0);
+#ifdef _COMPACT_STATE
+		for (auto& bases : rt.sent_q)
+			for (auto& base : bases) base.valid = false;
+#endif
+	}
+	rt.last_tick = rt.next_tick = high_resolution_clock::now();
+	TIMER_EVENT ev{ roomNum, -1, rt.next_tick, EV_ROOM_TICK };
+	timer_queue.Add(ev);
+}
+
+// 패킷을 방 틱의 송신 버퍼에 이어 붙인다. 버퍼가 차면 receivers 에게 보내고 새 버퍼를 만든다.
+void Append_Room_Packet(int roomNum, const void* packet, SEND_BUFFER*& buf, unsigned receivers)
+{
+	if (buf != nullptr && buf->Append(packet)) return;
+	if (buf != nullptr) Multicast_Buffer(roomNum, buf, receivers);
+	buf = SEND_BUFFER::Create(packet, false);
+}
+
+/**
+ * @brief SC_MOVE_MONSTERS 패킷을 송신 버퍼에 이어 붙이고 비운다.
+ */
+void Flush_Monster_Snapshots(int roomNum, SC_MOVE_MONSTERS_PACKET& p, SEND_BUFFER*& buf, unsigned receivers)
+{
+	if (p.count == 0) return;
+	p.size = static_cast<PACKET_SIZE>(SC_MOVE_MONSTERS_HEADER_SIZE + sizeof(MONSTER_SNAPSHOT) * p.count);
+	Append_Room_Packet(roomNum, &p, buf, receivers);
+	p.count = 0;
+}
+
+// mask 비트의 몬스터 상태를 SC_MOVE_MONSTERS 로 묶어 receivers 에게 보낸다.
+void Send_Monster_Snapshots(int roomNum, const array<MONSTER_SNAPSHOT, ROOM_MONSTER_COUNT>& snapshots, uint64_t mask, unsigned receivers)
+{
+	SEND_BUFFER* buf = nullptr;
+	SC_MOVE_MONSTERS_PACKET p;
+	p.type = SC_MOVE_MONSTERS;
+#ifdef _STRESS_TEST
+	p.room_num = roomNum;
+#endif
+	p.count = 0;
+	for (uint64_t bits = mask; bits != 0; bits &= bits - 1) {
+		p.monsters[p.count++] = snapshots[countr_zero(bits)];
+		if (p.count == MAX_MONSTER_SNAPSHOT) Flush_Monster_Snapshots(roomNum, p, buf, receivers);
+	}
+	Flush_Monster_Snapshots(roomNum, p, buf, receivers);
+	if (buf != nullptr) Multicast_Buffer(roomNum, buf, receivers);
+}
+
+#ifdef _COMPACT_STATE
+// 압축 인코딩한 몬스터 상태를 모으는 SC_MOVE_MONSTERS_Q 패킷
+struct MONSTER_BATCH_Q {
+	unsigned char packet[MAX_PACKET_SIZE];
+	int len = sizeof(SC_MOVE_MONSTERS_Q_HEADER);
+	int count = 0;
+};
+
+void Flush_Monster_Batch_Q(int roomNum, MONSTER_BATCH_Q& batch, SEND_BUFFER*& buf, unsigned receivers)
+{
+	if (batch.count == 0) return;
+	SC_MOVE_MONSTERS_Q_HEADER header;
+	header.size = static_cast<PACKET_SIZE>(batch.len);
+	header.type = SC_MOVE_MONSTERS_Q;
+#ifdef _STRESS_TEST
+	header.room_num = roomNum;
+#endif
+	header.count = static_cast<unsigned char>(batch.count);
+	memcpy(batch.packet, &header, sizeof(header));
+	Append_Room_Packet(roomNum, batch.packet, buf, receivers);
+	batch.len = sizeof(SC_MOVE_MONSTERS_Q_HEADER);
+	batch.count = 0;
+}
+
+// 몬스터 하나를 지난번에 보낸 상태에 대해 인코딩해서 패킷에 넣는다. 바뀐 것이 없으면 넣지 않는다.
+void Add_Monster_Batch_Q(int roomNum, MONSTER_BATCH_Q& batch, MONSTER_BASELINE& base, const MONSTER_SNAPSHOT& snapshot, SEND_BUFFER*& buf, unsigned receivers)
+{
+	unsigned char entry[MAX_PACKET_SIZE];
+	memcpy(entry, &snapshot.id, sizeof(short));
+	int len = Encode_Monster_State(entry + sizeof(short), MAX_PACKET_SIZE - sizeof(short) - sizeof(SC_MOVE_MONSTERS_Q_HEADER), base, snapshot);
+	if (len <= 0) return;
+	len += sizeof(short);
+	if (batch.len + len > MAX_PACKET_SIZE) Flush_Monster_Batch_Q(roomNum, batch, buf, receivers);
+	memcpy(batch.packet + batch.len, entry, len);
+	batch.len += len;
+	batch.count++;
+}
+
+// mask 비트의 몬스터 상태를 방의 slot 번 플레이어의 기준 상태에 대해 인코딩해서 보낸다.
+void Send_Monster_Batch_Q(int roomNum, const array<MONSTER_SNAPSHOT, ROOM_MONSTER_COUNT>& snapshots, uint64_t mask, int slot)
+{
+	ROOM_TICK& rt = room_ticks[roomNum];
+	unsigned receivers = 1u << slot;
+	SEND_BUFFER* buf = nullptr;
+	MONSTER_BATCH_Q batch;
+	for (uint64_t bits = mask; bits != 0; bits &= bits - 1) {
+		int i = countr_zero(bits);
+		Add_Monster_Batch_Q(roomNum, batch, rt.sent_q[slot][i], snapshots[i], buf, receivers);
+	}
+	Flush_Monster_Batch_Q(roomNum, batch, buf, receivers);
+	if (buf != nullptr) Multicast_Buffer(roomNum, buf, receivers);
+}
+#endif
+
+// 방의 살아있는 몬스터 (비트)
+uint64_t Alive_Monsters(int roomNum)
+{
+	uint64_t alive = 0;
+	for (int i = 0; i < ROOM_MONSTER_COUNT; ++i)
+		if (monsters[roomNum][i]->alive.load()) alive |= 1ull << i;
+	return alive;
+}
+
+/**
+ * @brief 이번 틱에 업데이트할 몬스터를 고른다.
+ * @param alive 방의 살아있는 몬스터
+ *
+ * 게임 중인 플레이어가 있는 스테이지와 DORMANT_STAGE_REACH 안의 이웃 스테이지의 몬스터, 그리고 Idle 이 아닌
+ * (쫓거나 때리거나 죽어 가는) 몬스터가 깨어 있습니다. 나머지는 플레이어가 와도 Idle 로 기다리기만 하므로 건너뜁니다.
+ * 플레이어가 모두 죽거나 끊기면 쫓던 몬스터가 Idle 로 돌아간 뒤 방 전체가 잠듭니다.
+ */
+uint64_t Awake_Monsters(int roomNum, uint64_t alive)
+{
+	if (false == room_dormancy.load()) return alive;
+	unsigned stages = 0;	// 비트 s 가 s 스테이지 (몬스터 m 은 m / MONSTER_PER_STAGE + 1 스테이지)
+	for (auto& cl : clients[roomNum]) {
+		if (cl._state.load() != ST_INGAME) continue;
+		int stage = Get_Stage(cl.GetPosition());
+		for (int s = max(stage - DORMANT_STAGE_REACH, 1); s <= min(stage + DORMANT_STAGE_REACH, static_cast<int>(STAGE_NUMBERS)); ++s)
+			stages |= 1u << s;
+	}
+	uint64_t awake = 0;
+	for (uint64_t bits = alive; bits != 0; bits &= bits - 1) {
+		int i = countr_zero(bits);
+		if ((stages & (1u << (i / MONSTER_PER_STAGE + 1))) || monsters[roomNum][i]->GetState() != NPC_State::Idle)
+			awake |= 1ull << i;
+	}
+	return awake;
+}
+
+/**
+ * @brief 잠든 방을 깨운다.
+ *
+ * 플레이어가 다른 스테이지로 옮겼을 때(CheckPosition)와 몬스터가 맞았을 때 부릅니다.
+ * 깨어날 몬스터가 없으면 계속 잠들어 있습니다. 잠든 동안 몬스터는 그대로였으므로 보낸 상태는 다시 보내지 않습니다.
+ */
+void Wake_Room_Tick(int roomNum)
+{
+	ROOM_TICK& rt = room_ticks[roomNum];
+	if (false == rt.dormant) return;
+	if (0 == Awake_Monsters(roomNum, Alive_Monsters(roomNum))) return;
+	STAT_ADD(room_wakes, 1);
+	Start_Room_Tick(roomNum, false);
+}
+
+/**
+ * @brief 방의 살아있는 몬스터를 상태별로 모아서 한 틱 업데이트한다.
+ * @param roomNum 방 번호
+ * @param awake 업데이트할 몬스터 (Awake_Monsters) - 살아있지 않은 몬스터는 빠진다
+ * @return 업데이트한 몬스터 (틱을 시작할 때 살아있던 awake 몬스터)의 비트 마스크
+ *
+ * 틱을 시작할 때의 상태로 몬스터를 나누고, 마술사의 마법을 먼저 움직인 뒤 Idle, Chase, Attack, Dead 순서로
+ * 같은 상태의 몬스터를 이어서 처리합니다. Idle 몬스터의 목표는 monster_stores 가 방 전체를 한 번에 고릅니다.
+ * 움직인 몬스터는 바로 공간 해시와 배열 묶음에 알려서 뒤에 움직이는 몬스터의 충돌 검사가 새 위치를 보게 합니다.
+ */
+uint64_t Update_Room_Monsters(int roomNum, float elapsed, uint64_t awake = ~0ull)
+{
+	ROOM_MONSTER_STORE& store = monster_stores[roomNum];
+	auto& room = monsters[roomNum];
+	array<uint64_t, 4> by_state{};		// NPC_State 별 몬스터
+	uint64_t alive = 0;
+	for (int i = 0; i < ROOM_MONSTER_COUNT; ++i) {
+		if ((awake & (1ull << i)) == 0 || room[i]->alive.load() == false) continue;
+		alive |= 1ull << i;
+		by_state[static_cast<int>(room[i]->GetState())] |= 1ull << i;
+	}
+
+	// 마법 - 마법이 맵 밖으로 나간 마술사는 이번 틱을 건너뛴다.
+	for (uint64_t bits = alive & store.Type_Mask(2); bits != 0; bits &= bits - 1) {
+		int i = countr_zero(bits);
+		if (false == room[i]->Magic_Update(elapsed))
+			for (auto& mask : by_state) mask &= ~(1ull << i);
+	}
+
+	if (uint64_t idle = by_state[static_cast<int>(NPC_State::Idle)]; idle != 0) {
+		array<XMFLOAT3, MAX_USER_PER_ROOM> players;
+		unsigned in_game = 0;
+		for (int slot = 0; slot < MAX_USER_PER_ROOM; ++slot) {
+			players[slot] = clients[roomNum][slot].GetPosition();
+			if (clients[roomNum][slot]._state.load() == ST_INGAME) in_game |= 1u << slot;
+		}
+		store.Select_Targets(players, in_game);
+		for (; idle != 0; idle &= idle - 1) {
+			int i = countr_zero(idle);
+			room[i]->Idle_Update(store.Target(i), store.Distance(i));
 		}
 	}
+
+	for (uint64_t bits = by_state[static_cast<int>(NPC_State::Chase)]; bits != 0; bits &= bits - 1) {
+		int i = countr_zero(bits);
+		room[i]->Chase_Update(elapsed);
+		monster_hashes[roomNum].Update(i, room[i]->Pos);
+		store.Move(i, room[i]->Pos);
+	}
+
+	for (uint64_t bits = by_state[static_cast<int>(NPC_State::Attack)]; bits != 0; bits &= bits - 1)
+		room[countr_zero(bits)]->Attack_Update(elapsed);
+
+	for (uint64_t bits = by_state[static_cast<int>(NPC_State::Dead)]; bits != 0; bits &= bits - 1)
+		room[countr_zero(bits)]->Dead_Update(elapsed);
+
+	STAT_ADD(monster_updates, popcount(alive));
+	return alive;
 }
 
+/**
+ * @brief 방의 살아있는 몬스터를 한 번에 업데이트하고 바뀐 상태를 관심 영역에 따라 나눠 보낸다.
+ * @param roomNum 방 번호
+ *
+ * 지난 틱과 달라진 몬스터를 플레이어마다 관심 영역(Interest.h)으로 걸러서, 가까우면 매 틱, 멀면 줄인 주기로 보내고
+ * 다른 층이거나 너무 멀면 관심 영역에 들어올 때까지 미뤄 둡니다. 죽는 몬스터는 모두에게 바로 보냅니다.
+ * 같은 몬스터 목록을 받는 플레이어끼리는 SC_MOVE_MONSTERS 송신 버퍼를 공유합니다.
+ * _COMPACT_STATE 이면 플레이어마다 자신의 기준 상태에 대해 인코딩한 SC_MOVE_MONSTERS_Q 로 보냅니다.
+ * 깨어 있는 스테이지(Awake_Monsters)의 몬스터만 업데이트하고, 잠든 몬스터는 마지막으로 보낸 상태를 그대로 둡니다.
+ * 깨어 있는 몬스터가 없으면 틱을 멈춥니다. 살아있는 몬스터가 남아 있으면 잠든 방이 되어 Wake_Room_Tick 으로,
+ * 모두 죽었으면 다음 소환 때 Start_Room_Tick 으로 다시 시작합니다.
+ * 방의 실행기에서 RJ_TICK 으로 호출되어 같은 방의 패킷 처리와 겹치지 않으므로 몬스터와 플레이어를 락 없이 바꿉니다.
+ */
+void Room_Tick(int roomNum)
+{
+	ROOM_TICK& rt = room_ticks[roomNum];
+	// 방이 비어 몬스터를 돌려준 뒤에 도착한 틱
+	if (room_monster_sets[roomNum] == nullptr) {
+		rt.running.store(false);
+		rt.dormant = false;
+		return;
+	}
+	auto begin_time = high_resolution_clock::now();
+	float elapsed = duration<float>(begin_time - rt.last_tick).count();
+	rt.last_tick = begin_time;
+
+	// 깨어 있는 몬스터를 상태별로 모아서 업데이트하고 지난 틱과 달라진 몬스터(changed)와 이번 틱에 죽은 몬스터(dying)를 모은다.
+	const uint64_t alive = Alive_Monsters(roomNum);
+	const uint64_t updated = Update_Room_Monsters(roomNum, elapsed, Awake_Monsters(roomNum, alive));
+	STAT_ADD(monster_dormant, popcount(alive & ~updated));
+	array<MONSTER_SNAPSHOT, ROOM_MONSTER_COUNT> snapshots;
+	uint64_t changed = 0, dying = 0;
+	for (int i = 0; i < ROOM_MONSTER_COUNT; ++i) {
+		Monster* monster = monsters[roomNum][i];
+		uint64_t bit = 1ull << i;
+		if ((updated & bit) == 0) {
+			// 잠든 몬스터는 마지막으로 보낸 상태를 그대로 둔다.
+			if (alive & bit) continue;
+			// 죽은 몬스터는 다시 소환되면 처음부터 보낸다.
+			rt.sent[i].id = -1;
+			for (auto& pending : rt.pending) pending &= ~bit;
+#ifdef _COMPACT_STATE
+			for (auto& bases : rt.sent_q) bases[i].valid = false;
+#endif
+			continue;
+		}
+		monster->recent_updateTime = begin_time;
+		snapshots[i] = SESSION::make_monster_snapshot(monster);
+		if (false == snapshots[i].is_alive) dying |= bit;
+		RECORD_MONSTER_STATE(roomNum, snapshots[i]);
+		if (0 != memcmp(&rt.sent[i], &snapshots[i], sizeof(MONSTER_SNAPSHOT))) {
+			rt.sent[i] = snapshots[i];
+			changed |= bit;
+		}
+	}
+
+	// 플레이어마다 관심 영역에 따라 이번 틱에 보낼 몬스터(due)를 정한다.
+	array<uint64_t, MAX_USER_PER_ROOM> due{};
+	for (int slot = 0; slot < MAX_USER_PER_ROOM; ++slot) {
+		SESSION& cl = clients[roomNum][slot];
+		S_STATE state = cl._state.load();
+		if (state != ST_INGAME && state != ST_DEAD) {
+			rt.pending[slot] = 0;
+			continue;
+		}
+		uint64_t allowed = dying;
+		for (uint64_t bits = updated & ~dying; bits != 0; bits &= bits - 1) {
+			int i = countr_zero(bits);
+			INTEREST_LEVEL level = cl.Interest_Of(snapshots[i].Pos, static_cast<short>(i / MONSTER_PER_STAGE + 1));
+			if (level == INTEREST_FULL || (level == INTEREST_REDUCED && (rt.tick_count + i) % AOI_REDUCED_INTERVAL == 0))
+				allowed |= 1ull << i;
+		}
+		STAT_ADD(interest_skipped, popcount(changed & ~allowed));
+#ifdef _COMPACT_STATE
+		due[slot] = allowed;	// 바뀌지 않은 몬스터는 인코더가 걸러낸다.
+#else
+		rt.pending[slot] |= changed;
+		due[slot] = rt.pending[slot] & allowed;
+		rt.pending[slot] &= ~due[slot];
+#endif
+	}
+	rt.tick_count++;
+
+#ifdef _COMPACT_STATE
+	for (int slot = 0; slot < MAX_USER_PER_ROOM; ++slot)
+		if (due[slot] != 0) Send_Monster_Batch_Q(roomNum, snapshots, due[slot], slot);
+#else
+	// 보낼 몬스터 목록이 같은 플레이어끼리 송신 버퍼를 공유한다.
+	unsigned done = 0;
+	for (int slot = 0; slot < MAX_USER_PER_ROOM; ++slot) {
+		if ((done & (1u << slot)) || due[slot] == 0) continue;
+		unsigned receivers = 0;
+		for (int other = slot; other < MAX_USER_PER_ROOM; ++other)
+			if (due[other] == due[slot]) receivers |= 1u << other;
+		done |= receivers;
+		Send_Monster_Snapshots(roomNum, snapshots, due[slot], receivers);
+	}
+#endif
+
+	auto end_time = high_resolution_clock::now();
+	long long tick_ns = duration_cast<nanoseconds>(end_time - begin_time).count();
+	rt.last_tick_us.store(tick_ns / 1000);
+	STAT_ADD(room_ticks, 1);
+	STAT_ADD(room_tick_ns, tick_ns);
+
+	// 다음 틱에 깨어 있을 몬스터가 없으면 틱을 멈춘다. (소환, 깨우기는 같은 방의 실행기에서 하므로 이 사이에 끼어들지 않는다)
+	const uint64_t alive_after = Alive_Monsters(roomNum);
+	if (0 == Awake_Monsters(roomNum, alive_after)) {
+		rt.running.store(false);
+		rt.dormant = (alive_after != 0);
+		if (rt.dormant) STAT_ADD(room_dormancies, 1);
+		return;
+	}
+
+	// 고정 주기로 다음 틱을 예약한다. 처리가 밀려 예정 시각이 지났으면 놓친 틱은 건너뛴다.
+	auto interval = duration_cast<high_resolution_clock::duration>(duration<double>(1.0 / rt.tick_rate.load()));
+	rt.next_tick += interval;
+	if (rt.next_tick <= end_time) rt.next_tick = end_time + interval;
+	TIMER_EVENT ev{ roomNum, -1, rt.next_tick, EV_ROOM_TICK };
+	timer_queue.Add(ev);
+}
 
 void Summon_Monster(int roomNum, int stageNum)
 {
@@ -164,14 +744,10 @@ void Summon_Monster(int roomNum, int stageNum)
 		bool old_state = false;
 		if (false == atomic_compare_exchange_strong(&monsters[roomNum][i]->alive, &old_state, true))
 			continue;
-		for (int j = 0; j < MAX_USER_PER_ROOM; ++j) {
-			if (clients[roomNum][j]._state.load() == ST_INGAME || clients[roomNum][j]._state.load() == ST_DEAD) {
-				clients[roomNum][j].send_summon_monster_packet(monsters[roomNum][i]);
-			}
-		}
-		TIMER_EVENT ev{ roomNum, monsters[roomNum][i]->m_id, high_resolution_clock::now(), EV_MONSTER_UPDATE };
-		timer_queue.push(ev);
+		SC_SUMMON_MONSTER_PACKET p = SESSION::make_summon_monster_packet(monsters[roomNum][i]);
+		Broadcast_Packet(roomNum, &p);
 	}
+	Start_Room_Tick(roomNum);
 }
 
 void SESSION::CheckPosition(XMFLOAT3 newPos)
@@ -193,14 +769,17 @@ void SESSION::CheckPosition(XMFLOAT3 newPos)
 	}
 
 
-	lock_guard<mutex> player_lock{ _s_lock };
 	SetPosition(newPos);
 	UpdateBoundingBox();
-	short stage = 0;
-	if (GetPosition().y >= -100.f)	
-		stage = static_cast<short>((GetPosition().z - 300.f) / STAGE_SIZE);
-	else
-		stage = 3 + static_cast<short>((MAP_Z_SIZE - GetPosition().z) / STAGE_SIZE);
+	short stage = Get_Stage(GetPosition());
+
+	// 스테이지를 옮기면 그 스테이지의 잠든 몬스터를 깨운다.
+	const int roomNum = _id / MAX_USER_PER_ROOM;
+	short& seen_stage = room_ticks[roomNum].player_stage[_id % MAX_USER_PER_ROOM];
+	if (stage != seen_stage) {
+		seen_stage = stage;
+		Wake_Room_Tick(roomNum);
+	}
 
 	if (stage == 6 && GetPosition().z < 400.f && get_remain_Monsters(_id) == 0) {
 		auto Room_Clients = getRoom_Clients(_id);
@@ -220,15 +799,15 @@ void SESSION::CheckPosition(XMFLOAT3 newPos)
 	}
 }
 
+/**
+ * @brief 접속한 클라이언트에게 줄 세션 자리를 차지한다. (SlotAllocator.h)
+ * @return 세션 id, 빈 자리가 없으면 -1
+ *
+ * 돌려준 자리의 _state 는 이미 ST_ALLOC 으로 바뀌어 있으므로 다른 accept 와 겹치지 않습니다.
+ */
 int get_new_client_id()
 {
-	for (int i = 0; i < MAX_ROOM; ++i) {
-		for (int j = 0; j < MAX_USER_PER_ROOM; ++j) {
-			if (clients[i][j]._state.load() == ST_FREE)
-				return i * MAX_USER_PER_ROOM + j;
-		}
-	}
-	return -1;
+	return slot_allocator.Allocate();
 }
 
 
@@ -246,108 +825,158 @@ void SESSION::Update(CS_HEARTBEAT_PACKET* packet)
 
 
 
-short Heuristic(const XMFLOAT3& start, const XMFLOAT3& dest) {
-	return abs(dest.z - start.z) + abs(dest.x - start.x);
-}
+// 몬스터 길찾기 (PathFinder.h) - 층마다 ObstacleGrid[층] 위에서 찾는다.
+using PATH_FINDER = GRID_PATH_FINDER<GRID_SIZE_X, GRID_SIZE_Z>;
 
+// 층마다 하나씩 두는 계층 경로 그래프 (HierarchicalPath.h) - InitializePathGraph 에서 만든 뒤로는 읽기만 한다.
+using PATH_GRAPH = HPA_GRAPH<GRID_SIZE_X, GRID_SIZE_Z>;
+array<PATH_GRAPH, GRID_SIZE_Y> path_graphs;
 
-bool Monster::check_path(const XMFLOAT3& _pos, unordered_set<XMFLOAT3, PointHash, PointEqual>& CloseList, BoundingBox& check_box)
+PATH_CELL To_Cell(const XMFLOAT3& pos)
 {
-	int collide_range_z = static_cast<int>(_pos.z / AREA_SIZE);
-	check_box.Center = _pos;
-
-	if (CloseList.count(_pos)) {
-		return false;
-	}
+	return PATH_CELL{ static_cast<short>(int(pos.x) / CELL_SIZE), static_cast<short>(int(pos.z) / CELL_SIZE) };
+}
 
-	for (auto& monster : monsters[room_num]) {
-		if (monster->alive.load() == false || monster->m_id == m_id) continue;
-		if (monster->BB.Intersects(check_box))
-			return false;
-	}
+XMFLOAT3 Cell_Center(PATH_CELL cell, float y)
+{
+	return XMFLOAT3(cell.x * CELL_SIZE + CELL_SIZE / 2.f, y, cell.z * CELL_SIZE + CELL_SIZE / 2.f);
+}
 
-	try {
-		if (m_id < 20) {
-			if (ObstacleGrid[0].at(int(_pos.x) / CELL_SIZE).at(int(_pos.z) / CELL_SIZE) == false)
-				return false;
-		}
-		else {
-			if (ObstacleGrid[1].at(int(_pos.x) / CELL_SIZE).at(int(_pos.z) / CELL_SIZE) == false)
-				return false;
-		}
-	}
-	catch (const exception& e) {
-		//cout << "array access error - " << _pos.x << ", " << _pos.z << endl;
-		return false;
-	}
+// pos 가 있는 칸이 갈 수 있는 칸인가 (그리드 밖이면 false)
+bool Walkable_At(int floor, const XMFLOAT3& pos)
+{
+	return ObstacleBits[floor].Walkable(int(pos.x) / CELL_SIZE, int(pos.z) / CELL_SIZE);
+}
 
-	return true;
+// from 에서 to 로 곧게 움직일 때 지나는 칸이 모두 갈 수 있는 칸인가
+bool Stride_Walkable(int floor, const XMFLOAT3& from, const XMFLOAT3& to)
+{
+	return ObstacleBits[floor].Segment_Walkable(from.x / CELL_SIZE, from.z / CELL_SIZE, to.x / CELL_SIZE, to.z / CELL_SIZE);
 }
 
 float nx[8]{ -1,1,0,0, -1, -1, 1, 1 };
 float nz[8]{ 0,0,1,-1, -1, 1, -1, 1 };
+constexpr int WANDER_ATTEMPTS = 8;		// 돌아다닐 방향을 뽑는 횟수 상한
+
+/**
+ * @brief newPos 로 옮기면 같은 방의 살아있는 다른 몬스터와 겹치는가
+ *
+ * 공간 해시(monster_hashes)에서 주변 몬스터 후보만 골라 BoundingBox 로 확인합니다.
+ */
+bool Monster::Blocked_By_Monster(const XMFLOAT3& newPos)
+{
+	BoundingBox box(newPos, BB.Extents);
+	uint64_t candidates = monster_hashes[room_num].Query(box) & ~(1ull << m_id);
+	STAT_ADD(collide_queries, 1);
+	while (candidates) {
+		int i = countr_zero(candidates);
+		candidates &= candidates - 1;
+		Monster* monster = monsters[room_num][i];
+		if (monster->alive.load() == false) continue;
+		STAT_ADD(collide_box_tests, 1);
+		if (monster->BB.Intersects(box)) return true;
+	}
+	return false;
+}
+
+/**
+ * @brief dest 로 가는 경로를 따라 이번 틱에 움직일 위치를 구한다.
+ *
+ * 목표가 같은 칸에 있고 남은 경로가 지금 위치에서 이어지면 전에 찾은 경로를 그대로 따라가고,
+ * 아니면 PATH_FINDER 로 경로 전체를 다시 찾습니다. (몬스터 종류의 path_algorithm 에 따라 A* 나 JPS)
+ * 다른 몬스터가 서 있는 칸은 막힌 칸으로 봅니다.
+ * 목표가 HPA_MIN_CELLS 칸보다 멀면 계층 경로 그래프(path_graphs)로 찾고, 이때는 다른 몬스터를 보지 않습니다.
+ * 경로가 없으면 wander 로 바꾸고 제자리를 돌려줍니다.
+ */
 XMFLOAT3 Monster::Find_Direction(float fTimeElapsed, XMFLOAT3 start, XMFLOAT3 dest)
 {
 	if (Vector3::Compare(start, dest)) return Pos;
 
-	auto start_time = high_resolution_clock::now();
-	unordered_set<XMFLOAT3, PointHash, PointEqual> closelist{};
-	unordered_map<XMFLOAT3, shared_ptr<A_star_Node>, PointHash, PointEqual> openlist;
-	priority_queue<shared_ptr<A_star_Node>, vector<shared_ptr<A_star_Node>>, CompareNodes> pq;
-
-	shared_ptr<A_star_Node> startNode = make_shared<A_star_Node>(start, 0.f, Heuristic(start, dest), nullptr);
-	openlist.insert(make_pair(start, startNode));
-	pq.push(startNode);
-
-	BoundingBox CheckBox = BoundingBox(start, BB.Extents);
-	while (!pq.empty())
-	{
-		if (duration_cast<milliseconds>(high_resolution_clock::now() - start_time).count() > 3) break;
-		shared_ptr<A_star_Node> S_Node = pq.top();
-		pq.pop();
-
-		if (Vector3::Length(Vector3::Subtract(dest, S_Node->Pos)) < min(attack_range,MELEE_ATTACK_RANGE))
-		{
-			while (S_Node->parent != nullptr)
-			{
-				if (Vector3::Compare(S_Node->parent->Pos, start))
-				{
-					XMFLOAT3 next_pos = S_Node->Pos;
-					return next_pos;
-				}
-				S_Node = S_Node->parent;
-			}
+	PATH_CELL cur = To_Cell(start);
+	PATH_CELL goal = To_Cell(dest);
+	bool follow = (path_index < path.size() && path_goal == goal &&
+		abs(path[path_index].x - cur.x) <= 1 && abs(path[path_index].z - cur.z) <= 1);
+	if (false == follow) {
+		vector<PATH_CELL> blocked;
+		for (auto& monster : monsters[room_num]) {
+			if (monster->alive.load() == false || monster->m_id == m_id) continue;
+			PATH_CELL cell = To_Cell(monster->GetPosition());
+			if (cell != cur) blocked.push_back(cell);
 		}
+		float goal_range = min(attack_range, static_cast<float>(MELEE_ATTACK_RANGE)) / CELL_SIZE;
+		const int floor = (m_id < 20) ? 0 : 1;
+#ifdef _COLLECT_STATS
+		auto begin_time = high_resolution_clock::now();
+#endif
+		PATH_SEARCH_STATS result;
+		if (max(abs(goal.x - cur.x), abs(goal.z - cur.z)) > HPA_MIN_CELLS) {
+			result = path_graphs[floor].Find(ObstacleGrid[floor], cur, goal, goal_range, path);
+			STAT_ADD(path_hierarchical, 1);
+		}
+		else if (path_algorithm == PATH_JPS)
+			result = PATH_FINDER::Local().Find_Jump(ObstacleGrid[floor], cur, goal, goal_range, blocked, path);
+		else
+			result = PATH_FINDER::Local().Find(ObstacleGrid[floor], cur, goal, goal_range, blocked, path);
+#ifdef _COLLECT_STATS
+		STAT_ADD(path_ns, duration_cast<nanoseconds>(high_resolution_clock::now() - begin_time).count());
+#endif
+		STAT_ADD(path_searches, 1);
+		STAT_ADD(path_expanded, result.expanded);
+		if (result.result == PATH_BUDGET) STAT_ADD(path_budget_hits, 1);
+		path_index = 0;
+		path_goal = goal;
+		// 시작 칸이 이미 목표 범위 안이면 빈 경로로 PATH_FOUND - 도착했으므로 제자리에 있는다.
+		if (path.empty() && result.result == PATH_FOUND) return Pos;
+		if (path.empty()) {
+			wander = true;
+			return Pos;
+		}
+	}
 
-		closelist.insert(S_Node->Pos);
-
-		for (int i = 0; i < 8; i++) {
-			XMFLOAT3 near_pos = Vector3::Add(S_Node->Pos, Vector3::ScalarProduct(XMFLOAT3{ nx[i],0,nz[i] }, speed * fTimeElapsed, false));
-
-			if (check_path(near_pos, closelist, CheckBox) == false)
-				continue;
-
-			float _G = S_Node->G + speed * fTimeElapsed * sqrt(abs(nx[i]) + abs(nz[i]));
+	// 다음 칸의 중심을 향해 speed * fTimeElapsed 만큼 움직인다.
+	float step = speed * fTimeElapsed;
+	XMFLOAT3 next = Cell_Center(path[path_index], start.y);
+	XMFLOAT3 to_next = Vector3::Subtract(next, start);
+	float distance = Vector3::XZLength(to_next);
+	if (distance <= step) {
+		path_index++;
+		return next;
+	}
+	return Vector3::Add(start, Vector3::ScalarProduct(to_next, step / distance, false));
+}
 
-			auto neighborIter = openlist.find(near_pos);
-			if (neighborIter == openlist.end()) {
-				float neighborH = Heuristic(near_pos, dest);
-				shared_ptr<A_star_Node> neighborNode = make_shared<A_star_Node>(near_pos, _G, neighborH, S_Node);
-				openlist.insert(make_pair(near_pos, neighborNode));
-				pq.push(neighborNode);
-			}
-			else if (_G < neighborIter->second->G)
-			{
-				float neighborH = Heuristic(near_pos, dest);
-				neighborIter->second->G = _G;
-				neighborIter->second->H = neighborH;
-				neighborIter->second->F = _G + neighborH;
-				neighborIter->second->parent = S_Node;
-			}
+/**
+ * @brief 쫓는 플레이어의 흐름장(FlowField.h)을 따라 이번 틱에 움직일 위치를 구한다.
+ *
+ * 흐름장은 같은 방의 몬스터가 함께 쓰고, 플레이어가 FLOW_REBUILD_CELLS 칸 넘게 옮겼을 때만 다시 계산합니다.
+ * 흐름장 범위 밖이거나 다음 칸에 다른 몬스터가 있으면 Find_Direction(A*)으로 찾습니다.
+ */
+XMFLOAT3 Monster::Chase_Step(float fTimeElapsed, int target)
+{
+	const int floor = (m_id < 20) ? 0 : 1;
+	XMFLOAT3 dest = clients[room_num][target].GetPosition();
+	ROOM_FLOW_FIELD& field = flow_fields[room_num][target][floor];
+#ifdef _COLLECT_STATS
+	auto begin_time = high_resolution_clock::now();
+#endif
+	if (field.Update(ObstacleGrid[floor], floor, To_Cell(dest))) STAT_ADD(flow_rebuilds, 1);
+	PATH_CELL next;
+	bool has_next = field.Next_Cell(To_Cell(Pos), next);
+#ifdef _COLLECT_STATS
+	STAT_ADD(flow_ns, duration_cast<nanoseconds>(high_resolution_clock::now() - begin_time).count());
+#endif
+	if (has_next) {
+		XMFLOAT3 center = Cell_Center(next, Pos.y);
+		XMFLOAT3 to_next = Vector3::Subtract(center, Pos);
+		float distance = Vector3::XZLength(to_next);
+		float step = speed * fTimeElapsed;
+		XMFLOAT3 newPos = (distance <= step) ? center : Vector3::Add(Pos, Vector3::ScalarProduct(to_next, step / distance, false));
+		if (false == Blocked_By_Monster(newPos)) {
+			STAT_ADD(flow_steps, 1);
+			return newPos;
 		}
 	}
-	wander = true;
-	return Pos;
+	return Find_Direction(fTimeElapsed, Pos, dest);
 }
 
 int Monster::get_targetID()
@@ -361,7 +990,7 @@ int Monster::get_targetID()
 		float distance_z = clients[room_num][i].GetPosition().z - Pos.z;
 		float distance_x = clients[room_num][i].GetPosition().x - Pos.x;
 		distances[i].distance = sqrtf(distance_z * distance_z + distance_x * distance_x);
-		distances[i]._id = clients[room_num][i]._id;
+		distances[i]._id = i;	// target_id 는 방 안의 자리 번호다. (clients[room_num][target_id])
 	}
 
 	auto min = (*min_element(distances.begin(), distances.end(), 
@@ -376,169 +1005,159 @@ int Monster::get_targetID()
 	else return -1;
 }
 
+/**
+ * @brief 몬스터 한 마리를 한 틱 업데이트한다.
+ *
+ * Room_Tick 은 같은 상태의 몬스터를 모아서 상태별 함수를 부르므로 이 함수를 쓰지 않습니다. (Update_Room_Monsters)
+ * 한 마리씩 돌리는 경우(측정 비교)를 위해 둡니다.
+ */
 void Monster::Update(float fTimeElapsed)
 {
+	if (false == Magic_Update(fTimeElapsed))
+		return;
 	switch (GetState())
 	{
 	case NPC_State::Idle: {
-		target_id = get_targetID();
-		if (target_id != -1) {
-			const auto& targetPlayer = &clients[room_num][target_id];
-			XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
-			g_distance = Vector3::XZLength(distanceVector);
-			if (attack_range >= g_distance)
-			{
-				SetState(NPC_State::Attack);
-			}
-			else {
-				SetState(NPC_State::Chase);
-			}
-		}
+		int target = get_targetID();
+		Idle_Update(target, (target != -1) ? distances[target].distance : 0.f);
 	}
 						break;
-	case NPC_State::Chase: {
-		if (wander) {
-			while (true) {
-				short rand_dir = rand() % 8;
-				XMFLOAT3 dir = XMFLOAT3(nx[rand_dir], 0, nz[rand_dir]);
-				XMFLOAT3 newPos = Vector3::Add(Pos, Vector3::ScalarProduct(dir, speed * fTimeElapsed, false));
-
-				if (m_id < 20) {
-					if (ObstacleGrid[0].at(int(newPos.x) / CELL_SIZE).at(int(newPos.z) / CELL_SIZE) == false)
-						continue;
-				}
-				else {
-					if (ObstacleGrid[1].at(int(newPos.x) / CELL_SIZE).at(int(newPos.z) / CELL_SIZE) == false)
-						continue;
-				}
-
-
-				for (const auto& monster : monsters[room_num]) {
-					if (monster->alive.load() == false || monster->m_id == m_id) continue;
-					if (monster->BB.Intersects(BoundingBox(newPos, BB.Extents))) {
-						continue;
-					}
-				}
-
+	case NPC_State::Chase:
+		Chase_Update(fTimeElapsed);
+		break;
+	case NPC_State::Attack:
+		Attack_Update(fTimeElapsed);
+		break;
+	case NPC_State::Dead:
+		Dead_Update(fTimeElapsed);
+		break;
+	default:
+		break;
+	}
+}
 
-				Pos = newPos;
-				BB.Center = Pos;
-				break;
-			}
-			wander_timer += fTimeElapsed;
-			if (wander_timer > 2.f) {
-				wander_timer = 0.f;
-				wander = false;
-				SetState(NPC_State::Idle);
-			}
+// target 은 get_targetID (또는 MONSTER_STORE::Select_Targets) 가 고른 플레이어 자리, distance 는 그 플레이어까지의 xz 거리
+void Monster::Idle_Update(int target, float distance)
+{
+	target_id = target;
+	if (target_id != -1) {
+		g_distance = distance;
+		if (attack_range >= g_distance)
+		{
+			SetState(NPC_State::Attack);
 		}
 		else {
-			const auto& targetPlayer = &clients[room_num][target_id];
-			XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
-			g_distance = Vector3::XZLength(distanceVector);
-
-			if (clients[room_num][target_id]._state.load() != ST_INGAME)
-			{
-				SetState(NPC_State::Idle);
-				target_id = -1;
-				break;
-			}
-			if (attack_range >= g_distance)
-			{
-				SetState(NPC_State::Attack);
-				break;
-			}
-			const int collide_range = static_cast<int>(Pos.z / AREA_SIZE);
-			XMFLOAT3 vel = Vector3::XZNormalize(distanceVector);
-			XMFLOAT3 newPos = Vector3::Add(Pos, Vector3::ScalarProduct(vel, speed * fTimeElapsed, false));
-			bool collide = false;
-
-			if (m_id < 20) {
-				if (ObstacleGrid[0].at(int(newPos.x) / CELL_SIZE).at(int(newPos.z) / CELL_SIZE) == false)
-					collide = true;
-			}
-			else {
-				if (ObstacleGrid[1].at(int(newPos.x) / CELL_SIZE).at(int(newPos.z) / CELL_SIZE) == false)
-					collide = true;
-			}
-
-			if (collide == false) {
-				for (const auto& monster : monsters[room_num]) {
-					if (monster->alive.load() == false || monster->m_id == m_id) continue;
-					if (monster->BB.Intersects(BoundingBox(newPos, BB.Extents))) {
-						collide = true;
-						break;
-					}
-				}
-			}
-
-			if (collide == true) {
-				Pos = Find_Direction(fTimeElapsed, Pos, targetPlayer->GetPosition());
-				BB.Center = Pos;
-			}
-			else {
-				Pos = newPos;
-				BB.Center = Pos;
-			}
+			SetState(NPC_State::Chase);
 		}
 	}
-						 break;
-	case NPC_State::Attack: {
-		const auto& targetPlayer = &clients[room_num][target_id];
-		XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
-		g_distance = Vector3::Length(distanceVector);
+}
 
-		attack_timer -= fTimeElapsed;
-		if (targetPlayer->_state != ST_INGAME) {
-			SetState(NPC_State::Idle);
-			target_id = -1;
-			SetAttackTimer(attack_cycle);
-			break;
-		}
-		if (attacked == false && GetAttackTimer() <= attack_cycle / 2.f) {
-			if (attack_range > g_distance) {
-				lock_guard <mutex> ll{ targetPlayer->_s_lock };
-				targetPlayer->HP -= GetPower();
-				if (targetPlayer->HP <= 0) {
-					targetPlayer->_state.store(ST_DEAD);
-					for (auto& cl : clients[room_num]) {
-						if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)
-							cl.send_update_packet(targetPlayer);
-					}
-				}
-			}
-			attacked = true;
+void Monster::Chase_Update(float fTimeElapsed)
+{
+	if (wander) {
+		// 갈 수 없는 방향이 나오면 다른 방향을 뽑는다. (WANDER_ATTEMPTS 번 안에 못 찾으면 제자리)
+		for (int attempt = 0; attempt < WANDER_ATTEMPTS; ++attempt) {
+			short rand_dir = rand() % 8;
+			XMFLOAT3 dir = XMFLOAT3(nx[rand_dir], 0, nz[rand_dir]);
+			XMFLOAT3 newPos = Vector3::Add(Pos, Vector3::ScalarProduct(dir, speed * fTimeElapsed, false));
+
+			if (false == Walkable_At((m_id < 20) ? 0 : 1, newPos))
+				continue;
+			if (Blocked_By_Monster(newPos))
+				continue;
+
+			Pos = newPos;
+			BB.Center = Pos;
 			break;
 		}
-		if (GetAttackTimer() <= 0) {
-			if (attack_range <= g_distance)
-			{
-				SetState(NPC_State::Chase);
-				SetAttackTimer(attack_cycle);
-			}
-			SetAttackTimer(attack_cycle);
-			attacked = false;
+		wander_timer += fTimeElapsed;
+		if (wander_timer > 2.f) {
+			wander_timer = 0.f;
+			wander = false;
+			SetState(NPC_State::Idle);
 		}
+		return;
 	}
-						  break;
-	case NPC_State::Dead: {
-		dead_timer -= fTimeElapsed;
-		if (dead_timer <= 0) {		
-			alive.store(false);
+
+	const auto& targetPlayer = &clients[room_num][target_id];
+	XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
+	g_distance = Vector3::XZLength(distanceVector);
+
+	if (clients[room_num][target_id]._state.load() != ST_INGAME)
+	{
+		SetState(NPC_State::Idle);
+		target_id = -1;
+		return;
+	}
+	if (attack_range >= g_distance)
+	{
+		SetState(NPC_State::Attack);
+		return;
+	}
+	XMFLOAT3 vel = Vector3::XZNormalize(distanceVector);
+	XMFLOAT3 newPos = Vector3::Add(Pos, Vector3::ScalarProduct(vel, speed * fTimeElapsed, false));
+	bool collide = false;
+
+	// 이번 틱에 움직이는 선분 전체를 한 번에 검사한다. (BitGrid.h)
+	if (false == Stride_Walkable((m_id < 20) ? 0 : 1, Pos, newPos))
+		collide = true;
+
+	if (collide == false && Blocked_By_Monster(newPos))
+		collide = true;
+
+	if (collide == true) {
+		Pos = Chase_Step(fTimeElapsed, target_id);
+		BB.Center = Pos;
+	}
+	else {
+		Pos = newPos;
+		BB.Center = Pos;
+	}
+}
+
+void Monster::Attack_Update(float fTimeElapsed)
+{
+	const auto& targetPlayer = &clients[room_num][target_id];
+	XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
+	g_distance = Vector3::Length(distanceVector);
+
+	attack_timer -= fTimeElapsed;
+	if (targetPlayer->_state != ST_INGAME) {
+		SetState(NPC_State::Idle);
+		target_id = -1;
+		SetAttackTimer(attack_cycle);
+		return;
+	}
+	if (attacked == false && GetAttackTimer() <= attack_cycle / 2.f) {
+		Attack_Hit(targetPlayer, distanceVector);
+		attacked = true;
+		return;
+	}
+	if (GetAttackTimer() <= 0) {
+		if (attack_range <= g_distance)
+		{
+			SetState(NPC_State::Chase);
+			SetAttackTimer(attack_cycle);
 		}
+		SetAttackTimer(attack_cycle);
+		attacked = false;
 	}
-						break;
-	default:
-		break;
+}
+
+void Monster::Dead_Update(float fTimeElapsed)
+{
+	dead_timer -= fTimeElapsed;
+	if (dead_timer <= 0) {		
+		alive.store(false);
 	}
 }
 
-void SorcererMonster::Update(float fTimeElapsed)
+// 날아가는 마법을 움직인다. (마술사만 쏜다) 마법이 맵 밖으로 나가서 이번 틱을 건너뛰어야 하면 false
+bool Monster::Magic_Update(float fTimeElapsed)
 {
 	if (Vector3::Length(MagicLook) > 0.f) {
 		MagicPos = Vector3::Add(MagicPos, Vector3::ScalarProduct(MagicLook, 100.f * fTimeElapsed, false)); // HAT_SPEED = 200.f
 		for (auto& player : clients[room_num]) {
-			lock_guard <mutex> ll{ player._s_lock };
 			if (BoundingBox(MagicPos, BULLET_SIZE).Intersects(player.m_xmOOBB))
 			{
 				player.HP -= GetPower();
@@ -547,10 +1166,7 @@ void SorcererMonster::Update(float fTimeElapsed)
 				if (player.HP <= 0)
 				{
 					player._state.store(ST_DEAD);
-					for (auto& cl : clients[room_num]) {
-						if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)
-							cl.send_update_packet(&player);
-					}
+					Broadcast_Player_Update(&player);
 				}
 			}
 		}
@@ -566,331 +1182,63 @@ void SorcererMonster::Update(float fTimeElapsed)
 		catch (const exception& e) {
 			//cout << "Hat Update catched error -" << e.what() << endl;
 			MagicPos = Pos;
-			return;
-		}
-	}
-	switch (GetState())
-	{
-	case NPC_State::Idle: {
-		target_id = get_targetID();
-		if (target_id != -1) {
-			const auto& targetPlayer = &clients[room_num][target_id];
-			XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
-			g_distance = Vector3::XZLength(distanceVector);
-			if (attack_range >= g_distance)
-			{
-				SetState(NPC_State::Attack);
-			}
-			else {
-				SetState(NPC_State::Chase);
-			}
-		}
-	}
-						break;
-	case NPC_State::Chase: {
-		if (wander) {
-			while (true) {
-				short rand_dir = rand() % 8;
-				XMFLOAT3 dir = XMFLOAT3(nx[rand_dir], 0, nz[rand_dir]);
-				XMFLOAT3 newPos = Vector3::Add(Pos, Vector3::ScalarProduct(dir, speed * fTimeElapsed, false));
-
-				if (m_id < 20) {
-					if (ObstacleGrid[0].at(int(newPos.x) / CELL_SIZE).at(int(newPos.z) / CELL_SIZE) == false)
-						continue;
-				}
-				else {
-					if (ObstacleGrid[1].at(int(newPos.x) / CELL_SIZE).at(int(newPos.z) / CELL_SIZE) == false)
-						continue;
-				}
-
-
-				for (const auto& monster : monsters[room_num]) {
-					if (monster->alive.load() == false || monster->m_id == m_id) continue;
-					if (monster->BB.Intersects(BoundingBox(newPos, BB.Extents))) {
-						continue;
-					}
-				}
-
-
-				Pos = newPos;
-				BB.Center = Pos;
-				break;
-			}
-			wander_timer += fTimeElapsed;
-			if (wander_timer > 2.f) {
-				wander_timer = 0.f;
-				wander = false;
-				SetState(NPC_State::Idle);
-			}
-		}
-		else {
-			const auto& targetPlayer = &clients[room_num][target_id];
-			XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
-			g_distance = Vector3::XZLength(distanceVector);
-
-			if (clients[room_num][target_id]._state.load() != ST_INGAME)
-			{
-				SetState(NPC_State::Idle);
-				target_id = -1;
-				break;
-			}
-			if (attack_range >= g_distance)
-			{
-				SetState(NPC_State::Attack);
-				break;
-			}
-			const int collide_range = static_cast<int>(Pos.z / AREA_SIZE);
-			XMFLOAT3 vel = Vector3::XZNormalize(distanceVector);
-			XMFLOAT3 newPos = Vector3::Add(Pos, Vector3::ScalarProduct(vel, speed * fTimeElapsed, false));
-			bool collide = false;
-
-			if (m_id < 20) {
-				if (ObstacleGrid[0].at(int(newPos.x) / CELL_SIZE).at(int(newPos.z) / CELL_SIZE) == false)
-					collide = true;
-			}
-			else {
-				if (ObstacleGrid[1].at(int(newPos.x) / CELL_SIZE).at(int(newPos.z) / CELL_SIZE) == false)
-					collide = true;
-			}
-
-			if (collide == false) {
-				for (const auto& monster : monsters[room_num]) {
-					if (monster->alive.load() == false || monster->m_id == m_id) continue;
-					if (monster->BB.Intersects(BoundingBox(newPos, BB.Extents))) {
-						collide = true;
-						break;
-					}
-				}
-			}
-
-			if (collide == true) {
-				Pos = Find_Direction(fTimeElapsed, Pos, targetPlayer->GetPosition());
-				BB.Center = Pos;
-			}
-			else {
-				Pos = newPos;
-				BB.Center = Pos;
-			}
-		}
-	}
-						 break;
-	case NPC_State::Attack: {
-		const auto& targetPlayer = &clients[room_num][target_id];
-		XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
-		g_distance = Vector3::Length(distanceVector);
-
-		attack_timer -= fTimeElapsed;
-		if (targetPlayer->_state != ST_INGAME) {
-			SetState(NPC_State::Idle);
-			target_id = -1;
-			SetAttackTimer(attack_cycle);
-			break;
-		}
-		if (attacked == false && GetAttackTimer() <= attack_cycle / 2.f) {
-			MagicPos = Vector3::Add(GetPosition(), XMFLOAT3(0, 10, 0));
-			MagicLook = Vector3::Normalize(distanceVector);
-			attacked = true;
-			break;
-		}
-		if (GetAttackTimer() <= 0) {
-			if (attack_range <= g_distance)
-			{
-				SetState(NPC_State::Chase);
-				SetAttackTimer(attack_cycle);
-			}
-			SetAttackTimer(attack_cycle);
-			attacked = false;
-		}
-	}
-						  break;
-	case NPC_State::Dead: {
-		dead_timer -= fTimeElapsed;
-		if (dead_timer <= 0) {
-			alive.store(false);
+			return false;
 		}
 	}
-						break;
-	default:
-		break;
-	}
+	return true;
 }
 
-void BossMonster::Update(float fTimeElapsed)
+// 근접 몬스터 - 공격 범위 안이면 목표 플레이어만 때린다.
+void Monster::Attack_Hit(SESSION* targetPlayer, const XMFLOAT3& distanceVector)
 {
-	switch (GetState())
-	{
-	case NPC_State::Idle: {
-		target_id = get_targetID();
-		if (target_id != -1) {
-			const auto& targetPlayer = &clients[room_num][target_id];
-			XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
-			g_distance = Vector3::XZLength(distanceVector);
-			if (attack_range >= g_distance)
-			{
-				SetState(NPC_State::Attack);
-			}
-			else {
-				SetState(NPC_State::Chase);
-			}
+	if (attack_range > g_distance) {
+		targetPlayer->HP -= GetPower();
+		if (targetPlayer->HP <= 0) {
+			targetPlayer->_state.store(ST_DEAD);
+			Broadcast_Player_Update(targetPlayer);
 		}
 	}
-						break;
-	case NPC_State::Chase: {
-		if (wander) {
-			while (true) {
-				short rand_dir = rand() % 8;
-				XMFLOAT3 dir = XMFLOAT3(nx[rand_dir], 0, nz[rand_dir]);
-				XMFLOAT3 newPos = Vector3::Add(Pos, Vector3::ScalarProduct(dir, speed * fTimeElapsed, false));
-
-				if (ObstacleGrid[1].at(int(newPos.x) / CELL_SIZE).at(int(newPos.z) / CELL_SIZE) == false)
-					continue;
-				
-
-
-				for (const auto& monster : monsters[room_num]) {
-					if (monster->alive.load() == false || monster->m_id == m_id) continue;
-					if (monster->BB.Intersects(BoundingBox(newPos, BB.Extents))) {
-						continue;
-					}
-				}
-
-
-				Pos = newPos;
-				BB.Center = Pos;
-				break;
-			}
-			wander_timer += fTimeElapsed;
-			if (wander_timer > 2.f) {
-				wander_timer = 0.f;
-				wander = false;
-				SetState(NPC_State::Idle);
-			}
-		}
-		else {
-			const auto& targetPlayer = &clients[room_num][target_id];
-			XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
-			g_distance = Vector3::XZLength(distanceVector);
-
-			if (clients[room_num][target_id]._state.load() != ST_INGAME)
-			{
-				SetState(NPC_State::Idle);
-				target_id = -1;
-				break;
-			}
-			if (attack_range >= g_distance)
-			{
-				SetState(NPC_State::Attack);
-				break;
-			}
-			const int collide_range = static_cast<int>(Pos.z / AREA_SIZE);
-			XMFLOAT3 vel = Vector3::XZNormalize(distanceVector);
-			XMFLOAT3 newPos = Vector3::Add(Pos, Vector3::ScalarProduct(vel, speed * fTimeElapsed, false));
-
-			bool collide = false;
-
-			if (ObstacleGrid[1].at(int(newPos.x) / CELL_SIZE).at(int(newPos.z) / CELL_SIZE) == false)
-				collide = true;
-
-			if (collide == false) {
-				for (const auto& monster : monsters[room_num]) {
-					if (monster->alive.load() == false || monster->m_id == m_id) continue;
-					if (monster->BB.Intersects(BoundingBox(newPos, BB.Extents))) {
-						collide = true;
-						break;
-					}
-				}
-			}
+}
 
-			if (collide == true) {
-				Pos = Find_Direction(fTimeElapsed, Pos, targetPlayer->GetPosition());
-				BB.Center = Pos;
-			}
-			else {
-				Pos = newPos;
-				BB.Center = Pos;
-			}
-		}
-	}
-						 break;
-	case NPC_State::Attack: {
-		const auto& targetPlayer = &clients[room_num][target_id];
-		XMFLOAT3 distanceVector = Vector3::Subtract(targetPlayer->GetPosition(), Pos);
-		g_distance = Vector3::Length(distanceVector);
+// 마술사 - 목표 플레이어 쪽으로 마법을 쏜다. (Magic_Update 가 움직인다)
+void SorcererMonster::Attack_Hit(SESSION* targetPlayer, const XMFLOAT3& distanceVector)
+{
+	MagicPos = Vector3::Add(GetPosition(), XMFLOAT3(0, 10, 0));
+	MagicLook = Vector3::Normalize(distanceVector);
+}
 
-		attack_timer -= fTimeElapsed;
-		if (targetPlayer->_state != ST_INGAME) {
-			SetState(NPC_State::Idle);
-			target_id = -1;
-			SetAttackTimer(attack_cycle);
-			break;
-		}
-		if (attacked == false && GetAttackTimer() <= attack_cycle / 2.f) {
-			for (auto& client : clients[room_num]) {
-				if (client._state.load() != ST_INGAME) continue;
-				XMFLOAT3 attack_distanceVector = Vector3::Subtract(client.GetPosition(), Pos);
-				float g_attack_distance = Vector3::Length(attack_distanceVector);
-				if (attack_range > g_attack_distance) {
-					lock_guard <mutex> ll{ client._s_lock };
-					client.HP -= GetPower();
-					if (client.HP <= 0) {
-						client._state.store(ST_DEAD);
-						for (auto& cl : clients[room_num]) {
-							if (cl._state.load() == ST_INGAME || cl._state.load() == ST_DEAD)
-								cl.send_update_packet(targetPlayer);
-						}
-					}
-				}
-			}
-			attacked = true;
-			break;
-		}
-		if (GetAttackTimer() <= 0) {
-			if (attack_range <= g_distance)
-			{
-				SetState(NPC_State::Chase);
-				SetAttackTimer(attack_cycle);
+// 보스 - 공격 범위 안의 플레이어를 모두 때린다.
+void BossMonster::Attack_Hit(SESSION* targetPlayer, const XMFLOAT3& distanceVector)
+{
+	for (auto& client : clients[room_num]) {
+		if (client._state.load() != ST_INGAME) continue;
+		XMFLOAT3 attack_distanceVector = Vector3::Subtract(client.GetPosition(), Pos);
+		float g_attack_distance = Vector3::Length(attack_distanceVector);
+		if (attack_range > g_attack_distance) {
+			client.HP -= GetPower();
+			if (client.HP <= 0) {
+				client._state.store(ST_DEAD);
+				Broadcast_Player_Update(targetPlayer);
 			}
-			SetAttackTimer(attack_cycle);
-			attacked = false;
 		}
-	}
-						  break;
-	case NPC_State::Dead: {
-		dead_timer -= fTimeElapsed;
-		if (dead_timer <= 0) {
-			alive.store(false);
-		}
-	}
-						break;
-	default:
-		break;
 	}
 }
 
-void InitializeMonsters()
+// 몬스터는 방을 처음 쓸 때 만든다. (Acquire_Room_Monsters) 여기서는 몬스터 번호마다 배치 정보가 있는지만 확인한다.
+bool InitializeMonsters()
 {
-	for (int i = 0; i < MAX_ROOM; ++i)
-	{
-		for (int j = 0; j < monsters[i].size(); ++j)
-		{
-			if (StagesInfo[j].type == 2)
-				monsters[i][j] = new SorcererMonster();
-			else if (StagesInfo[j].type == 3)
-				monsters[i][j] = new BossMonster();
-			else
-				monsters[i][j] = new Monster();			
-			monsters[i][j]->Initialize(i, StagesInfo[j].id, StagesInfo[j].type, StagesInfo[j].Pos);
-		}
+	if (StagesInfo.size() < monsters[0].size()) {
+		cout << "monster info is missing - " << StagesInfo.size() << " / " << monsters[0].size() << endl;
+		return false;
 	}
+	return true;
 }
 
+// 쓰고 있는 묶음을 풀에 돌려준다. 묶음은 풀이 없어질 때 지워진다.
 void FinalizeMonsters()
 {
-	for (int i = 0; i < monsters.size(); ++i)
-	{
-		for (int j = 0; j < monsters[i].size(); ++j)
-			delete monsters[i][j];
-	}
+	for (int i = 0; i < MAX_ROOM; ++i)
+		Release_Room_Monsters(i);
 }
 
 
@@ -909,6 +1257,7 @@ void InitializeGrid()
 					file >> ObstacleGrid[floor][x][z];
 				}
 			}
+			ObstacleBits[floor].Build(ObstacleGrid[floor]);
 		}
 		file.close();
 	}
@@ -918,6 +1267,34 @@ void InitializeGrid()
 	}
 }
 
+/**
+ * @brief 층마다 계층 경로 그래프를 준비한다. (InitializeGrid 다음에 부른다)
+ *
+ * HPA_CACHE_FILE 에 지금 ObstacleGrid 로 만든 그래프가 있으면 읽고, 없거나 map.txt 가 바뀌었으면 새로 만들어 저장합니다.
+ */
+void InitializePathGraph()
+{
+	auto begin_time = high_resolution_clock::now();
+	bool loaded = false;
+	std::ifstream in(HPA_CACHE_FILE, ios::binary);
+	if (in.is_open()) {
+		loaded = true;
+		for (int floor = 0; floor < GRID_SIZE_Y; ++floor)
+			loaded = loaded && path_graphs[floor].Load(in, ObstacleGrid[floor]);
+		in.close();
+	}
+	if (false == loaded) {
+		std::ofstream out(HPA_CACHE_FILE, ios::binary | ios::trunc);
+		for (int floor = 0; floor < GRID_SIZE_Y; ++floor) {
+			path_graphs[floor].Build(ObstacleGrid[floor]);
+			path_graphs[floor].Save(out);
+		}
+		if (false == static_cast<bool>(out)) std::cout << "Failed to write " << HPA_CACHE_FILE << endl;
+	}
+	std::cout << "path graph " << (loaded ? "loaded" : "built") << " : " << path_graphs[0].Nodes() << " / " << path_graphs[1].Nodes()
+		<< " nodes, " << duration_cast<milliseconds>(high_resolution_clock::now() - begin_time).count() << "ms" << endl;
+}
+
 void InitializeMap()
 {
 	int* m_nObjects = new int(0);
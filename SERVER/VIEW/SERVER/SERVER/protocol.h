@@ -1,7 +1,7 @@
+#pragma once
 // protocol.h
 
 constexpr short PORT_NUM = 3500;
-constexpr short BUF_SIZE = 512;
 constexpr short IDPW_SIZE = 11;
 constexpr short MAX_USER = 9000;
 constexpr short MAX_ROOM = 3000;
@@ -13,6 +13,22 @@ constexpr short STAGE_SIZE = 1200;
 constexpr short AREA_SIZE = 200;
 constexpr short OBJECT_ARRAY_SIZE = 24;
 
+// 패킷 프레이밍 버전 - 서버와 클라이언트가 같은 값으로 빌드해야 한다.
+//  1 : 패킷 앞 1바이트(unsigned char)가 길이 - 최대 255바이트
+//  2 : 패킷 앞 2바이트(unsigned short, 리틀 엔디언)가 길이 - 묶음 패킷이 255바이트를 넘을 수 있다
+#define FRAME_VERSION 2
+
+#if FRAME_VERSION >= 2
+using PACKET_SIZE = unsigned short;
+constexpr short BUF_SIZE = 1024;
+#else
+using PACKET_SIZE = unsigned char;
+constexpr short BUF_SIZE = 512;
+#endif
+constexpr int PACKET_HEADER_SIZE = sizeof(PACKET_SIZE) + 1;		// 길이 + 타입
+// 패킷 하나의 최대 길이 - 송신 버퍼 하나에 들어가야 하고 길이 필드로 나타낼 수 있어야 한다.
+constexpr int MAX_PACKET_SIZE = (BUF_SIZE < (1 << (8 * sizeof(PACKET_SIZE)))) ? BUF_SIZE : (1 << (8 * sizeof(PACKET_SIZE))) - 1;
+
 // Packet ID
 constexpr char CS_LOGIN = 0;
 constexpr char CS_SIGNUP = 1;
@@ -38,28 +54,52 @@ constexpr char SC_SIGNIN = 19;
 constexpr char SC_GAME_CLEAR = 20;
 constexpr char SC_INTERACTION = 21;
 constexpr char SC_MONSTER_DAMAGED = 22;
+constexpr char SC_MOVE_MONSTERS = 23;
+constexpr char SC_UPDATE_PLAYER_Q = 24;
+constexpr char SC_MOVE_MONSTERS_Q = 25;
 
 #include "stdafx.h"
 
+// 패킷 앞의 길이 필드를 읽는다. (수신 버퍼 안에서 정렬되지 않은 위치일 수 있으므로 memcpy)
+inline int Get_Packet_Size(const void* packet)
+{
+	PACKET_SIZE size;
+	memcpy(&size, packet, sizeof(size));
+	return size;
+}
+
+inline char Get_Packet_Type(const void* packet)
+{
+	return static_cast<const char*>(packet)[sizeof(PACKET_SIZE)];
+}
+
+// 계정 문자열의 문자 타입 - Windows 클라이언트의 wchar_t(2바이트)와 크기를 맞춘다
+#ifdef _WIN32
+using PACKET_WCHAR = wchar_t;
+#else
+using PACKET_WCHAR = char16_t;
+#endif
+
 // #define _STRESS_TEST
+// #define _COMPACT_STATE	// 플레이어/몬스터 상태를 PacketCodec.h 의 압축 인코딩으로 보낸다
 
 #pragma pack (push, 1)
 struct CS_LOGIN_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 };
 constexpr short CS_LOGIN_PACKET_SIZE = sizeof(CS_LOGIN_PACKET);
 
 struct CS_SIGN_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
-	wchar_t id[IDPW_SIZE];
-	wchar_t password[IDPW_SIZE];
+	PACKET_WCHAR id[IDPW_SIZE];
+	PACKET_WCHAR password[IDPW_SIZE];
 };
 constexpr short CS_SIGN_PACKET_SIZE = sizeof(CS_SIGN_PACKET);
 
 struct CS_HEARTBEAT_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	direction = 0;
 	XMFLOAT3 pos;
@@ -71,7 +111,7 @@ struct CS_HEARTBEAT_PACKET {
 constexpr short CS_MOVE_PACKET_SIZE = sizeof(CS_HEARTBEAT_PACKET);
 
 struct CS_ROTATE_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	float cxDelta = 0.f;
 	float cyDelta = 0.f;
@@ -80,25 +120,25 @@ struct CS_ROTATE_PACKET {
 constexpr short CS_ROTATE_PACKET_SIZE = sizeof(CS_ROTATE_PACKET);
 
 struct CS_ATTACK_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 };
 constexpr short CS_ATTACK_PACKET_SIZE = sizeof(CS_ATTACK_PACKET);
 
 struct CS_INTERACTION_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 };
 constexpr short CS_INTERACTION_PACKET_SIZE = sizeof(CS_INTERACTION_PACKET);
 
 struct CS_CHANGEWEAPON_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 };
 constexpr short CS_CHANGEWEAPON_PACKET_SIZE = sizeof(CS_CHANGEWEAPON_PACKET);
 
 struct SC_GAME_START_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	XMFLOAT3 pos;
@@ -106,7 +146,7 @@ struct SC_GAME_START_PACKET {
 constexpr short SC_GAME_START_PACKET_SIZE = sizeof(SC_GAME_START_PACKET);
 
 struct SC_ADD_PLAYER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	XMFLOAT3 Pos;
@@ -114,14 +154,14 @@ struct SC_ADD_PLAYER_PACKET {
 constexpr short SC_ADD_PLAYER_PACKET_SIZE = sizeof(SC_ADD_PLAYER_PACKET);
 
 struct SC_REMOVE_PLAYER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 };
 constexpr short SC_REMOVE_PLAYER_PACKET_SIZE = sizeof(SC_REMOVE_PLAYER_PACKET);
 
 struct SC_UPDATE_PLAYER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	float	HP;
@@ -135,7 +175,7 @@ struct SC_UPDATE_PLAYER_PACKET {
 constexpr short SC_UPDATE_PLAYER_PACKET_SIZE = sizeof(SC_UPDATE_PLAYER_PACKET);
 
 struct SC_ROTATE_PLAYER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	XMFLOAT3 Look, Right;
@@ -144,14 +184,14 @@ constexpr short SC_ROTATE_PLAYER_PACKET_SIZE = sizeof(SC_ROTATE_PLAYER_PACKET);
 
 
 struct SC_ATTACK_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 };
 constexpr short SC_ATTACK_PACKET_SIZE = sizeof(SC_ATTACK_PACKET);
 
 struct SC_CHANGEWEAPON_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	short	cur_weaponType;
@@ -159,7 +199,7 @@ struct SC_CHANGEWEAPON_PACKET {
 constexpr short SC_CHANGEWEAPON_PACKET_SIZE = sizeof(SC_CHANGEWEAPON_PACKET);
 
 struct SC_SUMMON_MONSTER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	short monster_type;
@@ -168,23 +208,66 @@ struct SC_SUMMON_MONSTER_PACKET {
 constexpr short SC_SUMMON_MONSTER_PACKET_SIZE = sizeof(SC_SUMMON_MONSTER_PACKET);
 
 struct SC_MOVE_MONSTER_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	id;
 	short	target_id;
 #ifdef _STRESS_TEST
-	short room_num; // stress test  ϴ ӽ (  )
+	short room_num; // stress test를 위해 사용하는 임시 변수(추후 삭제 예정)
 #endif
 	XMFLOAT3 Pos;
 	short HP;
 	bool is_alive;
 	XMFLOAT3 BulletPos;
-	short animation_track; // ִϸ̼ Ÿ
+	short animation_track; // 애니메이션 타입
 };
 constexpr short SC_MOVE_MONSTER_PACKET_SIZE = sizeof(SC_MOVE_MONSTER_PACKET);
 
+// SC_MOVE_MONSTERS 에 담기는 몬스터 하나의 상태
+struct MONSTER_SNAPSHOT {
+	short	id;
+	short	target_id;
+	XMFLOAT3 Pos;
+	short HP;
+	bool is_alive;
+	XMFLOAT3 BulletPos;
+	short animation_track; // 애니메이션 타입
+};
+// 패킷 하나에 담을 수 있는 몬스터 수 (길이 + 타입 + room_num + count 를 뺀 나머지, FRAME_VERSION 1 이면 7)
+constexpr int MAX_MONSTER_SNAPSHOT = (MAX_PACKET_SIZE - PACKET_HEADER_SIZE - 3) / sizeof(MONSTER_SNAPSHOT);
+
+// 방의 몬스터 중 지난 스냅샷 이후 상태가 바뀐 몬스터만 모아서 보내는 패킷
+// 실제 크기는 count 개의 monsters 까지만이다.
+struct SC_MOVE_MONSTERS_PACKET {
+	PACKET_SIZE size;
+	char	type;
+#ifdef _STRESS_TEST
+	short room_num; // stress test를 위해 사용하는 임시 변수(추후 삭제 예정)
+#endif
+	unsigned char count;
+	MONSTER_SNAPSHOT monsters[MAX_MONSTER_SNAPSHOT];
+};
+constexpr short SC_MOVE_MONSTERS_HEADER_SIZE = sizeof(SC_MOVE_MONSTERS_PACKET) - sizeof(MONSTER_SNAPSHOT) * MAX_MONSTER_SNAPSHOT;
+
+// 압축 인코딩(PacketCodec.h) 상태 패킷 - 헤더 뒤에 인코딩된 상태가 이어진다.
+struct SC_UPDATE_PLAYER_Q_HEADER {
+	PACKET_SIZE size;
+	char	type;
+	short	id;
+};
+
+// 헤더 뒤에 count 개의 [short id][인코딩된 몬스터 상태] 가 이어진다.
+struct SC_MOVE_MONSTERS_Q_HEADER {
+	PACKET_SIZE size;
+	char	type;
+#ifdef _STRESS_TEST
+	short room_num; // stress test를 위해 사용하는 임시 변수(추후 삭제 예정)
+#endif
+	unsigned char count;
+};
+
 struct SC_OPEN_DOOR_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	door_num;
 
@@ -192,20 +275,20 @@ struct SC_OPEN_DOOR_PACKET {
 constexpr short SC_OPEN_DOOR_PACKET_SIZE = sizeof(SC_OPEN_DOOR_PACKET);
 
 struct SC_SIGN_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	bool	success;
 };
 constexpr short SC_SIGN_PACKET_SIZE = sizeof(SC_SIGN_PACKET);
 
 struct SC_GAME_CLEAR_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 };
 constexpr short SC_GAME_CLEAR_PACKET_SIZE = sizeof(SC_GAME_CLEAR_PACKET);
 
 struct SC_INTERACTION_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	stage_id;
 	short	obj_id;
@@ -213,7 +296,7 @@ struct SC_INTERACTION_PACKET {
 constexpr short SC_INTERACTION_PACKET_SIZE = sizeof(SC_INTERACTION_PACKET);
 
 struct SC_MONSTER_DAMAGED_PACKET {
-	unsigned char size;
+	PACKET_SIZE size;
 	char	type;
 	short	player_id;
 	short	monster_id;
@@ -221,7 +304,8 @@ struct SC_MONSTER_DAMAGED_PACKET {
 };
 #pragma pack (pop)
 
-//  Լ    
+#ifdef _WIN32
+// 소켓 함수 오류 출력 후 종료
 void err_quit(const char* msg)
 {
 	LPVOID lpMsgBuf;
@@ -235,7 +319,7 @@ void err_quit(const char* msg)
 	exit(1);
 }
 
-//  Լ  
+// 소켓 함수 오류 출력
 void err_display(const char* msg)
 {
 	LPVOID lpMsgBuf;
@@ -248,7 +332,7 @@ void err_display(const char* msg)
 	LocalFree(lpMsgBuf);
 }
 
-//  Լ  
+// 소켓 함수 오류 출력
 void err_display(int errcode)
 {
 	LPVOID lpMsgBuf;
@@ -257,6 +341,26 @@ void err_display(int errcode)
 		NULL, errcode,
 		MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
 		(char*)&lpMsgBuf, 0, NULL);
-	printf("[] %s\n", (char*)lpMsgBuf);
+	printf("[오류] %s\n", (char*)lpMsgBuf);
 	LocalFree(lpMsgBuf);
-}
\ No newline at end of file
+}
+#else
+// 소켓 함수 오류 출력 후 종료
+void err_quit(const char* msg)
+{
+	printf("[%s] %s\n", msg, strerror(errno));
+	exit(1);
+}
+
+// 소켓 함수 오류 출력
+void err_display(const char* msg)
+{
+	printf("[%s] %s\n", msg, strerror(errno));
+}
+
+// 소켓 함수 오류 출력
+void err_display(int errcode)
+{
+	printf("[오류] %s\n", strerror(errcode));
+}
+#endif
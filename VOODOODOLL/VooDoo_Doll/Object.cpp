@@ -240,20 +240,20 @@ D3D12_SHADER_RESOURCE_VIEW_DESC CTexture::GetShaderResourceViewDesc(int nIndex)
 
 void CTexture::AnimateRowColumn(XMFLOAT3& texMat, float fTime)
 {
-	texMat.x = float(m_nRow) / texMat.z;//
+	texMat.x = float(m_nRow) / texMat.z;//가로
 
 	if (4 != texMat.z)
-		texMat.y = float(m_nCol) / texMat.z;//
+		texMat.y = float(m_nCol) / texMat.z;//세로
 	else
-		texMat.y = float(m_nCol) / (texMat.z * 1.5f);//
+		texMat.y = float(m_nCol) / (texMat.z * 1.5f);//세로
 
 	if (0.0f == fTime)
 	{
 		if (++m_nCol == texMat.z)
 		{
 
-			++m_nRow;// 
-			m_nCol = 0; // 0
+			++m_nRow;//가로 증가
+			m_nCol = 0; //세로 0
 
 			if (4 != texMat.z)
 			{
@@ -266,12 +266,12 @@ void CTexture::AnimateRowColumn(XMFLOAT3& texMat, float fTime)
 		if (4 != texMat.z)
 		{
 			if (m_nRow == texMat.z)
-				m_nRow = 0;// 0
+				m_nRow = 0;//가로 0
 		}
 		else
 		{
 			if (m_nRow == texMat.z * 1.5f)
-				m_nRow = 0;// 0
+				m_nRow = 0;//가로 0
 		}
 	}
 }
@@ -437,7 +437,7 @@ void CMaterial::PrepareShaders(ID3D12Device* pd3dDevice, ID3D12GraphicsCommandLi
 
 void CMaterial::UpdateShaderVariable(ID3D12GraphicsCommandList* pd3dCommandList)
 {
-	pd3dCommandList->SetGraphicsRoot32BitConstants(14, 4, &m_xmf4AmbientColor, 0);// 
+	pd3dCommandList->SetGraphicsRoot32BitConstants(14, 4, &m_xmf4AmbientColor, 0);//조명 관련
 	pd3dCommandList->SetGraphicsRoot32BitConstants(14, 4, &m_xmf4AlbedoColor, 4);
 	pd3dCommandList->SetGraphicsRoot32BitConstants(14, 4, &m_xmf4SpecularColor, 8);
 	pd3dCommandList->SetGraphicsRoot32BitConstants(14, 4, &m_xmf4EmissiveColor, 12);
@@ -472,13 +472,13 @@ void CMaterial::LoadTextureFromFile(ID3D12Device* pd3dDevice, ID3D12GraphicsComm
 			switch (choose)
 			{
 			case 1:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo1Albed");//ε1 Į
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo1Albed");//부두1 칼든애
 				break;
 			case 2:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Albed");//ε2 ٱʹٸ
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Albed");//부두2 뼈다귀다리
 				break;
 			case 3:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Albed");//ε5 
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Albed");//부두5 마법사
 				break;
 			}
 		}
@@ -487,13 +487,13 @@ void CMaterial::LoadTextureFromFile(ID3D12Device* pd3dDevice, ID3D12GraphicsComm
 			switch (choose)
 			{
 			case 1:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo1Norma");//ε1 Į
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo1Norma");//부두1 칼든애
 				break;
 			case 2:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Norma");//ε2 ٱʹٸ
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Norma");//부두2 뼈다귀다리
 				break;
 			case 3:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Norma");//ε5 
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Norma");//부두5 마법사
 				break;
 			}
 		}
@@ -502,13 +502,13 @@ void CMaterial::LoadTextureFromFile(ID3D12Device* pd3dDevice, ID3D12GraphicsComm
 			switch (choose)
 			{
 			case 1:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo1Metal");//ε1 Į
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo1Metal");//부두1 칼든애
 				break;
 			case 2:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Metal");//ε2 ٱʹٸ
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Metal");//부두2 뼈다귀다리
 				break;
 			case 3:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Metal");//ε5 
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Metal");//부두5 마법사
 				break;
 			}
 		}
@@ -517,13 +517,13 @@ void CMaterial::LoadTextureFromFile(ID3D12Device* pd3dDevice, ID3D12GraphicsComm
 			switch (choose)
 			{
 			case 1:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo1Emiss");//ε1 Į
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo1Emiss");//부두1 칼든애
 				break;
 			case 2:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Emiss");//ε2 ٱʹٸ
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Emiss");//부두2 뼈다귀다리
 				break;
 			case 3:
-				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Emiss");//ε5 
+				strcpy_s(pstrTextureName, sizeof(pstrTextureName), "Voodoo2Emiss");//부두5 마법사
 				break;
 			}
 		}
@@ -828,7 +828,7 @@ CAnimationController::CAnimationController(ID3D12Device* pd3dDevice, ID3D12Graph
 	m_ppd3dcbSkinningBoneTransforms = new ID3D12Resource * [m_nSkinnedMeshes];
 	m_ppcbxmf4x4MappedSkinningBoneTransforms = new XMFLOAT4X4 * [m_nSkinnedMeshes];
 
-	UINT ncbElementBytes = (((sizeof(XMFLOAT4X4) * SKINNED_ANIMATION_BONES) + 255) & ~255); //256 
+	UINT ncbElementBytes = (((sizeof(XMFLOAT4X4) * SKINNED_ANIMATION_BONES) + 255) & ~255); //256의 배수
 	for (int i{}; i < m_nSkinnedMeshes; ++i)
 	{
 		m_ppd3dcbSkinningBoneTransforms[i] = ::CreateBufferResource(pd3dDevice, pd3dCommandList, NULL, ncbElementBytes, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, NULL);
@@ -917,7 +917,7 @@ void CAnimationController::AdvanceTime(float fTimeElapsed, short curTrack, CGame
 
 		if (m_pAnimationTracks[curTrack].m_bEnable)
 		{
-			if (2 < m_nAnimationTracks)// ƴϸ
+			if (2 < m_nAnimationTracks)//문이 아니면
 			{
 				if (2 == curTrack)//player : attack
 					m_pAnimationTracks[curTrack].m_nType = ANIMATION_TYPE_ONCE;
@@ -1221,7 +1221,7 @@ void CGameObject::Render(ID3D12GraphicsCommandList* pd3dCommandList, ID3D12RootS
 						if (m_ppMaterials[i]->m_pShader)
 							m_ppMaterials[i]->m_pShader->Render(pd3dCommandList, pCamera);
 
-						m_ppMaterials[i]->UpdateShaderVariable(pd3dCommandList);// 
+						m_ppMaterials[i]->UpdateShaderVariable(pd3dCommandList);//조명 관련
 						pd3dCommandList->SetGraphicsRoot32BitConstants(1, 3, &texMat, 16);
 
 					}
@@ -1882,7 +1882,7 @@ void CBulletObject::SetFirePosition(XMFLOAT3 xmf3FirePosition)
 	SetPosition(xmf3FirePosition);
 }
 
-void CBulletObject::Animate(float fElapsedTime)//Ѿ Ʈ
+void CBulletObject::Animate(float fElapsedTime)//총알 업데이트
 {
 	m_fElapsedTimeAfterFire += fElapsedTime;
 
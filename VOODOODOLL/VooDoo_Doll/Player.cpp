@@ -532,7 +532,7 @@ bool SoundPlayer::Initialize()
 	HRESULT hr;
 
 
-	// XAudio2 ü 
+	// XAudio2 객체 생성
 	hr = XAudio2Create(&xAudio2_, 0, XAUDIO2_DEFAULT_PROCESSOR);
 	if (FAILED(hr)) {
 		return false;
@@ -540,7 +540,7 @@ bool SoundPlayer::Initialize()
 
 
 
-	//  ̽ 
+	// 마스터 보이스 생성
 	hr = xAudio2_->CreateMasteringVoice(&masterVoice_);
 	if (FAILED(hr)) {
 		return false;
@@ -556,7 +556,7 @@ bool SoundPlayer::Initialize()
 	waveFormat_.cbSize = 0;
 
 
-	// ҽ ̽ 
+	// 소스 보이스 생성
 	hr = xAudio2_->CreateSourceVoice(&sourceVoice_, &waveFormat_);
 	if (FAILED(hr)) {
 		return false;
@@ -586,7 +586,7 @@ void SoundPlayer::Terminate()
 
 HRESULT SoundPlayer::LoadWaveFile(const wchar_t* filename)
 {
-	// WAV  б  
+	// WAV 파일을 읽기 전용으로 열기
 	FILE* file = nullptr;
 	errno_t err = _wfopen_s(&file, filename, L"rb");
 	if (err != 0)
@@ -594,7 +594,7 @@ HRESULT SoundPlayer::LoadWaveFile(const wchar_t* filename)
 		return HRESULT_FROM_WIN32(err);
 	}
 
-	// WAV   б
+	// WAV 파일 헤더 읽기
 	WAVEHEADER header;
 	size_t bytesRead = fread(&header, 1, sizeof(WAVEHEADER), file);
 	if (bytesRead != sizeof(WAVEHEADER))
@@ -603,7 +603,7 @@ HRESULT SoundPlayer::LoadWaveFile(const wchar_t* filename)
 		return E_FAIL;
 	}
 
-	// WAV  
+	// WAV 파일 검증
 	if (memcmp(header.chunkId, "RIFF", 4) != 0 ||
 		memcmp(header.format, "WAVE", 4) != 0 ||
 		memcmp(header.subchunk1Id, "fmt ", 4) != 0 ||
@@ -613,7 +613,7 @@ HRESULT SoundPlayer::LoadWaveFile(const wchar_t* filename)
 		return E_FAIL;
 	}
 
-	// ̺   б
+	// 웨이브 형식 정보 읽기
 	WAVEFORMATEX* pWaveFormat = (WAVEFORMATEX*)malloc(header.subchunk1Size);
 	if (!pWaveFormat)
 	{
@@ -629,7 +629,7 @@ HRESULT SoundPlayer::LoadWaveFile(const wchar_t* filename)
 		return E_FAIL;
 	}
 
-	//   б
+	// 버퍼 데이터 읽기
 	BYTE* pData = (BYTE*)malloc(header.subchunk2Size);
 	if (!pData)
 	{
@@ -647,16 +647,16 @@ HRESULT SoundPlayer::LoadWaveFile(const wchar_t* filename)
 		//return E_FAIL;
 	}
 
-	// ȯ 
+	// 반환값 설정
 	waveFormat_ = *pWaveFormat;
 	buffer_.pAudioData = pData;
 	buffer_.AudioBytes = header.subchunk2Size;
 
-	buffer_.Flags = XAUDIO2_END_OF_STREAM; // Ʈ  Ÿ
-	buffer_.LoopCount = XAUDIO2_LOOP_INFINITE; //  Ƚ Ѵ 
+	buffer_.Flags = XAUDIO2_END_OF_STREAM; // 스트림의 끝임을 나타냄
+	buffer_.LoopCount = XAUDIO2_LOOP_INFINITE; // 루프 횟수를 무한대로 설정
 
 
-	//  ݱ
+	// 파일 닫기
 	fclose(file);
 
 	return S_OK;
@@ -665,7 +665,7 @@ HRESULT SoundPlayer::LoadWaveFile(const wchar_t* filename)
 bool SoundPlayer::LoadWave(const wchar_t* filename, int type = 0)
 {
 	HRESULT hr;
-	// WAVE  ε
+	// WAVE 파일 로드
 	hr = LoadWaveFile(filename);
 
 
@@ -676,14 +676,14 @@ bool SoundPlayer::LoadWave(const wchar_t* filename, int type = 0)
 	if (type == 1)
 	{
 		buffer_.Flags = XAUDIO2_END_OF_STREAM;
-		buffer_.LoopCount = 0; //   ϰ ߱   Ƚ 0 
+		buffer_.LoopCount = 0; // 한 번만 재생하고 멈추기 위해 루프 횟수를 0으로 설정
 	}
 
 	if (nullptr == sourceVoice_)
 	{
 		if (false == Initialize())
 		{
-			// ҽ ̽ 
+			// 소스 보이스 생성
 			hr = xAudio2_->CreateSourceVoice(&sourceVoice_, &waveFormat_);
 			if (FAILED(hr)) {
 				cout << "error" << endl;
@@ -694,7 +694,7 @@ bool SoundPlayer::LoadWave(const wchar_t* filename, int type = 0)
 		//Initialize();
 	}
 
-	// ҽ ̽  
+	// 소스 보이스에 버퍼 설정
 	hr = sourceVoice_->SubmitSourceBuffer(&buffer_);
 	if (FAILED(hr)) {
 		return false;
@@ -705,7 +705,7 @@ bool SoundPlayer::LoadWave(const wchar_t* filename, int type = 0)
 
 void SoundPlayer::Play()
 {
-	// ҽ ̽ 
+	// 소스 보이스 재생
 	if (sourceVoice_)
 		sourceVoice_->Start();
 }
@@ -714,7 +714,7 @@ void SoundPlayer::Stop()
 {
 	if (sourceVoice_)
 	{
-		// ҽ ̽ 
+		// 소스 보이스 중지
 		sourceVoice_->Stop();
 		sourceVoice_->FlushSourceBuffers();
 	}
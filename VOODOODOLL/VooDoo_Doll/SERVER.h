@@ -1,11 +1,11 @@
 #pragma once
 // SERVER.h
 
-#define _CRT_SECURE_NO_WARNINGS //  C Լ    
-#define _WINSOCK_DEPRECATED_NO_WARNINGS //   API    
+#define _CRT_SECURE_NO_WARNINGS // 구형 C 함수 사용 시 경고 끄기
+#define _WINSOCK_DEPRECATED_NO_WARNINGS // 구형 소켓 API 사용 시 경고 끄기
 
-#include <winsock2.h> // 2  
-#include <ws2tcpip.h> // 2 Ȯ 
+#include <winsock2.h> // 윈속2 메인 헤더
+#include <ws2tcpip.h> // 윈속2 확장 헤더
 
 #include <tchar.h> // _T(), ...
 #include <stdio.h> // printf(), ...
@@ -15,13 +15,15 @@
 #include <thread>
 
 #include "protocol.h"
+#include "PacketCodec.h"
+#include "RecvRing.h"
 
 extern HWND gMainWindowHandle;
 extern HINSTANCE gMainInstance;
 extern HWND gEditHandle;
 extern std::mutex gMutex;
 
-#pragma comment(lib, "ws2_32") // ws2_32.lib ũ
+#pragma comment(lib, "ws2_32") // ws2_32.lib 링크
 
 
 enum COMP_TYPE { OP_ACCEPT, OP_RECV, OP_SEND };
@@ -40,16 +42,16 @@ public:
 	}
 	OVER_EXP(char* packet)
 	{
-		_wsabuf.len = packet[0];
+		_wsabuf.len = Get_Packet_Size(packet);
 		_wsabuf.buf = _send_buf;
 		ZeroMemory(&_over, sizeof(_over));
 		_comp_type = OP_SEND;
-		memcpy(_send_buf, packet, packet[0]);
+		memcpy(_send_buf, packet, _wsabuf.len);
 	}
 };
 
 
-//  Լ    
+// 소켓 함수 오류 출력 후 종료
 void err_quit(const char* msg)
 {
 	LPVOID lpMsgBuf;
@@ -63,7 +65,7 @@ void err_quit(const char* msg)
 	exit(1);
 }
 
-//  Լ  
+// 소켓 함수 오류 출력
 void err_display(const char* msg)
 {
 	LPVOID lpMsgBuf;
@@ -76,7 +78,7 @@ void err_display(const char* msg)
 	LocalFree(lpMsgBuf);
 }
 
-//  Լ  
+// 소켓 함수 오류 출력
 void err_display(int errcode)
 {
 	LPVOID lpMsgBuf;
@@ -85,6 +87,6 @@ void err_display(int errcode)
 		NULL, errcode,
 		MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
 		(char*)&lpMsgBuf, 0, NULL);
-	printf("[] %s\n", (char*)lpMsgBuf);
+	printf("[오류] %s\n", (char*)lpMsgBuf);
 	LocalFree(lpMsgBuf);
 }
\ No newline at end of file
@@ -195,7 +195,7 @@ public:
 	CGameObject** userPw = nullptr;
 	CMultiSpriteObjectsShader* pMultiSpriteObjectShader = nullptr;
 
-	// ̴
+	//계산 셰이더
 	ID3D12RootSignature* m_pd3dComputeRootSignature = NULL;
 
 	CGaussian2DBlurComputeShader** pComputeShader = nullptr;
@@ -209,12 +209,12 @@ public:
 	
 	DXGI_FORMAT compShaderFormats[1] = { DXGI_FORMAT_R8G8B8A8_UNORM };
 
-	//     ޼  true ȯ
+	// 각 문마다 열리는 조건을 달성했을 경우 true로 전환
 	bool										b1stDoorPass = false;
 	bool										b2ndDoorPass = false;
 	bool										b3rdDoorPass = false;
 	bool										b4thDoorPass = false;
-	bool										b5thDoorPass = false;//  
+	bool										b5thDoorPass = false;// 문 통과
 
 	vector<int>							DeleteObject;
 	int											iGetItem = 0;
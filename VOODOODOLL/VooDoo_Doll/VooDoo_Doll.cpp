@@ -16,8 +16,9 @@ using namespace chrono;
 constexpr short SERVER_PORT = 3500;
 SOCKET s_socket;
 OVER_EXP recv_over;
-short _prev_remain = 0;
+RECV_RING gRecvRing;			// 받았지만 아직 처리하지 않은 데이터
 auto elapsedTime = high_resolution_clock::now();
+STATE_DECODER gStateDecoder;	// 압축 인코딩된 상태 패킷의 기준 상태
 #pragma endregion
 
 HINSTANCE                  ghAppInstance;
@@ -569,9 +570,84 @@ INT_PTR CALLBACK About(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
 //    }
 //}
 
+// 몬스터 하나의 상태를 반영한다. (SC_MOVE_MONSTER, SC_MOVE_MONSTERS 공용)
+void UpdateMonster(const MONSTER_SNAPSHOT* packet)
+{
+	auto iter = find_if(gGameFramework.m_pStage->Monsters.begin(), gGameFramework.m_pStage->Monsters.end(), [packet](CMonster* Mon) {return packet->id == Mon->c_id; });
+	if (iter == gGameFramework.m_pStage->Monsters.end()) return;
+	if (packet->is_alive == false) {
+		short type = (*iter)->npc_type;
+		gGameFramework.pMonsterModel[type].push((*iter)->_Model);   // 받아온 모델타입 다시 큐로 반환
+
+		if ((*iter)->npc_type == 2)
+		{
+			gGameFramework.MagiciansHat.push((*iter)->Hat_Model);
+		}
+		(*iter)->Sound.Stop();
+		(*iter)->Sound.Terminate();
+		gGameFramework.m_pStage->Monsters.erase(iter);
+		return;
+	}
+	if ((*iter)->m_pSkinnedAnimationController->Cur_Animation_Track != packet->animation_track) {
+		if ((*iter)->m_pSkinnedAnimationController->Cur_Animation_Track != 3 && packet->animation_track != 0) {
+			(*iter)->Sound.Stop();
+			(*iter)->Sound.LoadWave(gGameFramework.monster[packet->animation_track - 1], 1);
+			(*iter)->Sound.Play();
+		}
+
+		if (packet->animation_track > (*iter)->m_pSkinnedAnimationController->Cur_Animation_Track) {
+			auto target = find_if(gGameFramework.Players.begin(), gGameFramework.Players.end(), [packet](CPlayer* Pl) {return packet->target_id == Pl->c_id; });
+			if (target != gGameFramework.Players.end()) {
+				XMFLOAT3 pos = (*iter)->GetPosition();
+				XMFLOAT4X4 mtkLookAt = Matrix4x4::LookAtLH((*iter)->GetPosition(), (*target)->GetPosition(), XMFLOAT3(0, 1, 0));
+				mtkLookAt._11 = -mtkLookAt._11;
+				mtkLookAt._21 = -mtkLookAt._21;
+				mtkLookAt._31 = -mtkLookAt._31;
+				(*iter)->m_xmf4x4ToParent = mtkLookAt;
+				(*iter)->SetPosition(pos);
+			}
+		}
+
+		(*iter)->m_pSkinnedAnimationController->SetTrackPosition((*iter)->m_pSkinnedAnimationController->Cur_Animation_Track, 0.0f);
+		(*iter)->m_pSkinnedAnimationController->SetTrackEnable((*iter)->m_pSkinnedAnimationController->Cur_Animation_Track, false);
+		(*iter)->m_pSkinnedAnimationController->SetTrackEnable(packet->animation_track, true);
+	}
+
+	if ((*iter)->m_pSkinnedAnimationController->Cur_Animation_Track == 1) {
+		XMFLOAT3 FROM = (*iter)->GetPosition();
+		XMFLOAT3 TO = packet->Pos;
+		XMFLOAT4X4 mtkLookAt = Matrix4x4::LookAtLH(FROM, TO, XMFLOAT3(0, 1, 0));
+		mtkLookAt._11 = -mtkLookAt._11;
+		mtkLookAt._21 = -mtkLookAt._21;
+		mtkLookAt._31 = -mtkLookAt._31;
+		(*iter)->m_xmf4x4ToParent = mtkLookAt;
+
+		XMFLOAT3 deltaPos = Vector3::Subtract(packet->Pos, FROM);
+		XMFLOAT3 targetPos = Vector3::Add(FROM, Vector3::ScalarProduct(deltaPos, 0.1f, false));
+		(*iter)->m_xmOOBB.Center = targetPos;
+		(*iter)->m_xmf3Velocity = Vector3::ScalarProduct(Vector3::Normalize(deltaPos), (*iter)->speed, false);
+		(*iter)->SetPosition(targetPos);
+	}
+	else if ((*iter)->npc_type == 2 && (*iter)->m_pSkinnedAnimationController->Cur_Animation_Track == 2) {
+		auto target = find_if(gGameFramework.Players.begin(), gGameFramework.Players.end(), [packet](CPlayer* Pl) {return packet->target_id == Pl->c_id; });
+		if (target != gGameFramework.Players.end()) {
+			XMFLOAT3 FROM = (*iter)->GetPosition();
+			XMFLOAT3 TO = (*target)->GetPosition();
+			TO.y = FROM.y;
+			XMFLOAT4X4 mtkLookAt = Matrix4x4::LookAtLH(FROM, TO, XMFLOAT3(0, 1, 0));
+			mtkLookAt._11 = -mtkLookAt._11;
+			mtkLookAt._21 = -mtkLookAt._21;
+			mtkLookAt._31 = -mtkLookAt._31;
+			(*iter)->m_xmf4x4ToParent = mtkLookAt;
+			(*iter)->SetPosition(FROM);
+		}
+	}
+	(*iter)->m_ppHat->SetPosition(packet->BulletPos);
+}
+
 void ProcessPacket(char* ptr)
 {
-	switch (ptr[1]) {
+	switch (Get_Packet_Type(ptr)) {
 	case SC_GAME_START: {
 		gGameFramework.lobby[2] = true;
 		gGameFramework.m_pStage->pMultiSpriteObjectShader->obj[4]->m_ppMaterials[0]->m_ppTextures[0]->m_bActive[0] = false;
@@ -794,76 +870,46 @@ void ProcessPacket(char* ptr)
 	}
 	case SC_MOVE_MONSTER: {
 		SC_MOVE_MONSTER_PACKET* packet = reinterpret_cast<SC_MOVE_MONSTER_PACKET*>(ptr);
-		auto iter = find_if(gGameFramework.m_pStage->Monsters.begin(), gGameFramework.m_pStage->Monsters.end(), [packet](CMonster* Mon) {return packet->id == Mon->c_id; });
-		if (iter == gGameFramework.m_pStage->Monsters.end()) return;
-		if (packet->is_alive == false) {
-			short type = (*iter)->npc_type;
-			gGameFramework.pMonsterModel[type].push((*iter)->_Model);   // 받아온 모델타입 다시 큐로 반환
-
-			if ((*iter)->npc_type == 2)
-			{
-				gGameFramework.MagiciansHat.push((*iter)->Hat_Model);
-			}
-			(*iter)->Sound.Stop();
-			(*iter)->Sound.Terminate();
-			gGameFramework.m_pStage->Monsters.erase(iter);
-			break;
-		}
-		if ((*iter)->m_pSkinnedAnimationController->Cur_Animation_Track != packet->animation_track) {
-			if ((*iter)->m_pSkinnedAnimationController->Cur_Animation_Track != 3 && packet->animation_track != 0) {
-				(*iter)->Sound.Stop();
-				(*iter)->Sound.LoadWave(gGameFramework.monster[packet->animation_track - 1], 1);
-				(*iter)->Sound.Play();
-			}
-
-			if (packet->animation_track > (*iter)->m_pSkinnedAnimationController->Cur_Animation_Track) {
-				auto target = find_if(gGameFramework.Players.begin(), gGameFramework.Players.end(), [packet](CPlayer* Pl) {return packet->target_id == Pl->c_id; });
-				if (target != gGameFramework.Players.end()) {
-					XMFLOAT3 pos = (*iter)->GetPosition();
-					XMFLOAT4X4 mtkLookAt = Matrix4x4::LookAtLH((*iter)->GetPosition(), (*target)->GetPosition(), XMFLOAT3(0, 1, 0));
-					mtkLookAt._11 = -mtkLookAt._11;
-					mtkLookAt._21 = -mtkLookAt._21;
-					mtkLookAt._31 = -mtkLookAt._31;
-					(*iter)->m_xmf4x4ToParent = mtkLookAt;
-					(*iter)->SetPosition(pos);
-				}
-			}
-
-			(*iter)->m_pSkinnedAnimationController->SetTrackPosition((*iter)->m_pSkinnedAnimationController->Cur_Animation_Track, 0.0f);
-			(*iter)->m_pSkinnedAnimationController->SetTrackEnable((*iter)->m_pSkinnedAnimationController->Cur_Animation_Track, false);
-			(*iter)->m_pSkinnedAnimationController->SetTrackEnable(packet->animation_track, true);
-		}
-
-		if ((*iter)->m_pSkinnedAnimationController->Cur_Animation_Track == 1) {
-			XMFLOAT3 FROM = (*iter)->GetPosition();
-			XMFLOAT3 TO = packet->Pos;
-			XMFLOAT4X4 mtkLookAt = Matrix4x4::LookAtLH(FROM, TO, XMFLOAT3(0, 1, 0));
-			mtkLookAt._11 = -mtkLookAt._11;
-			mtkLookAt._21 = -mtkLookAt._21;
-			mtkLookAt._31 = -mtkLookAt._31;
-			(*iter)->m_xmf4x4ToParent = mtkLookAt;
-
-			XMFLOAT3 deltaPos = Vector3::Subtract(packet->Pos, FROM);
-			XMFLOAT3 targetPos = Vector3::Add(FROM, Vector3::ScalarProduct(deltaPos, 0.1f, false));
-			(*iter)->m_xmOOBB.Center = targetPos;
-			(*iter)->m_xmf3Velocity = Vector3::ScalarProduct(Vector3::Normalize(deltaPos), (*iter)->speed, false);
-			(*iter)->SetPosition(targetPos);
-		}
-		else if ((*iter)->npc_type == 2 && (*iter)->m_pSkinnedAnimationController->Cur_Animation_Track == 2) {
-			auto target = find_if(gGameFramework.Players.begin(), gGameFramework.Players.end(), [packet](CPlayer* Pl) {return packet->target_id == Pl->c_id; });
-			if (target != gGameFramework.Players.end()) {
-				XMFLOAT3 FROM = (*iter)->GetPosition();
-				XMFLOAT3 TO = (*target)->GetPosition();
-				TO.y = FROM.y;
-				XMFLOAT4X4 mtkLookAt = Matrix4x4::LookAtLH(FROM, TO, XMFLOAT3(0, 1, 0));
-				mtkLookAt._11 = -mtkLookAt._11;
-				mtkLookAt._21 = -mtkLookAt._21;
-				mtkLookAt._31 = -mtkLookAt._31;
-				(*iter)->m_xmf4x4ToParent = mtkLookAt;
-				(*iter)->SetPosition(FROM);
-			}
-		}
-		(*iter)->m_ppHat->SetPosition(packet->BulletPos);
+		MONSTER_SNAPSHOT snapshot;
+		snapshot.id = packet->id;
+		snapshot.target_id = packet->target_id;
+		snapshot.Pos = packet->Pos;
+		snapshot.HP = packet->HP;
+		snapshot.is_alive = packet->is_alive;
+		snapshot.BulletPos = packet->BulletPos;
+		snapshot.animation_track = packet->animation_track;
+		UpdateMonster(&snapshot);
+		break;
+	}
+	case SC_UPDATE_PLAYER_Q: {
+		// 복원한 상태로 SC_UPDATE_PLAYER 를 처리한다.
+		short id;
+		PLAYER_STATE state;
+		if (false == Decode_Player_Update(reinterpret_cast<unsigned char*>(ptr), gStateDecoder, id, state)) break;
+		SC_UPDATE_PLAYER_PACKET packet;
+		packet.size = sizeof(SC_UPDATE_PLAYER_PACKET);
+		packet.type = SC_UPDATE_PLAYER;
+		packet.id = id;
+		packet.HP = state.HP;
+		packet.Pos = state.Pos;
+		packet.direction = state.direction;
+		packet.vel = state.vel;
+#ifdef _STRESS_TEST
+		packet.move_time = state.move_time;
+#endif
+		ProcessPacket(reinterpret_cast<char*>(&packet));
+		break;
+	}
+	case SC_MOVE_MONSTERS_Q: {
+		Decode_Monster_Updates(reinterpret_cast<unsigned char*>(ptr), gStateDecoder, [](const MONSTER_SNAPSHOT& snapshot) {
+			UpdateMonster(&snapshot);
+			});
+		break;
+	}
+	case SC_MOVE_MONSTERS: {
+		SC_MOVE_MONSTERS_PACKET* packet = reinterpret_cast<SC_MOVE_MONSTERS_PACKET*>(ptr);
+		for (int i = 0; i < packet->count; ++i)
+			UpdateMonster(&packet->monsters[i]);
 		break;
 	}
 	case SC_OPEN_DOOR: {
@@ -933,27 +979,14 @@ void CALLBACK send_callback(DWORD err, DWORD num_bytes, LPWSAOVERLAPPED over, DW
 
 void CALLBACK recv_callback(DWORD err, DWORD num_bytes, LPWSAOVERLAPPED over, DWORD flags)
 {
-	char* ptr = recv_over._send_buf;
-	static size_t in_packet_size = 0;
-	static size_t saved_packet_size = 0;
-	static char packet_buffer[BUF_SIZE];
-
-	while (num_bytes != 0) {
-		if (0 == in_packet_size) in_packet_size = ptr[0];
-		if (num_bytes + saved_packet_size >= in_packet_size) {
-			memcpy(packet_buffer + saved_packet_size, ptr, in_packet_size - saved_packet_size);
-			ProcessPacket(packet_buffer);
-
-			ptr += in_packet_size - saved_packet_size;
-			num_bytes -= int(in_packet_size - saved_packet_size);
-			in_packet_size = 0;
-			saved_packet_size = 0;
-		}
-		else {
-			memcpy(packet_buffer + saved_packet_size, ptr, num_bytes);
-			saved_packet_size += num_bytes;
-			num_bytes = 0;
-		}
+	gRecvRing.Commit(num_bytes);
+	bool valid = Dispatch_Packets(gRecvRing, [](char* packet, int) {
+		ProcessPacket(packet);
+		});
+	if (false == valid) {
+		// 길이가 잘못된 패킷 뒤로는 경계를 알 수 없으므로 받은 데이터를 버린다.
+		err_display("wrong packet size");
+		gRecvRing.Clear();
 	}
 	do_recv();
 }
@@ -964,8 +997,9 @@ void do_recv()
 {
 	DWORD r_flag = 0;
 	memset(&recv_over._over, 0, sizeof(recv_over._over));
-	recv_over._wsabuf.len = BUF_SIZE;
-	recv_over._wsabuf.buf = recv_over._send_buf;
+	unsigned len = 0;
+	recv_over._wsabuf.buf = gRecvRing.Write_Space(len);
+	recv_over._wsabuf.len = len;
 	int ret = WSARecv(s_socket, &recv_over._wsabuf, 1, NULL, &r_flag, &recv_over._over, recv_callback);
 	if (ret != 0 && WSAGetLastError() != ERROR_IO_PENDING) err_display("WSARecv()");
 }
\ No newline at end of file
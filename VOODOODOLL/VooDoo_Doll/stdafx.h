@@ -1,15 +1,15 @@
-// stdafx.h :     ʴ
-// ǥ ý    Ʈ   
-//  ִ  Դϴ.
+// stdafx.h : 자주 사용하지만 자주 변경되지는 않는
+// 표준 시스템 포함 파일 및 프로젝트 관련 포함 파일이
+// 들어 있는 포함 파일입니다.
 //
 
 #pragma once
 
-#define WIN32_LEAN_AND_MEAN             //   ʴ  Windows  մϴ.
-// Windows  :
+#define WIN32_LEAN_AND_MEAN             // 거의 사용되지 않는 내용은 Windows 헤더에서 제외합니다.
+// Windows 헤더 파일:
 #include <windows.h>
 
-// C Ÿ  Դϴ.
+// C의 런타임 헤더 파일입니다.
 #include <stdlib.h>
 #include <malloc.h>
 #include <memory.h>
@@ -111,7 +111,7 @@ extern HINSTANCE						ghAppInstance;
 #pragma comment(lib, "dxguid.lib")
 
 
-// TODO: α׷ ʿ ߰  ⿡ մϴ.
+// TODO: 프로그램에 필요한 추가 헤더는 여기에서 참조합니다.
 
 extern UINT	gnCbvSrvDescriptorIncrementSize;
 extern UINT	gnRtvDescriptorIncrementSize;